@@ -0,0 +1,580 @@
+/*
+ * File:      Animation.cpp
+ * Authors:   Luke de Munk
+ * Class:     AnimationReader, AnimationFileReader, Animation,
+ *            AnimationEncoder
+ *
+ * Animations played from a file, decoded through a small read window.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "Animation.h"
+
+#if defined(ESP32)
+/**************************************************************************/
+/*!
+  @brief    Opens an animation file.
+  @param    fs              File system, for example SPIFFS
+  @param    path            Path of the file
+  @returns  True if the file is open
+*/
+/**************************************************************************/
+bool AnimationFileReader::open(fs::FS& fs, const char path[]) {
+    _file = fs.open(path, "r");
+
+    if (!_file) {
+        debugln("ERROR: Could not open the animation file.");
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Closes the file.
+*/
+/**************************************************************************/
+void AnimationFileReader::close() {
+    _file.close();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads bytes from the file.
+  @param    buffer          Buffer to read in
+  @param    length          Maximum number of bytes
+  @returns  Number of bytes read, 0 at the end of the file
+*/
+/**************************************************************************/
+uint16_t AnimationFileReader::read(uint8_t* buffer, uint16_t length) {
+    return _file.read(buffer, length);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the position the next read starts at.
+  @param    position        Position from the start of the file
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool AnimationFileReader::seek(uint32_t position) {
+    return _file.seek(position);
+}
+#endif
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+Animation::Animation() {
+    _matrix = nullptr;
+    _reader = nullptr;
+    _numFrames = 0;
+    _frame = 0;
+    _duration = 0;
+    _lastStep = 0;
+    _started = false;
+    _loop = true;
+    _finished = false;
+    _windowLength = 0;
+    _windowPosition = 0;
+    _bytesRead = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads the header of an animation and prepares playback. The
+            animation has to be made for the size of the matrix.
+  @param    matrix          Matrix to draw on, 1 bit per pixel
+  @param    reader          Reader of the animation file
+  @returns  True if the animation can be played
+*/
+/**************************************************************************/
+bool Animation::begin(MAX7219CWGMatrix* matrix, AnimationReader* reader) {
+    _matrix = nullptr;
+    _reader = reader;
+    _numFrames = 0;
+    _windowLength = 0;
+    _windowPosition = 0;
+    _bytesRead = 0;
+
+    if (matrix->getBitsPerPixel() != 1) {
+        debugln("ERROR: Animations can only be played with 1 bit per pixel.");
+        return false;
+    }
+
+    uint8_t header[ANIMATION_HEADER];
+
+    if (!_reader->seek(0)) {
+        debugln("ERROR: Could not read the animation.");
+        return false;
+    }
+    for (uint8_t i = 0; i < ANIMATION_HEADER; i++) {
+        if (!_readByte(header[i])) {
+            return false;
+        }
+    }
+
+    if (header[0] != ANIMATION_MAGIC || header[1] != 'N') {
+        debugln("ERROR: Not an animation.");
+        return false;
+    }
+    if (header[2] != matrix->getSegmentsHorizontal() || header[3] != matrix->getSegmentsVertical()) {
+        debugln("ERROR: Animation is made for another display size.");
+        return false;
+    }
+
+    _matrix = matrix;
+    _numFrames = header[4] | header[5] << 8;
+    restart();
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets if the animation starts again after the last frame.
+  @param    loop            True to repeat
+*/
+/**************************************************************************/
+void Animation::setLoop(bool loop) {
+    _loop = loop;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Starts playing again from the first frame.
+*/
+/**************************************************************************/
+void Animation::restart() {
+    _started = false;
+    _finished = !_rewind();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Decodes the next frame into the display buffer when the current
+            one has been shown long enough. Call it from the main loop as
+            often as possible, it returns immediately. Frames are never
+            skipped, every delta needs the frame before it.
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  True if a frame has been decoded, call display() to show it
+*/
+/**************************************************************************/
+bool Animation::step(uint32_t nowMs) {
+    if (_matrix == nullptr || _finished) {
+        return false;
+    }
+
+    /* The first step only decodes the first frame */
+    if (!_started) {
+        _started = true;
+        _lastStep = nowMs;
+        return nextFrame();
+    }
+
+    if (nowMs - _lastStep < _duration) {
+        return false;
+    }
+    _lastStep += _duration;
+
+    /* Far behind, for example after a blocking call: do not rush through the frames */
+    if (nowMs - _lastStep >= _duration) {
+        _lastStep = nowMs;
+    }
+    return nextFrame();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Decodes the next frame into the display buffer right away.
+  @returns  True if a frame has been decoded, false when finished
+*/
+/**************************************************************************/
+bool Animation::nextFrame() {
+    if (_matrix == nullptr || _finished) {
+        return false;
+    }
+
+    if (_frame == _numFrames) {
+        if (!_loop || !_rewind()) {
+            _finished = true;
+            return false;
+        }
+    }
+
+    uint8_t low;
+    uint8_t high;
+    uint8_t type;
+
+    if (!_readByte(low) || !_readByte(high) || !_readByte(type)) {
+        _finished = true;
+        return false;
+    }
+
+    if (type == FRAME_KEY) {
+        _matrix->clear();
+    } else if (type != FRAME_DELTA) {
+        debugln("ERROR: Unknown frame type.");
+        _finished = true;
+        return false;
+    } else if (_frame == 0) {
+        debugln("ERROR: Animation does not start with a keyframe.");
+        _finished = true;
+        return false;
+    }
+
+    if (!_decodeRuns()) {
+        _finished = true;
+        return false;
+    }
+
+    _duration = low | high << 8;
+    _frame++;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the last frame has been shown and it is not looping.
+  @returns  _finished       True if finished
+*/
+/**************************************************************************/
+bool Animation::isFinished() {
+    return _finished;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of frames.
+  @returns  _numFrames      Number of frames
+*/
+/**************************************************************************/
+uint16_t Animation::getNumFrames() {
+    return _numFrames;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of the next frame to decode.
+  @returns  _frame          Frame number
+*/
+/**************************************************************************/
+uint16_t Animation::getFrame() {
+    return _frame;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how long the last decoded frame is shown.
+  @returns  _duration       Duration in ms
+*/
+/**************************************************************************/
+uint16_t Animation::getDuration() {
+    return _duration;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of bytes read from the file since begin().
+  @returns  _bytesRead      Number of bytes
+*/
+/**************************************************************************/
+uint32_t Animation::getBytesRead() {
+    return _bytesRead;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Goes back to the first frame.
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool Animation::_rewind() {
+    _frame = 0;
+    _windowLength = 0;
+    _windowPosition = 0;
+
+    if (_reader == nullptr || !_reader->seek(ANIMATION_HEADER)) {
+        debugln("ERROR: Could not read the animation.");
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads the next part of the file into the window.
+  @returns  True if at least one byte has been read
+*/
+/**************************************************************************/
+bool Animation::_fill() {
+    _windowLength = _reader->read(_window, ANIMATION_WINDOW);
+    _windowPosition = 0;
+    _bytesRead += _windowLength;
+
+    if (_windowLength == 0) {
+        debugln("ERROR: Animation ends in the middle of a frame.");
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads one byte through the window.
+  @param    data            Byte read
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool Animation::_readByte(uint8_t& data) {
+    if (_windowPosition == _windowLength && !_fill()) {
+        return false;
+    }
+    data = _window[_windowPosition++];
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Applies the runs of one frame to the display buffer. Literal
+            bytes are XORed straight from the window.
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool Animation::_decodeRuns() {
+    uint16_t frameSize = _matrix->getFrameSize();
+    uint16_t position = 0;
+
+    while (position < frameSize) {
+        uint8_t control;
+
+        if (!_readByte(control)) {
+            return false;
+        }
+
+        uint16_t end = position + (control & ~RUN_LITERAL) + 1;
+
+        if (end > frameSize) {
+            debugln("ERROR: Run does not fit in the frame.");
+            return false;
+        }
+
+        if (!(control & RUN_LITERAL)) {
+            position = end;
+            continue;
+        }
+
+        /* A literal run may continue in the next window */
+        while (position < end) {
+            if (_windowPosition == _windowLength && !_fill()) {
+                return false;
+            }
+
+            uint16_t length = _windowLength - _windowPosition;
+            if (length > end - position) {
+                length = end - position;
+            }
+
+            _matrix->xorFrame(position, _window + _windowPosition, length);
+            _windowPosition += length;
+            position += length;
+        }
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+AnimationEncoder::AnimationEncoder() {
+    _numSegmentsHorizontal = 0;
+    _numSegmentsVertical = 0;
+    _frameSize = 0;
+    _keyframeInterval = 0;
+    _numFrames = 0;
+    _previous = nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the previous frame.
+*/
+/**************************************************************************/
+AnimationEncoder::~AnimationEncoder() {
+    free(_previous);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Starts a new animation.
+  @param    numSegmentsHorizontal   Number of segments horizontal
+  @param    numSegmentsVertical     Number of segments vertical
+  @param    keyframeInterval        Frames between keyframes, 0 to only
+                                    use a keyframe when it is smaller than
+                                    the delta
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool AnimationEncoder::begin(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint16_t keyframeInterval) {
+    if (numSegmentsHorizontal == 0 || numSegmentsHorizontal > MAX_HORIZONTAL_SEGMENTS ||
+        numSegmentsVertical == 0 || numSegmentsVertical > MAX_VERTICAL_SEGMENTS) {
+        debugln("ERROR: Invalid number of segments given.");
+        return false;
+    }
+
+    _numSegmentsHorizontal = numSegmentsHorizontal;
+    _numSegmentsVertical = numSegmentsVertical;
+    _frameSize = numSegmentsHorizontal*numSegmentsVertical*ROW_SIZE;
+    _keyframeInterval = keyframeInterval;
+    _numFrames = 0;
+
+    free(_previous);
+    _previous = (uint8_t*) malloc(_frameSize);
+
+    if (_previous == nullptr) {
+        debugln("ERROR: Not enough memory for the previous frame.");
+        return false;
+    }
+    memset(_previous, 0, _frameSize);
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes the header of the file.
+  @param    output          Buffer of ANIMATION_HEADER bytes
+  @param    numFrames       Number of frames in the file
+  @returns  Number of bytes written
+*/
+/**************************************************************************/
+uint16_t AnimationEncoder::encodeHeader(uint8_t* output, uint16_t numFrames) {
+    output[0] = ANIMATION_MAGIC;
+    output[1] = 'N';
+    output[2] = _numSegmentsHorizontal;
+    output[3] = _numSegmentsVertical;
+    output[4] = numFrames & 0xFF;
+    output[5] = numFrames >> 8;
+    output[6] = 0;
+    output[7] = 0;
+    return ANIMATION_HEADER;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Encodes the next frame, as a delta from the previous frame or
+            as a keyframe.
+  @param    frame           Frame of getFrameSize() bytes, with the layout
+                            of the display buffer
+  @param    duration        Time the frame is shown in ms
+  @param    output          Buffer of getMaxFrameLength() bytes
+  @returns  Number of bytes written, 0 on error
+*/
+/**************************************************************************/
+uint16_t AnimationEncoder::encodeFrame(const uint8_t* frame, uint16_t duration, uint8_t* output) {
+    if (_previous == nullptr) {
+        debugln("ERROR: Call begin() before encoding frames.");
+        return 0;
+    }
+
+    bool key = _numFrames == 0 || (_keyframeInterval != 0 && _numFrames % _keyframeInterval == 0);
+
+    /* After a change of scene a keyframe can be smaller */
+    if (!key) {
+        key = _encodeRuns(frame, nullptr, nullptr) < _encodeRuns(frame, _previous, nullptr);
+    }
+
+    output[0] = duration & 0xFF;
+    output[1] = duration >> 8;
+    output[2] = key ? FRAME_KEY : FRAME_DELTA;
+
+    uint16_t length = ANIMATION_FRAME_HEADER + _encodeRuns(frame, key ? nullptr : _previous, output + ANIMATION_FRAME_HEADER);
+
+    memcpy(_previous, frame, _frameSize);
+    _numFrames++;
+    return length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the size of a frame.
+  @returns  _frameSize      Size in bytes
+*/
+/**************************************************************************/
+uint16_t AnimationEncoder::getFrameSize() {
+    return _frameSize;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the most bytes one encoded frame can take: every byte
+            literal, one control byte per ANIMATION_MAX_RUN bytes.
+  @returns  Size in bytes
+*/
+/**************************************************************************/
+uint16_t AnimationEncoder::getMaxFrameLength() {
+    return ANIMATION_FRAME_HEADER + _frameSize + (_frameSize + ANIMATION_MAX_RUN - 1)/ANIMATION_MAX_RUN;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of frames encoded since begin().
+  @returns  _numFrames      Number of frames
+*/
+/**************************************************************************/
+uint16_t AnimationEncoder::getNumFrames() {
+    return _numFrames;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Encodes the XOR of two frames as runs. A single unchanged byte
+            between changed ones stays in the literal run, ending the run
+            would cost two control bytes.
+  @param    frame           New frame
+  @param    previous        Frame to XOR with, nullptr for an empty frame
+  @param    output          Buffer for the runs, nullptr to only count
+  @returns  Number of bytes of the runs
+*/
+/**************************************************************************/
+uint16_t AnimationEncoder::_encodeRuns(const uint8_t* frame, const uint8_t* previous, uint8_t* output) {
+    auto delta = [&](uint16_t i) -> uint8_t {
+        return previous != nullptr ? frame[i] ^ previous[i] : frame[i];
+    };
+    uint16_t length = 0;
+    uint16_t i = 0;
+
+    while (i < _frameSize) {
+        uint16_t start = i;
+
+        /* Unchanged run */
+        while (i < _frameSize && delta(i) == 0 && i - start < ANIMATION_MAX_RUN) {
+            i++;
+        }
+        if (i > start) {
+            if (output != nullptr) {
+                output[length] = i - start - 1;
+            }
+            length++;
+            continue;
+        }
+
+        /* Literal run, ends at two unchanged bytes */
+        while (i < _frameSize && i - start < ANIMATION_MAX_RUN) {
+            if (delta(i) == 0 && (i + 1 == _frameSize || delta(i + 1) == 0)) {
+                break;
+            }
+            i++;
+        }
+        if (output != nullptr) {
+            output[length] = RUN_LITERAL | (i - start - 1);
+            for (uint16_t j = start; j < i; j++) {
+                output[length + 1 + j - start] = delta(j);
+            }
+        }
+        length += 1 + i - start;
+    }
+    return length;
+}
@@ -0,0 +1,144 @@
+/*
+ * File:      Animation.h
+ * Authors:   Luke de Munk
+ * Class:     AnimationReader, AnimationFileReader, Animation,
+ *            AnimationEncoder
+ *
+ * Animations played from a file, for example on SPIFFS. Frames have the
+ * layout of the display buffer (see MAX7219CWGMatrix::loadFrame()) and
+ * are stored as runs of bytes to XOR with the previous frame. They are
+ * decoded straight into the display buffer through a small read window,
+ * so a clip never has to fit in RAM. Layout, multi-byte values little
+ * endian:
+ *
+ *   0  'A' 'N'                         magic
+ *   2  uint8 segments horizontal, uint8 segments vertical
+ *   4  uint16 count                    number of frames
+ *   6  uint16 reserved
+ *
+ * Every frame:
+ *   0  uint16 duration                 time the frame is shown in ms
+ *   2  uint8 type                      FRAME_KEY or FRAME_DELTA
+ *   3  runs                            until the frame is covered
+ *
+ * Every run starts with a control byte n. With RUN_LITERAL set, the
+ * (n & 0x7F) + 1 bytes that follow are XORed into the frame, otherwise
+ * n + 1 bytes stay the same. A keyframe is a delta from an empty frame,
+ * the first frame is always one. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef ANIMATION_H
+#define ANIMATION_H
+#include "MAX7219CWGMatrix.h"
+#include "Debugger.h"                                                       //For serial debugging
+#if defined(ESP32)
+#include <FS.h>
+#endif
+
+#define ANIMATION_MAGIC         'A'
+#define ANIMATION_HEADER        8                                           //Bytes before the first frame
+#define ANIMATION_FRAME_HEADER  3                                           //Bytes before the runs of a frame
+#define ANIMATION_WINDOW        64                                          //Bytes read from the file at a time
+#define ANIMATION_MAX_RUN       128                                         //Longest run in bytes
+
+/* Frame types */
+#define FRAME_KEY               0                                           //Runs apply to an empty frame
+#define FRAME_DELTA             1                                           //Runs apply to the previous frame
+
+#define RUN_LITERAL             0x80                                        //Control byte flag, bytes to XOR follow
+
+class AnimationReader {
+	public:
+        virtual ~AnimationReader() {}
+
+        virtual uint16_t read(uint8_t* buffer, uint16_t length) = 0;
+        virtual bool seek(uint32_t position) = 0;
+};
+
+#if defined(ESP32)
+class AnimationFileReader : public AnimationReader {
+	public:
+        bool open(fs::FS& fs, const char path[]);
+        void close();
+
+        uint16_t read(uint8_t* buffer, uint16_t length);
+        bool seek(uint32_t position);
+
+	private:
+        fs::File _file;
+};
+#endif
+
+class Animation {
+	public:
+        Animation();
+
+        bool begin(MAX7219CWGMatrix* matrix, AnimationReader* reader);
+
+        /* Config functions */
+        void setLoop(bool loop);
+        void restart();
+
+        /* Draw functions */
+        bool step(uint32_t nowMs);
+        bool nextFrame();
+
+        /* Getters */
+        bool isFinished();
+        uint16_t getNumFrames();
+        uint16_t getFrame();
+        uint16_t getDuration();
+        uint32_t getBytesRead();
+
+	private:
+        bool _rewind();
+        bool _fill();
+        bool _readByte(uint8_t& data);
+        bool _decodeRuns();
+
+        MAX7219CWGMatrix* _matrix;
+        AnimationReader* _reader;
+        uint16_t _numFrames;
+        uint16_t _frame;                                                    //Next frame to decode
+        uint16_t _duration;                                                 //Duration of the last decoded frame
+
+        uint32_t _lastStep;
+        bool _started;
+        bool _loop;
+        bool _finished;
+
+        uint8_t _window[ANIMATION_WINDOW];
+        uint8_t _windowLength;
+        uint8_t _windowPosition;
+        uint32_t _bytesRead;
+};
+
+class AnimationEncoder {
+	public:
+        AnimationEncoder();
+        ~AnimationEncoder();
+        AnimationEncoder(const AnimationEncoder&) = delete;
+        AnimationEncoder& operator=(const AnimationEncoder&) = delete;
+
+        bool begin(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint16_t keyframeInterval = 0);
+
+        uint16_t encodeHeader(uint8_t* output, uint16_t numFrames);
+        uint16_t encodeFrame(const uint8_t* frame, uint16_t duration, uint8_t* output);
+
+        /* Getters */
+        uint16_t getFrameSize();
+        uint16_t getMaxFrameLength();
+        uint16_t getNumFrames();
+
+	private:
+        uint16_t _encodeRuns(const uint8_t* frame, const uint8_t* previous, uint8_t* output);
+
+        uint8_t _numSegmentsHorizontal;
+        uint8_t _numSegmentsVertical;
+        uint16_t _frameSize;
+        uint16_t _keyframeInterval;                                         //Frames between keyframes, 0 only when smaller
+        uint16_t _numFrames;
+        uint8_t* _previous;                                                 //Last encoded frame
+};
+
+#endif /* ANIMATION_H */
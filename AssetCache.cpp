@@ -0,0 +1,381 @@
+/*
+ * File:      AssetCache.cpp
+ * Authors:   Luke de Munk
+ * Class:     AssetCache, PageTemplate
+ *
+ * Static files of a web page with ETags, and a page template rendered
+ * once per state version. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "AssetCache.h"
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without assets.
+*/
+/**************************************************************************/
+AssetCache::AssetCache() {
+    _numAssets = 0;
+    _cachedSize = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the cached files.
+*/
+/**************************************************************************/
+AssetCache::~AssetCache() {
+    for (uint16_t i = 0; i < _numAssets; i++) {
+        free(_assets[i].data);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Adds an asset. Its bytes are copied into RAM while they fit in
+            ASSET_CACHE_BUDGET, otherwise only the ETag is kept and the
+            asset is read from the file per request. Add hot files first.
+  @param    path            Path in the URL, for example "/style.css"
+  @param    contentType     MIME type, for example "text/css"
+  @param    data            Bytes of the file
+  @param    length          Number of bytes
+  @param    gzip            True if the bytes are gzip compressed
+  @param    file            File the bytes are read from
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool AssetCache::add(const char path[], const char contentType[], const uint8_t* data, uint32_t length, bool gzip, const char file[]) {
+    if (_numAssets == ASSET_CACHE_MAX_ASSETS) {
+        debugln("ERROR: Too many assets, increase ASSET_CACHE_MAX_ASSETS.");
+        return false;
+    }
+    if (strlen(path) >= ASSET_PATH_LENGTH || strlen(file) >= sizeof(_assets[0].file)) {
+        debugln("ERROR: Asset path too long.");
+        return false;
+    }
+
+    Asset& asset = _assets[_numAssets];
+
+    strcpy(asset.path, path);
+    strcpy(asset.file, file);
+    asset.contentType = contentType;
+    asset.length = length;
+    asset.gzip = gzip;
+    asset.data = nullptr;
+    makeEtag(data, length, asset.etag);
+
+    if (_cachedSize + length <= ASSET_CACHE_BUDGET) {
+        asset.data = (uint8_t*) malloc(length);
+
+        if (asset.data != nullptr) {
+            memcpy(asset.data, data, length);
+            _cachedSize += length;
+        }
+    }
+
+    _numAssets++;
+    return true;
+}
+
+#if defined(ESP32)
+/**************************************************************************/
+/*!
+  @brief    Adds an asset from a file system. Uses the compressed file
+            (path + ".gz") if there is one.
+  @param    fs              File system, for example SPIFFS
+  @param    path            Path of the file and in the URL
+  @param    contentType     MIME type, for example "text/css"
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool AssetCache::addFile(fs::FS& fs, const char path[], const char contentType[]) {
+    char file[ASSET_PATH_LENGTH + 3];
+    bool gzip = true;
+
+    snprintf(file, sizeof(file), "%s.gz", path);
+    if (!fs.exists(file)) {
+        strncpy(file, path, sizeof(file));
+        file[sizeof(file) - 1] = '\0';
+        gzip = false;
+    }
+
+    File f = fs.open(file, "r");
+    if (!f) {
+        debugln("ERROR: Could not open an asset.");
+        return false;
+    }
+
+    uint32_t length = f.size();
+    uint8_t* data = (uint8_t*) malloc(length);
+
+    if (data == nullptr) {
+        debugln("ERROR: Not enough memory to read an asset.");
+        f.close();
+        return false;
+    }
+
+    bool success = f.read(data, length) == length && add(path, contentType, data, length, gzip, file);
+
+    f.close();
+    free(data);
+    return success;
+}
+#endif
+
+/**************************************************************************/
+/*!
+  @brief    Returns the asset with a path.
+  @param    path            Path in the URL
+  @returns  Asset, nullptr if not found
+*/
+/**************************************************************************/
+const Asset* AssetCache::find(const char path[]) {
+    for (uint16_t i = 0; i < _numAssets; i++) {
+        if (strcmp(_assets[i].path, path) == 0) {
+            return &_assets[i];
+        }
+    }
+    return nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns an asset by index, for example to add a route for
+            every asset.
+  @param    index           Asset (0 to getNumAssets()-1)
+  @returns  Asset, nullptr if not found
+*/
+/**************************************************************************/
+const Asset* AssetCache::getAsset(uint16_t index) {
+    return index < _numAssets ? &_assets[index] : nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of assets.
+  @returns  _numAssets      Number of assets
+*/
+/**************************************************************************/
+uint16_t AssetCache::getNumAssets() {
+    return _numAssets;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the RAM used by cached files.
+  @returns  _cachedSize     Size in bytes
+*/
+/**************************************************************************/
+uint32_t AssetCache::getCachedSize() {
+    return _cachedSize;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the browser already has this version, so a 304
+            without a body can be sent.
+  @param    etag            ETag of the asset
+  @param    ifNoneMatch     If-None-Match header of the request, may be a
+                            list of ETags, nullptr if there is none
+  @returns  True if not modified
+*/
+/**************************************************************************/
+bool AssetCache::isNotModified(const char etag[], const char ifNoneMatch[]) {
+    return ifNoneMatch != nullptr && strstr(ifNoneMatch, etag) != nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Makes an ETag from a 32-bit FNV-1a hash of bytes.
+  @param    data            Bytes
+  @param    length          Number of bytes
+  @param    etag            Buffer of ASSET_ETAG_LENGTH characters
+*/
+/**************************************************************************/
+void AssetCache::makeEtag(const uint8_t* data, uint32_t length, char etag[]) {
+    uint32_t hash = 2166136261UL;
+
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    snprintf(etag, ASSET_ETAG_LENGTH, "\"%08lx\"", (unsigned long) hash);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+PageTemplate::PageTemplate() {
+    _template = nullptr;
+    _templateLength = 0;
+    _page = nullptr;
+    _length = 0;
+    _capacity = 0;
+    _processor = nullptr;
+    _version = 0;
+    _rendered = false;
+    _numRenders = 0;
+    _etag[0] = '\0';
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the template and the page.
+*/
+/**************************************************************************/
+PageTemplate::~PageTemplate() {
+    free(_template);
+    free(_page);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the template of a page.
+  @param    page            Page with %PLACEHOLDERS%, capitals, digits and
+                            underscores between percent signs
+  @param    length          Length of the page
+  @param    processor       Returns the value of a placeholder
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool PageTemplate::begin(const char page[], uint32_t length, String (*processor)(const String&)) {
+    free(_template);
+    free(_page);
+    _page = nullptr;
+    _length = 0;
+    _capacity = 0;
+    _rendered = false;
+
+    _template = (char*) malloc(length);
+    _templateLength = _template != nullptr ? length : 0;
+
+    if (_template == nullptr || !_append("", 0)) {                          //Reserves the page
+        debugln("ERROR: Not enough memory for the page template.");
+        return false;
+    }
+
+    memcpy(_template, page, length);
+    _processor = processor;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Renders the page, unless it is already rendered for this
+            version of the state.
+  @param    version         Version of the state, changes when the state
+                            shown on the page changes
+  @returns  True if rendered again
+*/
+/**************************************************************************/
+bool PageTemplate::render(uint32_t version) {
+    if (_template == nullptr || (_rendered && version == _version)) {
+        return false;
+    }
+
+    _length = 0;
+
+    for (uint32_t i = 0; i < _templateLength; i++) {
+        char name[PAGE_TEMPLATE_NAME_LENGTH];
+        uint8_t nameLength = 0;
+
+        /* A placeholder is a name between percent signs, anything else is copied */
+        if (_template[i] == '%') {
+            uint32_t end = i + 1;
+
+            while (end < _templateLength && nameLength < PAGE_TEMPLATE_NAME_LENGTH - 1 &&
+                   (isupper((unsigned char) _template[end]) || isdigit((unsigned char) _template[end]) || _template[end] == '_')) {
+                name[nameLength++] = _template[end++];
+            }
+
+            if (nameLength > 0 && end < _templateLength && _template[end] == '%') {
+                name[nameLength] = '\0';
+                String value = _processor(String(name));
+
+                if (!_append(value.c_str(), value.length())) {
+                    return false;
+                }
+                i = end;
+                continue;
+            }
+        }
+
+        if (!_append(&_template[i], 1)) {
+            return false;
+        }
+    }
+
+    AssetCache::makeEtag((const uint8_t*) _page, _length, _etag);
+    _version = version;
+    _rendered = true;
+    _numRenders++;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the rendered page, terminated.
+  @returns  _page           Page, nullptr before begin()
+*/
+/**************************************************************************/
+const char* PageTemplate::getPage() {
+    return _page;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the length of the rendered page.
+  @returns  _length         Length in bytes
+*/
+/**************************************************************************/
+uint32_t PageTemplate::getLength() {
+    return _length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the ETag of the rendered page.
+  @returns  _etag           ETag, quoted
+*/
+/**************************************************************************/
+const char* PageTemplate::getEtag() {
+    return _etag;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how many times the page has been rendered.
+  @returns  _numRenders     Number of renders
+*/
+/**************************************************************************/
+uint32_t PageTemplate::getNumRenders() {
+    return _numRenders;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Appends text to the page, grows it if needed.
+  @param    text            Text to append
+  @param    length          Length of the text
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool PageTemplate::_append(const char text[], uint32_t length) {
+    if (_length + length + 1 > _capacity) {
+        uint32_t capacity = _templateLength + _length + length + PAGE_TEMPLATE_MARGIN;
+        char* page = (char*) realloc(_page, capacity);
+
+        if (page == nullptr) {
+            debugln("ERROR: Not enough memory to render the page.");
+            return false;
+        }
+        _page = page;
+        _capacity = capacity;
+    }
+
+    memcpy(_page + _length, text, length);
+    _length += length;
+    _page[_length] = '\0';
+    return true;
+}
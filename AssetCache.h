@@ -0,0 +1,103 @@
+/*
+ * File:      AssetCache.h
+ * Authors:   Luke de Munk
+ * Class:     AssetCache, PageTemplate
+ *
+ * Static files of a web page, ready to send. Files are stored gzip
+ * compressed next to the original (style.css.gz), the cache keeps the
+ * compressed bytes in RAM up to a budget and reads larger ones from flash
+ * per request. Every asset has an ETag, a hash of its bytes, so browsers
+ * can revalidate with If-None-Match and get a 304 without a body.
+ *
+ * PageTemplate fills the %PLACEHOLDERS% of a page and keeps the result,
+ * so a page is only rendered again when the state it shows changed.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+#include <Arduino.h>
+#include "Debugger.h"                                                       //For serial debugging
+#if defined(ESP32)
+#include <FS.h>
+#endif
+
+#define ASSET_CACHE_MAX_ASSETS  12
+#define ASSET_CACHE_BUDGET      40960                                       //Bytes of RAM for cached files
+#define ASSET_PATH_LENGTH       32                                          //Longest path, terminator included
+#define ASSET_ETAG_LENGTH       11                                          //Quoted 8 hex digits and the terminator
+#define ASSET_MAX_AGE           "max-age=86400"                             //Cache-Control of assets, revalidate daily
+
+#define PAGE_TEMPLATE_MARGIN    64                                          //Room for placeholder values longer than their names
+#define PAGE_TEMPLATE_NAME_LENGTH 24                                        //Longest placeholder name, terminator included
+
+struct Asset {
+    char path[ASSET_PATH_LENGTH];                                           //Path in the URL
+    char file[ASSET_PATH_LENGTH + 3];                                       //File it is read from, .gz if compressed
+    const char* contentType;
+    uint8_t* data;                                                          //In RAM, nullptr if read from the file
+    uint32_t length;
+    bool gzip;
+    char etag[ASSET_ETAG_LENGTH];
+};
+
+class AssetCache {
+	public:
+        AssetCache();
+        ~AssetCache();
+        AssetCache(const AssetCache&) = delete;
+        AssetCache& operator=(const AssetCache&) = delete;
+
+        bool add(const char path[], const char contentType[], const uint8_t* data, uint32_t length, bool gzip, const char file[]);
+#if defined(ESP32)
+        bool addFile(fs::FS& fs, const char path[], const char contentType[]);
+#endif
+
+        /* Getters */
+        const Asset* find(const char path[]);
+        const Asset* getAsset(uint16_t index);
+        uint16_t getNumAssets();
+        uint32_t getCachedSize();
+
+        static bool isNotModified(const char etag[], const char ifNoneMatch[]);
+        static void makeEtag(const uint8_t* data, uint32_t length, char etag[]);
+
+	private:
+        Asset _assets[ASSET_CACHE_MAX_ASSETS];
+        uint16_t _numAssets;
+        uint32_t _cachedSize;                                               //Bytes in RAM
+};
+
+class PageTemplate {
+	public:
+        PageTemplate();
+        ~PageTemplate();
+        PageTemplate(const PageTemplate&) = delete;
+        PageTemplate& operator=(const PageTemplate&) = delete;
+
+        bool begin(const char page[], uint32_t length, String (*processor)(const String&));
+        bool render(uint32_t version);
+
+        /* Getters */
+        const char* getPage();
+        uint32_t getLength();
+        const char* getEtag();
+        uint32_t getNumRenders();
+
+	private:
+        bool _append(const char text[], uint32_t length);
+
+        char* _template;
+        uint32_t _templateLength;
+        char* _page;
+        uint32_t _length;
+        uint32_t _capacity;
+        String (*_processor)(const String&);
+
+        uint32_t _version;                                                  //State version of the rendered page
+        bool _rendered;
+        uint32_t _numRenders;
+        char _etag[ASSET_ETAG_LENGTH];
+};
+
+#endif /* ASSET_CACHE_H */
@@ -0,0 +1,443 @@
+/*
+ * File:      ClockService.cpp
+ * Authors:   Luke de Munk
+ * Class:     ClockService
+ *
+ * Non-blocking (S)NTP time source. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "ClockService.h"
+
+/**************************************************************************/
+/*!
+  @brief    Reads a big endian 32-bit word of a packet.
+  @param    data            First byte of the word
+  @returns  Word
+*/
+/**************************************************************************/
+static uint32_t readWord(const uint8_t* data) {
+    return (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3];
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a big endian 32-bit word into a packet.
+  @param    data            First byte of the word
+  @param    word            Word
+*/
+/**************************************************************************/
+static void writeWord(uint8_t* data, uint32_t word) {
+    data[0] = word >> 24;
+    data[1] = word >> 16;
+    data[2] = word >> 8;
+    data[3] = word;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+ClockService::ClockService() {
+    _udp = nullptr;
+    _server = NTP_DEFAULT_SERVER;
+    _serverPort = NTP_PORT;
+    _resolved = false;
+    _numLost = 0;
+    _timeOffset = 0;
+    _syncInterval = CLOCK_SYNC_INTERVAL;
+    _replyTimeout = CLOCK_REPLY_TIMEOUT;
+
+    _waiting = false;
+    _sentAt = 0;
+    _nextSyncAt = 0;
+    _requestId = 0;
+
+    _synced = false;
+    _syncedAt = 0;
+    _baseSeconds = 0;
+    _baseMillis = 0;
+    _drift = 0;
+
+    _lastOffset = 0;
+    _roundTrip = 0;
+    _numSyncs = 0;
+    _numTimeouts = 0;
+    _numRejected = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the socket and the time server. The first request is sent
+            by the first update().
+  @param    udp             UDP socket, for example a WiFiUDP
+  @param    server          Host name or address of the time server
+  @param    serverPort      Port of the time server
+  @param    localPort       Local port to receive the replies on
+*/
+/**************************************************************************/
+void ClockService::begin(UDP* udp, const char* server, uint16_t serverPort, uint16_t localPort) {
+    _udp = udp;
+    _server = server;
+    _serverPort = serverPort;
+    _resolved = false;
+    _numLost = 0;
+    _waiting = false;
+    _udp->begin(localPort);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the time between synchronisations.
+  @param    interval        Interval in ms
+*/
+/**************************************************************************/
+void ClockService::setSyncInterval(uint32_t interval) {
+    _syncInterval = interval;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets how long to wait for a reply before it counts as lost.
+  @param    timeout         Timeout in ms
+*/
+/**************************************************************************/
+void ClockService::setReplyTimeout(uint32_t timeout) {
+    _replyTimeout = timeout;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the time zone.
+  @param    offset          Offset from UTC in seconds, for example 3600
+                            for GMT +1
+*/
+/**************************************************************************/
+void ClockService::setTimeOffset(int32_t offset) {
+    _timeOffset = offset;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends a request when a synchronisation is due and handles the
+            reply when it came in. Never waits, call it from the main loop
+            at least every getTimeToUpdate() ms.
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  True if the time has been synchronised
+*/
+/**************************************************************************/
+bool ClockService::update(uint32_t nowMs) {
+    if (_udp == nullptr) {
+        return false;
+    }
+
+    if (_waiting) {
+        if (_receive(nowMs)) {
+            return true;
+        }
+
+        if (nowMs - _sentAt < _replyTimeout) {
+            return false;
+        }
+
+        /* Lost or too slow, a late reply is rejected by its id */
+        debugln("NOTE: No reply of the time server.");
+        _waiting = false;
+        _numTimeouts++;
+
+        /* The server may have left the pool, look the name up again */
+        if (++_numLost >= CLOCK_RESOLVE_TIMEOUTS) {
+            _resolved = false;
+            _numLost = 0;
+        }
+        _nextSyncAt = nowMs + CLOCK_RETRY_INTERVAL;
+    }
+
+    /* The first request is sent right away */
+    if (_requestId == 0 || (int32_t) (nowMs - _nextSyncAt) >= 0) {
+        _sendRequest(nowMs);
+    }
+    return false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the time has been synchronised at least once.
+  @returns  _synced         True if synchronised
+*/
+/**************************************************************************/
+bool ClockService::isSynced() {
+    return _synced;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the interpolated Unix time.
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  Seconds since 1970 (UTC)
+*/
+/**************************************************************************/
+uint32_t ClockService::getEpochTime(uint32_t nowMs) {
+    uint32_t seconds;
+    uint16_t millis;
+
+    _now(nowMs, seconds, millis);
+    return seconds;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the milliseconds of the interpolated time.
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  Milliseconds into the current second (0-999)
+*/
+/**************************************************************************/
+uint16_t ClockService::getMillis(uint32_t nowMs) {
+    uint32_t seconds;
+    uint16_t millis;
+
+    _now(nowMs, seconds, millis);
+    return millis;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the local time of day, ready for
+            SmartLedDisplay::setTime().
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  Time object
+*/
+/**************************************************************************/
+Time ClockService::getTime(uint32_t nowMs) {
+    uint32_t seconds = (getEpochTime(nowMs) + _timeOffset) % 86400;
+    Time time;
+
+    time.hour = seconds / 3600;
+    time.minute = (seconds / 60) % 60;
+    time.second = seconds % 60;
+    return time;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how long the caller may wait before the next update().
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  Time in ms
+*/
+/**************************************************************************/
+uint32_t ClockService::getTimeToUpdate(uint32_t nowMs) {
+    if (_udp == nullptr) {
+        return 0xFFFFFFFF;
+    }
+
+    if (_waiting) {
+        return CLOCK_POLL_INTERVAL;
+    }
+
+    int32_t remaining = _nextSyncAt - nowMs;
+    return remaining > 0 ? remaining : 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the time since the last synchronisation.
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  Age in ms, 0xFFFFFFFF if never synchronised
+*/
+/**************************************************************************/
+uint32_t ClockService::getSyncAge(uint32_t nowMs) {
+    if (!_synced) {
+        return 0xFFFFFFFF;
+    }
+    return nowMs - _syncedAt;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the measured drift of the local counter.
+  @returns  _drift          Correction in ppm, positive if the local
+                            counter runs slow
+*/
+/**************************************************************************/
+int32_t ClockService::getDrift() {
+    return _drift;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the error of the interpolated time found by the last
+            synchronisation.
+  @returns  _lastOffset     Measured minus interpolated time in ms
+*/
+/**************************************************************************/
+int32_t ClockService::getLastOffset() {
+    return _lastOffset;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the network delay of the last synchronisation.
+  @returns  _roundTrip      Round trip in ms, without the server time
+*/
+/**************************************************************************/
+uint32_t ClockService::getRoundTrip() {
+    return _roundTrip;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of synchronisations.
+  @returns  _numSyncs       Number of replies used
+*/
+/**************************************************************************/
+uint32_t ClockService::getNumSyncs() {
+    return _numSyncs;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of requests without a reply in time.
+  @returns  _numTimeouts    Number of timeouts
+*/
+/**************************************************************************/
+uint32_t ClockService::getNumTimeouts() {
+    return _numTimeouts;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of replies that were invalid or too late.
+  @returns  _numRejected    Number of rejected replies
+*/
+/**************************************************************************/
+uint32_t ClockService::getNumRejected() {
+    return _numRejected;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends an SNTP request. The transmit timestamp holds an id the
+            server echoes, so late replies of earlier requests are not
+            mistaken for the reply. The server name is only looked up
+            until a reply came in, after that its address is used, so
+            the blocking DNS lookup is not done every synchronisation.
+  @param    nowMs           Current time in ms
+*/
+/**************************************************************************/
+void ClockService::_sendRequest(uint32_t nowMs) {
+    uint8_t packet[NTP_PACKET_SIZE];
+
+    memset(packet, 0, NTP_PACKET_SIZE);
+    packet[0] = 0x1B;                                                       //No leap warning, version 3, client
+    _requestId++;
+    writeWord(packet + 40, nowMs);
+    writeWord(packet + 44, _requestId);
+
+    if (_resolved) {
+        _udp->beginPacket(_serverIP, _serverPort);
+    } else {
+        _udp->beginPacket(_server, _serverPort);
+    }
+    _udp->write(packet, NTP_PACKET_SIZE);
+    _udp->endPacket();
+
+    _waiting = true;
+    _sentAt = nowMs;
+    _nextSyncAt = nowMs + _syncInterval;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads the replies that came in. A valid reply to the last
+            request sets the time; the drift is measured from the error
+            of the interpolation since the previous synchronisation.
+  @param    nowMs           Current time in ms
+  @returns  True if the time has been synchronised
+*/
+/**************************************************************************/
+bool ClockService::_receive(uint32_t nowMs) {
+    uint8_t packet[NTP_PACKET_SIZE];
+    int size;
+
+    while ((size = _udp->parsePacket()) > 0) {
+        if (size < NTP_PACKET_SIZE || _udp->read(packet, NTP_PACKET_SIZE) < NTP_PACKET_SIZE) {
+            _udp->flush();
+            _numRejected++;
+            continue;
+        }
+        _udp->flush();
+
+        uint8_t mode = packet[0] & 0x07;
+        uint8_t stratum = packet[1];
+
+        if (mode != 4 || stratum == 0 || stratum > 15 || readWord(packet + 24) != _sentAt || readWord(packet + 28) != _requestId) {
+            _numRejected++;                                                 //Not a server, kiss-o'-death or stale
+            continue;
+        }
+
+        /* Round trip without the time the server held the request */
+        uint32_t receiveMs = ((uint64_t) readWord(packet + 36) * 1000) >> 32;
+        uint32_t transmitMs = ((uint64_t) readWord(packet + 44) * 1000) >> 32;
+        uint32_t held = (readWord(packet + 40) - readWord(packet + 32))*1000 + transmitMs - receiveMs;
+        uint32_t roundTrip = nowMs - _sentAt;
+
+        roundTrip = held < roundTrip ? roundTrip - held : 0;
+
+        /* Server time when the reply arrived */
+        uint32_t millis = transmitMs + roundTrip/2;
+        uint32_t seconds = readWord(packet + 40) - NTP_UNIX_OFFSET + millis/1000;
+        millis %= 1000;
+
+        if (_synced) {
+            uint32_t predictedSeconds;
+            uint16_t predictedMillis;
+
+            _now(nowMs, predictedSeconds, predictedMillis);
+            int32_t offset = (int32_t) (seconds - predictedSeconds)*1000 + (int32_t) millis - predictedMillis;
+            uint32_t elapsed = nowMs - _syncedAt;
+
+            /* Small errors over a long enough time are drift, half of it is corrected */
+            if (elapsed >= CLOCK_MIN_DRIFT_TIME && offset > -CLOCK_MAX_SLEW && offset < CLOCK_MAX_SLEW) {
+                _drift += (int32_t) ((int64_t) offset*1000000 / elapsed) / 2;
+
+                if (_drift > CLOCK_MAX_DRIFT) {
+                    _drift = CLOCK_MAX_DRIFT;
+                } else if (_drift < -CLOCK_MAX_DRIFT) {
+                    _drift = -CLOCK_MAX_DRIFT;
+                }
+            }
+            _lastOffset = offset;
+        }
+
+        _serverIP = _udp->remoteIP();
+        _resolved = true;
+        _numLost = 0;
+
+        _synced = true;
+        _syncedAt = nowMs;
+        _baseSeconds = seconds;
+        _baseMillis = millis;
+        _roundTrip = roundTrip;
+        _numSyncs++;
+        _waiting = false;
+        return true;
+    }
+    return false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Interpolates the Unix time from the last synchronisation.
+  @param    nowMs           Current time in ms
+  @param    seconds         Returns the seconds since 1970
+  @param    millis          Returns the milliseconds
+*/
+/**************************************************************************/
+void ClockService::_now(uint32_t nowMs, uint32_t& seconds, uint16_t& millis) {
+    uint32_t elapsed = nowMs - _syncedAt;
+    uint32_t corrected = elapsed + (int32_t) ((int64_t) elapsed*_drift / 1000000);
+    uint32_t total = _baseMillis + corrected;
+
+    seconds = _baseSeconds + total/1000;
+    millis = total % 1000;
+}
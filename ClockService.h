@@ -0,0 +1,98 @@
+/*
+ * File:      ClockService.h
+ * Authors:   Luke de Munk
+ * Class:     ClockService
+ *
+ * Non-blocking (S)NTP time source. Sends a request now and then and
+ * polls for the reply, so a slow or lost reply never stalls the caller.
+ * Between synchronisations the time is interpolated from a local
+ * millisecond counter, corrected for the measured drift of the local
+ * oscillator. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef CLOCK_SERVICE_H
+#define CLOCK_SERVICE_H
+#include <Arduino.h>
+#include <Udp.h>
+#include "SmartLedDisplay.h"                                                //For the Time struct
+#include "Debugger.h"                                                       //For serial debugging
+
+#define NTP_DEFAULT_SERVER      "pool.ntp.org"
+#define NTP_PORT                123
+#define NTP_LOCAL_PORT          1337
+#define NTP_PACKET_SIZE         48
+#define NTP_UNIX_OFFSET         2208988800UL                                //Seconds from 1900 to 1970
+
+#define CLOCK_SYNC_INTERVAL     600000                                      //Default time between synchronisations in ms
+#define CLOCK_RETRY_INTERVAL    5000                                        //Time before retrying a lost request in ms
+#define CLOCK_REPLY_TIMEOUT     1000                                        //Default time to wait for a reply in ms
+#define CLOCK_POLL_INTERVAL     10                                          //Time between polls while waiting in ms
+#define CLOCK_MIN_DRIFT_TIME    60000                                       //Shortest interval the drift is measured over in ms
+#define CLOCK_MAX_DRIFT         1000                                        //Largest drift that is corrected in ppm
+#define CLOCK_MAX_SLEW          1000                                        //Larger offsets are steps, not drift, in ms
+#define CLOCK_RESOLVE_TIMEOUTS  3                                           //Lost replies in a row before the server name is looked up again
+
+class ClockService {
+	public:
+        ClockService();
+
+        void begin(UDP* udp, const char* server = NTP_DEFAULT_SERVER, uint16_t serverPort = NTP_PORT, uint16_t localPort = NTP_LOCAL_PORT);
+
+        /* Config functions */
+        void setSyncInterval(uint32_t interval);
+        void setReplyTimeout(uint32_t timeout);
+        void setTimeOffset(int32_t offset);
+
+        bool update(uint32_t nowMs);
+
+        /* Getters */
+        bool isSynced();
+        uint32_t getEpochTime(uint32_t nowMs);
+        uint16_t getMillis(uint32_t nowMs);
+        Time getTime(uint32_t nowMs);
+        uint32_t getTimeToUpdate(uint32_t nowMs);
+
+        /* Statistics */
+        uint32_t getSyncAge(uint32_t nowMs);
+        int32_t getDrift();
+        int32_t getLastOffset();
+        uint32_t getRoundTrip();
+        uint32_t getNumSyncs();
+        uint32_t getNumTimeouts();
+        uint32_t getNumRejected();
+
+	private:
+        void _sendRequest(uint32_t nowMs);
+        bool _receive(uint32_t nowMs);
+        void _now(uint32_t nowMs, uint32_t& seconds, uint16_t& millis);
+
+        UDP* _udp;
+        const char* _server;
+        uint16_t _serverPort;
+        IPAddress _serverIP;                                                //Address of the last reply, saves a DNS lookup per request
+        bool _resolved;                                                     //_serverIP is valid
+        uint8_t _numLost;                                                   //Replies lost in a row
+        int32_t _timeOffset;                                                //Time zone in seconds
+        uint32_t _syncInterval;
+        uint32_t _replyTimeout;
+
+        bool _waiting;                                                      //Request sent, no reply yet
+        uint32_t _sentAt;                                                   //Local time of the request in ms
+        uint32_t _nextSyncAt;
+        uint32_t _requestId;                                                //Echoed by the server, rejects stale replies
+
+        /* Time at the last synchronisation, interpolated from there */
+        bool _synced;
+        uint32_t _syncedAt;                                                 //Local time in ms
+        uint32_t _baseSeconds;                                              //Unix time
+        uint16_t _baseMillis;
+        int32_t _drift;                                                     //Correction of the local counter in ppm
+
+        int32_t _lastOffset;                                                //Measured minus interpolated time at the last sync in ms
+        uint32_t _roundTrip;
+        uint32_t _numSyncs;
+        uint32_t _numTimeouts;
+        uint32_t _numRejected;
+};
+
+#endif /* CLOCK_SERVICE_H */
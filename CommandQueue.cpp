@@ -0,0 +1,99 @@
+/*
+ * File:      CommandQueue.cpp
+ * Authors:   Luke de Munk
+ * Class:     CommandQueue
+ *
+ * Lock-free ring of display commands, many producers and one consumer.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "CommandQueue.h"
+
+/**************************************************************************/
+/*!
+  @brief    Constructor, every slot free for its first round.
+*/
+/**************************************************************************/
+CommandQueue::CommandQueue() {
+    for (uint32_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _head.store(0, std::memory_order_relaxed);
+    _tail = 0;
+    _numDropped.store(0, std::memory_order_relaxed);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Adds a command. Safe to call from any task or core at the same
+            time, never blocks.
+  @param    command         Command to add
+  @returns  True if added, false if the queue is full
+*/
+/**************************************************************************/
+bool CommandQueue::push(const DisplayCommand& command) {
+    uint32_t position = _head.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    while (true) {
+        slot = &_slots[position & (COMMAND_QUEUE_SIZE - 1)];
+        int32_t difference = (int32_t) (slot->sequence.load(std::memory_order_acquire) - position);
+
+        if (difference == 0) {
+            /* Slot is free in this round, claim it; on failure position is reloaded */
+            if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            _numDropped.fetch_add(1, std::memory_order_relaxed);            //Consumer has not read it yet
+            return false;
+        } else {
+            position = _head.load(std::memory_order_relaxed);               //Claimed by another producer
+        }
+    }
+
+    slot->command = command;
+    slot->sequence.store(position + 1, std::memory_order_release);         //Publish
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Takes the oldest command. Only call it from one task.
+  @param    command         Command taken
+  @returns  True if a command has been taken, false if the queue is empty
+*/
+/**************************************************************************/
+bool CommandQueue::pop(DisplayCommand& command) {
+    Slot& slot = _slots[_tail & (COMMAND_QUEUE_SIZE - 1)];
+
+    if (slot.sequence.load(std::memory_order_acquire) != _tail + 1) {
+        return false;                                                       //Not published yet
+    }
+
+    command = slot.command;
+    slot.sequence.store(_tail + COMMAND_QUEUE_SIZE, std::memory_order_release); //Free for the next round
+    _tail++;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if there is no published command. Consumer only.
+  @returns  True if empty
+*/
+/**************************************************************************/
+bool CommandQueue::isEmpty() {
+    return _slots[_tail & (COMMAND_QUEUE_SIZE - 1)].sequence.load(std::memory_order_acquire) != _tail + 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how many commands push() refused because the queue was
+            full.
+  @returns  Number of refused commands
+*/
+/**************************************************************************/
+uint32_t CommandQueue::getNumDropped() {
+    return _numDropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+/*
+ * File:      CommandQueue.h
+ * Authors:   Luke de Munk
+ * Class:     CommandQueue
+ *
+ * Lock-free ring of display commands, from any number of producers (for
+ * example the tasks of the web server) to one consumer (the render loop).
+ * Every slot has a sequence number: producers claim a slot by moving the
+ * head with compare-and-swap and publish it by setting its sequence, so
+ * nobody ever waits for a lock. When the ring is full push() fails
+ * instead of blocking. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+#include <atomic>
+#include <Arduino.h>
+
+#define COMMAND_QUEUE_SIZE      16                                          //Slots, a power of 2
+
+struct DisplayCommand {
+    uint8_t type;
+    uint32_t value;
+};
+
+class CommandQueue {
+	public:
+        CommandQueue();
+
+        bool push(const DisplayCommand& command);
+        bool pop(DisplayCommand& command);
+
+        /* Getters */
+        bool isEmpty();
+        uint32_t getNumDropped();
+
+	private:
+        struct Slot {
+            std::atomic<uint32_t> sequence;                                 //Position it can be claimed at, +1 when filled
+            DisplayCommand command;
+        };
+
+        Slot _slots[COMMAND_QUEUE_SIZE];
+        std::atomic<uint32_t> _head;                                        //Next position to claim, producers
+        uint32_t _tail;                                                     //Next position to read, consumer only
+        std::atomic<uint32_t> _numDropped;
+};
+
+#endif /* COMMAND_QUEUE_H */
@@ -0,0 +1,318 @@
+/*
+ * File:      Compositor.cpp
+ * Authors:   Luke de Munk
+ * Class:     Compositor
+ *
+ * Layered drawing for a MAX7219CWGMatrix. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "Compositor.h"
+
+/**************************************************************************/
+/*!
+  @brief    Loads a 32-bit word of a layer. Through memcpy, the layers are
+            bytes.
+  @param    data            First byte of the word
+  @returns  Word
+*/
+/**************************************************************************/
+static uint32_t loadWord(const uint8_t* data) {
+    uint32_t word;
+    memcpy(&word, data, 4);
+    return word;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Stores a 32-bit word into a layer.
+  @param    data            First byte of the word
+  @param    word            Word
+*/
+/**************************************************************************/
+static void storeWord(uint8_t* data, uint32_t word) {
+    memcpy(data, &word, 4);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+Compositor::Compositor() {
+    _matrix = nullptr;
+    _memory = nullptr;
+    _frameSize = 0;
+    _numLayers = 0;
+    _activeLayer = MAX_LAYERS;
+
+    for (uint8_t layer = 0; layer < MAX_LAYERS; layer++) {
+        _rasterOps[layer] = RASTER_OP_OR;
+        _static[layer] = false;
+        _valid[layer] = false;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the layers.
+*/
+/**************************************************************************/
+Compositor::~Compositor() {
+    free(_memory);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the matrix and allocates the layers. Layer 0 is copied,
+            the others are OR-ed on top of it. All layers are dynamic.
+  @param    matrix          Matrix to compose on
+  @param    numLayers       Number of layers (1 to MAX_LAYERS)
+  @returns  True if the layers could be allocated
+*/
+/**************************************************************************/
+bool Compositor::begin(MAX7219CWGMatrix* matrix, uint8_t numLayers) {
+    if (numLayers == 0 || numLayers > MAX_LAYERS) {
+        debugln("ERROR: Number of layers out of range.");
+        return false;
+    }
+
+    if (_activeLayer != MAX_LAYERS) {
+        endLayer();
+    }
+    free(_memory);
+
+    _matrix = matrix;
+    _frameSize = matrix->getFrameSize();
+    _numLayers = numLayers;
+
+    /* One block: the layers and the output frame, rounded to whole words */
+    _frameSize = (_frameSize + 3) & ~3;
+    _memory = (uint8_t*) malloc((uint32_t) _frameSize*(numLayers + 1));
+
+    if (_memory == nullptr) {
+        debugln("ERROR: Not enough memory for the layers.");
+        _numLayers = 0;
+        return false;
+    }
+
+    for (uint8_t layer = 0; layer < MAX_LAYERS; layer++) {
+        _rasterOps[layer] = layer == 0 ? RASTER_OP_COPY : RASTER_OP_OR;
+        _static[layer] = false;
+        _valid[layer] = false;
+    }
+    memset(_memory, 0, (uint32_t) _frameSize*(numLayers + 1));
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets how a layer is combined with the layers below it.
+  @param    layer           Layer
+  @param    rasterOp        RASTER_OP_COPY, _OR, _AND, _XOR or _MASK
+*/
+/**************************************************************************/
+void Compositor::setRasterOp(uint8_t layer, uint8_t rasterOp) {
+    if (layer >= _numLayers || rasterOp > RASTER_OP_MASK) {
+        debugln("ERROR: Layer or raster operation out of range.");
+        return;
+    }
+    _rasterOps[layer] = rasterOp;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets if a layer keeps its pixels between frames. A static layer
+            is only drawn again after it has been invalidated.
+  @param    layer           Layer
+  @param    isStatic        True for static, false to draw every frame
+*/
+/**************************************************************************/
+void Compositor::setStatic(uint8_t layer, bool isStatic) {
+    if (layer >= _numLayers) {
+        debugln("ERROR: Layer out of range.");
+        return;
+    }
+    _static[layer] = isStatic;
+    _valid[layer] = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Makes a static layer be drawn again, for example after the
+            rotation or the screen changed.
+  @param    layer           Layer
+*/
+/**************************************************************************/
+void Compositor::invalidate(uint8_t layer) {
+    if (layer < _numLayers) {
+        _valid[layer] = false;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Makes all static layers be drawn again.
+*/
+/**************************************************************************/
+void Compositor::invalidateAll() {
+    for (uint8_t layer = 0; layer < _numLayers; layer++) {
+        _valid[layer] = false;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Starts drawing in a layer: the draw functions of the matrix
+            draw in the layer until endLayer(). A dynamic layer is cleared
+            first. A static layer that is still valid is left as it is.
+  @param    layer           Layer
+  @returns  True if the layer has to be drawn, false if it is cached
+*/
+/**************************************************************************/
+bool Compositor::beginLayer(uint8_t layer) {
+    if (layer >= _numLayers) {
+        debugln("ERROR: Layer out of range.");
+        return false;
+    }
+
+    if (_activeLayer != MAX_LAYERS) {
+        endLayer();
+    }
+
+    if (_static[layer] && _valid[layer]) {
+        return false;
+    }
+
+    uint8_t* buffer = getLayer(layer);
+    memset(buffer, 0, _frameSize);
+    _matrix->setDrawBuffer(buffer);
+    _activeLayer = layer;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Starts drawing in a layer without clearing it, for widgets that
+            only redraw what changed since the last frame. A layer that
+            does not hold its pixels anymore is cleared first.
+  @param    layer           Layer
+  @returns  True if the layer still holds its pixels, false if it was
+            cleared and everything has to be drawn again
+*/
+/**************************************************************************/
+bool Compositor::editLayer(uint8_t layer) {
+    if (layer >= _numLayers) {
+        debugln("ERROR: Layer out of range.");
+        return false;
+    }
+
+    if (_activeLayer != MAX_LAYERS) {
+        endLayer();
+    }
+
+    bool valid = _valid[layer];
+    uint8_t* buffer = getLayer(layer);
+
+    if (!valid) {
+        memset(buffer, 0, _frameSize);
+    }
+    _matrix->setDrawBuffer(buffer);
+    _activeLayer = layer;
+    return valid;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Stops drawing in the layer, the matrix draws on the display
+            again.
+*/
+/**************************************************************************/
+void Compositor::endLayer() {
+    if (_activeLayer == MAX_LAYERS) {
+        return;
+    }
+
+    _matrix->setDrawBuffer(nullptr);
+    _valid[_activeLayer] = true;
+    _activeLayer = MAX_LAYERS;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Combines the layers bottom to top into the display buffer.
+            Only changed rows are sent by the next display().
+*/
+/**************************************************************************/
+void Compositor::compose() {
+    if (_numLayers == 0) {
+        return;
+    }
+
+    uint8_t* out = getLayer(_numLayers);                                    //Output frame after the layers
+
+    memset(out, 0, _frameSize);
+
+    for (uint8_t layer = 0; layer < _numLayers; layer++) {
+        const uint8_t* in = getLayer(layer);
+
+        switch (_rasterOps[layer]) {
+            case RASTER_OP_COPY:
+                memcpy(out, in, _frameSize);
+                break;
+            case RASTER_OP_OR:
+                for (uint16_t i = 0; i < _frameSize; i += 4) {
+                    storeWord(out + i, loadWord(out + i) | loadWord(in + i));
+                }
+                break;
+            case RASTER_OP_AND:
+                for (uint16_t i = 0; i < _frameSize; i += 4) {
+                    storeWord(out + i, loadWord(out + i) & loadWord(in + i));
+                }
+                break;
+            case RASTER_OP_XOR:
+                for (uint16_t i = 0; i < _frameSize; i += 4) {
+                    storeWord(out + i, loadWord(out + i) ^ loadWord(in + i));
+                }
+                break;
+            case RASTER_OP_MASK:
+                for (uint16_t i = 0; i < _frameSize; i += 4) {
+                    storeWord(out + i, loadWord(out + i) & ~loadWord(in + i));
+                }
+                break;
+        }
+    }
+    _matrix->loadFrame(out);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of layers.
+  @returns  _numLayers      Number of layers
+*/
+/**************************************************************************/
+uint8_t Compositor::getNumLayers() {
+    return _numLayers;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a static layer still holds its pixels.
+  @param    layer           Layer
+  @returns  True if valid
+*/
+/**************************************************************************/
+bool Compositor::isValid(uint8_t layer) {
+    return layer < _numLayers && _valid[layer];
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the pixels of a layer, laid out like the display
+            buffer.
+  @param    layer           Layer
+  @returns  Pointer to the layer
+*/
+/**************************************************************************/
+uint8_t* Compositor::getLayer(uint8_t layer) {
+    return _memory + (uint32_t) layer*_frameSize;
+}
@@ -0,0 +1,63 @@
+/*
+ * File:      Compositor.h
+ * Authors:   Luke de Munk
+ * Class:     Compositor
+ *
+ * Layered drawing for a MAX7219CWGMatrix. Every layer is a 1 bit per
+ * pixel frame with the layout of the display buffer. Static layers keep
+ * their pixels until they are invalidated, so a screen only redraws what
+ * changed. compose() combines the layers with their raster operation,
+ * a word at a time, into the display buffer. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+#include "MAX7219CWGMatrix.h"
+#include "Debugger.h"                                                       //For serial debugging
+
+#define MAX_LAYERS              4
+
+/* Default layers, bottom to top */
+#define LAYER_BACKGROUND        0
+#define LAYER_CONTENT           1
+#define LAYER_OVERLAY           2
+
+class Compositor {
+	public:
+        Compositor();
+        ~Compositor();
+        Compositor(const Compositor&) = delete;
+        Compositor& operator=(const Compositor&) = delete;
+
+        bool begin(MAX7219CWGMatrix* matrix, uint8_t numLayers = 3);
+
+        /* Config functions */
+        void setRasterOp(uint8_t layer, uint8_t rasterOp);
+        void setStatic(uint8_t layer, bool isStatic);
+        void invalidate(uint8_t layer);
+        void invalidateAll();
+
+        /* Draw functions */
+        bool beginLayer(uint8_t layer);
+        bool editLayer(uint8_t layer);
+        void endLayer();
+        void compose();
+
+        /* Getters */
+        uint8_t getNumLayers();
+        bool isValid(uint8_t layer);
+        uint8_t* getLayer(uint8_t layer);
+
+	private:
+        MAX7219CWGMatrix* _matrix;
+        uint8_t* _memory;                                                   //Layers followed by the output frame
+        uint16_t _frameSize;
+        uint8_t _numLayers;
+        uint8_t _activeLayer;                                               //Layer drawn in, MAX_LAYERS if none
+
+        uint8_t _rasterOps[MAX_LAYERS];
+        bool _static[MAX_LAYERS];
+        bool _valid[MAX_LAYERS];                                            //Static layer still holds its pixels
+};
+
+#endif /* COMPOSITOR_H */
@@ -0,0 +1,299 @@
+/*
+ * File:      DigitalClock.cpp
+ * Authors:   Luke de Munk
+ * Class:     DigitalClock
+ *
+ * Digital clock that only redraws the digits that changed. For more
+ * info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "DigitalClock.h"
+
+/**************************************************************************/
+/*!
+  @brief    Constructor, call begin() before drawing.
+*/
+/**************************************************************************/
+DigitalClock::DigitalClock() {
+    _matrix = nullptr;
+    _numerals = nullptr;
+    _numeralSize = 0;
+    _height = 0;
+    _value = 1;
+    _numCellsDrawn = 0;
+    invalidate();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the numerals.
+*/
+/**************************************************************************/
+DigitalClock::~DigitalClock() {
+    free(_numerals);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the region of the clock. With DIGITAL_CLOCK_FONT the
+            glyphs of the font that is set are drawn, call begin() again
+            after changing the font. Otherwise seven-segment numerals of
+            the given height are rendered into bitmaps once. If there is
+            no memory for them, the glyphs of the font are drawn instead.
+  @param    matrix          Matrix to draw on
+  @param    x               X coordinate of leftest column of leds
+  @param    y               Y coordinate of lowest row of leds
+  @param    height          DIGITAL_CLOCK_FONT, height of the numerals in
+                            pixels, or DIGITAL_CLOCK_FULL_HEIGHT for
+                            numerals up to the last row of the display
+  @returns  True if the numerals could be rendered
+*/
+/**************************************************************************/
+bool DigitalClock::begin(MAX7219CWGMatrix* matrix, int16_t x, int16_t y, uint8_t height) {
+    _matrix = matrix;
+    _y = y;
+    _numCellsDrawn = 0;
+    free(_numerals);
+    _numerals = nullptr;
+    invalidate();
+
+    if (height == DIGITAL_CLOCK_FULL_HEIGHT) {
+        height = matrix->getHeight() > y ? min(matrix->getHeight() - y, 254) : 0;
+    }
+
+    if (height == DIGITAL_CLOCK_FONT) {
+        _height = matrix->getFontRows();
+        _digitWidth = matrix->getFontCols();
+        _colonWidth = _digitWidth;
+        _thickness = 1;                                                     //Same spacing as drawString()
+    } else {
+        if (height < DIGITAL_CLOCK_MIN_HEIGHT) {
+            debugln("ERROR: Numerals too small, using the minimum height.");
+            height = DIGITAL_CLOCK_MIN_HEIGHT;
+        }
+
+        /* Proportions of a seven-segment display: half as wide as high */
+        _height = height;
+        _thickness = (height + 5) / 10;
+        _digitWidth = height/2 + _thickness;
+        _colonWidth = _thickness;
+    }
+
+    /* Cells are HH:MM:SS, one segment thickness apart */
+    _cellX[0] = x;
+    for (uint8_t cell = 1; cell < DIGITAL_CLOCK_CELLS; cell++) {
+        _cellX[cell] = _cellX[cell-1] + _cellWidth(cell-1) + _thickness;
+    }
+
+    if (height == DIGITAL_CLOCK_FONT) {
+        return true;
+    }
+
+    /* Cells sized for numerals that do not exist would be drawn wrong */
+    if (!_renderNumerals()) {
+        debugln("ERROR: Using the font for the digital clock.");
+        begin(matrix, x, y, DIGITAL_CLOCK_FONT);
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Forgets what has been drawn, the next draw() draws every cell.
+            Call it when the region has been cleared or drawn over.
+*/
+/**************************************************************************/
+void DigitalClock::invalidate() {
+    memset(_shown, 0, sizeof(_shown));
+    _numShown = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the time, only the cells of which the character changed
+            are cleared and drawn again.
+  @param    hour            Hour
+  @param    minute          Minute
+  @param    second          Second, 255 to leave it out
+  @param    value           Value to fill (0-1)
+  @returns  Number of cells drawn
+*/
+/**************************************************************************/
+uint8_t DigitalClock::draw(uint8_t hour, uint8_t minute, uint8_t second, uint8_t value) {
+    if (_matrix == nullptr) {
+        debugln("ERROR: Call begin() before drawing the clock.");
+        return 0;
+    }
+
+    char text[DIGITAL_CLOCK_CELLS];
+    uint8_t length = TextFormat::time(text, hour, minute, second);
+    uint8_t drawn = 0;
+
+    if (value != _value) {
+        invalidate();                                                       //Every cell changes colour
+        _value = value;
+    }
+
+    for (uint8_t cell = 0; cell < length; cell++) {
+        if (text[cell] != _shown[cell]) {
+            _drawCell(cell, text[cell], value);
+            _shown[cell] = text[cell];
+            drawn++;
+        }
+    }
+
+    /* The seconds are left out, clear their cells */
+    for (uint8_t cell = length; cell < _numShown; cell++) {
+        _matrix->drawFillRectangle(_cellX[cell], _y, _cellWidth(cell), _height, !value);
+        _shown[cell] = 0;
+        drawn++;
+    }
+    _numShown = length;
+    _numCellsDrawn += drawn;
+    return drawn;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width of the clock.
+  @param    withSeconds     True for HH:MM:SS, false for HH:MM
+  @returns  Width in pixels
+*/
+/**************************************************************************/
+uint16_t DigitalClock::getWidth(bool withSeconds) {
+    uint8_t last = withSeconds ? TIME_SECONDS_LENGTH-1 : TIME_LENGTH-1;
+    return _cellX[last] + _cellWidth(last) - _cellX[0];
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the height of the clock.
+  @returns  _height         Height in pixels
+*/
+/**************************************************************************/
+uint8_t DigitalClock::getHeight() {
+    return _height;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how many cells have been drawn since begin.
+  @returns  _numCellsDrawn  Number of cells
+*/
+/**************************************************************************/
+uint32_t DigitalClock::getNumCellsDrawn() {
+    return _numCellsDrawn;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Renders the numerals 0 to 9 and the colon into bitmaps with
+            the layout of drawBitmap(), so a cell is drawn in one call.
+  @returns  True if the numerals could be allocated
+*/
+/**************************************************************************/
+bool DigitalClock::_renderNumerals() {
+    uint8_t stride = (_digitWidth + 7) / 8;
+    uint8_t t = _thickness;
+    uint8_t w = _digitWidth;
+    uint8_t h = _height;
+    uint8_t middle = (h - t) / 2;                                           //Top row of segment g
+
+    _numeralSize = stride*h;
+    _numerals = (uint8_t*) malloc(DIGITAL_CLOCK_NUMERALS*_numeralSize);
+
+    if (_numerals == nullptr) {
+        debugln("ERROR: Not enough memory for the numerals.");
+        return false;
+    }
+    memset(_numerals, 0, DIGITAL_CLOCK_NUMERALS*_numeralSize);
+
+    /* Segments a to g: x, y, w, h. The vertical ones overlap the horizontal ones */
+    const uint8_t segments[7][4] = {
+        {0, 0, w, t},                                                       //a, top
+        {(uint8_t) (w-t), 0, t, (uint8_t) (middle+t)},                      //b, top right
+        {(uint8_t) (w-t), middle, t, (uint8_t) (h-middle)},                 //c, bottom right
+        {0, (uint8_t) (h-t), w, t},                                         //d, bottom
+        {0, middle, t, (uint8_t) (h-middle)},                               //e, bottom left
+        {0, 0, t, (uint8_t) (middle+t)},                                    //f, top left
+        {0, middle, w, t}                                                   //g, middle
+    };
+
+    for (uint8_t digit = 0; digit < 10; digit++) {
+        uint8_t on = pgm_read_byte(SevenSegmentDigits + digit);
+
+        for (uint8_t segment = 0; segment < 7; segment++) {
+            if (on & (1 << segment)) {
+                _fillNumeral(_numerals + digit*_numeralSize, stride, segments[segment][0], segments[segment][1], segments[segment][2], segments[segment][3]);
+            }
+        }
+    }
+
+    /* The colon is t wide, its dots are as far from the middle as from the ends */
+    uint8_t dot = (middle - t + 1) / 2;
+    uint8_t* colon = _numerals + DIGITAL_CLOCK_COLON*_numeralSize;
+    uint8_t colonStride = (_colonWidth + 7) / 8;
+    _fillNumeral(colon, colonStride, 0, dot, t, t);
+    _fillNumeral(colon, colonStride, 0, h - dot - t, t, t);
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Turns on a rectangle of pixels of a numeral.
+  @param    numeral         Packed rows of the numeral
+  @param    stride          Bytes per row
+  @param    x               First column of the rectangle
+  @param    y               First row of the rectangle
+  @param    w               Width
+  @param    h               Height
+*/
+/**************************************************************************/
+void DigitalClock::_fillNumeral(uint8_t* numeral, uint8_t stride, uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+    for (uint8_t row = y; row < y + h; row++) {
+        for (uint8_t column = x; column < x + w; column++) {
+            numeral[row*stride + column/8] |= 0x80 >> (column % 8);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Clears a cell and draws a character in it.
+  @param    cell            Cell, 0 is the first digit of the hour
+  @param    character       Digit or colon
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void DigitalClock::_drawCell(uint8_t cell, char character, uint8_t value) {
+    int16_t x = _cellX[cell];
+    uint8_t w = _cellWidth(cell);
+
+    if (_numerals == nullptr) {
+        _matrix->drawFillRectangle(x, _y, w, _height, !value);
+        _matrix->drawChar(x, _y, character, value);
+        return;
+    }
+
+    const uint8_t* numeral = _numerals + (character == ':' ? DIGITAL_CLOCK_COLON : character - '0')*_numeralSize;
+
+    /* A copy clears the cell too; dark numerals are cut out of a lit cell */
+    if (value) {
+        _matrix->drawBitmap(x, _y, numeral, w, _height, RASTER_OP_COPY);
+    } else {
+        _matrix->drawFillRectangle(x, _y, w, _height, 1);
+        _matrix->drawBitmap(x, _y, numeral, w, _height, RASTER_OP_MASK);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width of a cell.
+  @param    cell            Cell, 0 is the first digit of the hour
+  @returns  Width in pixels
+*/
+/**************************************************************************/
+uint8_t DigitalClock::_cellWidth(uint8_t cell) {
+    return cell == 2 || cell == 5 ? _colonWidth : _digitWidth;
+}
@@ -0,0 +1,75 @@
+/*
+ * File:      DigitalClock.h
+ * Authors:   Luke de Munk
+ * Class:     DigitalClock
+ *
+ * Digital clock for a region of a MAX7219CWGMatrix that only redraws the
+ * digits that changed. It remembers the character in every cell, so
+ * usually only the last digit is cleared and drawn again and only its
+ * rows are sent by the next display(). Draws the glyphs of the font, or
+ * big seven-segment numerals that are rendered once into bitmaps. For
+ * more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef DIGITAL_CLOCK_H
+#define DIGITAL_CLOCK_H
+#include "MAX7219CWGMatrix.h"
+#include "TextFormat.h"
+#include "Debugger.h"                                                       //For serial debugging
+
+#define DIGITAL_CLOCK_FONT          0                                       //Height: glyphs of the font of the matrix
+#define DIGITAL_CLOCK_FULL_HEIGHT   255                                     //Height: numerals up to the last row of the display
+#define DIGITAL_CLOCK_MIN_HEIGHT    5                                       //Smallest numerals
+#define DIGITAL_CLOCK_CELLS         TIME_SECONDS_LENGTH                     //HH:MM:SS
+#define DIGITAL_CLOCK_NUMERALS      11                                      //0 to 9 and the colon
+#define DIGITAL_CLOCK_COLON         10                                      //Numeral of the colon
+
+/* Segments of the numerals 0 to 9, bit 0 is the top segment (a) and clockwise to bit 5 (f), bit 6 is the middle one (g) */
+const uint8_t SevenSegmentDigits[10] PROGMEM = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+};
+
+class DigitalClock {
+	public:
+        DigitalClock();
+        ~DigitalClock();
+        DigitalClock(const DigitalClock&) = delete;
+        DigitalClock& operator=(const DigitalClock&) = delete;
+
+        bool begin(MAX7219CWGMatrix* matrix, int16_t x, int16_t y, uint8_t height = DIGITAL_CLOCK_FONT);
+
+        /* Config functions */
+        void invalidate();
+
+        /* Draw functions */
+        uint8_t draw(uint8_t hour, uint8_t minute, uint8_t second = 255, uint8_t value = 1);
+
+        /* Getters */
+        uint16_t getWidth(bool withSeconds);
+        uint8_t getHeight();
+        uint32_t getNumCellsDrawn();
+
+	private:
+        bool _renderNumerals();
+        void _fillNumeral(uint8_t* numeral, uint8_t stride, uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+        void _drawCell(uint8_t cell, char character, uint8_t value);
+        uint8_t _cellWidth(uint8_t cell);
+
+        MAX7219CWGMatrix* _matrix;
+        int16_t _cellX[DIGITAL_CLOCK_CELLS];                                //Left column of every cell
+        int16_t _y;
+        uint8_t _height;
+        uint8_t _digitWidth;
+        uint8_t _colonWidth;
+        uint8_t _thickness;                                                 //Of a segment, 1 with the font
+
+        uint8_t* _numerals;                                                 //Rendered numerals, nullptr with the font
+        uint16_t _numeralSize;                                              //Bytes per numeral
+
+        char _shown[DIGITAL_CLOCK_CELLS];                                   //Character drawn in every cell, 0 if empty
+        uint8_t _numShown;
+        uint8_t _value;
+        uint32_t _numCellsDrawn;
+};
+
+#endif /* DIGITAL_CLOCK_H */
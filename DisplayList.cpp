@@ -0,0 +1,756 @@
+/*
+ * File:      DisplayList.cpp
+ * Authors:   Luke de Munk
+ * Class:     DisplayList
+ *
+ * Recorded draw calls of a MAX7219CWGMatrix, to replay, cull and save.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "DisplayList.h"
+
+/* Number of arguments per opcode */
+static const uint8_t NumArgs[DISPLAY_LIST_OPCODES] = {
+    0,                                                                      //Unused
+    2, 4, 4, 4, 5, 3, 3, 4, 4, 3, 3, 6, 6,                                  //Pixel to fill triangle
+    2, 3, 2, 5,                                                             //Char, row, string, bitmap
+    0, 0                                                                    //Clear, font
+};
+
+/* A command during cull() */
+struct CullEntry {
+    uint32_t offset;
+    int16_t box[4];                                                         //Left, top, right, bottom, inclusive
+    bool hasBox;
+    bool keep;
+};
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+DisplayList::DisplayList() {
+    _matrix = nullptr;
+    _commands = nullptr;
+    _ownsMemory = false;
+    _size = 0;
+    _length = 0;
+    _numCommands = 0;
+    _recording = false;
+    _overflowed = false;
+    _numSegmentsHorizontal = 0;
+    _numSegmentsVertical = 0;
+    _rotation = STANDARD_ROTATION;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, stops recording and frees the memory if it was
+            allocated by the class.
+*/
+/**************************************************************************/
+DisplayList::~DisplayList() {
+    stopRecording();
+    if (_ownsMemory) {
+        free(_commands);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Initialiser.
+  @param    matrix          Matrix to record and replay
+  @param    size            Bytes for commands
+  @param    buffer          Memory of size bytes to use, nullptr to
+                            allocate it once
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool DisplayList::begin(MAX7219CWGMatrix* matrix, uint32_t size, uint8_t* buffer) {
+    stopRecording();
+    if (_ownsMemory) {
+        free(_commands);
+    }
+
+    _matrix = matrix;
+    _commands = buffer;
+    _ownsMemory = false;
+    _size = size;
+
+    if (_commands == nullptr) {
+        _commands = (uint8_t*) malloc(size);
+        _ownsMemory = true;
+    }
+
+    if (_commands == nullptr) {
+        debugln("ERROR: Not enough memory for the display list.");
+        _ownsMemory = false;
+        _size = 0;
+    }
+
+    reset();
+    return _commands != nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Empties the list and records the draw calls of the matrix from
+            now on, instead of drawing them. Starts with the current font.
+*/
+/**************************************************************************/
+void DisplayList::startRecording() {
+    if (_matrix == nullptr) {
+        debugln("ERROR: Need to call begin() before recording.");
+        return;
+    }
+
+    reset();
+    _numSegmentsHorizontal = _matrix->getSegmentsHorizontal();
+    _numSegmentsVertical = _matrix->getSegmentsVertical();
+    _rotation = _matrix->getRotation();
+
+    record(DISPLAY_LIST_FONT, _matrix->getFont(), nullptr, 0);
+    _matrix->setDisplayList(this);
+    _recording = true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Lets the matrix draw again.
+*/
+/**************************************************************************/
+void DisplayList::stopRecording() {
+    if (_recording) {
+        _matrix->setDisplayList(nullptr);
+        _recording = false;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Removes all commands.
+*/
+/**************************************************************************/
+void DisplayList::reset() {
+    _length = 0;
+    _numCommands = 0;
+    _overflowed = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Adds a command, called by the draw functions of the matrix.
+  @param    opcode          DISPLAY_LIST_PIXEL ... DISPLAY_LIST_FONT
+  @param    value           Value, raster op or font
+  @param    args            Arguments
+  @param    numArgs         Number of arguments
+  @param    data            Bytes after the arguments, may be in flash
+  @param    dataLength      Number of bytes
+  @param    data2           More bytes after those, for example a mask
+  @param    data2Length     Number of bytes
+  @returns  True if added, false if the list is full
+*/
+/**************************************************************************/
+bool DisplayList::record(uint8_t opcode, uint8_t value, const int16_t args[], uint8_t numArgs, const uint8_t* data, uint16_t dataLength, const uint8_t* data2, uint16_t data2Length) {
+    uint32_t length = DISPLAY_LIST_COMMAND_HEADER + 2*numArgs + dataLength + data2Length;
+
+    if (_overflowed) {
+        return false;
+    }
+    if (_length + length > _size || length > 0xFFFF || _numCommands == 0xFFFF) {
+        debugln("ERROR: Display list full, commands are lost.");
+        _overflowed = true;
+        return false;
+    }
+
+    uint8_t* command = _commands + _length;
+    *command++ = opcode;
+    *command++ = value;
+    *command++ = length & 0xFF;
+    *command++ = length >> 8;
+
+    for (uint8_t i = 0; i < numArgs; i++) {
+        *command++ = args[i] & 0xFF;
+        *command++ = (uint16_t) args[i] >> 8;
+    }
+    for (uint16_t i = 0; i < dataLength; i++) {
+        *command++ = pgm_read_byte(data + i);
+    }
+    for (uint16_t i = 0; i < data2Length; i++) {
+        *command++ = pgm_read_byte(data2 + i);
+    }
+
+    _length += length;
+    _numCommands++;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the commands on the matrix, exactly like the recorded
+            calls did. Leaves the matrix in the last recorded font.
+*/
+/**************************************************************************/
+void DisplayList::replay() {
+    if (_matrix == nullptr) {
+        return;
+    }
+    if (_recording) {
+        _matrix->setDisplayList(nullptr);                                   //Draw, do not record the list into itself
+    }
+
+    for (uint32_t offset = 0; offset < _length; offset += _commands[offset + 2] | _commands[offset + 3] << 8) {
+        const uint8_t* command = _commands + offset;
+        const uint8_t* data = command + DISPLAY_LIST_COMMAND_HEADER + 2*NumArgs[command[0]];
+        uint8_t value = command[1];
+
+        switch (command[0]) {
+            case DISPLAY_LIST_PIXEL:
+                _matrix->drawPixel(_arg(command, 0), _arg(command, 1), value);
+                break;
+            case DISPLAY_LIST_LINE:
+                _matrix->drawLine(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), value);
+                break;
+            case DISPLAY_LIST_LINE_ANGLE:
+                _matrix->drawLineAngle(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), value);
+                break;
+            case DISPLAY_LIST_LINE_FINE_ANGLE:
+                _matrix->drawLineFineAngle(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), value);
+                break;
+            case DISPLAY_LIST_ARC:
+                _matrix->drawArc(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), _arg(command, 4), value);
+                break;
+            case DISPLAY_LIST_VLINE:
+                _matrix->drawVLine(_arg(command, 0), _arg(command, 1), _arg(command, 2), value);
+                break;
+            case DISPLAY_LIST_HLINE:
+                _matrix->drawHLine(_arg(command, 0), _arg(command, 1), _arg(command, 2), value);
+                break;
+            case DISPLAY_LIST_RECTANGLE:
+                _matrix->drawRectangle(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), value);
+                break;
+            case DISPLAY_LIST_FILL_RECTANGLE:
+                _matrix->drawFillRectangle(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), value);
+                break;
+            case DISPLAY_LIST_CIRCLE:
+                _matrix->drawCircle(_arg(command, 0), _arg(command, 1), _arg(command, 2), value);
+                break;
+            case DISPLAY_LIST_FILL_CIRCLE:
+                _matrix->drawFillCircle(_arg(command, 0), _arg(command, 1), _arg(command, 2), value);
+                break;
+            case DISPLAY_LIST_TRIANGLE:
+                _matrix->drawTriangle(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), _arg(command, 4), _arg(command, 5), value);
+                break;
+            case DISPLAY_LIST_FILL_TRIANGLE:
+                _matrix->drawFillTriangle(_arg(command, 0), _arg(command, 1), _arg(command, 2), _arg(command, 3), _arg(command, 4), _arg(command, 5), value);
+                break;
+            case DISPLAY_LIST_CHAR:
+                _matrix->drawChar(_arg(command, 0), _arg(command, 1), data[0], value);
+                break;
+            case DISPLAY_LIST_ROW:
+                _matrix->drawRow(_arg(command, 0), _arg(command, 1), _arg(command, 2), value);
+                break;
+            case DISPLAY_LIST_STRING:
+                _matrix->drawString(_arg(command, 0), _arg(command, 1), (const char*) data, (command + (command[2] | command[3] << 8)) - data, value);
+                break;
+            case DISPLAY_LIST_BITMAP: {
+                uint16_t w = _arg(command, 2);
+                uint16_t h = _arg(command, 3);
+                const uint8_t* mask = _arg(command, 4) ? data + (w + 7)/8*h : nullptr;
+
+                _matrix->drawBitmap(_arg(command, 0), _arg(command, 1), data, w, h, value, mask);
+                break;
+            }
+            case DISPLAY_LIST_CLEAR:
+                _matrix->clear();
+                break;
+            case DISPLAY_LIST_FONT:
+                _matrix->setFont(value);
+                break;
+        }
+    }
+
+    if (_recording) {
+        _matrix->setDisplayList(this);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Removes commands that do not change the result: commands off
+            the display and commands that are completely drawn over by a
+            later clear, filled rectangle or copied bitmap without a mask.
+            Every pixel only depends on its own earlier value, so what is
+            under an opaque area does not matter, whatever is drawn after.
+            Assumes the list is replayed without a draw buffer and with the
+            rotation of the matrix now.
+  @returns  Number of removed commands
+*/
+/**************************************************************************/
+uint16_t DisplayList::cull() {
+    if (_matrix == nullptr || _recording || _numCommands == 0) {
+        return 0;
+    }
+
+    CullEntry* entries = (CullEntry*) malloc(_numCommands*sizeof(CullEntry));
+    if (entries == nullptr) {
+        debugln("ERROR: Not enough memory to cull the display list.");
+        return 0;
+    }
+
+    /* Bounding boxes, characters depend on the font before them */
+    uint8_t font = FONT_3X5;
+    uint16_t i = 0;
+    for (uint32_t offset = 0; offset < _length; offset += _commands[offset + 2] | _commands[offset + 3] << 8, i++) {
+        const uint8_t* command = _commands + offset;
+
+        if (command[0] == DISPLAY_LIST_FONT) {
+            font = command[1];
+        }
+        entries[i].offset = offset;
+        entries[i].hasBox = _bounds(command, font, entries[i].box);
+        entries[i].keep = true;
+    }
+
+    /* From the last command back, remember the opaque areas drawn later */
+    int16_t covers[DISPLAY_LIST_MAX_COVERS][4];
+    uint8_t numCovers = 0;
+    int16_t width = _matrix->getWidth();
+    int16_t height = _matrix->getHeight();
+
+    for (int32_t c = _numCommands - 1; c >= 0; c--) {
+        CullEntry& entry = entries[c];
+        const uint8_t* command = _commands + entry.offset;
+
+        if (!entry.hasBox) {
+            continue;                                                       //Changes the state, always kept
+        }
+
+        /* Clip to the display */
+        int16_t* box = entry.box;
+        box[0] = max(box[0], (int16_t) 0);
+        box[1] = max(box[1], (int16_t) 0);
+        box[2] = min(box[2], (int16_t) (width - 1));
+        box[3] = min(box[3], (int16_t) (height - 1));
+
+        if (box[0] > box[2] || box[1] > box[3]) {
+            entry.keep = false;
+            continue;
+        }
+
+        for (uint8_t k = 0; k < numCovers; k++) {
+            if (box[0] >= covers[k][0] && box[1] >= covers[k][1] && box[2] <= covers[k][2] && box[3] <= covers[k][3]) {
+                entry.keep = false;
+                break;
+            }
+        }
+        if (!entry.keep) {
+            continue;
+        }
+
+        bool opaque = command[0] == DISPLAY_LIST_CLEAR ||
+                      (command[0] == DISPLAY_LIST_FILL_RECTANGLE && _arg(command, 2) > 0 && _arg(command, 3) > 0) ||
+                      (command[0] == DISPLAY_LIST_BITMAP && command[1] == RASTER_OP_COPY && _arg(command, 4) == 0);
+
+        if (opaque && numCovers < DISPLAY_LIST_MAX_COVERS) {
+            memcpy(covers[numCovers++], box, sizeof(covers[0]));
+        }
+    }
+
+    /* Move the kept commands together */
+    uint32_t length = 0;
+    uint16_t numCommands = 0;
+    for (i = 0; i < _numCommands; i++) {
+        uint8_t* command = _commands + entries[i].offset;
+        uint16_t commandLength = command[2] | command[3] << 8;
+
+        if (entries[i].keep) {
+            memmove(_commands + length, command, commandLength);
+            length += commandLength;
+            numCommands++;
+        }
+    }
+    free(entries);
+
+    uint16_t numCulled = _numCommands - numCommands;
+    _length = length;
+    _numCommands = numCommands;
+    return numCulled;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes the list in the file layout.
+  @param    buffer          Buffer of getSerialisedSize() bytes
+  @param    size            Size of the buffer
+  @returns  Bytes written, 0 if the buffer is too small
+*/
+/**************************************************************************/
+uint32_t DisplayList::serialise(uint8_t* buffer, uint32_t size) {
+    if (size < getSerialisedSize()) {
+        debugln("ERROR: Buffer too small for the display list.");
+        return 0;
+    }
+
+    _writeHeader(buffer);
+    memcpy(buffer + DISPLAY_LIST_HEADER, _commands, _length);
+    return getSerialisedSize();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads a list in the file layout, every command is checked.
+  @param    data            List
+  @param    length          Number of bytes
+  @returns  True if successful, on failure the list is empty
+*/
+/**************************************************************************/
+bool DisplayList::deserialise(const uint8_t* data, uint32_t length) {
+    stopRecording();
+
+    if (length < DISPLAY_LIST_HEADER || !_readHeader(data) || DISPLAY_LIST_HEADER + _length != length) {
+        debugln("ERROR: Not a display list, or too large.");
+        reset();
+        return false;
+    }
+
+    memcpy(_commands, data + DISPLAY_LIST_HEADER, _length);
+    return _isValid();
+}
+
+#if defined(ESP32)
+/**************************************************************************/
+/*!
+  @brief    Saves the list to a file.
+  @param    fs              File system, for example SPIFFS
+  @param    path            Path of the file
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool DisplayList::save(fs::FS& fs, const char path[]) {
+    uint8_t header[DISPLAY_LIST_HEADER];
+    File file = fs.open(path, "w");
+
+    if (!file) {
+        debugln("ERROR: Could not create the display list file.");
+        return false;
+    }
+
+    _writeHeader(header);
+    bool success = file.write(header, DISPLAY_LIST_HEADER) == DISPLAY_LIST_HEADER && file.write(_commands, _length) == _length;
+
+    file.close();
+    return success;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Loads a list from a file, every command is checked.
+  @param    fs              File system, for example SPIFFS
+  @param    path            Path of the file
+  @returns  True if successful, on failure the list is empty
+*/
+/**************************************************************************/
+bool DisplayList::load(fs::FS& fs, const char path[]) {
+    uint8_t header[DISPLAY_LIST_HEADER];
+    File file = fs.open(path, "r");
+
+    stopRecording();
+
+    if (!file) {
+        debugln("ERROR: Could not open the display list file.");
+        reset();
+        return false;
+    }
+
+    bool success = file.read(header, DISPLAY_LIST_HEADER) == DISPLAY_LIST_HEADER && _readHeader(header) &&
+                   file.read(_commands, _length) == _length;
+    file.close();
+
+    if (!success) {
+        debugln("ERROR: Not a display list, or too large.");
+        reset();
+        return false;
+    }
+    return _isValid();
+}
+#endif
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the draw calls of the matrix are recorded.
+  @returns  _recording      True if recording
+*/
+/**************************************************************************/
+bool DisplayList::isRecording() {
+    return _recording;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if commands were lost because the list was full.
+  @returns  _overflowed     True if commands were lost
+*/
+/**************************************************************************/
+bool DisplayList::isOverflowed() {
+    return _overflowed;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of commands.
+  @returns  _numCommands    Number of commands
+*/
+/**************************************************************************/
+uint16_t DisplayList::getNumCommands() {
+    return _numCommands;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the bytes used by commands.
+  @returns  _length         Bytes
+*/
+/**************************************************************************/
+uint32_t DisplayList::getLength() {
+    return _length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the bytes available for commands.
+  @returns  _size           Bytes
+*/
+/**************************************************************************/
+uint32_t DisplayList::getSize() {
+    return _size;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the size of the list in the file layout.
+  @returns  Bytes
+*/
+/**************************************************************************/
+uint32_t DisplayList::getSerialisedSize() {
+    return DISPLAY_LIST_HEADER + _length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the horizontal segments of the recording display.
+  @returns  _numSegmentsHorizontal  Number of segments
+*/
+/**************************************************************************/
+uint8_t DisplayList::getSegmentsHorizontal() {
+    return _numSegmentsHorizontal;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the vertical segments of the recording display.
+  @returns  _numSegmentsVertical    Number of segments
+*/
+/**************************************************************************/
+uint8_t DisplayList::getSegmentsVertical() {
+    return _numSegmentsVertical;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the rotation of the recording display.
+  @returns  _rotation       Rotation type
+*/
+/**************************************************************************/
+uint8_t DisplayList::getRotation() {
+    return _rotation;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes the file header.
+  @param    header          Buffer of DISPLAY_LIST_HEADER bytes
+*/
+/**************************************************************************/
+void DisplayList::_writeHeader(uint8_t* header) {
+    header[0] = DISPLAY_LIST_MAGIC;
+    header[1] = 'L';
+    header[2] = _numSegmentsHorizontal;
+    header[3] = _numSegmentsVertical;
+    header[4] = _rotation;
+    header[5] = 0;
+    header[6] = _numCommands & 0xFF;
+    header[7] = _numCommands >> 8;
+    header[8] = _length & 0xFF;
+    header[9] = (_length >> 8) & 0xFF;
+    header[10] = (_length >> 16) & 0xFF;
+    header[11] = _length >> 24;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads the file header.
+  @param    header          DISPLAY_LIST_HEADER bytes
+  @returns  True if it is a display list that fits
+*/
+/**************************************************************************/
+bool DisplayList::_readHeader(const uint8_t* header) {
+    uint32_t length = header[8] | header[9] << 8 | (uint32_t) header[10] << 16 | (uint32_t) header[11] << 24;
+
+    reset();
+    if (header[0] != DISPLAY_LIST_MAGIC || header[1] != 'L' || length > _size) {
+        return false;
+    }
+
+    _numSegmentsHorizontal = header[2];
+    _numSegmentsVertical = header[3];
+    _rotation = header[4];
+    _numCommands = header[6] | header[7] << 8;
+    _length = length;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Checks every command of a loaded list, so replay() never reads
+            outside it.
+  @returns  True if valid, otherwise the list is emptied
+*/
+/**************************************************************************/
+bool DisplayList::_isValid() {
+    uint32_t offset = 0;
+    uint16_t numCommands = 0;
+
+    while (offset + DISPLAY_LIST_COMMAND_HEADER <= _length) {
+        const uint8_t* command = _commands + offset;
+        uint16_t length = command[2] | command[3] << 8;
+
+        if (command[0] == 0 || command[0] >= DISPLAY_LIST_OPCODES) {
+            break;
+        }
+
+        /* Bytes after the arguments */
+        uint32_t expected = DISPLAY_LIST_COMMAND_HEADER + 2*NumArgs[command[0]];
+        if (command[0] == DISPLAY_LIST_CHAR) {
+            expected += 1;
+        } else if (command[0] == DISPLAY_LIST_BITMAP && offset + expected <= _length) {
+            int16_t w = _arg(command, 2);
+            int16_t h = _arg(command, 3);
+            expected += w >= 0 && h >= 0 ? (uint32_t) (w + 7)/8*h*(_arg(command, 4) ? 2 : 1) : 0x10000;
+        } else if (command[0] == DISPLAY_LIST_STRING && length >= expected && length - expected <= 0xFF) {
+            expected = length;
+        }
+
+        if (length != expected || offset + length > _length) {
+            break;
+        }
+        offset += length;
+        numCommands++;
+    }
+
+    if (offset != _length || numCommands != _numCommands) {
+        debugln("ERROR: Display list is damaged.");
+        reset();
+        return false;
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns an argument of a command.
+  @param    command         Command
+  @param    index           Argument
+  @returns  Argument
+*/
+/**************************************************************************/
+int16_t DisplayList::_arg(const uint8_t* command, uint8_t index) {
+    const uint8_t* arg = command + DISPLAY_LIST_COMMAND_HEADER + 2*index;
+    return (int16_t) (arg[0] | arg[1] << 8);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the area a command may draw in, in drawing coordinates.
+  @param    command         Command
+  @param    font            Font the command is drawn in
+  @param    box             Returns left, top, right and bottom, inclusive
+  @returns  False if the command does not draw
+*/
+/**************************************************************************/
+bool DisplayList::_bounds(const uint8_t* command, uint8_t font, int16_t box[4]) {
+    int16_t x = NumArgs[command[0]] >= 2 ? _arg(command, 0) : 0;
+    int16_t y = NumArgs[command[0]] >= 2 ? _arg(command, 1) : 0;
+    int16_t points[6] = {x, y, x, y, x, y};                                 //Points the area spans
+    uint8_t fontRows = font == FONT_4X6 ? FONT_4X6_ROWS : font == FONT_5X7 ? FONT_5X7_ROWS : FONT_3X5_ROWS;
+    uint8_t fontCols = font == FONT_4X6 ? FONT_4X6_COLS : font == FONT_5X7 ? FONT_5X7_COLS : FONT_3X5_COLS;
+
+    switch (command[0]) {
+        case DISPLAY_LIST_LINE:
+            points[2] = _arg(command, 2);
+            points[3] = _arg(command, 3);
+            break;
+        case DISPLAY_LIST_LINE_ANGLE:
+            _matrix->getAnglePoint(x, y, _arg(command, 2), ((uint16_t) _arg(command, 3) % 360)*ANGLE_STEPS_PER_DEGREE, points[2], points[3]);
+            break;
+        case DISPLAY_LIST_LINE_FINE_ANGLE:
+            _matrix->getAnglePoint(x, y, _arg(command, 2), _arg(command, 3), points[2], points[3]);
+            break;
+        case DISPLAY_LIST_ARC:
+        case DISPLAY_LIST_CIRCLE:
+        case DISPLAY_LIST_FILL_CIRCLE: {
+            int16_t r = abs(_arg(command, 2));
+            points[0] = x - r;
+            points[1] = y - r;
+            points[2] = x + r;
+            points[3] = y + r;
+            break;
+        }
+        case DISPLAY_LIST_VLINE:
+            points[3] = y + (_arg(command, 2) != 0 ? _arg(command, 2) - 1 : 0);
+            break;
+        case DISPLAY_LIST_HLINE:
+            points[2] = x + (_arg(command, 2) != 0 ? _arg(command, 2) - 1 : 0);
+            break;
+        case DISPLAY_LIST_RECTANGLE:
+        case DISPLAY_LIST_FILL_RECTANGLE:
+        case DISPLAY_LIST_BITMAP:
+            points[2] = x + _arg(command, 2) - 1;
+            points[3] = y + _arg(command, 3) - 1;
+            break;
+        case DISPLAY_LIST_TRIANGLE:
+        case DISPLAY_LIST_FILL_TRIANGLE:
+            for (uint8_t i = 2; i < 6; i++) {
+                points[i] = _arg(command, i);
+            }
+            break;
+        case DISPLAY_LIST_CHAR:
+            points[2] = x + COLUMN_SIZE - 1;                                //A glyph row is drawn as 8 bits
+            points[3] = y + fontRows - 1;
+            break;
+        case DISPLAY_LIST_ROW:
+            points[2] = x + COLUMN_SIZE - 1;
+            break;
+        case DISPLAY_LIST_STRING: {
+            int16_t length = (command[2] | command[3] << 8) - DISPLAY_LIST_COMMAND_HEADER - 2*NumArgs[DISPLAY_LIST_STRING];
+            points[2] = x + max(length - 1, 0)*(fontCols + 1) + COLUMN_SIZE - 1;
+            points[3] = y + fontRows - 1;
+            break;
+        }
+        case DISPLAY_LIST_CLEAR:
+            points[0] = 0;
+            points[1] = 0;
+            points[2] = _matrix->getWidth() - 1;
+            points[3] = _matrix->getHeight() - 1;
+            break;
+        case DISPLAY_LIST_FONT:
+            return false;
+    }
+
+    box[0] = min(points[0], min(points[2], points[4]));
+    box[1] = min(points[1], min(points[3], points[5]));
+    box[2] = max(points[0], max(points[2], points[4]));
+    box[3] = max(points[1], max(points[3], points[5]));
+    return true;
+}
@@ -0,0 +1,124 @@
+/*
+ * File:      DisplayList.h
+ * Authors:   Luke de Munk
+ * Class:     DisplayList
+ *
+ * Records the draw calls of a MAX7219CWGMatrix instead of drawing them,
+ * in a command buffer carved from one block of memory. The list can be
+ * replayed, culled (commands that are off the display or completely
+ * drawn over are removed) and saved to a file, to replay captured frames
+ * bit-exactly somewhere else. Layout, multi-byte values little endian:
+ *
+ *   0  'D' 'L'                         magic
+ *   2  uint8 segments horizontal, uint8 segments vertical
+ *   4  uint8 rotation, uint8 reserved
+ *   6  uint16 count                    number of commands
+ *   8  uint32 length                   bytes of the commands
+ *
+ * Every command:
+ *   0  uint8 opcode                    DISPLAY_LIST_PIXEL ... _FONT
+ *   1  uint8 value                     value, raster op or font
+ *   2  uint16 length                   bytes of the command
+ *   4  int16 arguments                 number depends on the opcode
+ *      data                            characters or bitmap rows
+ *
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+#include "MAX7219CWGMatrix.h"
+#include "Debugger.h"                                                       //For serial debugging
+#if defined(ESP32)
+#include <FS.h>
+#endif
+
+#define DISPLAY_LIST_MAGIC      'D'
+#define DISPLAY_LIST_HEADER     12                                          //Bytes before the first command
+#define DISPLAY_LIST_COMMAND_HEADER 4                                       //Bytes before the arguments of a command
+#define DISPLAY_LIST_MAX_ARGS   6
+#define DISPLAY_LIST_MAX_COVERS 8                                           //Opaque areas cull() keeps track of
+
+/* Opcodes, one per draw function */
+#define DISPLAY_LIST_PIXEL          1
+#define DISPLAY_LIST_LINE           2
+#define DISPLAY_LIST_LINE_ANGLE     3
+#define DISPLAY_LIST_LINE_FINE_ANGLE 4
+#define DISPLAY_LIST_ARC            5
+#define DISPLAY_LIST_VLINE          6
+#define DISPLAY_LIST_HLINE          7
+#define DISPLAY_LIST_RECTANGLE      8
+#define DISPLAY_LIST_FILL_RECTANGLE 9
+#define DISPLAY_LIST_CIRCLE         10
+#define DISPLAY_LIST_FILL_CIRCLE    11
+#define DISPLAY_LIST_TRIANGLE       12
+#define DISPLAY_LIST_FILL_TRIANGLE  13
+#define DISPLAY_LIST_CHAR           14
+#define DISPLAY_LIST_ROW            15
+#define DISPLAY_LIST_STRING         16
+#define DISPLAY_LIST_BITMAP         17                                      //Arguments x, y, w, h, mask flag; rows and mask rows follow
+#define DISPLAY_LIST_CLEAR          18
+#define DISPLAY_LIST_FONT           19
+#define DISPLAY_LIST_OPCODES        20
+
+class DisplayList {
+	public:
+        DisplayList();
+        ~DisplayList();
+        DisplayList(const DisplayList&) = delete;
+        DisplayList& operator=(const DisplayList&) = delete;
+
+        bool begin(MAX7219CWGMatrix* matrix, uint32_t size, uint8_t* buffer = nullptr);
+
+        /* Recording */
+        void startRecording();
+        void stopRecording();
+        void reset();
+        bool record(uint8_t opcode, uint8_t value, const int16_t args[], uint8_t numArgs, const uint8_t* data = nullptr, uint16_t dataLength = 0, const uint8_t* data2 = nullptr, uint16_t data2Length = 0);
+
+        /* Playing */
+        void replay();
+        uint16_t cull();
+
+        /* Files */
+        uint32_t serialise(uint8_t* buffer, uint32_t size);
+        bool deserialise(const uint8_t* data, uint32_t length);
+#if defined(ESP32)
+        bool save(fs::FS& fs, const char path[]);
+        bool load(fs::FS& fs, const char path[]);
+#endif
+
+        /* Getters */
+        bool isRecording();
+        bool isOverflowed();
+        uint16_t getNumCommands();
+        uint32_t getLength();
+        uint32_t getSize();
+        uint32_t getSerialisedSize();
+        uint8_t getSegmentsHorizontal();
+        uint8_t getSegmentsVertical();
+        uint8_t getRotation();
+
+	private:
+        void _writeHeader(uint8_t* header);
+        bool _readHeader(const uint8_t* header);
+        bool _isValid();
+        int16_t _arg(const uint8_t* command, uint8_t index);
+        bool _bounds(const uint8_t* command, uint8_t font, int16_t box[4]);
+
+        MAX7219CWGMatrix* _matrix;
+        uint8_t* _commands;
+        bool _ownsMemory;                                                   //True if allocated by the class
+        uint32_t _size;
+        uint32_t _length;                                                   //Bytes recorded
+        uint16_t _numCommands;
+        bool _recording;
+        bool _overflowed;                                                   //A command did not fit, the list is incomplete
+
+        /* Geometry of the display the list was recorded on */
+        uint8_t _numSegmentsHorizontal;
+        uint8_t _numSegmentsVertical;
+        uint8_t _rotation;
+};
+
+#endif /* DISPLAY_LIST_H */
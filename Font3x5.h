@@ -101,3 +101,105 @@ const uint8_t Font3x5[] = {
 };
 
 const unsigned char FontToIndex3x5[FONT_3X5_SIZE+1] = " !%'()+,-./0123456789:;<=>?ABCDEFGHIJKLMNOPQRSTUVWXYZ[]^_`abcdefghijklmnopqrstuvwxyz{|}";
+
+/* ASCII (32-127) to glyph index, unknown characters are drawn as a space */
+const uint8_t AsciiToIndex3x5[96] PROGMEM = {
+     0,  1,  0,  0,  0,  2,  0,  3,  4,  5,  0,  6,  7,  8,  9, 10,
+    11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26,
+     0, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41,
+    42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53,  0, 54, 55, 56,
+    57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72,
+    73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86,  0,  0,
+};
+
+/* Same glyphs transposed, FONT_3X5_ROWS bytes per glyph from top to bottom row. The leftmost
+ * column is the most significant bit, so a row can be shifted into the display buffer */
+const uint8_t Font3x5Rows[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00,               // (space)
+    0x40, 0x00, 0x40, 0x40, 0x40,               // !
+    0xA0, 0x80, 0x40, 0x20, 0xA0,               // %
+    0x00, 0x00, 0x00, 0x00, 0x40,               // '
+    0x40, 0x80, 0x80, 0x80, 0x40,               // (
+    0x40, 0x20, 0x20, 0x20, 0x40,               // )
+    0x00, 0x40, 0xE0, 0x40, 0x00,               // +
+    0x40, 0x40, 0x00, 0x00, 0x00,               // ,
+    0x00, 0x00, 0xE0, 0x00, 0x00,               // -
+    0x40, 0x00, 0x00, 0x00, 0x00,               // .
+    0x80, 0x40, 0x40, 0x40, 0x20,               // /
+    0xE0, 0xA0, 0xA0, 0xA0, 0xE0,               // 0
+    0x40, 0x40, 0x40, 0x40, 0x40,               // 1
+    0xE0, 0x80, 0xE0, 0x20, 0xE0,               // 2
+    0xE0, 0x20, 0x60, 0x20, 0xE0,               // 3
+    0x20, 0x20, 0xE0, 0xA0, 0xA0,               // 4
+    0xE0, 0x20, 0xE0, 0x80, 0xE0,               // 5
+    0xE0, 0xA0, 0xE0, 0x80, 0xE0,               // 6
+    0x20, 0x20, 0x20, 0x20, 0xE0,               // 7
+    0xE0, 0xA0, 0xE0, 0xA0, 0xE0,               // 8
+    0xE0, 0x20, 0xE0, 0xA0, 0xE0,               // 9
+    0x00, 0x40, 0x00, 0x40, 0x00,               // :
+    0x40, 0x40, 0x00, 0x40, 0x00,               // ;
+    0x20, 0x40, 0x80, 0x40, 0x20,               // <
+    0x00, 0xE0, 0x00, 0xE0, 0x00,               // =
+    0x80, 0x40, 0x20, 0x40, 0x80,               // >
+    0x40, 0x00, 0x40, 0x20, 0x40,               // ?
+    0xA0, 0xA0, 0xE0, 0xA0, 0xE0,               // A
+    0xE0, 0xA0, 0xC0, 0xA0, 0xE0,               // B
+    0xE0, 0x80, 0x80, 0x80, 0xE0,               // C
+    0xC0, 0xA0, 0xA0, 0xA0, 0xC0,               // D
+    0xE0, 0x80, 0xC0, 0x80, 0xE0,               // E
+    0x80, 0x80, 0xC0, 0x80, 0xE0,               // F
+    0xE0, 0xA0, 0xA0, 0x80, 0xE0,               // G
+    0xA0, 0xA0, 0xE0, 0xA0, 0xA0,               // H
+    0x40, 0x40, 0x40, 0x40, 0x40,               // I
+    0xE0, 0x20, 0x20, 0x20, 0x20,               // J
+    0xA0, 0xA0, 0xC0, 0xA0, 0xA0,               // K
+    0xE0, 0x80, 0x80, 0x80, 0x80,               // L
+    0xA0, 0xA0, 0xE0, 0xE0, 0xA0,               // M
+    0xA0, 0xA0, 0xA0, 0xA0, 0xE0,               // N
+    0xE0, 0xA0, 0xA0, 0xA0, 0xE0,               // O
+    0x80, 0x80, 0xE0, 0xA0, 0xE0,               // P
+    0xE0, 0xA0, 0xA0, 0xA0, 0xE0,               // Q
+    0xA0, 0xA0, 0xC0, 0xA0, 0xE0,               // R
+    0xE0, 0x20, 0xE0, 0x80, 0xE0,               // S
+    0x40, 0x40, 0x40, 0x40, 0xE0,               // T
+    0xE0, 0xA0, 0xA0, 0xA0, 0xA0,               // U
+    0x40, 0xA0, 0xA0, 0xA0, 0xA0,               // V
+    0xA0, 0xE0, 0xE0, 0xA0, 0xA0,               // W
+    0xA0, 0xA0, 0x40, 0xA0, 0xA0,               // X
+    0x40, 0x40, 0xE0, 0xA0, 0xA0,               // Y
+    0xE0, 0x80, 0x40, 0x20, 0xE0,               // Z
+    0xC0, 0x80, 0x80, 0x80, 0xC0,               // [
+    0x60, 0x20, 0x20, 0x20, 0x60,               // ]
+    0x00, 0x00, 0x00, 0xA0, 0x40,               // ^
+    0xE0, 0x00, 0x00, 0x00, 0x00,               // _
+    0x00, 0x00, 0x00, 0x20, 0x40,               // `
+    0x60, 0xA0, 0xA0, 0x60, 0x00,               // a
+    0xC0, 0xA0, 0xA0, 0xC0, 0x80,               // b
+    0xE0, 0x80, 0x80, 0xE0, 0x00,               // c
+    0x60, 0xA0, 0xA0, 0x60, 0x20,               // d
+    0x60, 0xC0, 0xA0, 0x40, 0x00,               // e
+    0x40, 0x40, 0xE0, 0x40, 0x60,               // f
+    0x20, 0xE0, 0xA0, 0xE0, 0x00,               // g
+    0xA0, 0xA0, 0xA0, 0xC0, 0x80,               // h
+    0x40, 0x40, 0x40, 0x00, 0x40,               // i
+    0x40, 0x40, 0x40, 0x00, 0x40,               // j
+    0xA0, 0xA0, 0xC0, 0xA0, 0x80,               // k
+    0x40, 0x40, 0x40, 0x40, 0xC0,               // l
+    0xA0, 0xA0, 0xE0, 0xA0, 0x00,               // m
+    0xA0, 0xA0, 0xA0, 0xE0, 0x00,               // n
+    0xE0, 0xA0, 0xA0, 0xE0, 0x00,               // o
+    0xC0, 0xA0, 0xA0, 0xC0, 0x00,               // p
+    0x60, 0xA0, 0xA0, 0x60, 0x00,               // q
+    0x80, 0x80, 0xA0, 0xE0, 0x00,               // r
+    0xC0, 0x20, 0x80, 0x60, 0x00,               // s
+    0x20, 0x40, 0x40, 0xE0, 0x40,               // t
+    0xE0, 0xA0, 0xA0, 0xA0, 0x00,               // u
+    0x40, 0xA0, 0xA0, 0xA0, 0x00,               // v
+    0xA0, 0xE0, 0xA0, 0xA0, 0x00,               // w
+    0xA0, 0xA0, 0x40, 0xA0, 0x00,               // x
+    0x20, 0xE0, 0xA0, 0xA0, 0x00,               // y
+    0xE0, 0x80, 0x20, 0xE0, 0x00,               // z
+    0x60, 0x40, 0x80, 0x40, 0x60,               // {
+    0x40, 0x40, 0x40, 0x40, 0x40,               // |
+    0xC0, 0x40, 0x20, 0x40, 0xC0,               // }
+};
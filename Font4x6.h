@@ -102,3 +102,106 @@ const uint8_t Font4x6[] = {
 };
 
 const unsigned char FontToIndex4x6[FONT_4X6_SIZE+1] = " !%'()*+,-./0123456789:;<=>?ABCDEFGHIJKLMNOPQRSTUVWXYZ[]^_`abcdefghijklmnopqrstuvwxyz{|}";
+
+/* ASCII (32-127) to glyph index, unknown characters are drawn as a space */
+const uint8_t AsciiToIndex4x6[96] PROGMEM = {
+     0,  1,  0,  0,  0,  2,  0,  3,  4,  5,  6,  7,  8,  9, 10, 11,
+    12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27,
+     0, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42,
+    43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54,  0, 55, 56, 57,
+    58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73,
+    74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87,  0,  0,
+};
+
+/* Same glyphs transposed, FONT_4X6_ROWS bytes per glyph from top to bottom row. The leftmost
+ * column is the most significant bit, so a row can be shifted into the display buffer */
+const uint8_t Font4x6Rows[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,         // (space)
+    0x40, 0x00, 0x40, 0x40, 0x40, 0x40,         // !
+    0x90, 0x80, 0x40, 0x20, 0x10, 0x90,         // %
+    0x00, 0x00, 0x00, 0x00, 0x40, 0x40,         // '
+    0x20, 0x40, 0x80, 0x80, 0x40, 0x20,         // (
+    0x40, 0x20, 0x10, 0x10, 0x20, 0x40,         // )
+    0x00, 0x00, 0x00, 0x40, 0xE0, 0x40,         // *
+    0x00, 0x60, 0xF0, 0xF0, 0x60, 0x00,         // +
+    0x40, 0x40, 0x00, 0x00, 0x00, 0x00,         // ,
+    0x00, 0x00, 0xF0, 0xF0, 0x00, 0x00,         // -
+    0x40, 0x00, 0x00, 0x00, 0x00, 0x00,         // .
+    0x80, 0x40, 0x40, 0x20, 0x20, 0x10,         // /
+    0x60, 0x90, 0xD0, 0xB0, 0x90, 0x60,         // 0
+    0xE0, 0x40, 0x40, 0x40, 0xC0, 0x40,         // 1
+    0xF0, 0x80, 0x60, 0x10, 0x90, 0x60,         // 2
+    0x60, 0x90, 0x10, 0x20, 0x90, 0x60,         // 3
+    0x20, 0x20, 0xF0, 0xA0, 0x60, 0x20,         // 4
+    0x60, 0x90, 0x10, 0xE0, 0x80, 0xF0,         // 5
+    0x60, 0x90, 0x90, 0xE0, 0x80, 0x60,         // 6
+    0x40, 0x40, 0x40, 0x20, 0x10, 0xF0,         // 7
+    0x60, 0x90, 0x90, 0x60, 0x90, 0x60,         // 8
+    0x60, 0x10, 0x70, 0x90, 0x90, 0x60,         // 9
+    0x00, 0x40, 0x00, 0x00, 0x40, 0x00,         // :
+    0x40, 0x40, 0x00, 0x00, 0x40, 0x00,         // ;
+    0x20, 0x40, 0x80, 0x40, 0x20, 0x00,         // <
+    0x00, 0xE0, 0x00, 0xE0, 0x00, 0x00,         // =
+    0x80, 0x40, 0x20, 0x40, 0x80, 0x00,         // >
+    0x40, 0x00, 0x40, 0x40, 0x20, 0x40,         // ?
+    0x90, 0x90, 0xF0, 0x90, 0x90, 0x60,         // A
+    0xE0, 0x90, 0x90, 0xE0, 0x90, 0xE0,         // B
+    0x60, 0x90, 0x80, 0x80, 0x90, 0x60,         // C
+    0xE0, 0x90, 0x90, 0x90, 0x90, 0xE0,         // D
+    0xF0, 0x80, 0x80, 0xE0, 0x80, 0xF0,         // E
+    0x80, 0x80, 0x80, 0xE0, 0x80, 0xF0,         // F
+    0x70, 0x90, 0xB0, 0x80, 0x90, 0x60,         // G
+    0x90, 0x90, 0x90, 0xF0, 0x90, 0x90,         // H
+    0xE0, 0x40, 0x40, 0x40, 0x40, 0xE0,         // I
+    0x60, 0x90, 0x10, 0x10, 0x10, 0x70,         // J
+    0x90, 0x90, 0xA0, 0xC0, 0xA0, 0x90,         // K
+    0xF0, 0x80, 0x80, 0x80, 0x80, 0x80,         // L
+    0x90, 0x90, 0x90, 0x90, 0xF0, 0x90,         // M
+    0x90, 0x90, 0x90, 0xB0, 0xD0, 0x90,         // N
+    0x60, 0x90, 0x90, 0x90, 0x90, 0x60,         // O
+    0x80, 0x80, 0xE0, 0x90, 0x90, 0xE0,         // P
+    0x50, 0xA0, 0x90, 0x90, 0x90, 0x60,         // Q
+    0x90, 0x90, 0xE0, 0x90, 0x90, 0xE0,         // R
+    0xE0, 0x10, 0x10, 0x60, 0x80, 0x70,         // S
+    0x40, 0x40, 0x40, 0x40, 0x40, 0xF0,         // T
+    0x60, 0x90, 0x90, 0x90, 0x90, 0x90,         // U
+    0x20, 0x50, 0x90, 0x90, 0x90, 0x90,         // V
+    0x90, 0xF0, 0x90, 0x90, 0x90, 0x90,         // W
+    0x90, 0x90, 0x90, 0x60, 0x90, 0x90,         // X
+    0x20, 0x20, 0x20, 0x50, 0x90, 0x90,         // Y
+    0xF0, 0x80, 0x40, 0x40, 0x20, 0xF0,         // Z
+    0xE0, 0x80, 0x80, 0x80, 0x80, 0xE0,         // [
+    0x70, 0x10, 0x10, 0x10, 0x10, 0x70,         // ]
+    0x00, 0x00, 0x00, 0x00, 0xA0, 0x40,         // ^
+    0xF0, 0x00, 0x00, 0x00, 0x00, 0x00,         // _
+    0x00, 0x00, 0x00, 0x00, 0x20, 0x40,         // `
+    0x70, 0x90, 0x70, 0x10, 0x60, 0x00,         // a
+    0xE0, 0x90, 0x90, 0xE0, 0x80, 0x80,         // b
+    0x60, 0x90, 0x80, 0x90, 0x60, 0x00,         // c
+    0x70, 0x90, 0x90, 0x70, 0x10, 0x10,         // d
+    0x70, 0x80, 0xF0, 0x90, 0x60, 0x00,         // e
+    0x40, 0x40, 0x40, 0xE0, 0x40, 0x30,         // f
+    0x10, 0x70, 0x90, 0x90, 0x70, 0x00,         // g
+    0x90, 0x90, 0x90, 0xE0, 0x80, 0x80,         // h
+    0xE0, 0x40, 0x40, 0xC0, 0x00, 0x40,         // i
+    0x10, 0x10, 0x10, 0x30, 0x00, 0x10,         // j
+    0x90, 0xA0, 0xC0, 0xA0, 0x90, 0x80,         // k
+    0xE0, 0x40, 0x40, 0x40, 0x40, 0xC0,         // l
+    0x90, 0x90, 0x90, 0xF0, 0x90, 0x00,         // m
+    0x90, 0x90, 0x90, 0xD0, 0xA0, 0x00,         // n
+    0x60, 0x90, 0x90, 0x90, 0x60, 0x00,         // o
+    0xE0, 0x90, 0x90, 0x90, 0xE0, 0x00,         // p
+    0x70, 0x90, 0x90, 0x90, 0x70, 0x00,         // q
+    0x80, 0x80, 0x80, 0xD0, 0xA0, 0x00,         // r
+    0xE0, 0x10, 0x60, 0x80, 0x70, 0x00,         // s
+    0x30, 0x40, 0x40, 0x40, 0xE0, 0x40,         // t
+    0x60, 0x90, 0x90, 0x90, 0x90, 0x00,         // u
+    0x20, 0x50, 0x90, 0x90, 0x90, 0x00,         // v
+    0x90, 0xF0, 0x90, 0x90, 0x90, 0x00,         // w
+    0x90, 0x90, 0x60, 0x90, 0x90, 0x00,         // x
+    0x10, 0x70, 0x90, 0x90, 0x90, 0x00,         // y
+    0xF0, 0x80, 0x40, 0x20, 0xF0, 0x00,         // z
+    0x60, 0x40, 0x80, 0x80, 0x40, 0x60,         // {
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40,         // |
+    0x60, 0x20, 0x10, 0x10, 0x20, 0x60,         // }
+};
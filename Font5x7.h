@@ -106,3 +106,110 @@ const uint8_t Font5x7[] = {
 };
 
 const unsigned char FontToIndex5x7[FONT_5X7_SIZE+1] = " !#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[]^_`abcdefghijklmnopqrstuvwxyz{|}";
+
+/* ASCII (32-127) to glyph index, unknown characters are drawn as a space */
+const uint8_t AsciiToIndex5x7[96] PROGMEM = {
+     0,  1,  0,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
+    31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46,
+    47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58,  0, 59, 60, 61,
+    62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77,
+    78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91,  0,  0,
+};
+
+/* Same glyphs transposed, FONT_5X7_ROWS bytes per glyph from top to bottom row. The leftmost
+ * column is the most significant bit, so a row can be shifted into the display buffer */
+const uint8_t Font5x7Rows[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // (space)
+    0x20, 0x00, 0x20, 0x20, 0x20, 0x20, 0x20,   // !
+    0x50, 0x50, 0xF8, 0x50, 0xF8, 0x50, 0x50,   // #
+    0x20, 0xF0, 0x28, 0x70, 0xA0, 0x78, 0x20,   // $
+    0x18, 0x98, 0x40, 0x20, 0x10, 0xC8, 0xC0,   // %
+    0x68, 0x90, 0xA8, 0x40, 0xA0, 0x90, 0x60,   // &
+    0x00, 0x00, 0x00, 0x00, 0x40, 0x20, 0x60,   // '
+    0x10, 0x20, 0x40, 0x40, 0x40, 0x20, 0x10,   // (
+    0x40, 0x20, 0x10, 0x10, 0x10, 0x20, 0x40,   // )
+    0x00, 0x50, 0x20, 0xF8, 0x20, 0x50, 0x00,   // *
+    0x00, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x00,   // +
+    0x40, 0x20, 0x60, 0x00, 0x00, 0x00, 0x00,   // ,
+    0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x00,   // -
+    0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00,   // .
+    0x00, 0x80, 0x40, 0x20, 0x10, 0x08, 0x00,   // /
+    0x70, 0x88, 0xC8, 0xA8, 0x98, 0x88, 0x70,   // 0
+    0x70, 0x20, 0x20, 0x20, 0x20, 0x60, 0x20,   // 1
+    0xF8, 0x40, 0x20, 0x10, 0x08, 0x88, 0x70,   // 2
+    0x70, 0x88, 0x08, 0x10, 0x20, 0x10, 0xF8,   // 3
+    0x10, 0x10, 0xF8, 0x90, 0x50, 0x30, 0x10,   // 4
+    0x70, 0x88, 0x08, 0x08, 0xF0, 0x80, 0xF8,   // 5
+    0x70, 0x88, 0x88, 0xF0, 0x80, 0x40, 0x30,   // 6
+    0x40, 0x40, 0x40, 0x20, 0x10, 0x08, 0xF8,   // 7
+    0x70, 0x88, 0x88, 0x70, 0x88, 0x88, 0x70,   // 8
+    0x60, 0x10, 0x08, 0x78, 0x88, 0x88, 0x70,   // 9
+    0x00, 0x60, 0x60, 0x00, 0x60, 0x60, 0x00,   // :
+    0x40, 0x20, 0x60, 0x00, 0x60, 0x60, 0x00,   // ;
+    0x08, 0x10, 0x20, 0x40, 0x20, 0x10, 0x08,   // <
+    0x00, 0x00, 0xF8, 0x00, 0xF8, 0x00, 0x00,   // =
+    0x80, 0x40, 0x20, 0x10, 0x20, 0x40, 0x80,   // >
+    0x20, 0x00, 0x20, 0x10, 0x08, 0x88, 0x70,   // ?
+    0x70, 0xA8, 0xA8, 0x68, 0x08, 0x88, 0x70,   // @
+    0x88, 0x88, 0xF8, 0x88, 0x88, 0x88, 0x70,   // A
+    0xF0, 0x88, 0x88, 0xF0, 0x88, 0x88, 0xF0,   // B
+    0x70, 0x88, 0x80, 0x80, 0x80, 0x88, 0x70,   // C
+    0xE0, 0x90, 0x88, 0x88, 0x88, 0x90, 0xE0,   // D
+    0xF8, 0x80, 0x80, 0xF0, 0x80, 0x80, 0xF8,   // E
+    0x80, 0x80, 0x80, 0xE0, 0x80, 0x80, 0xF8,   // F
+    0x70, 0x88, 0x98, 0x80, 0x80, 0x88, 0x70,   // G
+    0x88, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x88,   // H
+    0x70, 0x20, 0x20, 0x20, 0x20, 0x20, 0x70,   // I
+    0x60, 0x90, 0x10, 0x10, 0x10, 0x10, 0x38,   // J
+    0x88, 0x90, 0xA0, 0xC0, 0xA0, 0x90, 0x88,   // K
+    0xF8, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,   // L
+    0x88, 0x88, 0x88, 0x88, 0xA8, 0xD8, 0x88,   // M
+    0x88, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x88,   // N
+    0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70,   // O
+    0x80, 0x80, 0x80, 0xF0, 0x88, 0x88, 0xF0,   // P
+    0x68, 0x90, 0xA8, 0x88, 0x88, 0x88, 0x70,   // Q
+    0x88, 0x90, 0xA0, 0xF0, 0x88, 0x88, 0xF0,   // R
+    0xF0, 0x08, 0x08, 0x70, 0x80, 0x80, 0x78,   // S
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0xF8,   // T
+    0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88,   // U
+    0x20, 0x50, 0x88, 0x88, 0x88, 0x88, 0x88,   // V
+    0x88, 0xD8, 0xA8, 0xA8, 0x88, 0x88, 0x88,   // W
+    0x88, 0x88, 0x50, 0x20, 0x50, 0x88, 0x88,   // X
+    0x20, 0x20, 0x20, 0x20, 0x50, 0x88, 0x88,   // Y
+    0xF8, 0x80, 0x40, 0x20, 0x10, 0x08, 0xF8,   // Z
+    0x38, 0x20, 0x20, 0x20, 0x20, 0x20, 0x38,   // [
+    0xE0, 0x20, 0x20, 0x20, 0x20, 0x20, 0xE0,   // ]
+    0x00, 0x00, 0x00, 0x00, 0x88, 0x50, 0x20,   // ^
+    0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // _
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x20, 0x40,   // `
+    0x78, 0x88, 0x78, 0x08, 0x70, 0x00, 0x00,   // a
+    0xF0, 0x88, 0x88, 0xC8, 0xB0, 0x80, 0x80,   // b
+    0x70, 0x88, 0x80, 0x80, 0x70, 0x00, 0x00,   // c
+    0x78, 0x88, 0x88, 0x98, 0x68, 0x08, 0x08,   // d
+    0x70, 0x80, 0xF8, 0x88, 0x70, 0x00, 0x00,   // e
+    0x40, 0x40, 0x40, 0xE0, 0x40, 0x48, 0x30,   // f
+    0x30, 0x08, 0x78, 0x88, 0x78, 0x00, 0x00,   // g
+    0x88, 0x88, 0x88, 0xC8, 0xB0, 0x80, 0x80,   // h
+    0x70, 0x20, 0x20, 0x20, 0x60, 0x00, 0x20,   // i
+    0x60, 0x90, 0x10, 0x10, 0x30, 0x00, 0x10,   // j
+    0x48, 0x50, 0x60, 0x50, 0x48, 0x40, 0x40,   // k
+    0x70, 0x20, 0x20, 0x20, 0x20, 0x20, 0x60,   // l
+    0x88, 0x88, 0xA8, 0xA8, 0xD0, 0x00, 0x00,   // m
+    0x88, 0x88, 0x88, 0xC8, 0xB0, 0x00, 0x00,   // n
+    0x70, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00,   // o
+    0x80, 0x80, 0xF0, 0x88, 0xF0, 0x00, 0x00,   // p
+    0x08, 0x08, 0x78, 0x98, 0x68, 0x00, 0x00,   // q
+    0x80, 0x80, 0x80, 0xC8, 0xB0, 0x00, 0x00,   // r
+    0xF0, 0x08, 0x70, 0x80, 0x70, 0x00, 0x00,   // s
+    0x30, 0x48, 0x40, 0x40, 0xE0, 0x40, 0x40,   // t
+    0x68, 0x98, 0x88, 0x88, 0x88, 0x00, 0x00,   // u
+    0x20, 0x50, 0x88, 0x88, 0x88, 0x00, 0x00,   // v
+    0x50, 0xA8, 0xA8, 0x88, 0x88, 0x00, 0x00,   // w
+    0x88, 0x50, 0x20, 0x50, 0x88, 0x00, 0x00,   // x
+    0x70, 0x08, 0x78, 0x88, 0x88, 0x00, 0x00,   // y
+    0xF8, 0x40, 0x20, 0x10, 0xF8, 0x00, 0x00,   // z
+    0x10, 0x20, 0x20, 0x40, 0x20, 0x20, 0x10,   // {
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,   // |
+    0x40, 0x20, 0x20, 0x10, 0x20, 0x20, 0x40,   // }
+};
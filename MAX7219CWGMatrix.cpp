@@ -8,6 +8,19 @@
  * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
  */
 #include "MAX7219CWGMatrix.h"
+#include "DisplayList.h"
+
+/* 8x8 ordered dither thresholds, neighbouring thresholds are far apart */
+static const uint8_t BayerMatrix[ROW_SIZE][COLUMN_SIZE] PROGMEM = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
 
 /**************************************************************************/
 /*!
@@ -16,10 +29,16 @@
   @param    numSegmentsVertical     Number of vertical segments
   @param    csPin                   Chip-Select pin
   @param    wiringType              Type of circuit is used. Check circuit diagram.
+  @param    buffer                  Memory of getBufferSize() bytes to use,
+                                    nullptr to allocate it
 */
 /**************************************************************************/
-MAX7219CWGMatrix::MAX7219CWGMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType) {
-    initialiseMatrix(numSegmentsHorizontal, numSegmentsVertical, csPin, wiringType);
+MAX7219CWGMatrix::MAX7219CWGMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType, uint8_t* buffer) {
+    _memory = nullptr;
+    _ownsMemory = false;
+    _planes = nullptr;
+    _transport = nullptr;
+    initialiseMatrix(numSegmentsHorizontal, numSegmentsVertical, csPin, wiringType, buffer);
 }
 
 /**************************************************************************/
@@ -28,40 +47,119 @@ MAX7219CWGMatrix::MAX7219CWGMatrix(uint8_t numSegmentsHorizontal, uint8_t numSeg
 */
 /**************************************************************************/
 MAX7219CWGMatrix::MAX7219CWGMatrix() {
+    _memory = nullptr;
+    _ownsMemory = false;
+    _planes = nullptr;
+    _transport = nullptr;
+    _bitsPerPixel = 1;
+    _drawPlanes = 1;
+    _drawBuffer = nullptr;
+    _displayList = nullptr;
+    _matrix = nullptr;
+    _numSegmentsHorizontal = 0;
+    _numSegmentsVertical = 0;
+    _numSegments = 0;
+    _width = 0;
+    _height = 0;
     debugln("NOTE: Need to call initialiseMatrix() to initialise the matrix.");
 }
 
 /**************************************************************************/
 /*!
-  @brief    Initialiser.
+  @brief    Destructor, frees the memory if it was allocated by the class.
+*/
+/**************************************************************************/
+MAX7219CWGMatrix::~MAX7219CWGMatrix() {
+    if (_ownsMemory) {
+        free(_memory);
+    }
+    free(_planes);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Initialiser. Calling it again keeps the transport given with
+            setTransport(), the built-in SPI transport is only the first
+            one.
   @param    numSegmentsHorizontal   Number of horizontal segments
   @param    numSegmentsVertical     Number of vertical segments
   @param    csPin                   Chip-Select pin
   @param    wiringType              Type of circuit is used. Check circuit diagram.
+  @param    buffer                  Memory of getBufferSize() bytes to use,
+                                    nullptr to allocate it once
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::initialiseMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType) {
+void MAX7219CWGMatrix::initialiseMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType, uint8_t* buffer) {
+    if (_transport == nullptr) {
+        _transport = &_spiTransport;
+    }
+    _transport->waitIdle();                                                 //A flush may still read the old buffers
+
+    /* Release memory of an earlier initialisation */
+    if (_ownsMemory) {
+        free(_memory);
+    }
+    free(_planes);
+    _planes = nullptr;
+    _bitsPerPixel = 1;
+    _drawPlanes = 1;
+    _drawBuffer = nullptr;
+    _displayList = nullptr;
+    _memory = buffer;
+    _ownsMemory = false;
+
+    if ((uint32_t) numSegmentsHorizontal*numSegmentsVertical > MAX_SEGMENTS) {
+        debugln("ERROR: Too many segments, a frame would not fit getFrameSize().");
+        numSegmentsHorizontal = 0;
+        numSegmentsVertical = 0;
+    }
+
+    if (_memory == nullptr) {
+        _memory = (uint8_t*) malloc(getBufferSize(numSegmentsHorizontal, numSegmentsVertical));
+        _ownsMemory = true;
+    }
+
+    if (_memory == nullptr) {
+        debugln("ERROR: Not enough memory for the display buffer.");
+        _ownsMemory = false;
+        numSegmentsHorizontal = 0;
+        numSegmentsVertical = 0;
+    }
+
     _numSegmentsHorizontal = numSegmentsHorizontal;
     _numSegmentsVertical = numSegmentsVertical;
     _numSegments = _numSegmentsHorizontal * _numSegmentsVertical;
 
+    /* Carve the buffers, see MAX7219_BUFFER_SIZE */
+    _segmentMap = (uint16_t*) (((uintptr_t) _memory + 1) & ~(uintptr_t) 1); //Aligned for 16-bit access
+    _matrix = (uint8_t*) (((uintptr_t) (_segmentMap + _numSegments) + 3) & ~(uintptr_t) 3);   //Aligned for 32-bit frame operations
+    _shadow = _matrix + _numSegments*ROW_SIZE;
+    _txBuffer[0] = _shadow + _numSegments*ROW_SIZE;
+    _txBuffer[1] = _txBuffer[0] + _numSegments*ROW_SIZE*2;
+    _segmentPower = _txBuffer[1] + _numSegments*ROW_SIZE*2;
+
     _csPin = csPin;
-    _wiringType = wiringType;
-    _rotation = STANDARD_ROTATION;
-    _width = _numSegmentsHorizontal * ROW_SIZE;
-    _height = _numSegmentsVertical * COLUMN_SIZE;
+    setWiring(wiringType);
+    setRotation(STANDARD_ROTATION);
 
     _font = 0;
     _fontRows = 0;
     _fontCols = 0;
 
     _power = false;
+    _inverted = false;
+    _powerSaving = false;
 
-    pinMode(_csPin, OUTPUT);
-    digitalWrite(_csPin, 1);
+    _dirtyRows = 0xFF;
+    _shadowValid = false;
+    _skippedWords = 0;
 
-    SPI.begin();
+    _txIndex = 0;
+    _transport->begin(_csPin);
 
+    if (_matrix != nullptr) {
+        memset(_matrix, 0, _numSegments*ROW_SIZE);
+    }
     clear();
     display();
     setFont(FONT_3X5);
@@ -70,11 +168,47 @@ void MAX7219CWGMatrix::initialiseMatrix(uint8_t numSegmentsHorizontal, uint8_t n
 
     _sendCommand(OPCODE_TEST | 0);                                          //Disable test mode
     _sendCommand(OPCODE_DECODE | 0);                                        //Disable decode mode
-    _sendCommand(OPCODE_SCAN_LIMIT | 7);                                    //Display all lines
+    setScanLimit(ROW_SIZE-1);                                               //Display all lines
 
     debugln("NOTE: Matrix ready to use.");
 }
 
+/**************************************************************************/
+/*!
+  @brief    Sets the transport used to reach the chips, instead of the
+            built-in SPI transport. The chips on it are set up like in
+            initialiseMatrix(), with the current power and intensity, and
+            the display buffer is resent by the next display(). Settings
+            per segment have to be given again.
+  @param    transport       Transport to use
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setTransport(MAX7219Transport* transport) {
+    _transport->waitIdle();
+    _transport = transport;
+    _transport->setWiringMap(_segmentMap, _numSegments);
+    _transport->begin(_csPin);
+    _shadowValid = false;                                                   //New bus, state of the chips unknown
+
+    /* The chips may have just powered up: shut down, scanning one digit */
+    _sendCommand(OPCODE_TEST | 0);
+    _sendCommand(OPCODE_DECODE | 0);
+    setScanLimit(ROW_SIZE-1);
+    setIntensity(_intensity);
+    setPower(_power);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the SPI clock of the transport. The MAX7219 allows up to
+            10 MHz.
+  @param    hz              Clock in Hz
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setClock(uint32_t hz) {
+    _transport->setClock(hz);
+}
+
 /**************************************************************************/
 /*!
   @brief    Sets the power of the display.
@@ -84,6 +218,8 @@ void MAX7219CWGMatrix::initialiseMatrix(uint8_t numSegmentsHorizontal, uint8_t n
 void MAX7219CWGMatrix::setPower(bool on) {
     _power = on;
     _sendCommand(OPCODE_ENABLE | (_power ? 1: 0));
+
+    memset(_segmentPower, _power, _numSegments);
 }
 
 /**************************************************************************/
@@ -103,15 +239,201 @@ void MAX7219CWGMatrix::setIntensity(uint8_t level) {
 
 /**************************************************************************/
 /*!
-  @brief    Sets the rotation of the display.
-  @param    rotation        Rotation of the display
+  @brief    Sets the intensity of one segment. Other segments keep their
+            intensity.
+  @param    segmentX        Segment column, in drawing coordinates
+  @param    segmentY        Segment row, in drawing coordinates
+  @param    level           Level of intensity (0-15)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setSegmentIntensity(uint8_t segmentX, uint8_t segmentY, uint8_t level) {
+    if (level > MAX_INTENSITY) {
+        level = MAX_INTENSITY;
+    }
+    _sendSegmentCommand(segmentX, segmentY, OPCODE_INTENSITY | level);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Turns one segment on or off (shutdown mode). The segment keeps
+            its data, other segments are not affected.
+  @param    segmentX        Segment column, in drawing coordinates
+  @param    segmentY        Segment row, in drawing coordinates
+  @param    on              Turn on (true), Turn off (false)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setSegmentPower(uint8_t segmentX, uint8_t segmentY, bool on) {
+    int32_t segment = _segmentIndex(segmentX, segmentY);
+
+    if (segment < 0) {
+        debugln("ERROR: Invalid segment given. Ignoring it.");
+        return;
+    }
+
+    _segmentPower[segment] = on;
+    _sendSegmentCommand(segmentX, segmentY, OPCODE_ENABLE | (on ? 1: 0));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the number of digit rows the chips scan (scan limit).
+            Fewer rows are brighter and draw less current, for layouts
+            that do not use the full height of the segments.
+  @param    limit           Last digit row to scan (0-7)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setScanLimit(uint8_t limit) {
+    if (limit > ROW_SIZE-1) {
+        limit = ROW_SIZE-1;
+    }
+    _sendCommand(OPCODE_SCAN_LIMIT | limit);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the scan limit of one segment.
+  @param    segmentX        Segment column, in drawing coordinates
+  @param    segmentY        Segment row, in drawing coordinates
+  @param    limit           Last digit row to scan (0-7)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setSegmentScanLimit(uint8_t segmentX, uint8_t segmentY, uint8_t limit) {
+    if (limit > ROW_SIZE-1) {
+        limit = ROW_SIZE-1;
+    }
+    _sendSegmentCommand(segmentX, segmentY, OPCODE_SCAN_LIMIT | limit);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets if segments without any led on are shut down by
+            display(). Saves current on large displays.
+  @param    enabled         True to shut down blank segments
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setPowerSaving(bool enabled) {
+    _powerSaving = enabled;
+
+    /* Turn every segment back on */
+    if (!_powerSaving) {
+        setPower(_power);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the wiring of the segments. The chain position and the
+            orientation of every segment are resolved once, display()
+            only looks them up.
+  @param    wiringType      Type of circuit is used. Check circuit diagram.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setWiring(uint8_t wiringType) {
+    if (wiringType > COLUMN_WIRING) {
+        debugln("ERROR: Invalid wiring type given, use setWiringMap() for a custom wiring. Using 'ZIGZAG_WIRING'.");
+        wiringType = ZIGZAG_WIRING;
+    }
+
+    for (uint8_t segRow = 0; segRow < _numSegmentsVertical; segRow++) {
+        bool odd = segRow % 2 == 1;
+
+        for (uint8_t d = 0; d < _numSegmentsHorizontal; d++) {
+            uint16_t position = segRow*_numSegmentsHorizontal + d;
+
+            if (odd && (wiringType == ZIGZAG_WIRING || wiringType == SERPENTINE_WIRING)) {
+                position = segRow*_numSegmentsHorizontal + _numSegmentsHorizontal-1 - d;
+            } else if (wiringType == COLUMN_WIRING) {
+                position = d*_numSegmentsVertical + segRow;
+            }
+
+            if (odd && wiringType == ZIGZAG_WIRING) {
+                position |= SEGMENT_FLIPPED;
+            }
+            _segmentMap[segRow*_numSegmentsHorizontal + d] = position;
+        }
+    }
+
+    _wiringType = wiringType;
+    _shadowValid = false;                                                   //Every segment may have moved
+    _transport->setWiringMap(_segmentMap, _numSegments);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets a custom wiring of the segments.
+  @param    map             Chain position per segment, index is
+                            segmentY*segmentsHorizontal + segmentX with
+                            standard rotation. Position 0 is sent first
+                            (the segment at the end of the chain). Add
+                            SEGMENT_FLIPPED if the segment is mounted
+                            upside down.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setWiringMap(const uint16_t map[]) {
+    uint8_t* used = _txBuffer[_txIndex];                                    //Not in flight
+
+    /* Every chain position must be used once */
+    memset(used, 0, _numSegments);
+
+    for (uint16_t segment = 0; segment < _numSegments; segment++) {
+        uint16_t position = map[segment] & ~SEGMENT_FLIPPED;
+
+        if (position >= _numSegments || used[position]) {
+            debugln("ERROR: Invalid wiring map given. Ignoring it.");
+            return;
+        }
+        used[position] = 1;
+    }
+
+    memcpy(_segmentMap, map, _numSegments*sizeof(uint16_t));
+    _wiringType = CUSTOM_WIRING;
+    _shadowValid = false;
+    _transport->setWiringMap(_segmentMap, _numSegments);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the rotation of the display. The image is turned on the
+            panel: with CLOCKWISE_ROTATION the top left of the drawing is
+            the top right of the panel. Mirroring flips the drawing left
+            to right before it is turned. Quarter rotations swap the
+            width and the height.
+  @param    rotation        Rotation of the display, optionally combined
+                            with MIRRORED_ROTATION
 */
 /**************************************************************************/
 void MAX7219CWGMatrix::setRotation(uint8_t rotation) {
-    if (rotation != STANDARD_ROTATION && rotation != UPSIDE_DOWN_ROTATION) {
+    if ((rotation & ~MIRRORED_ROTATION) > COUNTERCLOCKWISE_ROTATION) {
         debugln("ERROR: Invalid rotation given. Ignoring it.");
         return;
     }
+
+    uint8_t quarter = rotation & ~MIRRORED_ROTATION;
+    int16_t bufferWidth = _numSegmentsHorizontal*COLUMN_SIZE;
+    int16_t bufferHeight = _numSegmentsVertical*ROW_SIZE;
+    bool swapXY = quarter == CLOCKWISE_ROTATION || quarter == COUNTERCLOCKWISE_ROTATION;
+    bool flipX = quarter == UPSIDE_DOWN_ROTATION || quarter == CLOCKWISE_ROTATION;
+    bool flipY = quarter == UPSIDE_DOWN_ROTATION || quarter == COUNTERCLOCKWISE_ROTATION;
+
+    /* Mirroring flips the buffer axis the drawing x ends up on */
+    if (rotation & MIRRORED_ROTATION) {
+        if (swapXY) {
+            flipY = !flipY;
+        } else {
+            flipX = !flipX;
+        }
+    }
+
+    /* Resolve the mapping once, drawing only multiplies and adds */
+    _transform[0] = swapXY ? 0 : (flipX ? -1 : 1);
+    _transform[1] = swapXY ? (flipX ? -1 : 1) : 0;
+    _transform[2] = flipX ? bufferWidth-1 : 0;
+    _transform[3] = swapXY ? (flipY ? -1 : 1) : 0;
+    _transform[4] = swapXY ? 0 : (flipY ? -1 : 1);
+    _transform[5] = flipY ? bufferHeight-1 : 0;
+
+    _width = swapXY ? bufferHeight : bufferWidth;
+    _height = swapXY ? bufferWidth : bufferHeight;
     _rotation = rotation;
 }
 
@@ -122,9 +444,98 @@ void MAX7219CWGMatrix::setRotation(uint8_t rotation) {
 */
 /**************************************************************************/
 void MAX7219CWGMatrix::setInverted(bool inverted) {
+    if (inverted != _inverted) {
+        _shadowValid = false;                                               //Every latched row changes
+    }
     _inverted = inverted;
 }
 
+/**************************************************************************/
+/*!
+  @brief    Sets the number of bits per pixel. With more than 1 bit, the
+            value of the draw functions is a gray level (0 to
+            2^bitsPerPixel - 1) and updateGrayscale() has to be called
+            continuously to show it.
+  @param    bitsPerPixel    1 for on/off, 2 to MAX_BITS_PER_PIXEL for grayscale
+  @param    subFrameTime    Time the least significant bit is shown in us,
+                            every next bit is shown twice as long
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setGrayscale(uint8_t bitsPerPixel, uint32_t subFrameTime) {
+    if (bitsPerPixel == 0 || bitsPerPixel > MAX_BITS_PER_PIXEL) {
+        debugln("ERROR: Invalid number of bits per pixel given. Ignoring it.");
+        return;
+    }
+
+    uint16_t planeSize = _numSegments*ROW_SIZE;
+
+    /* Keep the last shown frame, lit pixels of the most significant bit */
+    if (_drawBuffer != nullptr) {
+        debugln("ERROR: Can not change the bits per pixel while drawing in another buffer.");
+        return;
+    }
+
+    if (_planes != nullptr) {
+        memcpy(_matrix, _planes + (_bitsPerPixel-1)*planeSize, planeSize);
+        _dirtyRows = 0xFF;
+        free(_planes);
+        _planes = nullptr;
+    }
+    _bitsPerPixel = 1;
+    _drawPlanes = 1;
+
+    if (bitsPerPixel == 1) {
+        return;
+    }
+
+    _planes = (uint8_t*) malloc(bitsPerPixel*planeSize);
+
+    if (_planes == nullptr) {
+        debugln("ERROR: Not enough memory for grayscale, using 1 bit per pixel.");
+        return;
+    }
+
+    /* Lit pixels get the highest level */
+    for (uint8_t plane = 0; plane < bitsPerPixel; plane++) {
+        memcpy(_planes + plane*planeSize, _matrix, planeSize);
+    }
+
+    if (subFrameTime == 0) {
+        subFrameTime = 1;
+    }
+
+    _bitsPerPixel = bitsPerPixel;
+    _drawPlanes = bitsPerPixel;
+    _subFrameTime = subFrameTime;
+    _subFramePlane = 0;
+    _subFrameShown = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Lets the draw functions draw in another buffer instead of the
+            display, for example a layer of a Compositor. The buffer has
+            the layout of the display buffer, 1 bit per pixel.
+  @param    buffer          Buffer of getFrameSize() bytes, nullptr to
+                            draw on the display again
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setDrawBuffer(uint8_t* buffer) {
+    _drawBuffer = buffer;
+    _drawPlanes = _drawBuffer != nullptr ? 1 : _bitsPerPixel;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Lets the draw functions add commands to a display list instead
+            of drawing, see DisplayList::startRecording().
+  @param    list            List to record in, nullptr to draw again
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setDisplayList(DisplayList* list) {
+    _displayList = list;
+}
+
 /**************************************************************************/
 /*!
   @brief    Sets the font.
@@ -132,20 +543,27 @@ void MAX7219CWGMatrix::setInverted(bool inverted) {
 */
 /**************************************************************************/
 void MAX7219CWGMatrix::setFont(uint8_t font) {
+    if (_displayList != nullptr) {
+        _displayList->record(DISPLAY_LIST_FONT, font, nullptr, 0);          //Still set, the layout of text depends on it
+    }
+
     _font = font;
-    if (_font == FONT_3X5) {
-        _fontRows = FONT_3X5_ROWS;
-        _fontCols = FONT_3X5_COLS;
-    } else if (_font == FONT_4X6) {
+    if (_font == FONT_4X6) {
         _fontRows = FONT_4X6_ROWS;
         _fontCols = FONT_4X6_COLS;
+        _fontIndex = AsciiToIndex4x6;
+        _fontGlyphs = Font4x6Rows;
     } else if (_font == FONT_5X7) {
         _fontRows = FONT_5X7_ROWS;
         _fontCols = FONT_5X7_COLS;
+        _fontIndex = AsciiToIndex5x7;
+        _fontGlyphs = Font5x7Rows;
     } else {
         _font = FONT_3X5;
         _fontRows = FONT_3X5_ROWS;
         _fontCols = FONT_3X5_COLS;
+        _fontIndex = AsciiToIndex3x5;
+        _fontGlyphs = Font3x5Rows;
     }
 }
 
@@ -157,26 +575,31 @@ void MAX7219CWGMatrix::setFont(uint8_t font) {
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawPixel(uint8_t x, uint8_t y, uint8_t value) {
-    /* Check is coordinates are on display */
-    if (x >= _width || y >= _height) {
+void MAX7219CWGMatrix::drawPixel(int16_t x, int16_t y, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y};
+        _displayList->record(DISPLAY_LIST_PIXEL, value, args, 2);
         return;
     }
 
-    /* If rotation is upside down, invert x and y*/
-    if (_rotation == UPSIDE_DOWN_ROTATION) {
-        x = _numSegmentsHorizontal*ROW_SIZE-1 - x;
-        y = _numSegmentsVertical*COLUMN_SIZE-1 - y;
+    /* Check is coordinates are on display */
+    if (x < 0 || y < 0 || x >= _width || y >= _height) {
+        return;
     }
 
-    uint8_t segment = x/COLUMN_SIZE;                                        //Select segment
-	  uint16_t b = 7 - (x & 7);                                               //Extract bit
+    _mapPoint(x, y);
 
-    /* (For now,) if value != 0, turn led on else turn off */
-	  if (value) {
-		    _matrix[segment][y] |= (1<<b);
-    }	else {
-		    _matrix[segment][y] &= ~(1<<b);
+    uint16_t offset = y*_numSegmentsHorizontal + x/COLUMN_SIZE;             //Select segment
+    uint8_t mask = 1 << (7 - (x & 7));                                      //Extract bit
+
+    for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+        uint8_t* segment = _plane(plane) + offset;
+        uint8_t data = _planeValue(value, plane) ? (*segment | mask) : (*segment & ~mask);
+
+        if (data != *segment) {
+            *segment = data;
+            _dirtyRows |= 1 << (y & 7);                                     //Mark digit row for the next display()
+        }
     }
 }
 
@@ -190,25 +613,31 @@ void MAX7219CWGMatrix::drawPixel(uint8_t x, uint8_t y, uint8_t value) {
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t value) {
+void MAX7219CWGMatrix::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, x1, y1};
+        _displayList->record(DISPLAY_LIST_LINE, value, args, 4);
+        return;
+    }
+
     bool steep = abs(y1 - y0) > abs(x1 - x0);
 
     if (steep) {
-        _swap_byte(x0, y0);
-        _swap_byte(x1, y1);
+        _swap_int16(x0, y0);
+        _swap_int16(x1, y1);
     }
   
     if (x0 > x1) {
-        _swap_byte(x0, x1);
-        _swap_byte(y0, y1);
+        _swap_int16(x0, x1);
+        _swap_int16(y0, y1);
     }
   
-    int8_t dx, dy;
+    int16_t dx, dy;
     dx = x1 - x0;
     dy = abs(y1 - y0);
     
     int16_t err = dx / 2;
-    int8_t ystep;
+    int16_t ystep;
     
     if (y0 < y1) {
         ystep = 1;
@@ -242,17 +671,101 @@ void MAX7219CWGMatrix::drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawLineAngle(uint8_t x0, uint8_t y0, uint8_t l, uint16_t angle, uint8_t value) {
-    if (angle > 360) {
-        angle = angle % 360;
+void MAX7219CWGMatrix::drawLineAngle(int16_t x0, int16_t y0, int16_t l, uint16_t angle, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, l, (int16_t) angle};
+        _displayList->record(DISPLAY_LIST_LINE_ANGLE, value, args, 4);
+        return;
+    }
+
+    drawLineFineAngle(x0, y0, l, (angle % 360)*ANGLE_STEPS_PER_DEGREE, value);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a line under an angle with sub-degree resolution, for
+            example a clock hand at one of 720 positions.
+  @param    x0              Start x coordinate
+  @param    y0              Start y coordinate
+  @param    l               Length in pixels
+  @param    angle           Angle in 1/ANGLE_STEPS_PER_DEGREE degrees
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::drawLineFineAngle(int16_t x0, int16_t y0, int16_t l, uint16_t angle, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, l, (int16_t) angle};
+        _displayList->record(DISPLAY_LIST_LINE_FINE_ANGLE, value, args, 4);
+        return;
     }
-    
-    uint8_t x = x0 + l * sin(angle * 0.0174532925);
-    uint8_t y = y0 + l * cos(angle * 0.0174532925);
 
+    int16_t x;
+    int16_t y;
+
+    getAnglePoint(x0, y0, l, angle, x, y);
     drawLine(x0, y0, x, y, value);
 }
 
+/**************************************************************************/
+/*!
+  @brief    Draws the part of a circle from one angle to another, turning
+            with increasing angles.
+  @param    x0              Center x coordinate
+  @param    y0              Center y coordinate
+  @param    r               Radius
+  @param    startAngle      Start in 1/ANGLE_STEPS_PER_DEGREE degrees
+  @param    endAngle        End in 1/ANGLE_STEPS_PER_DEGREE degrees, equal
+                            to the start for a full circle
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::drawArc(int16_t x0, int16_t y0, int16_t r, uint16_t startAngle, uint16_t endAngle, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, r, (int16_t) startAngle, (int16_t) endAngle};
+        _displayList->record(DISPLAY_LIST_ARC, value, args, 5);
+        return;
+    }
+
+    if (r <= 0) {
+        drawPixel(x0, y0, value);
+        return;
+    }
+
+    startAngle %= FULL_ANGLE;
+    endAngle %= FULL_ANGLE;
+
+    uint16_t sweep = (endAngle + FULL_ANGLE - startAngle) % FULL_ANGLE;
+    if (sweep == 0) {
+        sweep = FULL_ANGLE;
+    }
+
+    /* Steps of at most one pixel along the circle: 1 radian / r */
+    uint16_t step = FULL_ANGLE / 7 / r;
+    if (step == 0) {
+        step = 1;
+    }
+
+    int16_t lastX = INT16_MIN;
+    int16_t lastY = INT16_MIN;
+
+    for (uint32_t a = 0; a <= sweep; a += step) {
+        int16_t x;
+        int16_t y;
+
+        getAnglePoint(x0, y0, r, startAngle + a, x, y);
+        if (x != lastX || y != lastY) {
+            drawPixel(x, y, value);
+            lastX = x;
+            lastY = y;
+        }
+
+        /* Always end exactly on the end angle */
+        if (a < sweep && a + step > sweep) {
+            a = sweep - step;
+        }
+    }
+}
+
 /**************************************************************************/
 /*!
   @brief    Draws a vertical line.
@@ -262,12 +775,18 @@ void MAX7219CWGMatrix::drawLineAngle(uint8_t x0, uint8_t y0, uint8_t l, uint16_t
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawVLine(uint8_t x, uint8_t y, uint8_t h, uint8_t value) {
+void MAX7219CWGMatrix::drawVLine(int16_t x, int16_t y, int16_t h, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y, h};
+        _displayList->record(DISPLAY_LIST_VLINE, value, args, 3);
+        return;
+    }
+
     if (h == 0) {
         h = 1;
     }
     
-    drawLine(x, y, x, y+h-1, value);
+    _drawVSpan(x, y, h, value);
 }
 
 /**************************************************************************/
@@ -279,12 +798,18 @@ void MAX7219CWGMatrix::drawVLine(uint8_t x, uint8_t y, uint8_t h, uint8_t value)
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawHLine(uint8_t x, uint8_t y, uint8_t w, uint8_t value) {
+void MAX7219CWGMatrix::drawHLine(int16_t x, int16_t y, int16_t w, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y, w};
+        _displayList->record(DISPLAY_LIST_HLINE, value, args, 3);
+        return;
+    }
+
     if (w == 0) {
         w = 1;
     }
 
-    drawLine(x, y, x+w-1, y, value);
+    _drawHSpan(x, y, w, value);
 }
 
 /**************************************************************************/
@@ -297,7 +822,13 @@ void MAX7219CWGMatrix::drawHLine(uint8_t x, uint8_t y, uint8_t w, uint8_t value)
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t value) {
+void MAX7219CWGMatrix::drawRectangle(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y, w, h};
+        _displayList->record(DISPLAY_LIST_RECTANGLE, value, args, 4);
+        return;
+    }
+
     drawHLine(x, y, w, value);
     drawHLine(x, y+h-1, w, value);
     drawVLine(x, y, h, value);
@@ -314,9 +845,15 @@ void MAX7219CWGMatrix::drawRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h,
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawFillRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t value) {
-    for (uint8_t i = x; i < x+w; i++) {
-        drawVLine(i, y, h, value);
+void MAX7219CWGMatrix::drawFillRectangle(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y, w, h};
+        _displayList->record(DISPLAY_LIST_FILL_RECTANGLE, value, args, 4);
+        return;
+    }
+
+    for (int16_t i = y; i < y+h; i++) {
+        _drawHSpan(x, i, w, value);
     }
 }
 
@@ -329,7 +866,13 @@ void MAX7219CWGMatrix::drawFillRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawCircle(uint8_t x0, uint8_t y0, int16_t r, uint8_t value) {
+void MAX7219CWGMatrix::drawCircle(int16_t x0, int16_t y0, int16_t r, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, r};
+        _displayList->record(DISPLAY_LIST_CIRCLE, value, args, 3);
+        return;
+    }
+
     int16_t f = 1 - r;
     int16_t ddF_x = 1;
     int16_t ddF_y = -2 * r;
@@ -372,8 +915,14 @@ void MAX7219CWGMatrix::drawCircle(uint8_t x0, uint8_t y0, int16_t r, uint8_t val
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawFillCircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t value) {
-    drawVLine(x0, y0-r, 2*r+1, value);
+void MAX7219CWGMatrix::drawFillCircle(int16_t x0, int16_t y0, int16_t r, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, r};
+        _displayList->record(DISPLAY_LIST_FILL_CIRCLE, value, args, 3);
+        return;
+    }
+
+    _drawHSpan(x0-r, y0, 2*r+1, value);
     _fillCircleHelper(x0, y0, r, 3, 0, value);
 }
 
@@ -389,7 +938,13 @@ void MAX7219CWGMatrix::drawFillCircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value) {  
+void MAX7219CWGMatrix::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t value) {  
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, x1, y1, x2, y2};
+        _displayList->record(DISPLAY_LIST_TRIANGLE, value, args, 6);
+        return;
+    }
+
     drawLine(x0, y0, x1, y1, value);
     drawLine(x1, y1, x2, y2, value);
     drawLine(x2, y2, x0, y0, value);
@@ -407,18 +962,24 @@ void MAX7219CWGMatrix::drawTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawFillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value) {
+void MAX7219CWGMatrix::drawFillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x0, y0, x1, y1, x2, y2};
+        _displayList->record(DISPLAY_LIST_FILL_TRIANGLE, value, args, 6);
+        return;
+    }
+
     int16_t a, b, y, last;
     
     /* Sort coordinates by Y order (y2 >= y1 >= y0) */
     if (y0 > y1) {
-        _swap_byte(y0, y1); _swap_byte(x0, x1);
+        _swap_int16(y0, y1); _swap_int16(x0, x1);
     }
     if (y1 > y2) {
-        _swap_byte(y2, y1); _swap_byte(x2, x1);
+        _swap_int16(y2, y1); _swap_int16(x2, x1);
     }
     if (y0 > y1) {
-        _swap_byte(y0, y1); _swap_byte(x0, x1);
+        _swap_int16(y0, y1); _swap_int16(x0, x1);
     }
 
     /* Handle awkward all-on-same-line case as its own thing */
@@ -437,7 +998,7 @@ void MAX7219CWGMatrix::drawFillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint
             b = x2;
         }
 
-        drawHLine(a, y0, b-a+1, value);
+        _drawHSpan(a, y0, b-a+1, value);
         return;
     }
   
@@ -475,9 +1036,9 @@ void MAX7219CWGMatrix::drawFillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint
          * b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
          */
         if (a > b) {
-            _swap_byte(a, b);
+            _swap_int16(a, b);
         }
-        drawHLine(a, y, b-a+1, value);
+        _drawHSpan(a, y, b-a+1, value);
     }
     
     /* For lower part of triangle, find scanline crossings for segments
@@ -497,68 +1058,61 @@ void MAX7219CWGMatrix::drawFillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint
          * b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
          */
         if (a > b) {
-            _swap_byte(a, b);
+            _swap_int16(a, b);
         }
-        drawHLine(a, y, b-a+1, value);
+        _drawHSpan(a, y, b-a+1, value);
     }
 }
 
 /**************************************************************************/
 /*!
-  @brief    Draws a character.
+  @brief    Draws a character. The glyph is looked up directly and drawn
+            row by row from the transposed font.
   @param    x           x coordinate of most left column of leds
   @param    y           y coordinate of lowest row of leds
   @param    character   Character to be drawn
   @param    value       Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawChar(uint8_t x, uint8_t y, char character, uint8_t value) {
-    uint8_t i = 0;
-    uint8_t bitCounter = 0b00000001;
+void MAX7219CWGMatrix::drawChar(int16_t x, int16_t y, char character, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y};
+        _displayList->record(DISPLAY_LIST_CHAR, value, args, 2, (const uint8_t*) &character, 1);
+        return;
+    }
 
-    if (_font == FONT_3X5) {
-        while (i < FONT_3X5_SIZE) {
-            if (character == FontToIndex3x5[i]) {
-                break;
-            }
-            i++;
-        }
-    } else if (_font == FONT_4X6) {
-        while (i < FONT_4X6_SIZE) {
-            if (character == FontToIndex4x6[i]) {
-                break;
-            }
-            i++;
-        }
-    } else if (_font == FONT_5X7) {
-        while (i < FONT_5X7_SIZE) {
-            if (character == FontToIndex5x7[i]) {
-                break;
-            }
-            i++;
-        }
+    uint8_t c = character;
+    uint8_t index = 0;                                                      //Unknown characters are drawn as a space
+
+    if (c >= ' ' && c < 128) {
+        index = pgm_read_byte(_fontIndex + (c - ' '));
     }
-    
-    uint16_t memAddress = i*_fontCols;
-    uint8_t columnValue = 0;
-        
-    for (uint8_t column = 0; column < _fontCols; column++) {
-        for (uint8_t row = _fontRows; row > 0; row--) {
-            if (_font == FONT_3X5) {
-                columnValue = pgm_read_byte_near(Font3x5 + (memAddress+column));  
-            } else if (_font == FONT_4X6) {
-                columnValue = pgm_read_byte_near(Font4x6 + (memAddress+column));
-            } else if (_font == FONT_5X7) {
-                columnValue = pgm_read_byte_near(Font5x7 + (memAddress+column));
-            }
 
-            if (columnValue & bitCounter) {
-                drawPixel(x+column, y+row-1, value);
-            }
-            bitCounter = bitCounter << 1;
-        }
-        bitCounter = 0b00000001;
+    const uint8_t* glyph = _fontGlyphs + index*_fontRows;
+
+    for (uint8_t row = 0; row < _fontRows; row++) {
+        _drawRowBits(x, y+row, pgm_read_byte(glyph + row), value);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws up to 8 pixels of one row at once.
+  @param    x               X coordinate of the most significant bit
+  @param    y               Y coordinate
+  @param    bits            Pixels to draw, leftmost pixel in the most
+                            significant bit. Zero bits are left untouched.
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::drawRow(int16_t x, int16_t y, uint8_t bits, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y, bits};
+        _displayList->record(DISPLAY_LIST_ROW, value, args, 3);
+        return;
     }
+
+    _drawRowBits(x, y, bits, value);
 }
 
 /**************************************************************************/
@@ -571,7 +1125,13 @@ void MAX7219CWGMatrix::drawChar(uint8_t x, uint8_t y, char character, uint8_t va
   @param    value           Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::drawString(uint8_t x, uint8_t y, char string[], uint8_t length, uint8_t value) {
+void MAX7219CWGMatrix::drawString(int16_t x, int16_t y, const char string[], uint8_t length, uint8_t value) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y};
+        _displayList->record(DISPLAY_LIST_STRING, value, args, 2, (const uint8_t*) string, length);
+        return;
+    }
+
     for (int character = 0; character < length; character++) {
         drawChar(x+character+(character*_fontCols), y, string[character], value);
     }
@@ -579,200 +1139,1496 @@ void MAX7219CWGMatrix::drawString(uint8_t x, uint8_t y, char string[], uint8_t l
 
 /**************************************************************************/
 /*!
-  @brief    Returns the value of a pixel.
-  @param    x               X coordinate of the pixel
-  @param    y               Y coordinate of the pixel
-  @returns  value           Value of the pixel (for now 0 or 1)
-*/
+  @brief    Draws a 1 bit per pixel bitmap, a row at a time: the bits are
+            shifted into the bytes of the display buffer they cover. Rows
+            are ceil(w/8) bytes, leftmost pixel in the most significant
+            bit, row 0 is drawn at y. The bitmap may be in flash.
+  @param    x               X coordinate of the leftmost column
+  @param    y               Y coordinate of row 0
+  @param    bitmap          Packed rows
+  @param    w               Width in pixels
+  @param    h               Height in pixels
+  @param    rasterOp        RASTER_OP_COPY, _OR, _AND, _XOR or _MASK
+  @param    mask            Packed rows like the bitmap, only pixels that
+                            are on in the mask are drawn. nullptr to draw
+                            the whole rectangle
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], uint16_t w, uint16_t h, uint8_t rasterOp, const uint8_t mask[]) {
+    if (_displayList != nullptr) {
+        int16_t args[] = {x, y, (int16_t) w, (int16_t) h, mask != nullptr};
+        uint16_t length = (w + 7)/8*h;
+
+        _displayList->record(DISPLAY_LIST_BITMAP, rasterOp, args, 5, bitmap, length, mask, mask != nullptr ? length : 0);
+        return;
+    }
+
+    if (rasterOp > RASTER_OP_MASK) {
+        debugln("ERROR: Raster operation does not exist.");
+        return;
+    }
+
+    /* Columns of the bitmap that are on the display */
+    int16_t firstColumn = x < 0 ? -x : 0;
+    int16_t lastColumn = min((int32_t) w, (int32_t) _width - x) - 1;
+    uint16_t rowBytes = (w + 7) / 8;
+
+    if (lastColumn < firstColumn) {
+        return;
+    }
+
+    for (uint16_t r = 0; r < h; r++) {
+        int16_t rowY = y + r;
+        const uint8_t* source = bitmap + r*rowBytes;
+        const uint8_t* maskRow = mask != nullptr ? mask + r*rowBytes : nullptr;
+
+        if (rowY < 0 || rowY >= _height) {
+            continue;
+        }
+
+        /* With a quarter rotation the row is a column of the buffer */
+        if (_transform[0] == 0) {
+            for (int16_t c = firstColumn; c <= lastColumn; c++) {
+                uint8_t bit = 0x80 >> (c & 7);
+
+                if (maskRow == nullptr || (pgm_read_byte(maskRow + c/8) & bit)) {
+                    _blitPixel(x + c, rowY, pgm_read_byte(source + c/8) & bit, rasterOp);
+                }
+            }
+            continue;
+        }
+
+        /* Map both ends of the visible part, a mirrored row is read backwards */
+        int16_t bx0 = x + firstColumn;
+        int16_t bx1 = x + lastColumn;
+        int16_t by = rowY;
+        int16_t by1 = rowY;
+        _mapPoint(bx0, by);
+        _mapPoint(bx1, by1);
+
+        _blitRow(by, bx0, bx1, source, maskRow, rowBytes, firstColumn, bx1 < bx0, rasterOp);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the value of a pixel.
+  @param    x               X coordinate of the pixel
+  @param    y               Y coordinate of the pixel
+  @returns  value           Value of the pixel (0 or 1, gray level with
+                            more than 1 bit per pixel)
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getPixel(int16_t x, int16_t y) {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) {
+        debugln("ERROR: Invalid x or y coordinate given while asking value.");
+        return 0;
+    }
+
+    _mapPoint(x, y);
+
+    uint16_t offset = y*_numSegmentsHorizontal + x/COLUMN_SIZE;
+    uint16_t b = 7 - (x & 7);
+    uint8_t value = 0;
+
+    /* Collect the bit of every plane */
+    for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+        value |= ((_plane(plane)[offset] >> b) & 1) << plane;
+    }
+    return value;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the end of a line under an angle, rounded to the
+            nearest pixel. Uses the sine table, no floating point math.
+  @param    x0              Start x coordinate
+  @param    y0              Start y coordinate
+  @param    l               Length in pixels
+  @param    angle           Angle in 1/ANGLE_STEPS_PER_DEGREE degrees
+  @param    x               Returns the end x coordinate
+  @param    y               Returns the end y coordinate
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::getAnglePoint(int16_t x0, int16_t y0, int16_t l, uint16_t angle, int16_t& x, int16_t& y) {
+    angle %= FULL_ANGLE;
+
+    x = x0 + _scale(l, _sine(angle));
+    y = y0 + _scale(l, _sine((angle + FULL_ANGLE/4) % FULL_ANGLE));       //Cosine
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width in pixels.
+  @returns  _width          Width in pixels
+*/
+/**************************************************************************/
+uint16_t MAX7219CWGMatrix::getWidth() {
+    return _width;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the height in pixels.
+  @returns  _height         Height in pixels
+*/
+/**************************************************************************/
+uint16_t MAX7219CWGMatrix::getHeight() {
+    return _height;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the wiring type.
+  @returns  _wiringType     Type of circuit
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getWiring() {
+    return _wiringType;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the rotation.
+  @returns  _rotation       Rotation of the display
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getRotation() {
+    return _rotation;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the font.
+  @returns  _font           Number of the font
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getFont() {
+    return _font;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of horizontal segments.
+  @returns  _numSegmentsHorizontal  Number of segments
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getSegmentsHorizontal() {
+    return _numSegmentsHorizontal;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of vertical segments.
+  @returns  _numSegmentsVertical    Number of segments
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getSegmentsVertical() {
+    return _numSegmentsVertical;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of columns in the selected font.
+  @returns  _fontCols       Number of columns
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getFontCols() {
+    return _fontCols;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of rows in the selected font.
+  @returns  _fontRows       Number of rows
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getFontRows() {
+    return _fontRows;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns one row of a glyph of the selected font.
+  @param    character       Character
+  @param    row             Row of the glyph, 0 is the top row
+  @returns  Pixels of the row, leftmost pixel in the most significant bit
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getGlyphRow(char character, uint8_t row) {
+    uint8_t c = character;
+    uint8_t index = 0;
+
+    if (row >= _fontRows) {
+        return 0;
+    }
+
+    if (c >= ' ' && c < 128) {
+        index = pgm_read_byte(_fontIndex + (c - ' '));
+    }
+    return pgm_read_byte(_fontGlyphs + index*_fontRows + row);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the power state.
+  @returns  _power          True if power is on  
+*/
+/**************************************************************************/
+bool MAX7219CWGMatrix::getPower() {
+    return _power;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the intensity.
+  @returns  _intensity      0 = lowest, 15 = highest
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getIntensity() {
+    return _intensity;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if display is inverted.
+  @returns  _inverted       True if display is inverted.
+*/
+/**************************************************************************/
+bool MAX7219CWGMatrix::getInverted() {
+    return _inverted;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of bits per pixel.
+  @returns  _bitsPerPixel   1 for on/off, more for grayscale
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::getBitsPerPixel() {
+    return _bitsPerPixel;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the time the least significant bit plane is shown.
+  @returns  _subFrameTime   Time in us
+*/
+/**************************************************************************/
+uint32_t MAX7219CWGMatrix::getSubFrameTime() {
+    return _subFrameTime;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the size of a frame with 1 bit per pixel, the size of
+            the display buffer.
+  @returns  Size in bytes
+*/
+/**************************************************************************/
+uint16_t MAX7219CWGMatrix::getFrameSize() {
+    return _numSegments*ROW_SIZE;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of SPI words display() did not have to send,
+            because the digit row was already latched in the chips.
+  @returns  _skippedWords   Number of skipped 16-bit words
+*/
+/**************************************************************************/
+uint32_t MAX7219CWGMatrix::getSkippedWords() {
+    return _skippedWords;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Resets the skipped words counter.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::resetSkippedWords() {
+    _skippedWords = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shoots the display buffer in the display. Calculates order
+            depending on the wiring type. Digit rows that are unchanged
+            since the last call are skipped.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::display() {
+    _transport->waitIdle();                                                 //Do not interleave with an asynchronous flush
+    metricsStart(TIMER_FLUSH);
+
+    if (_powerSaving) {
+        _updateSegmentPower();
+    }
+
+    uint8_t* buffer = _txBuffer[_txIndex];
+    uint8_t numRows = 0;
+
+    for (uint8_t r = 0; r < ROW_SIZE; r++) {
+        /* Skip the transaction if every segment already shows this row */
+        if (!_isRowChanged(r)) {
+            _skippedWords += _numSegments;
+            continue;
+        }
+
+        uint16_t length = _packRow(r, buffer);
+        _transport->write(buffer, length);
+        metricsCount(COUNTER_WORDS, length/2);
+        numRows++;
+    }
+    _dirtyRows = 0;
+    _shadowValid = true;
+
+    metricsCount(COUNTER_TRANSACTIONS, numRows);
+    metricsCount(COUNTER_FRAMES, 1);
+    metricsCount(COUNTER_SKIPPED_FRAMES, numRows == 0);
+    metricsStop(TIMER_FLUSH);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Packs the changed rows of the display buffer in a transmit
+            buffer and hands it to the transport in one bulk transfer.
+            Returns without waiting for the bus, so the next frame can be
+            drawn while this one is sent. Two transmit buffers are used
+            in turn, so the next call only waits if the previous flush is
+            still running.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::displayAsync() {
+    metricsStart(TIMER_FLUSH);
+
+    if (_powerSaving) {
+        _updateSegmentPower();
+    }
+
+    uint8_t* buffer = _txBuffer[_txIndex];                                  //Not in flight, the other one may be
+    uint16_t frameLength = _numSegments*2;
+    uint8_t numFrames = 0;
+
+    for (uint8_t r = 0; r < ROW_SIZE; r++) {
+        if (!_isRowChanged(r)) {
+            _skippedWords += _numSegments;
+            continue;
+        }
+
+        _packRow(r, buffer + numFrames*frameLength);
+        numFrames++;
+    }
+    _dirtyRows = 0;
+    _shadowValid = true;
+
+    metricsCount(COUNTER_FRAMES, 1);
+    metricsCount(COUNTER_SKIPPED_FRAMES, numFrames == 0);
+
+    if (numFrames == 0) {
+        metricsStop(TIMER_FLUSH);
+        return;
+    }
+
+    metricsCount(COUNTER_WORDS, numFrames*_numSegments);
+    metricsCount(COUNTER_TRANSACTIONS, numFrames);
+    metricsStop(TIMER_FLUSH);                                               //Before waiting for the previous flush
+
+    _transport->waitIdle();
+    _transport->writeAsync(buffer, frameLength, numFrames);
+    _txIndex ^= 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if an asynchronous flush is still in progress.
+  @returns  True if the bus is still busy with the last displayAsync()
+*/
+/**************************************************************************/
+bool MAX7219CWGMatrix::isFlushing() {
+    return _transport->isBusy();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Blocks until the last asynchronous flush is finished.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::waitForFlush() {
+    _transport->waitIdle();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets a function that is called when an asynchronous flush is
+            finished.
+  @param    callback        Function to call, nullptr to disable
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::setFlushCallback(void (*callback)()) {
+    _transport->setCallback(callback);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shows the next bit plane when the current one has been shown
+            long enough (binary code modulation). Plane n is shown
+            subFrameTime << n us, so every pixel is on for a part of the
+            time proportional to its gray level. Call it from the main
+            loop as often as possible, it returns immediately.
+  @param    nowUs           Current time in us, for example micros()
+  @returns  True if a sub-frame has been sent
+*/
+/**************************************************************************/
+bool MAX7219CWGMatrix::updateGrayscale(uint32_t nowUs) {
+    if (_planes == nullptr) {
+        return false;
+    }
+
+    if (_subFrameShown) {
+        uint32_t duration = _subFrameTime << _subFramePlane;
+
+        if (nowUs - _subFrameStart < duration) {
+            return false;
+        }
+
+        _subFrameStart += duration;
+        _subFramePlane++;
+
+        if (_subFramePlane == _bitsPerPixel) {
+            _subFramePlane = 0;
+        }
+
+        /* Too late for a whole sub-frame, start counting again from now */
+        if (nowUs - _subFrameStart >= _subFrameTime) {
+            _subFrameStart = nowUs;
+        }
+    } else {
+        _subFrameShown = true;
+        _subFramePlane = 0;
+        _subFrameStart = nowUs;
+    }
+
+    /* A sub-frame is a copy of the plane, display() only sends the rows that differ */
+    memcpy(_matrix, _planes + _subFramePlane*_numSegments*ROW_SIZE, _numSegments*ROW_SIZE);
+    _dirtyRows = 0xFF;
+    display();
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies a frame into the display buffer. Only marks the rows
+            that changed for the next display().
+  @param    frame           Frame of getFrameSize() bytes with the layout
+                            of the display buffer
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::loadFrame(const uint8_t* frame) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be loaded with 1 bit per pixel.");
+        return;
+    }
+
+    uint8_t* row = _matrix;
+
+    for (uint16_t y = 0; y < _numSegmentsVertical*ROW_SIZE; y++) {
+        if (memcmp(row, frame, _numSegmentsHorizontal) != 0) {
+            memcpy(row, frame, _numSegmentsHorizontal);
+            _dirtyRows |= 1 << (y & 7);
+        }
+        row += _numSegmentsHorizontal;
+        frame += _numSegmentsHorizontal;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    XORs bytes into the display buffer, for example a delta of an
+            Animation. Only marks the rows that changed for the next
+            display().
+  @param    position        Position in the frame layout of loadFrame()
+  @param    data            Bytes to XOR
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::xorFrame(uint16_t position, const uint8_t* data, uint16_t length) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be loaded with 1 bit per pixel.");
+        return;
+    }
+    if ((uint32_t) position + length > getFrameSize()) {
+        debugln("ERROR: Delta does not fit in the frame.");
+        return;
+    }
+
+    uint16_t y = position / _numSegmentsHorizontal;
+    uint8_t x = position % _numSegmentsHorizontal;
+    uint8_t* row = _matrix + y*_numSegmentsHorizontal;
+
+    for (uint16_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            row[x] ^= data[i];
+            _dirtyRows |= 1 << (y & 7);
+        }
+
+        if (++x == _numSegmentsHorizontal) {
+            x = 0;
+            y++;
+            row += _numSegmentsHorizontal;
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Exchanges the display buffer with a frame, for example to keep
+            the shown frame while the next one is drawn.
+  @param    frame           Frame of getFrameSize() bytes, laid out like
+                            loadFrame(), receives the display buffer
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::swapFrame(uint8_t* frame) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be swapped with 1 bit per pixel.");
+        return;
+    }
+
+    for (uint16_t i = 0; i < getFrameSize(); i++) {
+        uint8_t t = _matrix[i];
+        _matrix[i] = frame[i];
+        frame[i] = t;
+    }
+    _dirtyRows = 0xFF;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shifts the display buffer n pixels, in place. The pixels that
+            shift in are taken from a source frame that lies next to the
+            display, so shifting a whole width or height in steps slides
+            the source in.
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN, the way the
+                            content moves
+  @param    n               Number of pixels
+  @param    source          Frame laid out like loadFrame(), nullptr to
+                            shift in empty pixels
+  @param    offset          Pixels of the source that have shifted in
+                            before
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::shiftFrame(uint8_t direction, uint16_t n, const uint8_t* source, uint16_t offset) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be shifted with 1 bit per pixel.");
+        return;
+    }
+
+    uint8_t bufferDirection = _bufferDirection(direction);
+    uint16_t rowBytes = _numSegmentsHorizontal;
+    uint16_t width = rowBytes*COLUMN_SIZE;
+    uint16_t height = _numSegmentsVertical*ROW_SIZE;
+    uint16_t size = bufferDirection == SHIFT_LEFT || bufferDirection == SHIFT_RIGHT ? width : height;
+
+    if ((uint32_t) offset + n > size) {
+        debugln("ERROR: Shift out of the source frame.");
+        return;
+    }
+    if (n == 0) {
+        return;
+    }
+
+    switch (bufferDirection) {
+        case SHIFT_LEFT:
+        case SHIFT_RIGHT: {
+            /* Pixels shift in at the right when moving left, from the left of the source onwards */
+            bool left = bufferDirection == SHIFT_LEFT;
+            uint16_t x = left ? width - n : 0;
+            uint16_t sourceX = left ? offset : width - offset - n;
+
+            for (uint16_t y = 0; y < height; y++) {
+                uint8_t* row = _matrix + y*rowBytes;
+
+                _shiftRow(row, left ? n : -n);
+                if (source != nullptr) {
+                    _copyBits(row, x, source + y*rowBytes, sourceX, n);
+                }
+            }
+            break;
+        }
+        case SHIFT_UP:
+            memmove(_matrix, _matrix + n*rowBytes, (height - n)*rowBytes);
+            if (source != nullptr) {
+                memcpy(_matrix + (height - n)*rowBytes, source + offset*rowBytes, n*rowBytes);
+            } else {
+                memset(_matrix + (height - n)*rowBytes, 0, n*rowBytes);
+            }
+            break;
+        case SHIFT_DOWN:
+            memmove(_matrix + n*rowBytes, _matrix, (height - n)*rowBytes);
+            if (source != nullptr) {
+                memcpy(_matrix, source + (height - offset - n)*rowBytes, n*rowBytes);
+            } else {
+                memset(_matrix, 0, n*rowBytes);
+            }
+            break;
+    }
+    _dirtyRows = 0xFF;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the pixels of a source frame that an edge moving over
+            the display has passed, in place. Wiping a whole width or
+            height in steps replaces the display buffer with the source.
+  @param    source          Frame laid out like loadFrame()
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN, the way the
+                            edge moves
+  @param    position        Pixels the edge has moved from its side
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::wipeFrame(const uint8_t* source, uint8_t direction, uint16_t position) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be wiped with 1 bit per pixel.");
+        return;
+    }
+
+    uint8_t bufferDirection = _bufferDirection(direction);
+    uint16_t rowBytes = _numSegmentsHorizontal;
+    uint16_t width = rowBytes*COLUMN_SIZE;
+    uint16_t height = _numSegmentsVertical*ROW_SIZE;
+
+    switch (bufferDirection) {
+        case SHIFT_LEFT:
+        case SHIFT_RIGHT: {
+            position = min(position, width);
+            uint16_t x = bufferDirection == SHIFT_LEFT ? width - position : 0;
+
+            for (uint16_t y = 0; y < height; y++) {
+                _copyBits(_matrix + y*rowBytes, x, source + y*rowBytes, x, position);
+            }
+            break;
+        }
+        case SHIFT_UP:
+        case SHIFT_DOWN: {
+            position = min(position, height);
+            uint16_t y = bufferDirection == SHIFT_UP ? height - position : 0;
+
+            memcpy(_matrix + y*rowBytes, source + y*rowBytes, position*rowBytes);
+            break;
+        }
+    }
+    _dirtyRows = 0xFF;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the pixels of a source frame where a mask is on, a word
+            at a time, for wipes of any shape.
+  @param    source          Frame laid out like loadFrame()
+  @param    mask            Frame laid out like loadFrame()
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::blendFrame(const uint8_t* source, const uint8_t* mask) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be blended with 1 bit per pixel.");
+        return;
+    }
+
+    _blendRows(0, _numSegmentsVertical*ROW_SIZE, source, mask, 0);
+    _dirtyRows = 0xFF;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies a share of the pixels of a source frame in an ordered
+            dither pattern, in place. Every pixel that is copied at a level
+            is copied at the higher levels too, so stepping the level up to
+            DISSOLVE_LEVELS dissolves the display buffer into the source.
+  @param    source          Frame laid out like loadFrame()
+  @param    level           Pixels copied in 1/DISSOLVE_LEVELS
+                            (0-DISSOLVE_LEVELS)
+  @param    seed            Moves the pattern, use the same seed for all
+                            levels of a dissolve
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::dissolveFrame(const uint8_t* source, uint8_t level, uint8_t seed) {
+    if (_planes != nullptr) {
+        debugln("ERROR: Frames can only be dissolved with 1 bit per pixel.");
+        return;
+    }
+
+    /* The pattern repeats every 8 pixels, so a byte of mask is the same for every byte of a row */
+    uint8_t masks[ROW_SIZE];
+    uint8_t shiftX = seed & 7;
+    uint8_t shiftY = (seed >> 3) & 7;
+
+    for (uint8_t y = 0; y < ROW_SIZE; y++) {
+        masks[y] = 0;
+        for (uint8_t x = 0; x < COLUMN_SIZE; x++) {
+            if (pgm_read_byte(&BayerMatrix[(y + shiftY) & 7][(x + shiftX) & 7]) < level) {
+                masks[y] |= 0x80 >> x;
+            }
+        }
+    }
+
+    _blendRows(0, _numSegmentsVertical*ROW_SIZE, source, masks, ROW_SIZE);
+    _dirtyRows = 0xFF;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Clears display buffer.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::clear() {
+    if (_displayList != nullptr) {
+        _displayList->record(DISPLAY_LIST_CLEAR, 0, nullptr, 0);
+        return;
+    }
+
+    uint8_t* data = _matrix;
+
+    if (_planes != nullptr) {
+        memset(_planes, 0, _bitsPerPixel*_numSegments*ROW_SIZE);
+    }
+
+    for (uint16_t y = 0; y < _numSegmentsVertical*ROW_SIZE; y++) {
+        for (uint8_t x = 0; x < _numSegmentsHorizontal; x++, data++) {
+            if (*data != 0) {
+                *data = 0;
+                _dirtyRows |= 1 << (y & 7);
+            }
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of bytes of memory a display needs, for
+            passing a buffer to the constructor or initialiseMatrix().
+  @param    numSegmentsHorizontal   Number of horizontal segments
+  @param    numSegmentsVertical     Number of vertical segments
+  @returns  Size in bytes
+*/
+/**************************************************************************/
+uint32_t MAX7219CWGMatrix::getBufferSize(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical) {
+    return MAX7219_BUFFER_SIZE(numSegmentsHorizontal, numSegmentsVertical);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends a command to the displays.
+  @param    command         Command do execute (see datasheet)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_sendCommand(uint16_t command) {
+    uint8_t* buffer = _txBuffer[_txIndex];                                  //Not in flight
+
+    /* Send the same command to all segments */
+    for (uint16_t i = 0; i < _numSegments; ++i) {
+        buffer[2*i] = command >> 8;
+        buffer[2*i+1] = command & 0xFF;
+    }
+
+    _transport->waitIdle();
+    metricsStart(TIMER_COMMAND);
+    _transport->write(buffer, _numSegments*2);
+    metricsStop(TIMER_COMMAND);
+
+    metricsCount(COUNTER_COMMANDS, 1);
+    metricsCount(COUNTER_WORDS, _numSegments);
+    metricsCount(COUNTER_TRANSACTIONS, 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends a different command to every segment in one chip-select
+            frame.
+  @param    commands        One command per segment, index is
+                            segmentY*segmentsHorizontal + segmentX in
+                            drawing coordinates. OPCODE_NOOP leaves a
+                            segment untouched.
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::sendSegmentCommands(const uint16_t commands[]) {
+    uint8_t* buffer = _txBuffer[_txIndex];                                  //Not in flight
+    uint8_t segmentsHorizontal = _width/COLUMN_SIZE;
+    uint8_t segmentsVertical = _height/ROW_SIZE;
+
+    for (uint8_t segmentY = 0; segmentY < segmentsVertical; segmentY++) {
+        for (uint8_t segmentX = 0; segmentX < segmentsHorizontal; segmentX++) {
+            _packCommand(buffer, _segmentIndex(segmentX, segmentY), commands[segmentY*segmentsHorizontal + segmentX]);
+        }
+    }
+
+    _transport->waitIdle();
+    _transport->write(buffer, _numSegments*2);
+    metricsCount(COUNTER_WORDS, _numSegments);
+    metricsCount(COUNTER_TRANSACTIONS, 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends a command to one segment, the others get a no-op.
+  @param    segmentX        Segment column, in drawing coordinates
+  @param    segmentY        Segment row, in drawing coordinates
+  @param    command         Command do execute (see datasheet)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_sendSegmentCommand(uint8_t segmentX, uint8_t segmentY, uint16_t command) {
+    uint8_t* buffer = _txBuffer[_txIndex];                                  //Not in flight
+    int32_t segment = _segmentIndex(segmentX, segmentY);
+
+    if (segment < 0) {
+        debugln("ERROR: Invalid segment given. Ignoring it.");
+        return;
+    }
+
+    memset(buffer, 0, _numSegments*2);                                      //No-op for all other segments
+    _packCommand(buffer, segment, command);
+
+    _transport->waitIdle();
+    _transport->write(buffer, _numSegments*2);
+    metricsCount(COUNTER_WORDS, _numSegments);
+    metricsCount(COUNTER_TRANSACTIONS, 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Puts a command for one segment at its position in a
+            chip-select frame.
+  @param    buffer          Frame, 2 bytes per segment
+  @param    segment         Index of the segment in the display buffer
+  @param    command         Command do execute (see datasheet)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_packCommand(uint8_t* buffer, uint16_t segment, uint16_t command) {
+    uint16_t position = _segmentMap[segment] & ~SEGMENT_FLIPPED;
+
+    buffer[2*position] = command >> 8;
+    buffer[2*position+1] = command & 0xFF;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shuts down segments that have no led on and turns the others
+            on. Only sends a frame if a segment changes state.
+*/
 /**************************************************************************/
-uint8_t MAX7219CWGMatrix::getPixel(uint8_t x, uint8_t y) {
-    if (x > _numSegmentsHorizontal*COLUMN_SIZE || y > _numSegmentsVertical*ROW_SIZE) {
-        debugln("ERROR: Invalid x or y coordinate given while asking value.");
-        return 0;
+void MAX7219CWGMatrix::_updateSegmentPower() {
+    uint8_t* buffer = _txBuffer[_txIndex];                                  //Not in flight
+    uint8_t offData = _inverted ? 0xFF : 0x00;                              //Buffer value of a row without leds on
+    bool changed = false;
+
+    memset(buffer, 0, _numSegments*2);
+
+    for (uint16_t segment = 0; segment < _numSegments; segment++) {
+        uint8_t* data = _matrix + (segment / _numSegmentsHorizontal)*ROW_SIZE*_numSegmentsHorizontal + segment % _numSegmentsHorizontal;
+        bool blank = true;
+
+        for (uint8_t r = 0; r < ROW_SIZE && blank; r++, data += _numSegmentsHorizontal) {
+            blank = *data == offData;
+        }
+
+        bool on = _power && !blank;
+
+        if (on != (bool) _segmentPower[segment]) {
+            _segmentPower[segment] = on;
+            _packCommand(buffer, segment, OPCODE_ENABLE | (on ? 1: 0));
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        _transport->waitIdle();
+        _transport->write(buffer, _numSegments*2);
+        metricsCount(COUNTER_WORDS, _numSegments);
+        metricsCount(COUNTER_TRANSACTIONS, 1);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the index of a segment in the display buffer
+            (segment row * segments horizontal + segment column).
+  @param    segmentX        Segment column, in drawing coordinates
+  @param    segmentY        Segment row, in drawing coordinates
+  @returns  Index of the segment, -1 if it does not exist
+*/
+/**************************************************************************/
+int32_t MAX7219CWGMatrix::_segmentIndex(uint8_t segmentX, uint8_t segmentY) {
+    if (segmentX >= _width/COLUMN_SIZE || segmentY >= _height/ROW_SIZE) {
+        return -1;
     }
 
-	uint16_t b = 7 - (x & 7);
+    /* Any pixel of the segment lands in the buffer segment */
+    int16_t x = segmentX*COLUMN_SIZE;
+    int16_t y = segmentY*ROW_SIZE;
+    _mapPoint(x, y);
 
-	return _matrix[x][y] & (1 << b);                                        //Return extracted bit
+    return (y/ROW_SIZE)*_numSegmentsHorizontal + x/COLUMN_SIZE;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Returns the width in pixels.
-  @returns  _width          Width in pixels
+  @brief    Packs one digit row of all segments in the order of the daisy
+            chain. The order comes from the segment map of the wiring
+            type. Updates the shadow copy.
+  @param    r           Digit row (0-7)
+  @param    buffer      Buffer to write to, [register, data] per segment
+  @returns  Number of bytes written
 */
 /**************************************************************************/
-uint8_t MAX7219CWGMatrix::getWidth() {
-    return _width;
+uint16_t MAX7219CWGMatrix::_packRow(uint8_t r, uint8_t* buffer) {
+    uint8_t invert = _inverted ? 0xFF : 0x00;
+    uint8_t digit = ROW_SIZE - r;                                           //Register of this row
+    uint8_t flippedDigit = r + 1;                                           //Register of this row on an upside down segment
+    const uint16_t* map = _segmentMap;
+
+    for (uint8_t segRow = 0; segRow < _numSegmentsVertical; segRow++) {
+        uint16_t offset = (r + segRow*ROW_SIZE)*_numSegmentsHorizontal;
+        const uint8_t* row = _matrix + offset;
+
+        memcpy(_shadow + offset, row, _numSegmentsHorizontal);
+
+        for (uint8_t d = 0; d < _numSegmentsHorizontal; d++, map++) {
+            uint8_t* word = buffer + 2*(*map & ~SEGMENT_FLIPPED);
+            uint8_t data = row[d] ^ invert;
+
+            if (*map & SEGMENT_FLIPPED) {
+                word[0] = flippedDigit;
+                word[1] = pgm_read_byte(&BitReverse[data]);
+            } else {
+                word[0] = digit;
+                word[1] = data;
+            }
+        }
+    }
+    return _numSegments*2;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Returns the height in pixels.
-  @returns  _height         Height in pixels
+  @brief    Checks if a digit row has to be sent to the chips.
+  @param    r           Digit row (0-7)
+  @returns  True if any segment differs from what is latched
 */
 /**************************************************************************/
-uint8_t MAX7219CWGMatrix::getHeight() {
-    return _height;
+bool MAX7219CWGMatrix::_isRowChanged(uint8_t r) {
+    if (!_shadowValid) {
+        return true;
+    }
+
+    if (!(_dirtyRows & (1 << r))) {
+        return false;
+    }
+
+    /* Row is marked, compare with the shadow (pixel could be drawn and erased again) */
+    for (uint8_t segRow = 0; segRow < _numSegmentsVertical; segRow++) {
+        uint16_t offset = (r + segRow*ROW_SIZE)*_numSegmentsHorizontal;
+
+        if (memcmp(_matrix + offset, _shadow + offset, _numSegmentsHorizontal) != 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Returns the number of columns in the selected font.
-  @returns  _fontCols       Number of columns
+  @brief    A helper function used to reverse bits in a byte.
+  @param    b           Pointer to an 8-bit unsigned integer
 */
 /**************************************************************************/
-uint8_t MAX7219CWGMatrix::getFontCols() {
-    return _fontCols;
+void MAX7219CWGMatrix::_reverse(uint8_t& b) {
+    b = pgm_read_byte(&BitReverse[b]);
 }
 
 /**************************************************************************/
 /*!
-  @brief    Returns the power state.
-  @returns  _power          True if power is on  
+  @brief    Maps a point in drawing coordinates to buffer coordinates.
+  @param    x           X coordinate, replaced by the buffer x
+  @param    y           Y coordinate, replaced by the buffer y
 */
 /**************************************************************************/
-bool MAX7219CWGMatrix::getPower() {
-    return _power;
+void MAX7219CWGMatrix::_mapPoint(int16_t& x, int16_t& y) {
+    int16_t bufferX = _transform[0]*x + _transform[1]*y + _transform[2];
+    int16_t bufferY = _transform[3]*x + _transform[4]*y + _transform[5];
+
+    x = bufferX;
+    y = bufferY;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Returns the intensity.
-  @returns  _intensity      0 = lowest, 15 = highest
+  @brief    Returns the sine of a fine angle from the quarter wave table,
+            interpolated between the half degrees.
+  @param    angle           Angle in 1/ANGLE_STEPS_PER_DEGREE degrees
+                            (0 to FULL_ANGLE-1)
+  @returns  Sine times SINE_TABLE_ONE
 */
 /**************************************************************************/
-uint8_t MAX7219CWGMatrix::getIntensity() {
-    return _intensity;
+int32_t MAX7219CWGMatrix::_sine(uint16_t angle) {
+    const uint16_t quarter = FULL_ANGLE/4;
+    const uint8_t stepSize = quarter/SINE_TABLE_STEPS;                      //Fine steps per table entry
+    uint8_t quadrant = angle / quarter;
+    uint16_t position = angle % quarter;
+
+    /* Second and fourth quadrant run back through the table */
+    if (quadrant & 1) {
+        position = quarter - position;
+    }
+
+    uint8_t index = position / stepSize;
+    uint8_t fraction = position % stepSize;
+    int32_t sine = pgm_read_word(&SineTable[index]);
+
+    if (fraction != 0) {
+        int32_t next = pgm_read_word(&SineTable[index+1]);
+        sine += (next - sine)*fraction / stepSize;
+    }
+    return quadrant >= 2 ? -sine : sine;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Returns if display is inverted.
-  @returns  _inverted       True if display is inverted.
+  @brief    Multiplies a length with a sine, rounded half away from zero,
+            so opposite angles give mirrored points.
+  @param    l               Length in pixels
+  @param    sine            Sine times SINE_TABLE_ONE
+  @returns  Rounded product
 */
 /**************************************************************************/
-bool MAX7219CWGMatrix::getInverted() {
-    return _inverted;
+int16_t MAX7219CWGMatrix::_scale(int16_t l, int32_t sine) {
+    bool negative = (l < 0) != (sine < 0);
+    uint32_t product = (uint32_t) abs(l) * (uint32_t) abs(sine);
+    int16_t result = (product + SINE_TABLE_ONE/2) / SINE_TABLE_ONE;
+
+    return negative ? -result : result;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Shoots the display buffer in the display. Calculates order
-            depending on the wiring type.
+  @brief    Returns the buffer of a bit plane.
+  @param    plane       Bit of the gray level (0 is the least significant)
+  @returns  Plane, laid out like the display buffer
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::display() {
-    /* Currently only zigzag wiring supported */
-    if (_wiringType != ZIGZAG_WIRING) {
-        debugln("ERROR: Wiringtype not supported, choose 'ZIGZAG_WIRING'");
+uint8_t* MAX7219CWGMatrix::_plane(uint8_t plane) {
+    if (_drawBuffer != nullptr) {
+        return _drawBuffer;
+    }
+
+    if (_planes == nullptr) {
+        return _matrix;
+    }
+    return _planes + plane*_numSegments*ROW_SIZE;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a value lights a pixel in a bit plane.
+  @param    value       Value to fill, gray level with more than 1 bit
+                        per pixel
+  @param    plane       Bit of the gray level
+  @returns  True if the pixel is on in the plane
+*/
+/**************************************************************************/
+bool MAX7219CWGMatrix::_planeValue(uint8_t value, uint8_t plane) {
+    /* 1 bit per pixel: any value turns the led on */
+    if (_planes == nullptr || _drawBuffer != nullptr) {
+        return value != 0;
+    }
+
+    /* Levels above the highest one are the highest one */
+    if (value >> _bitsPerPixel) {
+        return true;
+    }
+    return (value >> plane) & 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets or clears a horizontal span of pixels. Clipping and
+            rotation are handled once, the span becomes a row or a column
+            of the buffer.
+  @param    x           Start x coordinate, may be off the display
+  @param    y           Y coordinate, may be off the display
+  @param    w           Width in pixels
+  @param    value       Value to fill (0-1)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_drawHSpan(int16_t x, int16_t y, int16_t w, uint8_t value) {
+    /* Clip to the display */
+    if (y < 0 || y >= _height) {
+        return;
+    }
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (x + w > _width) {
+        w = _width - x;
+    }
+    if (w <= 0) {
         return;
     }
 
-    uint8_t rowAddress;
-    uint8_t matrixRow;
-    int16_t r2;
-    
-    for (int16_t r = 0; r < ROW_SIZE; r++){
-        rowAddress = r;
-        if (r >= 2*ROW_SIZE) {
-            rowAddress = r - 2*ROW_SIZE;
-        } else if (r >= ROW_SIZE) {
-            rowAddress = r - ROW_SIZE;
-        }
-      
-        SPI.beginTransaction(SPISettings(5000000, MSBFIRST, SPI_MODE0));
-        digitalWrite(_csPin, 0);
-
-        for (uint8_t segRow = 0; segRow < _numSegmentsVertical; segRow++) {
-            r2 = r + segRow*ROW_SIZE;
-
-            if (segRow % 2 == 1) {
-                matrixRow = rowAddress;
-
-                for (int16_t d = _numSegmentsHorizontal; d != -1; d--) {
-                    uint8_t data = _matrix[d][r2];
-                    if (_inverted) {
-                        data = ~data;
-                    }
-                    _reverse(data);
-                    uint16_t cmd = ((matrixRow + 1) << 8) | data;
-                    SPI.transfer16(cmd);
-                }
-            } else {
-                matrixRow = ROW_SIZE-1-rowAddress;
-
-                for (int16_t d = 0; d != _numSegmentsHorizontal; d++) {
-                    uint8_t data = _matrix[d][r2];
-                    if (_inverted) {
-                        data = ~data;
-                    }
-                    uint16_t cmd = ((matrixRow + 1) << 8) | data;
-                    SPI.transfer16(cmd);
-                }
+    /* Map both ends, the lowest one is the start in the buffer */
+    int16_t x0 = x;
+    int16_t y0 = y;
+    int16_t x1 = x + w - 1;
+    int16_t y1 = y;
+    _mapPoint(x0, y0);
+    _mapPoint(x1, y1);
+
+    if (y0 == y1) {
+        _fillBufferRow(min(x0, x1), y0, w, value);
+    } else {
+        _fillBufferColumn(x0, min(y0, y1), w, value);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets or clears a vertical span of pixels. Clipping and rotation
+            are handled once, the span becomes a column or a row of the
+            buffer.
+  @param    x           X coordinate, may be off the display
+  @param    y           Start y coordinate, may be off the display
+  @param    h           Height in pixels
+  @param    value       Value to fill (0-1)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_drawVSpan(int16_t x, int16_t y, int16_t h, uint8_t value) {
+    /* Clip to the display */
+    if (x < 0 || x >= _width) {
+        return;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (y + h > _height) {
+        h = _height - y;
+    }
+    if (h <= 0) {
+        return;
+    }
+
+    /* Map both ends, the lowest one is the start in the buffer */
+    int16_t x0 = x;
+    int16_t y0 = y;
+    int16_t x1 = x;
+    int16_t y1 = y + h - 1;
+    _mapPoint(x0, y0);
+    _mapPoint(x1, y1);
+
+    if (x0 == x1) {
+        _fillBufferColumn(x0, min(y0, y1), h, value);
+    } else {
+        _fillBufferRow(min(x0, x1), y0, h, value);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets or clears pixels in one row of the buffer. Whole bytes of
+            each segment are written, with a mask for the first and last
+            segment.
+  @param    x           Start x coordinate in the buffer, on the display
+  @param    y           Y coordinate in the buffer, on the display
+  @param    w           Width in pixels, fits on the display
+  @param    value       Value to fill (0-1)
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_fillBufferRow(int16_t x, int16_t y, int16_t w, uint8_t value) {
+    int16_t x1 = x + w - 1;
+    uint8_t first = x/COLUMN_SIZE;
+    uint8_t last = x1/COLUMN_SIZE;
+    uint8_t firstMask = 0xFF >> (x & 7);                                    //Most significant bit is the leftmost pixel
+    uint8_t lastMask = 0xFF << (7 - (x1 & 7));
+    bool changed = false;
+
+    for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+        uint8_t* row = _plane(plane) + y*_numSegmentsHorizontal;
+        bool on = _planeValue(value, plane);
+
+        for (uint8_t segment = first; segment <= last; segment++) {
+            uint8_t mask = 0xFF;
+            if (segment == first) {
+                mask &= firstMask;
+            }
+            if (segment == last) {
+                mask &= lastMask;
+            }
+
+            uint8_t data = on ? (row[segment] | mask) : (row[segment] & ~mask);
+
+            if (data != row[segment]) {
+                row[segment] = data;
+                changed = true;
             }
         }
-        digitalWrite(_csPin, 1);
-        SPI.endTransaction();
+    }
+
+    if (changed) {
+        _dirtyRows |= 1 << (y & 7);
     }
 }
 
 /**************************************************************************/
 /*!
-  @brief    Clears display buffer.
+  @brief    Sets or clears pixels in one column of the buffer, one bit per
+            row.
+  @param    x           X coordinate in the buffer, on the display
+  @param    y           Start y coordinate in the buffer, on the display
+  @param    h           Height in pixels, fits on the display
+  @param    value       Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::clear() {
-    for (uint8_t y = 0; y < _numSegmentsVertical*ROW_SIZE; y++) {
-        for (uint8_t x = 0; x < _numSegmentsHorizontal; x++) {
-            _matrix[x][y] = 0;
+void MAX7219CWGMatrix::_fillBufferColumn(int16_t x, int16_t y, int16_t h, uint8_t value) {
+    uint16_t offset = y*_numSegmentsHorizontal + x/COLUMN_SIZE;
+    uint8_t mask = 1 << (7 - (x & 7));
+
+    for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+        uint8_t* data = _plane(plane) + offset;
+        bool on = _planeValue(value, plane);
+
+        for (int16_t i = y; i < y + h; i++, data += _numSegmentsHorizontal) {
+            uint8_t newData = on ? (*data | mask) : (*data & ~mask);
+
+            if (newData != *data) {
+                *data = newData;
+                _dirtyRows |= 1 << (i & 7);
+            }
         }
     }
 }
 
 /**************************************************************************/
 /*!
-  @brief    Sends a command to the displays.
-  @param    command         Command do execute (see datasheet)
+  @brief    Sets or clears the pixels of up to 8 columns in one row. The
+            bits are shifted into the (at most two) segments they cover.
+  @param    x           X coordinate of the most significant bit
+  @param    y           Y coordinate, may be off the display
+  @param    bits        Pixels to write, leftmost pixel in the most
+                        significant bit. Zero bits are left untouched.
+  @param    value       Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::_sendCommand(uint16_t command) {
-	SPI.beginTransaction(SPISettings(5000000, MSBFIRST, SPI_MODE0));
-	digitalWrite(_csPin, 0);
+void MAX7219CWGMatrix::_drawRowBits(int16_t x, int16_t y, uint8_t bits, uint8_t value) {
+    if (bits == 0 || y < 0 || y >= _height) {
+        return;
+    }
 
-	/* Send the same command to all segments */
-	for (uint8_t i = 0; i < _numSegments; ++i)	{
-		SPI.transfer16(command);
-	}
-    
-	digitalWrite(_csPin, 1);
-	SPI.endTransaction();
+    /* With a quarter rotation the row is a column of the buffer */
+    if (_transform[0] == 0) {
+        for (uint8_t i = 0; i < COLUMN_SIZE; i++) {
+            if (bits & (0x80 >> i)) {
+                drawPixel(x + i, y, value);
+            }
+        }
+        return;
+    }
+
+    /* Map both ends of the 8 pixel window, mirror it if they swapped */
+    int16_t x0 = x;
+    int16_t x1 = x + COLUMN_SIZE-1;
+    int16_t y1 = y;
+    _mapPoint(x0, y);
+    _mapPoint(x1, y1);
+
+    x = x0;
+    if (x1 < x0) {
+        x = x1;
+        _reverse(bits);
+    }
+
+    int16_t first = x >> 3;                                                 //Rounds down for negative x
+    uint16_t window = (bits << 8) >> (x & 7);                               //High byte in segment, low byte in the next
+    bool changed = false;
+
+    for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+        uint8_t* row = _plane(plane) + y*_numSegmentsHorizontal;
+        bool on = _planeValue(value, plane);
+        int16_t segment = first;
+
+        for (uint8_t i = 0; i < 2; i++, segment++) {
+            uint8_t mask = i == 0 ? window >> 8 : window & 0xFF;
+
+            if (mask == 0 || segment < 0 || segment >= _numSegmentsHorizontal) {
+                continue;
+            }
+
+            uint8_t data = on ? (row[segment] | mask) : (row[segment] & ~mask);
+
+            if (data != row[segment]) {
+                row[segment] = data;
+                changed = true;
+            }
+        }
+    }
+
+    if (changed) {
+        _dirtyRows |= 1 << (y & 7);
+    }
 }
 
 /**************************************************************************/
 /*!
-  @brief    A helper function used to reverse bits in a byte.
-  @param    b           Pointer to an 8-bit unsigned integer
+  @brief    Combines one row of a bitmap with a row of the buffer, a byte
+            of the buffer at a time.
+  @param    y           Y coordinate in the buffer
+  @param    bx0         X coordinate in the buffer of the first column
+  @param    bx1         X coordinate in the buffer of the last column
+  @param    source      Packed row of the bitmap
+  @param    mask        Packed row of the mask, nullptr if none
+  @param    rowBytes    Bytes per row
+  @param    column      Column of the bitmap at bx0
+  @param    reversed    True if bx1 is left of bx0 in the buffer
+  @param    rasterOp    Raster operation
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::_reverse(uint8_t& b) {
-    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
-    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
-    b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+void MAX7219CWGMatrix::_blitRow(int16_t y, int16_t bx0, int16_t bx1, const uint8_t* source, const uint8_t* mask, uint16_t rowBytes, int16_t column, bool reversed, uint8_t rasterOp) {
+    int16_t start = reversed ? bx1 : bx0;
+    int16_t end = reversed ? bx0 : bx1;
+    uint8_t first = start/COLUMN_SIZE;
+    uint8_t last = end/COLUMN_SIZE;
+    bool changed = false;
+
+    for (uint8_t segment = first; segment <= last; segment++) {
+        uint8_t window = 0xFF;
+        if (segment == first) {
+            window &= 0xFF >> (start & 7);
+        }
+        if (segment == last) {
+            window &= 0xFF << (7 - (end & 7));
+        }
+
+        /* Column of the bitmap that lands on the most significant bit */
+        int16_t position = column + segment*COLUMN_SIZE - start;
+        if (reversed) {
+            position = column + end - segment*COLUMN_SIZE - (COLUMN_SIZE-1);
+        }
+
+        uint8_t bits = _readBits(source, rowBytes, position);
+        uint8_t affected = window;
+
+        if (mask != nullptr) {
+            affected &= reversed ? pgm_read_byte(&BitReverse[_readBits(mask, rowBytes, position)]) : _readBits(mask, rowBytes, position);
+        }
+        if (reversed) {
+            bits = pgm_read_byte(&BitReverse[bits]);
+        }
+
+        for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+            uint8_t* data = _plane(plane) + y*_numSegmentsHorizontal + segment;
+            uint8_t newData = _rasterOp(*data, bits, affected, rasterOp);
+
+            if (newData != *data) {
+                *data = newData;
+                changed = true;
+            }
+        }
+    }
+
+    if (changed) {
+        _dirtyRows |= 1 << (y & 7);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Combines one pixel of a bitmap with the buffer.
+  @param    x           X coordinate, on the display
+  @param    y           Y coordinate, on the display
+  @param    source      Pixel of the bitmap
+  @param    rasterOp    Raster operation
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_blitPixel(int16_t x, int16_t y, bool source, uint8_t rasterOp) {
+    _mapPoint(x, y);
+
+    uint16_t offset = y*_numSegmentsHorizontal + x/COLUMN_SIZE;
+    uint8_t bit = 0x80 >> (x & 7);
+
+    for (uint8_t plane = 0; plane < _drawPlanes; plane++) {
+        uint8_t* data = _plane(plane) + offset;
+        uint8_t newData = _rasterOp(*data, source ? bit : 0, bit, rasterOp);
+
+        if (newData != *data) {
+            *data = newData;
+            _dirtyRows |= 1 << (y & 7);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns 8 pixels of a packed row, from any column.
+  @param    row         Packed row, may be in flash
+  @param    rowBytes    Bytes per row
+  @param    position    Column of the most significant bit, may be
+                        outside the row
+  @returns  Pixels, outside the row is empty
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::_readBits(const uint8_t* row, uint16_t rowBytes, int16_t position) {
+    int16_t index = position >> 3;                                          //Rounds down for negative positions
+    uint8_t shift = position & 7;
+    uint8_t high = 0;
+    uint8_t low = 0;
+
+    if (index >= 0 && index < rowBytes) {
+        high = pgm_read_byte(row + index);
+    }
+    if (shift != 0 && index+1 >= 0 && index+1 < rowBytes) {
+        low = pgm_read_byte(row + index+1);
+    }
+    return (high << shift) | (low >> (8 - shift));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Combines 8 pixels of a bitmap with a byte of the buffer.
+  @param    data        Byte of the buffer
+  @param    bits        Pixels of the bitmap
+  @param    affected    Pixels that may change
+  @param    rasterOp    Raster operation
+  @returns  New byte of the buffer
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::_rasterOp(uint8_t data, uint8_t bits, uint8_t affected, uint8_t rasterOp) {
+    switch (rasterOp) {
+        case RASTER_OP_COPY:
+            return (data & ~affected) | (bits & affected);
+        case RASTER_OP_OR:
+            return data | (bits & affected);
+        case RASTER_OP_AND:
+            return data & (bits | ~affected);
+        case RASTER_OP_XOR:
+            return data ^ (bits & affected);
+        case RASTER_OP_MASK:
+            return data & ~(bits & affected);
+    }
+    return data;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Quarter-circle drawer with fill, used for circles.
+  @brief    Half-circle drawer with fill, used for circles. Draws
+            horizontal spans.
   @param    x0          Center-point x coordinate
   @param    y0          Center-point y coordinate
   @param    r           Radius of circle
-  @param    corners     Mask bits indicating which quarters we're doing
+  @param    corners     Mask bits indicating which halves we're doing
+                        (1 = lower, 2 = upper)
   @param    delta       Offset from center-point, used for round-rects
   @param    value       Value to fill (0-1)
 */
 /**************************************************************************/
-void MAX7219CWGMatrix::_fillCircleHelper(uint8_t x0, uint8_t y0, int16_t r, uint8_t corners, int16_t delta, uint8_t value) {
+void MAX7219CWGMatrix::_fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint8_t value) {
     int16_t f = 1 - r;
     int16_t ddF_x = 1;
     int16_t ddF_y = -2 * r;
@@ -799,19 +2655,19 @@ void MAX7219CWGMatrix::_fillCircleHelper(uint8_t x0, uint8_t y0, int16_t r, uint
          */
         if (x < (y + 1)) {
             if (corners & 1) {
-                drawVLine(x0+x, y0-y, 2*y+delta, value);
+                _drawHSpan(x0-y, y0+x, 2*y+delta, value);
             }
             if (corners & 2) {
-                drawVLine(x0-x, y0-y, 2*y+delta, value);
+                _drawHSpan(x0-y, y0-x, 2*y+delta, value);
             }
         }
 
         if (y != py) {
             if (corners & 1) {
-                drawVLine(x0+py, y0-px, 2*px+delta, value);
+                _drawHSpan(x0-px, y0+py, 2*px+delta, value);
             }
             if (corners & 2) {
-                drawVLine(x0-py, y0-px, 2*px+delta, value);
+                _drawHSpan(x0-px, y0-py, 2*px+delta, value);
             }
 
             py = y;
@@ -819,3 +2675,149 @@ void MAX7219CWGMatrix::_fillCircleHelper(uint8_t x0, uint8_t y0, int16_t r, uint
         px = x;
     }
 }
+
+/**************************************************************************/
+/*!
+  @brief    Returns the direction in the display buffer of a direction in
+            drawing coordinates.
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN
+  @returns  Direction in the display buffer
+*/
+/**************************************************************************/
+uint8_t MAX7219CWGMatrix::_bufferDirection(uint8_t direction) {
+    int16_t dx = direction == SHIFT_LEFT ? -1 : direction == SHIFT_RIGHT ? 1 : 0;
+    int16_t dy = direction == SHIFT_UP ? -1 : direction == SHIFT_DOWN ? 1 : 0;
+    int16_t bufferX = _transform[0]*dx + _transform[1]*dy;
+    int16_t bufferY = _transform[3]*dx + _transform[4]*dy;
+
+    if (bufferX != 0) {
+        return bufferX < 0 ? SHIFT_LEFT : SHIFT_RIGHT;
+    }
+    return bufferY < 0 ? SHIFT_UP : SHIFT_DOWN;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shifts a packed row of the display buffer, a byte at a time
+            with the carry of the next byte. Empty pixels shift in.
+  @param    row             Packed row
+  @param    n               Pixels to the left, negative to the right
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_shiftRow(uint8_t* row, int16_t n) {
+    int16_t rowBytes = _numSegmentsHorizontal;
+    int16_t bytes = abs(n) >> 3;
+    uint8_t bits = abs(n) & 7;
+
+    if (n > 0) {
+        for (int16_t i = 0; i < rowBytes; i++) {
+            uint8_t high = i + bytes < rowBytes ? row[i + bytes] : 0;
+            uint8_t low = i + bytes + 1 < rowBytes ? row[i + bytes + 1] : 0;
+            row[i] = bits == 0 ? high : (high << bits) | (low >> (8 - bits));
+        }
+    } else {
+        for (int16_t i = rowBytes-1; i >= 0; i--) {
+            uint8_t low = i - bytes >= 0 ? row[i - bytes] : 0;
+            uint8_t high = i - bytes - 1 >= 0 ? row[i - bytes - 1] : 0;
+            row[i] = bits == 0 ? low : (low >> bits) | (high << (8 - bits));
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies pixels from a packed row into a row of the display
+            buffer, whole bytes when both columns are on a byte boundary.
+  @param    row             Packed row to copy into
+  @param    x               First column to copy into
+  @param    source          Packed row to copy from
+  @param    sourceX         First column to copy from
+  @param    count           Number of pixels
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_copyBits(uint8_t* row, uint16_t x, const uint8_t* source, uint16_t sourceX, uint16_t count) {
+    if ((x & 7) == 0 && (sourceX & 7) == 0) {
+        memcpy(row + (x >> 3), source + (sourceX >> 3), count >> 3);
+        x += count & ~7;
+        sourceX += count & ~7;
+        count &= 7;
+    }
+
+    while (count > 0) {
+        uint8_t n = count < 8 ? count : 8;
+        _writeBits(row, x, _readBits(source, _numSegmentsHorizontal, sourceX), n);
+        x += n;
+        sourceX += n;
+        count -= n;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes up to 8 pixels into a packed row of the display buffer.
+  @param    row             Packed row
+  @param    x               Column of the most significant bit
+  @param    bits            Pixels, most significant bit first
+  @param    count           Number of pixels (1-8), must fit in the row
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_writeBits(uint8_t* row, uint16_t x, uint8_t bits, uint8_t count) {
+    uint8_t mask = 0xFF << (8 - count);
+    uint16_t window = (uint16_t) (bits & mask) << 8 >> (x & 7);             //High byte in this byte, low byte in the next
+    uint16_t windowMask = (uint16_t) mask << 8 >> (x & 7);
+    uint16_t index = x >> 3;
+
+    row[index] = (row[index] & ~(windowMask >> 8)) | (window >> 8);
+    if ((windowMask & 0xFF) != 0) {
+        row[index+1] = (row[index+1] & ~windowMask) | (window & 0xFF);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the pixels of a source frame where a mask is on, 32 bits
+            at a time where the frames are aligned.
+  @param    y               First row
+  @param    numRows         Number of rows
+  @param    source          Frame laid out like loadFrame()
+  @param    masks           Mask frame if numMasks is 0, else one byte per
+                            row that is repeated over the row, row y uses
+                            masks[y % numMasks]
+  @param    numMasks        Number of mask bytes, 0 for a mask frame
+*/
+/**************************************************************************/
+void MAX7219CWGMatrix::_blendRows(uint16_t y, uint16_t numRows, const uint8_t* source, const uint8_t* masks, uint8_t numMasks) {
+    uint16_t rowBytes = _numSegmentsHorizontal;
+
+    for (uint16_t r = y; r < y + numRows; r++) {
+        uint8_t* row = _matrix + r*rowBytes;
+        const uint8_t* sourceRow = source + r*rowBytes;
+        const uint8_t* maskRow = numMasks == 0 ? masks + r*rowBytes : nullptr;
+        uint8_t mask = numMasks == 0 ? 0 : masks[r % numMasks];
+        uint16_t i = 0;
+
+        if ((((uintptr_t) row | (uintptr_t) sourceRow | (uintptr_t) maskRow) & 3) == 0) {
+            uint32_t mask32 = mask*0x01010101UL;
+
+            /* Words are loaded and stored with memcpy, the rows are bytes */
+            for (; i + 4 <= rowBytes; i += 4) {
+                uint32_t m = mask32;
+                uint32_t word;
+                uint32_t sourceWord;
+
+                if (maskRow != nullptr) {
+                    memcpy(&m, maskRow + i, 4);
+                }
+                memcpy(&word, row + i, 4);
+                memcpy(&sourceWord, sourceRow + i, 4);
+                word = (word & ~m) | (sourceWord & m);
+                memcpy(row + i, &word, 4);
+            }
+        }
+
+        for (; i < rowBytes; i++) {
+            uint8_t m = maskRow != nullptr ? maskRow[i] : mask;
+            row[i] = (row[i] & ~m) | (sourceRow[i] & m);
+        }
+    }
+}
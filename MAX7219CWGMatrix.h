@@ -12,6 +12,10 @@
 #include <SPI.h>
 #include <Arduino.h>
 #include "Debugger.h"                                                       //For serial debugging
+#include "Metrics.h"                                                        //For performance counters
+#include "MAX7219Transport.h"
+#include "BitReverse.h"
+#include "SineTable.h"
 #include "Font3x5.h"
 #include "Font4x6.h"
 #include "Font5x7.h"
@@ -19,20 +23,57 @@
 #define ROW_SIZE                8
 #define COLUMN_SIZE             8
 
-#define MAX_HORIZONTAL_SEGMENTS 4
-#define MAX_VERTICAL_SEGMENTS   4
+/* Largest geometry the examples and benchmarks use, the class itself is only limited by memory */
+#define MAX_HORIZONTAL_SEGMENTS 32
+#define MAX_VERTICAL_SEGMENTS   8
+#define MAX_SEGMENTS            (0xFFFF/ROW_SIZE)                           //Most segments, a frame has to fit the 16-bit getFrameSize()
+
+/* Bytes of memory a display of h x v segments needs: segment map, display buffer, shadow, two transmit buffers and segment states.
+ * 3 bytes to align the display buffer to a 32-bit word */
+#define MAX7219_BUFFER_SIZE(h, v)   ((uint32_t) (h)*(v)*(6*ROW_SIZE + 3) + 3)
 
 /* Others */
 #define MAX_INTENSITY           0xF                                         //The maximum intensity value that can be set for a LED array
+#define MAX_BITS_PER_PIXEL      4                                           //Most grayscale levels: 16
+#define GRAYSCALE_SUBFRAME_TIME 500                                         //Default time of the least significant sub-frame in us
+
+/* Raster operations, how drawn pixels (bitmaps, layers) combine with what is there */
+#define RASTER_OP_COPY          0                                           //Replaces the pixels
+#define RASTER_OP_OR            1                                           //Adds the pixels that are on
+#define RASTER_OP_AND           2                                           //Keeps pixels that are on in both
+#define RASTER_OP_XOR           3                                           //Inverts where the source is on
+#define RASTER_OP_MASK          4                                           //Turns off where the source is on
+
+/* Fine angles, 0 points down the y axis and angles turn towards +x */
+#define ANGLE_STEPS_PER_DEGREE  16
+#define FULL_ANGLE              (360*ANGLE_STEPS_PER_DEGREE)
 
 /* Data Connection Types, depends on hardware */
-#define ZIGZAG_WIRING           0                                           //See wiring diagram
+#define ZIGZAG_WIRING           0                                           //See wiring diagram, every other row of segments upside down
+#define SERPENTINE_WIRING       1                                           //Rows of segments alternate direction, all the same way up
+#define PROGRESSIVE_WIRING      2                                           //Every row of segments from left to right
+#define COLUMN_WIRING           3                                           //Every column of segments from top to bottom
+#define CUSTOM_WIRING           4                                           //Map given with setWiringMap()
+
+#define SEGMENT_FLIPPED         0x8000                                      //Wiring map flag, segment is mounted upside down
 
 /* Rotation types */
 #define STANDARD_ROTATION       0
 #define UPSIDE_DOWN_ROTATION    1
+#define CLOCKWISE_ROTATION      2                                           //Image turned a quarter clockwise on the panel
+#define COUNTERCLOCKWISE_ROTATION 3                                         //Image turned a quarter counterclockwise on the panel
+#define MIRRORED_ROTATION       0x04                                        //Flag, mirrors left and right of any rotation
+
+/* Directions the content of the display buffer moves in, in drawing coordinates */
+#define SHIFT_LEFT              0
+#define SHIFT_RIGHT             1
+#define SHIFT_UP                2
+#define SHIFT_DOWN              3
+
+#define DISSOLVE_LEVELS         64                                          //Levels of dissolveFrame(), an 8x8 ordered dither
 
 /* Op codes as defined in the datasheet */
+#define OPCODE_NOOP             0x0000
 #define OPCODE_ENABLE           0x0C00
 #define OPCODE_TEST             0x0F00
 #define OPCODE_INTENSITY        0x0A00
@@ -67,75 +108,188 @@
 #define _swap_byte(a, b) { uint8_t t = a; a = b; b = t; }
 #endif
 
+/* Function used to swap two 16-bit integers */
+#ifndef _swap_int16
+#define _swap_int16(a, b) { int16_t t = a; a = b; b = t; }
+#endif
+
+class DisplayList;
+
 class MAX7219CWGMatrix {
 	public:
-        MAX7219CWGMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType = ZIGZAG_WIRING);
+        MAX7219CWGMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType = ZIGZAG_WIRING, uint8_t* buffer = nullptr);
         MAX7219CWGMatrix();
+        ~MAX7219CWGMatrix();
+        MAX7219CWGMatrix(const MAX7219CWGMatrix&) = delete;
+        MAX7219CWGMatrix& operator=(const MAX7219CWGMatrix&) = delete;
 
-        void initialiseMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType = ZIGZAG_WIRING);
+        void initialiseMatrix(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType = ZIGZAG_WIRING, uint8_t* buffer = nullptr);
         
         /* Config functions */
+        void setTransport(MAX7219Transport* transport);
+        void setClock(uint32_t hz);
         void setPower(bool on);
         void setIntensity(uint8_t level);
+        void setSegmentIntensity(uint8_t segmentX, uint8_t segmentY, uint8_t level);
+        void setSegmentPower(uint8_t segmentX, uint8_t segmentY, bool on);
+        void setScanLimit(uint8_t limit);
+        void setSegmentScanLimit(uint8_t segmentX, uint8_t segmentY, uint8_t limit);
+        void setPowerSaving(bool enabled);
+        void sendSegmentCommands(const uint16_t commands[]);
+        void setWiring(uint8_t wiringType);
+        void setWiringMap(const uint16_t map[]);
         void setRotation(uint8_t rotation);
         void setFont(uint8_t font);
         void setInverted(bool inverted);
+        void setGrayscale(uint8_t bitsPerPixel, uint32_t subFrameTime = GRAYSCALE_SUBFRAME_TIME);
+        void setDrawBuffer(uint8_t* buffer);
+        void setDisplayList(DisplayList* list);
 
         /* Draw functions*/
-        void drawPixel(uint8_t x, uint8_t y, uint8_t value);
-        void drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t value);
-        void drawLineAngle(uint8_t x0, uint8_t y0, uint8_t l, uint16_t angle, uint8_t value);
-        void drawVLine(uint8_t x, uint8_t y, uint8_t h, uint8_t value);
-        void drawHLine(uint8_t x, uint8_t y, uint8_t w, uint8_t value);
-        void drawRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t value);
-        void drawFillRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t value);
-        void drawCircle(uint8_t x0, uint8_t y0, int16_t r, uint8_t value);
-        void drawFillCircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t value);
-        void drawTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value);
-        void drawFillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value);
-
-        void drawChar(uint8_t x, uint8_t y, char character, uint8_t value);
-        void drawString(uint8_t x, uint8_t y, char string[], uint8_t length, uint8_t value);
+        void drawPixel(int16_t x, int16_t y, uint8_t value);
+        void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t value);
+        void drawLineAngle(int16_t x0, int16_t y0, int16_t l, uint16_t angle, uint8_t value);
+        void drawLineFineAngle(int16_t x0, int16_t y0, int16_t l, uint16_t angle, uint8_t value);
+        void drawArc(int16_t x0, int16_t y0, int16_t r, uint16_t startAngle, uint16_t endAngle, uint8_t value);
+        void drawVLine(int16_t x, int16_t y, int16_t h, uint8_t value);
+        void drawHLine(int16_t x, int16_t y, int16_t w, uint8_t value);
+        void drawRectangle(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value);
+        void drawFillRectangle(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value);
+        void drawCircle(int16_t x0, int16_t y0, int16_t r, uint8_t value);
+        void drawFillCircle(int16_t x0, int16_t y0, int16_t r, uint8_t value);
+        void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t value);
+        void drawFillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t value);
+
+        void drawChar(int16_t x, int16_t y, char character, uint8_t value);
+        void drawRow(int16_t x, int16_t y, uint8_t bits, uint8_t value);
+        void drawString(int16_t x, int16_t y, const char string[], uint8_t length, uint8_t value);
+        void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], uint16_t w, uint16_t h, uint8_t rasterOp = RASTER_OP_COPY, const uint8_t mask[] = nullptr);
 
         /* Getters */
-        uint8_t getPixel(uint8_t x, uint8_t y);
-        uint8_t getWidth();
-        uint8_t getHeight();
+        uint8_t getPixel(int16_t x, int16_t y);
+        void getAnglePoint(int16_t x0, int16_t y0, int16_t l, uint16_t angle, int16_t& x, int16_t& y);
+        uint16_t getWidth();
+        uint16_t getHeight();
+        uint8_t getSegmentsHorizontal();
+        uint8_t getSegmentsVertical();
+        uint8_t getWiring();
+        uint8_t getRotation();
+        uint8_t getFont();
         uint8_t getFontCols();
+        uint8_t getFontRows();
+        uint8_t getGlyphRow(char character, uint8_t row);
         bool getPower();
         uint8_t getIntensity();
         bool getInverted();
+        uint8_t getBitsPerPixel();
+        uint32_t getSubFrameTime();
+        uint16_t getFrameSize();
+        uint32_t getSkippedWords();
+        void resetSkippedWords();
 
         /* Display and clear functions */
         void display();
+        void displayAsync();
+        bool isFlushing();
+        void waitForFlush();
+        void setFlushCallback(void (*callback)());
+        bool updateGrayscale(uint32_t nowUs);
+        void loadFrame(const uint8_t* frame);
+        void xorFrame(uint16_t position, const uint8_t* data, uint16_t length);
+        void swapFrame(uint8_t* frame);
+        void shiftFrame(uint8_t direction, uint16_t n, const uint8_t* source = nullptr, uint16_t offset = 0);
+        void wipeFrame(const uint8_t* source, uint8_t direction, uint16_t position);
+        void blendFrame(const uint8_t* source, const uint8_t* mask);
+        void dissolveFrame(const uint8_t* source, uint8_t level, uint8_t seed = 0);
         void clear();
+
+        static uint32_t getBufferSize(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical);
 		
 	private:
         void _sendCommand(uint16_t command);
+        void _packCommand(uint8_t* buffer, uint16_t segment, uint16_t command);
+        void _sendSegmentCommand(uint8_t segmentX, uint8_t segmentY, uint16_t command);
+        void _updateSegmentPower();
+        int32_t _segmentIndex(uint8_t segmentX, uint8_t segmentY);
 
+        uint16_t _packRow(uint8_t r, uint8_t* buffer);
         void _reverse(uint8_t& b);
+        bool _isRowChanged(uint8_t r);
+        uint8_t _bufferDirection(uint8_t direction);
+        void _shiftRow(uint8_t* row, int16_t n);
+        void _copyBits(uint8_t* row, uint16_t x, const uint8_t* source, uint16_t sourceX, uint16_t count);
+        void _writeBits(uint8_t* row, uint16_t x, uint8_t bits, uint8_t count);
+        void _blendRows(uint16_t y, uint16_t numRows, const uint8_t* source, const uint8_t* masks, uint8_t numMasks);
         
-        void _fillCircleHelper(uint8_t x0, uint8_t y0, int16_t r, uint8_t corners, int16_t delta, uint8_t value);
+        void _mapPoint(int16_t& x, int16_t& y);
+        int32_t _sine(uint16_t angle);
+        int16_t _scale(int16_t l, int32_t sine);
+        uint8_t* _plane(uint8_t plane);
+        bool _planeValue(uint8_t value, uint8_t plane);
+        void _drawHSpan(int16_t x, int16_t y, int16_t w, uint8_t value);
+        void _drawVSpan(int16_t x, int16_t y, int16_t h, uint8_t value);
+        void _fillBufferRow(int16_t x, int16_t y, int16_t w, uint8_t value);
+        void _fillBufferColumn(int16_t x, int16_t y, int16_t h, uint8_t value);
+        void _drawRowBits(int16_t x, int16_t y, uint8_t bits, uint8_t value);
+        void _blitRow(int16_t y, int16_t bx0, int16_t bx1, const uint8_t* source, const uint8_t* mask, uint16_t w, int16_t column, bool reversed, uint8_t rasterOp);
+        void _blitPixel(int16_t x, int16_t y, bool source, uint8_t rasterOp);
+        uint8_t _readBits(const uint8_t* row, uint16_t rowBytes, int16_t position);
+        uint8_t _rasterOp(uint8_t data, uint8_t bits, uint8_t affected, uint8_t rasterOp);
+        void _fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint8_t value);
 
-        uint8_t _width;
-        uint8_t _height;
+        uint16_t _width;                                                    //In drawing coordinates, swaps with quarter rotations
+        uint16_t _height;
 
         uint8_t _numSegmentsHorizontal;
         uint8_t _numSegmentsVertical;
-        uint8_t _numSegments;
+        uint16_t _numSegments;
         uint8_t _wiringType;
+        uint16_t* _segmentMap;                                              //Chain position per buffer segment, SEGMENT_FLIPPED if upside down
         uint8_t _csPin;
         uint8_t _rotation;
+        int16_t _transform[6];                                              //Drawing to buffer coordinates: bx = t0*x + t1*y + t2, by = t3*x + t4*y + t5
 
         uint8_t _font;
         uint8_t _fontRows;
         uint8_t _fontCols;
+        const uint8_t* _fontIndex;                                          //ASCII to glyph index table
+        const uint8_t* _fontGlyphs;                                         //Transposed glyphs
 
         bool _power;
         uint8_t _intensity;
         uint8_t _inverted;
+        bool _powerSaving;                                                  //Shut down blank segments in display()
+        uint8_t* _segmentPower;                                             //Power state per segment
+
+        /* All buffers are carved from one block of MAX7219_BUFFER_SIZE bytes.
+         * The display buffer is row-major: row y is _numSegmentsHorizontal
+         * contiguous bytes at _matrix + y*_numSegmentsHorizontal */
+        uint8_t* _memory;
+        bool _ownsMemory;                                                   //True if allocated by the class
+        uint8_t* _matrix;
+        uint8_t* _shadow;                                                   //Copy of what is latched in the chips
+        uint8_t _dirtyRows;                                                 //Bit n set: digit row n may differ from _shadow
+        bool _shadowValid;                                                  //False: next display() sends all rows
+        uint32_t _skippedWords;
+
+        /* Grayscale: bit n of every pixel level is stored in plane n, laid
+         * out like _matrix. updateGrayscale() copies plane n into _matrix
+         * and shows it for _subFrameTime << n us */
+        uint8_t* _planes;                                                   //nullptr with 1 bit per pixel
+        uint8_t _bitsPerPixel;
+        uint8_t _subFramePlane;                                             //Plane that is shown
+        bool _subFrameShown;                                                //False: next update starts at plane 0
+        uint32_t _subFrameTime;
+        uint32_t _subFrameStart;
+
+        uint8_t* _drawBuffer;                                               //Buffer drawn in instead of the display, nullptr if none
+        uint8_t _drawPlanes;                                                //Number of planes the draw functions write
+        DisplayList* _displayList;                                          //Records the draw calls instead, nullptr if none
 
-        uint8_t _matrix[MAX_HORIZONTAL_SEGMENTS][MAX_VERTICAL_SEGMENTS*ROW_SIZE];
+        MAX7219SPITransport _spiTransport;                                  //Default transport
+        MAX7219Transport* _transport;
+        uint8_t* _txBuffer[2];                                              //Packed frames for displayAsync()
+        uint8_t _txIndex;                                                   //Transmit buffer to pack next
 };
 
 #endif /* MAX7219CWG_MATRIX_H */
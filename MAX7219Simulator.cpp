@@ -0,0 +1,256 @@
+/*
+ * File:      MAX7219Simulator.cpp
+ * Authors:   Luke de Munk
+ * Class:     MAX7219Simulator
+ *
+ * Simulated chain of MAX7219 chips, decodes the register stream back
+ * into pixels. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219Simulator.h"
+
+#define PBM_LINE_LENGTH         64                                          //Pixels per line, plain PBM lines stay under 70 characters
+
+/**************************************************************************/
+/*!
+  @brief    Constructor, the chips start as after power-up. The chain
+            runs row by row from the top left segment, every chip
+            upright, until setLayout() is called.
+  @param    numSegmentsHorizontal   Number of horizontal segments
+  @param    numSegmentsVertical     Number of vertical segments
+*/
+/**************************************************************************/
+MAX7219Simulator::MAX7219Simulator(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical) {
+    _numSegmentsHorizontal = numSegmentsHorizontal;
+    _numSegmentsVertical = numSegmentsVertical;
+    _numChips = numSegmentsHorizontal*numSegmentsVertical;
+
+    _chips = (MAX7219Chip*) malloc(_numChips*sizeof(MAX7219Chip));
+    _shift = (uint16_t*) malloc(_numChips*sizeof(uint16_t));
+    _layout = (uint16_t*) malloc(_numChips*sizeof(uint16_t));
+
+    if (_chips == nullptr || _shift == nullptr || _layout == nullptr) {
+        debugln("ERROR: Not enough memory for the simulator.");
+        _numSegmentsHorizontal = 0;
+        _numSegmentsVertical = 0;
+        _numChips = 0;
+    }
+
+    reset();
+    for (uint16_t i = 0; i < _numChips; i++) {
+        _layout[i] = i;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the chips.
+*/
+/**************************************************************************/
+MAX7219Simulator::~MAX7219Simulator() {
+    free(_chips);
+    free(_shift);
+    free(_layout);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Does nothing, no hardware is used.
+  @param    csPin           Chip-Select pin
+*/
+/**************************************************************************/
+void MAX7219Simulator::begin(uint8_t /*csPin*/) {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shifts one chip-select frame through the chain, then latches
+            the word every chip holds.
+  @param    data            Bytes to send, [register, data] per segment
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void MAX7219Simulator::write(const uint8_t* data, uint16_t length) {
+    if (_numChips == 0) {
+        return;
+    }
+
+    /* The last word sent is in the chip nearest the controller */
+    for (uint16_t i = 0; i + 1 < length; i += 2) {
+        _shift[_numShifted % _numChips] = (data[i] << 8) | data[i+1];
+        _numShifted++;
+    }
+
+    for (uint16_t position = 0; position < _numChips; position++) {
+        uint16_t word = _shift[(_numShifted + position) % _numChips];
+        uint8_t address = (word >> 8) & 0x0F;                               //D15 to D12 are ignored
+        uint8_t value = word & 0xFF;
+        MAX7219Chip& chip = _chips[position];
+
+        if (address >= 1 && address <= ROW_SIZE) {
+            chip.digits[address - 1] = value;
+        } else if (address == (OPCODE_DECODE >> 8)) {
+            chip.decode = value;
+        } else if (address == (OPCODE_INTENSITY >> 8)) {
+            chip.intensity = value & 0x0F;
+        } else if (address == (OPCODE_SCAN_LIMIT >> 8)) {
+            chip.scanLimit = value & 0x07;
+        } else if (address == (OPCODE_ENABLE >> 8)) {
+            chip.shutdown = !(value & 0x01);
+        } else if (address == (OPCODE_TEST >> 8)) {
+            chip.test = value & 0x01;
+        }
+    }
+    _numLatches++;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets how the chips are mounted on the panel, as read from the
+            panel itself. Deliberately no wiring type: the layout is given
+            by the caller, so a mistake in the mapping of the matrix shows
+            up as a wrong image instead of being repeated here.
+  @param    layout          Chain position of the chip behind every segment,
+                            row by row from the top left as seen from the
+                            front, SEGMENT_FLIPPED if mounted upside down
+*/
+/**************************************************************************/
+void MAX7219Simulator::setLayout(const uint16_t layout[]) {
+    for (uint16_t i = 0; i < _numChips; i++) {
+        if ((layout[i] & ~SEGMENT_FLIPPED) >= _numChips) {
+            debugln("ERROR: Chain position outside the chain, layout not changed.");
+            return;
+        }
+    }
+    memcpy(_layout, layout, _numChips*sizeof(uint16_t));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Resets every chip as on power-up: display blanked, shut down,
+            scan limit and intensity 0, no decoding.
+*/
+/**************************************************************************/
+void MAX7219Simulator::reset() {
+    for (uint16_t i = 0; i < _numChips; i++) {
+        memset(&_chips[i], 0, sizeof(MAX7219Chip));
+        _chips[i].shutdown = true;
+        _shift[i] = OPCODE_NOOP;
+    }
+    _numShifted = 0;
+    _numLatches = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a led of the panel is on. A chip that is shut down
+            is dark, a test shows every led, digits above the scan limit
+            are not scanned.
+  @param    x               X coordinate on the panel, from the left
+  @param    y               Y coordinate on the panel, from the top
+  @returns  True if on
+*/
+/**************************************************************************/
+bool MAX7219Simulator::getPixel(uint16_t x, uint16_t y) {
+    if (x >= getWidth() || y >= getHeight()) {
+        return false;
+    }
+
+    uint16_t segment = _layout[(y/ROW_SIZE)*_numSegmentsHorizontal + x/COLUMN_SIZE];
+    const MAX7219Chip& chip = _chips[segment & ~SEGMENT_FLIPPED];
+    uint8_t row = y % ROW_SIZE;
+    uint8_t column = x % COLUMN_SIZE;
+
+    /* Upright: digit 7 is the top row, bit 7 the left column. Upside down it is turned half a circle */
+    uint8_t digit = segment & SEGMENT_FLIPPED ? row : ROW_SIZE-1 - row;
+    uint8_t bit = segment & SEGMENT_FLIPPED ? column : COLUMN_SIZE-1 - column;
+
+    if (chip.test) {
+        return true;
+    }
+    return !chip.shutdown && digit <= chip.scanLimit && (chip.digits[digit] >> bit) & 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width of the panel.
+  @returns  Width in pixels
+*/
+/**************************************************************************/
+uint16_t MAX7219Simulator::getWidth() {
+    return _numSegmentsHorizontal*COLUMN_SIZE;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the height of the panel.
+  @returns  Height in pixels
+*/
+/**************************************************************************/
+uint16_t MAX7219Simulator::getHeight() {
+    return _numSegmentsVertical*ROW_SIZE;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the registers of a chip.
+  @param    position        Chain position, 0 is the chip farthest from the
+                            controller
+  @returns  Chip, nullptr if not found
+*/
+/**************************************************************************/
+const MAX7219Chip* MAX7219Simulator::getChip(uint16_t position) {
+    return position < _numChips ? &_chips[position] : nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how many times chip-select went high.
+  @returns  _numLatches     Number of latches
+*/
+/**************************************************************************/
+uint32_t MAX7219Simulator::getNumLatches() {
+    return _numLatches;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the size of the panel as a plain PBM image.
+  @returns  Bytes, terminator included
+*/
+/**************************************************************************/
+uint32_t MAX7219Simulator::getPbmSize() {
+    char header[16];
+    uint32_t lineBreaks = (getWidth() + PBM_LINE_LENGTH-1) / PBM_LINE_LENGTH;
+
+    return snprintf(header, sizeof(header), "P1\n%u %u\n", getWidth(), getHeight()) + (uint32_t) getHeight()*(getWidth() + lineBreaks) + 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes the panel as a plain PBM image, 1 is a led that is on.
+  @param    buffer          Buffer of getPbmSize() bytes
+  @param    size            Size of the buffer
+  @returns  Length of the image, 0 if the buffer is too small
+*/
+/**************************************************************************/
+uint32_t MAX7219Simulator::toPbm(char* buffer, uint32_t size) {
+    if (size < getPbmSize()) {
+        debugln("ERROR: Buffer too small for the image.");
+        return 0;
+    }
+
+    uint32_t length = sprintf(buffer, "P1\n%u %u\n", getWidth(), getHeight());
+
+    for (uint16_t y = 0; y < getHeight(); y++) {
+        for (uint16_t x = 0; x < getWidth(); x++) {
+            buffer[length++] = getPixel(x, y) ? '1' : '0';
+
+            if (x % PBM_LINE_LENGTH == PBM_LINE_LENGTH-1 || x == getWidth()-1) {
+                buffer[length++] = '\n';
+            }
+        }
+    }
+    buffer[length] = '\0';
+    return length;
+}
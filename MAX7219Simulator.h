@@ -0,0 +1,65 @@
+/*
+ * File:      MAX7219Simulator.h
+ * Authors:   Luke de Munk
+ * Class:     MAX7219Simulator
+ *
+ * Transport that simulates a chain of MAX7219 chips instead of sending.
+ * Every word is shifted through the chain like on the real bus and is
+ * latched when chip-select goes high, into the digit and control
+ * registers of the chip it ended up in. The panel the chips are mounted
+ * on is described by a layout table of its own, not by the wiring of the
+ * matrix, so the registers can be turned back into the pixels a viewer
+ * sees, for example as a PBM image. No display has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef MAX7219_SIMULATOR_H
+#define MAX7219_SIMULATOR_H
+#include "MAX7219CWGMatrix.h"
+#include "Debugger.h"                                                       //For serial debugging
+
+/* Registers of one chip, reset as on power-up */
+struct MAX7219Chip {
+    uint8_t digits[ROW_SIZE];                                               //Digit 0 to 7
+    uint8_t decode;
+    uint8_t intensity;
+    uint8_t scanLimit;
+    bool shutdown;                                                          //True: display blanked
+    bool test;                                                              //True: every led on
+};
+
+class MAX7219Simulator : public MAX7219Transport {
+	public:
+        MAX7219Simulator(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical);
+        ~MAX7219Simulator();
+        MAX7219Simulator(const MAX7219Simulator&) = delete;
+        MAX7219Simulator& operator=(const MAX7219Simulator&) = delete;
+
+        void begin(uint8_t csPin);
+        void write(const uint8_t* data, uint16_t length);
+
+        /* Config functions */
+        void setLayout(const uint16_t layout[]);
+        void reset();
+
+        /* Getters */
+        bool getPixel(uint16_t x, uint16_t y);
+        uint16_t getWidth();
+        uint16_t getHeight();
+        const MAX7219Chip* getChip(uint16_t position);
+        uint32_t getNumLatches();
+        uint32_t getPbmSize();
+        uint32_t toPbm(char* buffer, uint32_t size);
+
+	private:
+        uint8_t _numSegmentsHorizontal;
+        uint8_t _numSegmentsVertical;
+        uint16_t _numChips;
+
+        MAX7219Chip* _chips;                                                //By chain position, 0 is the chip farthest from the controller
+        uint16_t* _shift;                                                   //Shift registers, a ring of the last words sent
+        uint32_t _numShifted;                                               //Words shifted in since reset()
+        uint16_t* _layout;                                                  //Chain position per segment of the panel, SEGMENT_FLIPPED if upside down
+        uint32_t _numLatches;
+};
+
+#endif /* MAX7219_SIMULATOR_H */
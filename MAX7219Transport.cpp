@@ -0,0 +1,770 @@
+/*
+ * File:      MAX7219Transport.cpp
+ * Authors:   Luke de Munk
+ * Class:     MAX7219Transport, MAX7219SPITransport, MAX7219BulkSPITransport,
+ *            MAX7219RecordingTransport, MAX7219MultiChainTransport
+ *
+ * Transport layer between the MAX7219CWGMatrix and the bus. For more
+ * info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219Transport.h"
+#include "MAX7219CWGMatrix.h"                                               //For SEGMENT_FLIPPED
+
+/**************************************************************************/
+/*!
+  @brief    Writes several chip-select frames of equal length, one after
+            another. Transports that can send in the background return
+            immediately; this default sends them blocking.
+  @param    data            Frames, stored contiguously
+  @param    frameLength     Number of bytes per frame
+  @param    numFrames       Number of frames
+*/
+/**************************************************************************/
+void MAX7219Transport::writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames) {
+    for (uint8_t f = 0; f < numFrames; f++) {
+        write(data + f*frameLength, frameLength);
+    }
+    _complete();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if an asynchronous write is still in progress.
+  @returns  True if the data passed to writeAsync() is still in use
+*/
+/**************************************************************************/
+bool MAX7219Transport::isBusy() {
+    return false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Blocks until the last asynchronous write is finished.
+*/
+/**************************************************************************/
+void MAX7219Transport::waitIdle() {
+    while (isBusy()) {
+        yield();
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets a function that is called when an asynchronous write is
+            finished. On the ESP32 it is called from the flush task.
+  @param    callback        Function to call, nullptr to disable
+*/
+/**************************************************************************/
+void MAX7219Transport::setCallback(void (*callback)()) {
+    _callback = callback;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the SPI clock.
+  @param    hz              Clock in Hz, limited to MAX7219_MAX_SPI_CLOCK
+*/
+/**************************************************************************/
+void MAX7219Transport::setClock(uint32_t hz) {
+    if (hz > MAX7219_MAX_SPI_CLOCK) {
+        debugln("ERROR: SPI clock too high for the MAX7219, using maximum.");
+        hz = MAX7219_MAX_SPI_CLOCK;
+    }
+
+    if (hz == 0) {
+        hz = MAX7219_SPI_CLOCK;
+    }
+    _clock = hz;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the SPI clock.
+  @returns  _clock          Clock in Hz
+*/
+/**************************************************************************/
+uint32_t MAX7219Transport::getClock() {
+    return _clock;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Signals the end of an asynchronous write.
+*/
+/**************************************************************************/
+void MAX7219Transport::_complete() {
+    if (_parent != nullptr) {
+        _parent->_chainComplete();
+    }
+
+    if (_callback != nullptr) {
+        _callback();
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor.
+  @param    spi             SPI host to use, for example a second host
+                            for a chain that flushes in parallel
+*/
+/**************************************************************************/
+MAX7219SPITransport::MAX7219SPITransport(SPIClass* spi) {
+    _spi = spi;
+    _csPin = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Initialises the chip-select pin and the SPI bus.
+  @param    csPin           Chip-Select pin
+*/
+/**************************************************************************/
+void MAX7219SPITransport::begin(uint8_t csPin) {
+    _csPin = csPin;
+
+    pinMode(_csPin, OUTPUT);
+    digitalWrite(_csPin, 1);
+
+    _spi->begin();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes one chip-select frame. The data is latched by the chips
+            when chip-select goes high.
+  @param    data            Bytes to send, [register, data] per segment
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void MAX7219SPITransport::write(const uint8_t* data, uint16_t length) {
+    _spi->beginTransaction(SPISettings(_clock, MSBFIRST, SPI_MODE0));
+    digitalWrite(_csPin, 0);
+
+    for (uint16_t i = 0; i + 1 < length; i += 2) {
+        _spi->transfer16((data[i] << 8) | data[i+1]);
+    }
+
+    digitalWrite(_csPin, 1);
+    _spi->endTransaction();
+}
+
+#if defined(ESP32)
+/**************************************************************************/
+/*!
+  @brief    Hands the frames to the flush task and returns immediately.
+            The data must stay untouched until isBusy() returns false.
+  @param    data            Frames, stored contiguously
+  @param    frameLength     Number of bytes per frame
+  @param    numFrames       Number of frames
+*/
+/**************************************************************************/
+void MAX7219SPITransport::writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames) {
+    waitIdle();                                                             //One job at a time
+
+    /* Create the flush task on the other core the first time */
+    if (_task == nullptr) {
+        if (xTaskCreatePinnedToCore(_flushTask, "max7219", 2048, this, 1, &_task, _core) != pdPASS) {
+            debugln("ERROR: Could not create flush task, sending blocking.");
+            _task = nullptr;
+            MAX7219Transport::writeAsync(data, frameLength, numFrames);
+            return;
+        }
+    }
+
+    _data = data;
+    _frameLength = frameLength;
+    _numFrames = numFrames;
+    _busy = true;
+    xTaskNotifyGive(_task);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the flush task is still sending.
+  @returns  True if the data passed to writeAsync() is still in use
+*/
+/**************************************************************************/
+bool MAX7219SPITransport::isBusy() {
+    return _busy;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the core the flush task runs on. Must be called before
+            the first asynchronous write.
+  @param    core            Core (0-1)
+*/
+/**************************************************************************/
+void MAX7219SPITransport::setCore(uint8_t core) {
+    if (_task != nullptr) {
+        debugln("ERROR: Flush task already running, can not change its core.");
+        return;
+    }
+    _core = core;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Flush task, sends the frames in bulk transfers.
+  @param    parameter       Pointer to the transport
+*/
+/**************************************************************************/
+void MAX7219SPITransport::_flushTask(void* parameter) {
+    MAX7219SPITransport* transport = (MAX7219SPITransport*) parameter;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        const uint8_t* data = transport->_data;
+
+        for (uint8_t f = 0; f < transport->_numFrames; f++) {
+            transport->_spi->beginTransaction(SPISettings(transport->_clock, MSBFIRST, SPI_MODE0));
+            digitalWrite(transport->_csPin, 0);
+            transport->_spi->writeBytes(data, transport->_frameLength);
+            digitalWrite(transport->_csPin, 1);
+            transport->_spi->endTransaction();
+            data += transport->_frameLength;
+        }
+
+        transport->_busy = false;
+        transport->_complete();
+    }
+}
+#endif
+
+/**************************************************************************/
+/*!
+  @brief    Constructor.
+  @param    spi             SPI host to use
+*/
+/**************************************************************************/
+MAX7219BulkSPITransport::MAX7219BulkSPITransport(SPIClass* spi) : MAX7219SPITransport(spi) {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes one chip-select frame with bulk transfers instead of
+            one transfer per word.
+  @param    data            Bytes to send, [register, data] per segment
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void MAX7219BulkSPITransport::write(const uint8_t* data, uint16_t length) {
+    _spi->beginTransaction(SPISettings(_clock, MSBFIRST, SPI_MODE0));
+    digitalWrite(_csPin, 0);
+
+#if defined(ESP32)
+    _spi->writeBytes(data, length);
+#else
+    /* SPI.transfer() overwrites the buffer with the received bytes */
+    uint8_t chunk[MAX7219_BULK_CHUNK];
+
+    for (uint16_t i = 0; i < length; i += MAX7219_BULK_CHUNK) {
+        uint16_t n = length - i;
+        if (n > MAX7219_BULK_CHUNK) {
+            n = MAX7219_BULK_CHUNK;
+        }
+        memcpy(chunk, data + i, n);
+        _spi->transfer(chunk, n);
+    }
+#endif
+
+    digitalWrite(_csPin, 1);
+    _spi->endTransaction();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor, only counts words and transactions.
+*/
+/**************************************************************************/
+MAX7219RecordingTransport::MAX7219RecordingTransport() {
+    _log = nullptr;
+    _logSize = 0;
+    _busDelay = false;
+    reset();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor, also records every chip-select edge and word.
+  @param    log             Buffer for the recorded events
+  @param    logSize         Number of events that fit in the buffer
+*/
+/**************************************************************************/
+MAX7219RecordingTransport::MAX7219RecordingTransport(MAX7219Event* log, uint16_t logSize) {
+    _log = log;
+    _logSize = logSize;
+    _busDelay = false;
+    reset();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Does nothing, no hardware is used.
+  @param    csPin           Chip-Select pin
+*/
+/**************************************************************************/
+void MAX7219RecordingTransport::begin(uint8_t /*csPin*/) {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Records one chip-select frame.
+  @param    data            Bytes to send, [register, data] per segment
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void MAX7219RecordingTransport::write(const uint8_t* data, uint16_t length) {
+    _record(EVENT_CS_LOW, 0);
+
+    for (uint16_t i = 0; i + 1 < length; i += 2) {
+        _record(EVENT_WORD, (data[i] << 8) | data[i+1]);
+        _words++;
+    }
+
+    if (_busDelay) {
+        uint32_t start = micros();
+        uint32_t busTime = (uint64_t) length * 8 * 1000000 / _clock;
+
+        while (micros() - start < busTime) {
+            yield();                                                        //Let other chains run
+        }
+    }
+
+    _record(EVENT_CS_HIGH, 0);
+    _transactions++;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Clears the counters and the recorded events.
+*/
+/**************************************************************************/
+void MAX7219RecordingTransport::reset() {
+    _numEvents = 0;
+    _overflowed = false;
+    _words = 0;
+    _transactions = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets if write() takes as long as the frame would take on the
+            bus, to simulate the timing of a real chain.
+  @param    enabled         True to wait the bus time of every frame
+*/
+/**************************************************************************/
+void MAX7219RecordingTransport::setBusDelay(bool enabled) {
+    _busDelay = enabled;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of words sent.
+  @returns  _words          Number of 16-bit words
+*/
+/**************************************************************************/
+uint32_t MAX7219RecordingTransport::getWords() {
+    return _words;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of chip-select frames sent.
+  @returns  _transactions   Number of transactions
+*/
+/**************************************************************************/
+uint32_t MAX7219RecordingTransport::getTransactions() {
+    return _transactions;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the estimated time the bus was busy shifting bits, at
+            the configured clock. Overhead per transaction is not counted.
+  @returns  Bus time in us
+*/
+/**************************************************************************/
+uint32_t MAX7219RecordingTransport::getBusTime() {
+    return (uint64_t) _words * 16 * 1000000 / _clock;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of recorded events.
+  @returns  _numEvents      Number of events in the log
+*/
+/**************************************************************************/
+uint16_t MAX7219RecordingTransport::getNumEvents() {
+    return _numEvents;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns a recorded event.
+  @param    index           Index of the event
+  @returns  Event, empty if the index is invalid
+*/
+/**************************************************************************/
+MAX7219Event MAX7219RecordingTransport::getEvent(uint16_t index) {
+    if (index >= _numEvents) {
+        debugln("ERROR: Invalid event index given.");
+        MAX7219Event event = {0, 0, EVENT_CS_HIGH};
+        return event;
+    }
+    return _log[index];
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if events were dropped because the log was full.
+  @returns  _overflowed     True if the log overflowed
+*/
+/**************************************************************************/
+bool MAX7219RecordingTransport::isOverflowed() {
+    return _overflowed;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Appends an event to the log.
+  @param    type            Type of event
+  @param    word            Word sent, only for EVENT_WORD
+*/
+/**************************************************************************/
+void MAX7219RecordingTransport::_record(uint8_t type, uint16_t word) {
+    if (_log == nullptr) {
+        return;
+    }
+
+    if (_numEvents >= _logSize) {
+        _overflowed = true;
+        return;
+    }
+
+    _log[_numEvents].time = micros();
+    _log[_numEvents].word = word;
+    _log[_numEvents].type = type;
+    _numEvents++;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Constructor. Nothing is sent until the matrix gave its wiring
+            with setWiringMap(), MAX7219CWGMatrix::setTransport() does.
+  @param    numSegmentsHorizontal   Number of horizontal segments of the display
+  @param    numSegmentsVertical     Number of vertical segments of the display
+*/
+/**************************************************************************/
+MAX7219MultiChainTransport::MAX7219MultiChainTransport(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical) {
+    _segmentMap = (uint16_t*) malloc(numSegmentsHorizontal*numSegmentsVertical*sizeof(uint16_t));
+
+    if (_segmentMap == nullptr) {
+        debugln("ERROR: Not enough memory for the wiring map.");
+        numSegmentsHorizontal = 0;
+        numSegmentsVertical = 0;
+    }
+
+    _numSegmentsHorizontal = numSegmentsHorizontal;
+    _numSegmentsVertical = numSegmentsVertical;
+    _hasWiringMap = false;
+    _numChains = 0;
+    _pending = 0;
+    _async = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the frame buffers of the chains.
+*/
+/**************************************************************************/
+MAX7219MultiChainTransport::~MAX7219MultiChainTransport() {
+    for (uint8_t c = 0; c < _numChains; c++) {
+        free(_chains[c].buffer);
+    }
+    free(_segmentMap);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Adds a chain that drives a rectangle of segments. The rectangle
+            is given in display buffer coordinates (standard rotation).
+            Its chips are chained like the wiring of the matrix cut to
+            the rectangle: in the order of their positions in the wiring
+            map, mounted as the map says. Any wiring can be split this
+            way. Chains must not overlap.
+  @param    transport               Transport of the chain, give every
+                                    chain its own SPI host to flush in
+                                    parallel
+  @param    csPin                   Chip-Select pin of the chain
+  @param    segmentX                Leftmost segment column
+  @param    segmentY                First segment row
+  @param    numSegmentsHorizontal   Number of horizontal segments
+  @param    numSegmentsVertical     Number of vertical segments
+  @returns  True if the chain is added
+*/
+/**************************************************************************/
+bool MAX7219MultiChainTransport::addChain(MAX7219Transport* transport, uint8_t csPin, uint8_t segmentX, uint8_t segmentY, uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical) {
+    if (_numChains >= MAX7219_MAX_CHAINS) {
+        debugln("ERROR: Too many chains, increase MAX7219_MAX_CHAINS.");
+        return false;
+    }
+
+    if (transport == nullptr || transport == this || numSegmentsHorizontal == 0 || numSegmentsVertical == 0
+        || segmentX + numSegmentsHorizontal > _numSegmentsHorizontal || segmentY + numSegmentsVertical > _numSegmentsVertical) {
+        debugln("ERROR: Invalid chain given. Ignoring it.");
+        return false;
+    }
+
+    uint16_t numSegments = numSegmentsHorizontal*numSegmentsVertical;
+    uint8_t* buffer = (uint8_t*) malloc(numSegments*2*MAX7219_MAX_FRAMES + numSegments*sizeof(uint16_t));
+
+    if (buffer == nullptr) {
+        debugln("ERROR: Not enough memory for the chain.");
+        return false;
+    }
+
+    MAX7219Chain& chain = _chains[_numChains++];
+    chain.transport = transport;
+    chain.csPin = csPin;
+    chain.segmentX = segmentX;
+    chain.segmentY = segmentY;
+    chain.numSegmentsHorizontal = numSegmentsHorizontal;
+    chain.numSegmentsVertical = numSegmentsVertical;
+    chain.buffer = buffer;
+    chain.order = (uint16_t*) (buffer + numSegments*2*MAX7219_MAX_FRAMES);  //Even offset, aligned
+    _orderChain(chain);
+
+    transport->_parent = this;
+    transport->setClock(_clock);
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Initialises every chain with its own chip-select pin.
+  @param    csPin           Chip-Select pin of the display, not used
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::begin(uint8_t /*csPin*/) {
+    for (uint8_t c = 0; c < _numChains; c++) {
+        _chains[c].transport->begin(_chains[c].csPin);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes one chip-select frame of the whole display. Every chain
+            sends its part at the same time and this returns when all
+            chains are done.
+  @param    data            Bytes to send, [register, data] per segment
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::write(const uint8_t* data, uint16_t length) {
+    _dispatch(data, length, 1, false);
+    waitIdle();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Splits the frames over the chains and starts them all. Returns
+            immediately if the chains send in the background.
+  @param    data            Frames, stored contiguously
+  @param    frameLength     Number of bytes per frame
+  @param    numFrames       Number of frames
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames) {
+    _dispatch(data, frameLength, numFrames, true);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a chain is still sending.
+  @returns  True if the data passed to writeAsync() is still in use
+*/
+/**************************************************************************/
+bool MAX7219MultiChainTransport::isBusy() {
+    return _pending != 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the SPI clock of every chain.
+  @param    hz              Clock in Hz, limited to MAX7219_MAX_SPI_CLOCK
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::setClock(uint32_t hz) {
+    MAX7219Transport::setClock(hz);
+
+    for (uint8_t c = 0; c < _numChains; c++) {
+        _chains[c].transport->setClock(_clock);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Takes the wiring of the matrix, the chains send their segments
+            in the order of it.
+  @param    map             Chain position per segment, see
+                            MAX7219CWGMatrix::setWiringMap()
+  @param    numSegments     Number of segments of the map
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::setWiringMap(const uint16_t* map, uint16_t numSegments) {
+    if (numSegments != _numSegmentsHorizontal*_numSegmentsVertical) {
+        debugln("ERROR: Wiring map does not match the geometry of the chains. Ignoring it.");
+        return;
+    }
+
+    waitIdle();                                                             //Orders are read by a running dispatch
+    memcpy(_segmentMap, map, numSegments*sizeof(uint16_t));
+    _hasWiringMap = true;
+
+    for (uint8_t c = 0; c < _numChains; c++) {
+        _orderChain(_chains[c]);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of chains.
+  @returns  _numChains      Number of chains
+*/
+/**************************************************************************/
+uint8_t MAX7219MultiChainTransport::getNumChains() {
+    return _numChains;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the transport of a chain.
+  @param    index           Index of the chain
+  @returns  Transport, nullptr if the index is invalid
+*/
+/**************************************************************************/
+MAX7219Transport* MAX7219MultiChainTransport::getChain(uint8_t index) {
+    if (index >= _numChains) {
+        debugln("ERROR: Invalid chain index given.");
+        return nullptr;
+    }
+    return _chains[index].transport;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Called by a chain when it finished, the last one signals the
+            end of the write. Can be called from another task.
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::_chainComplete() {
+    if (__atomic_sub_fetch(&_pending, 1, __ATOMIC_ACQ_REL) == 0 && _async) {
+        _complete();
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Gathers the part of every chain and starts the chains.
+  @param    data            Frames, stored contiguously
+  @param    frameLength     Number of bytes per frame
+  @param    numFrames       Number of frames
+  @param    async           True to call the callback when all chains are done
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::_dispatch(const uint8_t* data, uint16_t frameLength, uint8_t numFrames, bool async) {
+    if (frameLength != _numSegmentsHorizontal*_numSegmentsVertical*2 || numFrames > MAX7219_MAX_FRAMES) {
+        debugln("ERROR: Frame does not match the geometry of the chains. Ignoring it.");
+        return;
+    }
+
+    if (!_hasWiringMap) {
+        debugln("ERROR: No wiring map given, the chains are unknown. Ignoring the frame.");
+        return;
+    }
+
+    waitIdle();                                                             //Chain buffers must be free
+
+    if (_numChains == 0) {
+        if (async) {
+            _complete();
+        }
+        return;
+    }
+
+    /* Gather all parts first, so the chains start as close together as possible */
+    uint16_t chainLengths[MAX7219_MAX_CHAINS];
+
+    for (uint8_t c = 0; c < _numChains; c++) {
+        uint8_t* buffer = _chains[c].buffer;
+        chainLengths[c] = 0;
+
+        for (uint8_t f = 0; f < numFrames; f++) {
+            chainLengths[c] = _gather(_chains[c], data + f*frameLength, buffer);
+            buffer += chainLengths[c];
+        }
+    }
+
+    _async = async;
+    _pending = _numChains;
+
+    for (uint8_t c = 0; c < _numChains; c++) {
+        _chains[c].transport->writeAsync(_chains[c].buffer, chainLengths[c], numFrames);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the words of the segments of a chain out of a frame of
+            the whole display, in the order of the chain.
+  @param    chain           Chain to gather for
+  @param    frame           Frame of the whole display
+  @param    buffer          Buffer to write to
+  @returns  Number of bytes written
+*/
+/**************************************************************************/
+uint16_t MAX7219MultiChainTransport::_gather(const MAX7219Chain& chain, const uint8_t* frame, uint8_t* buffer) {
+    uint16_t numSegments = chain.numSegmentsHorizontal*chain.numSegmentsVertical;
+
+    for (uint16_t i = 0; i < numSegments; i++) {
+        const uint8_t* word = frame + chain.order[i]*2;
+        buffer[i*2] = word[0];
+        buffer[i*2 + 1] = word[1];
+    }
+    return numSegments*2;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Resolves which words of a display frame a chain sends, once
+            per wiring. The frame holds the word of a segment at its
+            position in the wiring map, the chain sends the positions of
+            its rectangle in ascending order.
+  @param    chain           Chain to resolve
+*/
+/**************************************************************************/
+void MAX7219MultiChainTransport::_orderChain(MAX7219Chain& chain) {
+    if (!_hasWiringMap) {
+        return;
+    }
+
+    uint16_t numSorted = 0;
+
+    for (uint8_t segRow = chain.segmentY; segRow < chain.segmentY + chain.numSegmentsVertical; segRow++) {
+        for (uint8_t d = chain.segmentX; d < chain.segmentX + chain.numSegmentsHorizontal; d++) {
+            uint16_t position = _segmentMap[segRow*_numSegmentsHorizontal + d] & ~SEGMENT_FLIPPED;
+
+            /* Insertion sort, a chain holds few segments */
+            uint16_t i = numSorted++;
+            while (i > 0 && chain.order[i-1] > position) {
+                chain.order[i] = chain.order[i-1];
+                i--;
+            }
+            chain.order[i] = position;
+        }
+    }
+}
@@ -0,0 +1,183 @@
+/*
+ * File:      MAX7219Transport.h
+ * Authors:   Luke de Munk
+ * Class:     MAX7219Transport, MAX7219SPITransport, MAX7219BulkSPITransport,
+ *            MAX7219RecordingTransport, MAX7219MultiChainTransport
+ *
+ * Transport layer between the MAX7219CWGMatrix and the bus. The matrix
+ * packs its frames into bytes ([register, data] per segment) and hands
+ * them to a transport, which owns the chip-select line and the SPI bus.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef MAX7219_TRANSPORT_H
+#define MAX7219_TRANSPORT_H
+#include <SPI.h>
+#include <Arduino.h>
+#include "Debugger.h"                                                       //For serial debugging
+
+#define MAX7219_SPI_CLOCK       5000000                                     //Default SPI clock in Hz
+#define MAX7219_MAX_SPI_CLOCK   10000000                                    //Maximum SPI clock of the MAX7219 in Hz
+#define MAX7219_BULK_CHUNK      32                                          //Bytes copied per bulk transfer
+#define MAX7219_MAX_CHAINS      4                                           //Maximum number of chains of a multi-chain transport
+#define MAX7219_MAX_FRAMES      8                                           //Frames per writeAsync(), one per digit row
+
+/* Recorded bus events */
+#define EVENT_CS_LOW            0
+#define EVENT_WORD              1
+#define EVENT_CS_HIGH           2
+
+struct MAX7219Event {
+    uint32_t time;                                                          //Timestamp in us
+    uint16_t word;                                                          //Word sent, only for EVENT_WORD
+    uint8_t type;
+};
+
+class MAX7219Transport {
+	public:
+        virtual ~MAX7219Transport() {}
+
+        virtual void begin(uint8_t csPin) = 0;
+        virtual void write(const uint8_t* data, uint16_t length) = 0;
+        virtual void writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames);
+
+        virtual bool isBusy();
+        void waitIdle();
+        void setCallback(void (*callback)());
+
+        virtual void setClock(uint32_t hz);
+        uint32_t getClock();
+
+        /* Chain position per segment, given by the matrix on every change of the wiring */
+        virtual void setWiringMap(const uint16_t* /*map*/, uint16_t /*numSegments*/) {}
+
+	protected:
+        friend class MAX7219MultiChainTransport;
+
+        void _complete();
+        virtual void _chainComplete() {}
+
+        void (*_callback)() = nullptr;
+        MAX7219Transport* _parent = nullptr;                                //Multi-chain transport this is a chain of
+        uint32_t _clock = MAX7219_SPI_CLOCK;
+};
+
+class MAX7219SPITransport : public MAX7219Transport {
+	public:
+        MAX7219SPITransport(SPIClass* spi = &SPI);
+
+        void begin(uint8_t csPin);
+        void write(const uint8_t* data, uint16_t length);
+#if defined(ESP32)
+        void writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames);
+        bool isBusy();
+        void setCore(uint8_t core);
+#endif
+
+	protected:
+        SPIClass* _spi;                                                     //SPI host of the chain
+        uint8_t _csPin;
+
+#if defined(ESP32)
+        static void _flushTask(void* parameter);
+
+        TaskHandle_t _task = nullptr;
+        uint8_t _core = 0;                                                  //Core the flush task runs on
+        const uint8_t* volatile _data = nullptr;
+        volatile uint16_t _frameLength = 0;
+        volatile uint8_t _numFrames = 0;
+        volatile bool _busy = false;
+#endif
+};
+
+class MAX7219BulkSPITransport : public MAX7219SPITransport {
+	public:
+        MAX7219BulkSPITransport(SPIClass* spi = &SPI);
+
+        void write(const uint8_t* data, uint16_t length);
+};
+
+class MAX7219RecordingTransport : public MAX7219Transport {
+	public:
+        MAX7219RecordingTransport();
+        MAX7219RecordingTransport(MAX7219Event* log, uint16_t logSize);
+
+        void begin(uint8_t csPin);
+        void write(const uint8_t* data, uint16_t length);
+
+        void reset();
+        void setBusDelay(bool enabled);
+
+        /* Getters */
+        uint32_t getWords();
+        uint32_t getTransactions();
+        uint32_t getBusTime();
+        uint16_t getNumEvents();
+        MAX7219Event getEvent(uint16_t index);
+        bool isOverflowed();
+
+	private:
+        void _record(uint8_t type, uint16_t word);
+
+        MAX7219Event* _log;
+        uint16_t _logSize;
+        uint16_t _numEvents;
+        bool _overflowed;
+        bool _busDelay;                                                     //Wait the bus time of every frame
+
+        uint32_t _words;
+        uint32_t _transactions;
+};
+
+/* Part of a multi-chain display: a rectangle of segments in the display
+ * buffer. Its chips are chained in the order of the wiring of the matrix,
+ * cut to the rectangle */
+struct MAX7219Chain {
+    MAX7219Transport* transport;
+    uint8_t csPin;
+    uint8_t segmentX;                                                       //Leftmost segment column in the buffer
+    uint8_t segmentY;                                                       //First segment row in the buffer
+    uint8_t numSegmentsHorizontal;
+    uint8_t numSegmentsVertical;
+    uint8_t* buffer;                                                        //Frames of this chain, MAX7219_MAX_FRAMES frames
+    uint16_t* order;                                                        //Word of the display frame per chain position
+};
+
+class MAX7219MultiChainTransport : public MAX7219Transport {
+	public:
+        MAX7219MultiChainTransport(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical);
+        ~MAX7219MultiChainTransport();
+        MAX7219MultiChainTransport(const MAX7219MultiChainTransport&) = delete;
+        MAX7219MultiChainTransport& operator=(const MAX7219MultiChainTransport&) = delete;
+
+        bool addChain(MAX7219Transport* transport, uint8_t csPin, uint8_t segmentX, uint8_t segmentY, uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical);
+
+        void begin(uint8_t csPin);
+        void write(const uint8_t* data, uint16_t length);
+        void writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames);
+        bool isBusy();
+        void setClock(uint32_t hz);
+        void setWiringMap(const uint16_t* map, uint16_t numSegments);
+
+        /* Getters */
+        uint8_t getNumChains();
+        MAX7219Transport* getChain(uint8_t index);
+
+	private:
+        void _chainComplete();
+        void _dispatch(const uint8_t* data, uint16_t frameLength, uint8_t numFrames, bool async);
+        uint16_t _gather(const MAX7219Chain& chain, const uint8_t* frame, uint8_t* buffer);
+        void _orderChain(MAX7219Chain& chain);
+
+        uint8_t _numSegmentsHorizontal;
+        uint8_t _numSegmentsVertical;
+        uint16_t* _segmentMap;                                              //Copy of the wiring map of the matrix
+        bool _hasWiringMap;
+
+        MAX7219Chain _chains[MAX7219_MAX_CHAINS];
+        uint8_t _numChains;
+        volatile uint8_t _pending;                                          //Chains still sending
+        volatile bool _async;                                               //Call the callback when all chains are done
+};
+
+#endif /* MAX7219_TRANSPORT_H */
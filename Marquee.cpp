@@ -0,0 +1,247 @@
+/*
+ * File:      Marquee.cpp
+ * Authors:   Luke de Munk
+ * Class:     Marquee
+ *
+ * Non-blocking scrolling text for a region of a MAX7219CWGMatrix. For
+ * more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "Marquee.h"
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+Marquee::Marquee() {
+    _matrix = nullptr;
+    _x = 0;
+    _y = 0;
+    _width = 0;
+    _rows = 0;
+    _value = 1;
+    _stepDelay = 100;
+    _lastStep = 0;
+    _started = false;
+    _loop = true;
+    _finished = false;
+    _cursor = 0;
+    _textWidth = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the matrix and the region to scroll in.
+  @param    matrix          Matrix to draw on
+  @param    x               X coordinate of leftest column of leds
+  @param    y               Y coordinate of lowest row of leds
+  @param    width           Width of the region in pixels
+  @param    stepDelay       Time per one pixel step in ms
+*/
+/**************************************************************************/
+void Marquee::begin(MAX7219CWGMatrix* matrix, int16_t x, int16_t y, uint16_t width, uint16_t stepDelay) {
+    _matrix = matrix;
+    _x = x;
+    _y = y;
+    _width = width;
+    setSpeed(stepDelay);
+    restart();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Renders the text into the strip with the current font of the
+            matrix, and restarts scrolling.
+  @param    string          String to be shown
+  @param    length          Length of the string (number of characters)
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void Marquee::setText(const char string[], uint8_t length, uint8_t value) {
+    if (_matrix == nullptr) {
+        debugln("ERROR: Call begin() before setting the text of a marquee.");
+        return;
+    }
+
+    uint8_t cols = _matrix->getFontCols();
+    _rows = _matrix->getFontRows();
+    _value = value;
+
+    if (_rows > MARQUEE_MAX_ROWS) {
+        _rows = MARQUEE_MAX_ROWS;
+    }
+
+    /* Same spacing as drawString(), one empty column between characters */
+    if (length*(cols+1) > MARQUEE_MAX_WIDTH) {
+        debugln("ERROR: Text too long for the marquee, cutting it off.");
+        length = MARQUEE_MAX_WIDTH/(cols+1);
+    }
+    _textWidth = length*(cols+1);
+
+    memset(_strip, 0, sizeof(_strip));
+
+    for (uint8_t row = 0; row < _rows; row++) {
+        for (uint8_t c = 0; c < length; c++) {
+            uint8_t bits = _matrix->getGlyphRow(string[c], row);
+            uint16_t position = c*(cols+1);
+            uint8_t shift = position & 7;
+
+            _strip[row][position >> 3] |= bits >> shift;
+            if (shift != 0 && (position >> 3) + 1 < MARQUEE_MAX_WIDTH/8) {
+                _strip[row][(position >> 3) + 1] |= bits << (8 - shift);
+            }
+        }
+    }
+    restart();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the scroll speed.
+  @param    stepDelay       Time per one pixel step in ms
+*/
+/**************************************************************************/
+void Marquee::setSpeed(uint16_t stepDelay) {
+    if (stepDelay == 0) {
+        stepDelay = 1;
+    }
+    _stepDelay = stepDelay;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets if the text starts again when it has scrolled out.
+  @param    loop            True to repeat
+*/
+/**************************************************************************/
+void Marquee::setLoop(bool loop) {
+    _loop = loop;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Starts scrolling again from the right edge of the region.
+*/
+/**************************************************************************/
+void Marquee::restart() {
+    _cursor = _width - 1;
+    _started = false;
+    _finished = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Advances the text by the number of steps passed since the last
+            step and redraws the region. Call it from the main loop as
+            often as possible, it returns immediately.
+  @param    nowMs           Current time in ms, for example millis()
+  @returns  True if the region has been redrawn
+*/
+/**************************************************************************/
+bool Marquee::step(uint32_t nowMs) {
+    if (_matrix == nullptr || _finished) {
+        return false;
+    }
+
+    /* The first step only draws the start position */
+    if (!_started) {
+        _started = true;
+        _lastStep = nowMs;
+        draw();
+        return true;
+    }
+
+    uint32_t steps = (nowMs - _lastStep) / _stepDelay;
+    if (steps == 0) {
+        return false;
+    }
+    _lastStep += steps*_stepDelay;
+
+    /* Scrolled out when the last column passed the left edge */
+    int16_t end = -(int16_t) _textWidth;
+    int32_t cursor = (int32_t) _cursor - steps;
+
+    if (cursor <= end) {
+        if (_loop) {
+            uint16_t period = _width - 1 - end;
+            cursor = _width - 1 - (end - cursor) % period;
+        } else {
+            cursor = end;
+            _finished = true;
+        }
+    }
+    _cursor = cursor;
+
+    draw();
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the visible window of the strip into the region.
+*/
+/**************************************************************************/
+void Marquee::draw() {
+    if (_matrix == nullptr) {
+        return;
+    }
+
+    _matrix->drawFillRectangle(_x, _y, _width, _rows, 0);
+
+    for (uint8_t row = 0; row < _rows; row++) {
+        for (uint16_t k = 0; k < _width; k += 8) {
+            uint8_t bits = _getStripBits(row, k - _cursor);
+
+            /* Keep the last byte inside the region */
+            if (_width - k < 8) {
+                bits &= 0xFF << (8 - (_width - k));
+            }
+            _matrix->drawRow(_x + k, _y + row, bits, _value);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the text has scrolled out and is not looping.
+  @returns  _finished       True if finished
+*/
+/**************************************************************************/
+bool Marquee::isFinished() {
+    return _finished;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width of the rendered text.
+  @returns  _textWidth      Width in pixels
+*/
+/**************************************************************************/
+uint16_t Marquee::getTextWidth() {
+    return _textWidth;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns 8 pixels of a row of the strip.
+  @param    row             Row of the strip
+  @param    position        Pixel position of the most significant bit,
+                            may be outside the strip
+  @returns  Pixels, outside the strip is empty
+*/
+/**************************************************************************/
+uint8_t Marquee::_getStripBits(uint8_t row, int16_t position) {
+    int16_t index = position >> 3;                                          //Rounds down for negative positions
+    uint8_t shift = position & 7;
+    uint8_t high = 0;
+    uint8_t low = 0;
+
+    if (index >= 0 && index < MARQUEE_MAX_WIDTH/8) {
+        high = _strip[row][index];
+    }
+    if (index+1 >= 0 && index+1 < MARQUEE_MAX_WIDTH/8) {
+        low = _strip[row][index+1];
+    }
+    return (high << shift) | (low >> (8 - shift));
+}
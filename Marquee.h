@@ -0,0 +1,60 @@
+/*
+ * File:      Marquee.h
+ * Authors:   Luke de Munk
+ * Class:     Marquee
+ *
+ * Non-blocking scrolling text for a region of a MAX7219CWGMatrix. The
+ * text is rendered once into an off-screen strip, every step only the
+ * visible window is shifted into the region. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef MARQUEE_H
+#define MARQUEE_H
+#include "MAX7219CWGMatrix.h"
+#include "Debugger.h"                                                       //For serial debugging
+
+#define MARQUEE_MAX_WIDTH       256                                         //Maximum width of the text in pixels
+#define MARQUEE_MAX_ROWS        8                                           //Maximum height of a font
+
+class Marquee {
+	public:
+        Marquee();
+
+        void begin(MAX7219CWGMatrix* matrix, int16_t x, int16_t y, uint16_t width, uint16_t stepDelay = 100);
+
+        /* Config functions */
+        void setText(const char string[], uint8_t length, uint8_t value = 1);
+        void setSpeed(uint16_t stepDelay);
+        void setLoop(bool loop);
+        void restart();
+
+        /* Draw functions */
+        bool step(uint32_t nowMs);
+        void draw();
+
+        /* Getters */
+        bool isFinished();
+        uint16_t getTextWidth();
+
+	private:
+        uint8_t _getStripBits(uint8_t row, int16_t position);
+
+        MAX7219CWGMatrix* _matrix;
+        int16_t _x;
+        int16_t _y;
+        uint16_t _width;
+        uint8_t _rows;
+        uint8_t _value;
+
+        uint16_t _stepDelay;
+        uint32_t _lastStep;
+        bool _started;
+        bool _loop;
+        bool _finished;
+
+        int16_t _cursor;                                                    //Region x where the strip starts
+        uint16_t _textWidth;
+        uint8_t _strip[MARQUEE_MAX_ROWS][MARQUEE_MAX_WIDTH/8];
+};
+
+#endif /* MARQUEE_H */
@@ -0,0 +1,231 @@
+/*
+ * File:      Metrics.cpp
+ * Authors:   Luke de Munk
+ * Class:     Metrics
+ *
+ * Performance counters and latency histograms of the display. For more
+ * info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <stdarg.h>
+#include "Metrics.h"
+
+static const char* const CounterNames[NUMBER_OF_COUNTERS] = {"words", "transactions", "frames", "skippedFrames", "commands", "renders"};
+static const char* const TimerNames[NUMBER_OF_TIMERS] = {"render", "flush", "command"};
+
+uint32_t Metrics::_counters[NUMBER_OF_COUNTERS];
+MetricsTimer Metrics::_timers[NUMBER_OF_TIMERS];
+uint32_t Metrics::_starts[NUMBER_OF_TIMERS];
+
+/**************************************************************************/
+/*!
+  @brief    Starts a timer. A timer can not be nested in itself.
+  @param    timer           TIMER_RENDER, _FLUSH or _COMMAND
+*/
+/**************************************************************************/
+void Metrics::start(uint8_t timer) {
+    _starts[timer] = cycles();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Stops a timer and adds the time since start() to it.
+  @param    timer           TIMER_RENDER, _FLUSH or _COMMAND
+*/
+/**************************************************************************/
+void Metrics::stop(uint8_t timer) {
+    uint32_t elapsed = cycles() - _starts[timer];                           //Also right when the counter wrapped
+    uint32_t us = elapsed / getCyclesPerUs();
+    uint8_t bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+    MetricsTimer& t = _timers[timer];
+
+    if (bucket >= METRICS_BUCKETS) {
+        bucket = METRICS_BUCKETS - 1;
+    }
+
+    t.count++;
+    t.totalCycles += elapsed;
+    t.buckets[bucket]++;
+    if (elapsed > t.maxCycles) {
+        t.maxCycles = elapsed;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Adds to a counter.
+  @param    counter         COUNTER_WORDS, _TRANSACTIONS, _FRAMES,
+                            _SKIPPED_FRAMES, _COMMANDS or _RENDERS
+  @param    n               Number to add
+*/
+/**************************************************************************/
+void Metrics::count(uint8_t counter, uint32_t n) {
+    _counters[counter] += n;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets all counters and timers to zero.
+*/
+/**************************************************************************/
+void Metrics::reset() {
+    memset(_counters, 0, sizeof(_counters));
+    memset(_timers, 0, sizeof(_timers));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns a counter.
+  @param    counter         COUNTER_ constant
+  @returns  Value of the counter
+*/
+/**************************************************************************/
+uint32_t Metrics::getCounter(uint8_t counter) {
+    return _counters[counter];
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns a timer, with its histogram.
+  @param    timer           TIMER_ constant
+  @returns  Timer
+*/
+/**************************************************************************/
+const MetricsTimer& Metrics::getTimer(uint8_t timer) {
+    return _timers[timer];
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how many units of cycles() are in a microsecond.
+  @returns  CPU frequency in MHz on the ESP32, 1 elsewhere
+*/
+/**************************************************************************/
+uint32_t Metrics::getCyclesPerUs() {
+#if defined(ESP32)
+    return getCpuFrequencyMhz();
+#else
+    return 1;
+#endif
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the average time of a timer.
+  @param    timer           TIMER_ constant
+  @returns  Average time in us, 0 if never stopped
+*/
+/**************************************************************************/
+float Metrics::getAverageUs(uint8_t timer) {
+    const MetricsTimer& t = _timers[timer];
+
+    if (t.count == 0) {
+        return 0;
+    }
+    return (float) t.totalCycles / t.count / getCyclesPerUs();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the longest time of a timer.
+  @param    timer           TIMER_ constant
+  @returns  Longest time in us
+*/
+/**************************************************************************/
+float Metrics::getMaxUs(uint8_t timer) {
+    return (float) _timers[timer].maxCycles / getCyclesPerUs();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints all counters and timers on the serial port.
+*/
+/**************************************************************************/
+void Metrics::print() {
+    for (uint8_t c = 0; c < NUMBER_OF_COUNTERS; c++) {
+        Serial.print(CounterNames[c]);
+        Serial.print(": ");
+        Serial.println(_counters[c]);
+    }
+
+    for (uint8_t t = 0; t < NUMBER_OF_TIMERS; t++) {
+        Serial.print(TimerNames[t]);
+        Serial.print(": count ");
+        Serial.print(_timers[t].count);
+        Serial.print(", avg us ");
+        Serial.print(getAverageUs(t));
+        Serial.print(", max us ");
+        Serial.print(getMaxUs(t));
+        Serial.print(", histogram");
+
+        for (uint8_t b = 0; b < METRICS_BUCKETS; b++) {
+            Serial.print(" ");
+            Serial.print(_timers[t].buckets[b]);
+        }
+        Serial.println();
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes all counters and timers as JSON, for example for a web
+            server route. Histogram bucket n counts the times below 2^n us.
+  @param    buffer          Buffer to write in
+  @param    size            Size of the buffer
+  @returns  Length of the JSON, cut off if it is size or more
+*/
+/**************************************************************************/
+uint16_t Metrics::toJson(char* buffer, uint16_t size) {
+    uint16_t length = 0;
+
+    _append(buffer, size, length, "{\"counters\":{");
+    for (uint8_t c = 0; c < NUMBER_OF_COUNTERS; c++) {
+        _append(buffer, size, length, "%s\"%s\":%lu", c == 0 ? "" : ",", CounterNames[c], (unsigned long) _counters[c]);
+    }
+
+    _append(buffer, size, length, "},\"timers\":{");
+    for (uint8_t t = 0; t < NUMBER_OF_TIMERS; t++) {
+        _append(buffer, size, length, "%s\"%s\":{\"count\":%lu,\"avgUs\":%.2f,\"maxUs\":%.2f,\"histogram\":[", t == 0 ? "" : ",",
+                TimerNames[t], (unsigned long) _timers[t].count, getAverageUs(t), getMaxUs(t));
+
+        for (uint8_t b = 0; b < METRICS_BUCKETS; b++) {
+            _append(buffer, size, length, "%s%lu", b == 0 ? "" : ",", (unsigned long) _timers[t].buckets[b]);
+        }
+        _append(buffer, size, length, "]}");
+    }
+    _append(buffer, size, length, "}}");
+
+    return length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the clock the timers count with.
+  @returns  CPU cycles on the ESP32, microseconds elsewhere
+*/
+/**************************************************************************/
+uint32_t Metrics::cycles() {
+#if defined(ESP32)
+    return ESP.getCycleCount();
+#else
+    return micros();
+#endif
+}
+
+/**************************************************************************/
+/*!
+  @brief    Appends formatted text to a buffer, never past its end.
+  @param    buffer          Buffer to write in
+  @param    size            Size of the buffer
+  @param    length          Length of the text so far, also counts what
+                            did not fit
+  @param    format          printf() format
+*/
+/**************************************************************************/
+void Metrics::_append(char* buffer, uint16_t size, uint16_t& length, const char format[], ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    length += vsnprintf(buffer + (length < size ? length : size), length < size ? size - length : 0, format, arguments);
+    va_end(arguments);
+}
@@ -0,0 +1,83 @@
+/*
+ * File:      Metrics.h
+ * Authors:   Luke de Munk
+ * Class:     Metrics
+ *
+ * Performance counters of the display: SPI words, transactions, frames
+ * and commands, and timers with a latency histogram around rendering,
+ * flushing and sending commands. Timers count CPU cycles on the ESP32
+ * and microseconds elsewhere. Read them with the getters, print them on
+ * the serial port with print() or as JSON with toJson(). Set METRICS to
+ * 0 to compile all measuring out. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef METRICS_H
+#define METRICS_H
+#include <Arduino.h>
+
+/* Enable or disable metrics here */
+#define METRICS             1
+
+/* Counters */
+#define COUNTER_WORDS           0                                           //16-bit words written to the bus
+#define COUNTER_TRANSACTIONS    1                                           //Chip-select frames written to the bus
+#define COUNTER_FRAMES          2                                           //Calls to display() and displayAsync()
+#define COUNTER_SKIPPED_FRAMES  3                                           //Frames without a changed row
+#define COUNTER_COMMANDS        4                                           //Commands sent to all segments
+#define COUNTER_RENDERS         5                                           //Screens rendered
+#define NUMBER_OF_COUNTERS      6
+
+/* Timers */
+#define TIMER_RENDER            0                                           //Rendering a screen, flush included
+#define TIMER_FLUSH             1                                           //display(), or packing for displayAsync()
+#define TIMER_COMMAND           2                                           //Sending a command to all segments
+#define NUMBER_OF_TIMERS        3
+
+#define METRICS_BUCKETS         16                                          //Bucket n: below 2^n us, the last one the rest
+
+#if METRICS == 1
+    #define metricsStart(timer) Metrics::start(timer)
+    #define metricsStop(timer) Metrics::stop(timer)
+    #define metricsCount(counter, n) Metrics::count(counter, n)
+#else
+    #define metricsStart(timer)
+    #define metricsStop(timer)
+    #define metricsCount(counter, n) (void) (n)                             //Keeps variables only counted in use
+#endif
+
+struct MetricsTimer {
+    uint32_t count;
+    uint64_t totalCycles;
+    uint32_t maxCycles;
+    uint32_t buckets[METRICS_BUCKETS];
+};
+
+class Metrics {
+	public:
+        static void start(uint8_t timer);
+        static void stop(uint8_t timer);
+        static void count(uint8_t counter, uint32_t n);
+        static void reset();
+
+        /* Getters */
+        static uint32_t getCounter(uint8_t counter);
+        static const MetricsTimer& getTimer(uint8_t timer);
+        static uint32_t getCyclesPerUs();
+        static float getAverageUs(uint8_t timer);
+        static float getMaxUs(uint8_t timer);
+
+        /* Output functions */
+        static void print();
+        static uint16_t toJson(char* buffer, uint16_t size);
+
+        static uint32_t cycles();
+
+	private:
+        static void _append(char* buffer, uint16_t size, uint16_t& length, const char format[], ...);
+
+        static uint32_t _counters[NUMBER_OF_COUNTERS];
+        static MetricsTimer _timers[NUMBER_OF_TIMERS];
+        static uint32_t _starts[NUMBER_OF_TIMERS];
+};
+
+#endif /* METRICS_H */
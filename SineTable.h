@@ -0,0 +1,38 @@
+/*
+ * File:        SineTable.h
+ * Author:      Luke de Munk
+ * 
+ * Fixed-point quarter wave sine table, generated by the compiler. Used
+ * for lines and arcs under an angle without floating point math.
+ */
+#ifndef SINE_TABLE_H
+#define SINE_TABLE_H
+
+#define SINE_TABLE_STEPS        180                                         //Entries per quarter turn, half a degree apart
+#define SINE_TABLE_ONE          65535                                       //Fixed-point value of 1.0
+
+/* Taylor series of sin(x) up to x^13, exact to far below 1/65535 for 0 <= x <= pi/2 */
+constexpr double sineTaylor(double x, double x2) {
+    return x*(1 - x2/6*(1 - x2/20*(1 - x2/42*(1 - x2/72*(1 - x2/110*(1 - x2/156))))));
+}
+
+/* Entry i is sin(i/2 degrees), rounded */
+constexpr uint16_t sineTableEntry(uint8_t i) {
+    return (uint16_t) (sineTaylor(i*3.14159265358979323846/360, (i*3.14159265358979323846/360)*(i*3.14159265358979323846/360))*SINE_TABLE_ONE + 0.5);
+}
+
+#define SINE_ENTRIES_10(i)  sineTableEntry(i), sineTableEntry(i+1), sineTableEntry(i+2), sineTableEntry(i+3), sineTableEntry(i+4), \
+                            sineTableEntry(i+5), sineTableEntry(i+6), sineTableEntry(i+7), sineTableEntry(i+8), sineTableEntry(i+9)
+
+/* SineTable[i] is sin(i/2 degrees) * SINE_TABLE_ONE, 0 to 90 degrees */
+const uint16_t SineTable[SINE_TABLE_STEPS + 1] PROGMEM = {
+    SINE_ENTRIES_10(0),   SINE_ENTRIES_10(10),  SINE_ENTRIES_10(20),  SINE_ENTRIES_10(30),
+    SINE_ENTRIES_10(40),  SINE_ENTRIES_10(50),  SINE_ENTRIES_10(60),  SINE_ENTRIES_10(70),
+    SINE_ENTRIES_10(80),  SINE_ENTRIES_10(90),  SINE_ENTRIES_10(100), SINE_ENTRIES_10(110),
+    SINE_ENTRIES_10(120), SINE_ENTRIES_10(130), SINE_ENTRIES_10(140), SINE_ENTRIES_10(150),
+    SINE_ENTRIES_10(160), SINE_ENTRIES_10(170), sineTableEntry(180)
+};
+
+#undef SINE_ENTRIES_10
+
+#endif /* SINE_TABLE_H */
@@ -16,40 +16,69 @@
   @param    numSegmentsVertical     Number of vertical segments
   @param    csPin                   Chip-Select pin
   @param    wiringType              Type of circuit is used. Check circuit diagram.
+  @param    buffer                  Memory of MAX7219_BUFFER_SIZE bytes for the
+                                    matrix, nullptr to allocate it once
 */
 /**************************************************************************/
-SmartLedDisplay::SmartLedDisplay(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType) {
-    _matrix.initialiseMatrix(numSegmentsHorizontal, numSegmentsVertical, csPin, wiringType);
+SmartLedDisplay::SmartLedDisplay(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType, uint8_t* buffer) {
+    _matrix.initialiseMatrix(numSegmentsHorizontal, numSegmentsVertical, csPin, wiringType, buffer);
 
     /* Initialise the display */
     _matrix.setPower(true);
     _matrix.setIntensity(0);
     _matrix.setRotation(UPSIDE_DOWN_ROTATION);
     _matrix.display();
+
+    /* Borders and clock faces do not change between frames, the digital clock only redraws changed digits */
+    _compositor.begin(&_matrix, 3);
+    _compositor.setStatic(LAYER_BACKGROUND, true);
+    _digitalClock.begin(&_matrix, 6, 2);
     
     _time.minute = 0;
     _time.hour = 0;
-
-    _months[0] = JANUARY;
-    _months[1] = FEBRUARY;
-    _months[2] = MARCH;
-    _months[3] = APRIL;
-    _months[4] = MAY;
-    _months[5] = JUNE;
-    _months[6] = JULY;
-    _months[7] = AUGUST;
-    _months[8] = SEPTEMBER;
-    _months[9] = OCTOBER;
-    _months[10] = NOVEMBER;
-    _months[11] = DECEMBER;
+    _clock = millis;
+    _timeBase = 0;
+    _timeSetAt = _clock();
+
+    /* The clock screen has a second hand, the others are static */
+    _dependencies[0] = DEPENDS_ON_SECOND;
+    _dependencies[1] = 0;
+    _dependencies[2] = 0;
+    _screen = 0;
+    _changed = 0;
+    _screenChanged = true;                                                  //First update() renders
+    _screenSwitched = false;
+    _offscreen = false;
+    _renderedKey = 0;
+    _numRenders = 0;
 
     _date.day = 0;
     _date.month = 0;
     _date.year = 0;
 
-    _longDate.dayName = MONDAY;
+    _longDate.dayOfWeek = 0;
     _longDate.day = 0;
     _longDate.month = 0;
+    _dateX = 0xFF;                                                          //Forces the first date to be rendered
+    _dateY = 0xFF;
+
+    _transitionType = TRANSITION_NONE;
+    _transitionDirection = SHIFT_LEFT;
+    _transitionFrames = 0;
+    _transitionFrameTime = TRANSITION_FRAME_TIME;
+    _transitionStep = 0;
+    _transitionStepAt = 0;
+    _transitionSeed = 0;
+    _transitionFrame = nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Destructor, frees the frame of the transitions.
+*/
+/**************************************************************************/
+SmartLedDisplay::~SmartLedDisplay() {
+    free(_transitionFrame);
 }
 
 /**************************************************************************/
@@ -60,6 +89,7 @@ SmartLedDisplay::SmartLedDisplay(uint8_t numSegmentsHorizontal, uint8_t numSegme
 /**************************************************************************/
 void SmartLedDisplay::setPower(bool on) {
 	_matrix.setPower(on);
+    _changed |= DEPENDS_ON_POWER;
 }
 
 /**************************************************************************/
@@ -70,6 +100,7 @@ void SmartLedDisplay::setPower(bool on) {
 /**************************************************************************/
 void SmartLedDisplay::setIntensity(uint8_t level) {
 	_matrix.setIntensity(level);
+    _changed |= DEPENDS_ON_INTENSITY;
 }
 
 /**************************************************************************/
@@ -80,6 +111,8 @@ void SmartLedDisplay::setIntensity(uint8_t level) {
 /**************************************************************************/
 void SmartLedDisplay::setRotation(uint8_t rotation) {
     _matrix.setRotation(rotation);
+    _compositor.invalidateAll();
+    _screenChanged = true;                                                  //Everything moves
 }
 
 /**************************************************************************/
@@ -90,23 +123,186 @@ void SmartLedDisplay::setRotation(uint8_t rotation) {
 /**************************************************************************/
 void SmartLedDisplay::setInverted(bool inverted) {
     _matrix.setInverted(inverted);
+    _changed |= DEPENDS_ON_INVERTED;
 }
 
 /**************************************************************************/
 /*!
-  @brief    Sets time to display.
+  @brief    Sets time to display. From then on the time advances with the
+            clock source, so it only has to be set again to correct it.
   @param    time            Time object to describe the time
+  @param    millis          Milliseconds into the second, aligns the
+                            seconds of the display
 */
 /**************************************************************************/
-void SmartLedDisplay::setTime(Time time) {
+void SmartLedDisplay::setTime(Time time, uint16_t millis) {
     _time.second = time.second;
     _time.minute = time.minute;
     _time.hour = time.hour;
+
+    _timeBase = (uint32_t) time.hour*3600 + time.minute*60;
+    if (time.second != 255) {
+        _timeBase += time.second;
+    }
+    _timeSetAt = _clock() - millis;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the screen update() shows.
+  @param    screen          Screen (0 to NUMBER_OF_SCREENS-1)
+*/
+/**************************************************************************/
+void SmartLedDisplay::setScreen(uint8_t screen) {
+    if (screen >= NUMBER_OF_SCREENS) {
+        debugln("ERROR: Screen does not exist.");
+        return;
+    }
+
+    if (screen != _screen) {
+        _screen = screen;
+        _screenChanged = true;
+        _screenSwitched = true;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Declares the state a screen shows. update() only renders the
+            screen again when the screen changed, when the time passed a
+            second or minute it depends on, or when other state it
+            depends on changed.
+  @param    screen          Screen (0 to NUMBER_OF_SCREENS-1)
+  @param    dependencies    DEPENDS_ON_ flags, OR-ed together
+*/
+/**************************************************************************/
+void SmartLedDisplay::setScreenDependencies(uint8_t screen, uint8_t dependencies) {
+    if (screen >= NUMBER_OF_SCREENS) {
+        debugln("ERROR: Screen does not exist.");
+        return;
+    }
+    _dependencies[screen] = dependencies;
+    _screenChanged = true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets how update() changes from one screen to another. The old
+            screen is changed into the new one in place in the display
+            buffer, a step every frame time; the screen is rendered once.
+  @param    type            TRANSITION_NONE, _SLIDE, _WIPE or _DISSOLVE
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN, the way a
+                            slide or wipe moves
+  @param    frames          Number of frames
+  @param    frameTime       Time per frame in ms
+  @returns  True if the frame of the new screen could be allocated
+*/
+/**************************************************************************/
+bool SmartLedDisplay::setTransition(uint8_t type, uint8_t direction, uint8_t frames, uint16_t frameTime) {
+    if (type > TRANSITION_DISSOLVE || direction > SHIFT_DOWN || frames == 0) {
+        debugln("ERROR: Invalid transition.");
+        return false;
+    }
+
+    if (type != TRANSITION_NONE && _transitionFrame == nullptr) {
+        _transitionFrame = (uint8_t*) malloc(_matrix.getFrameSize());
+
+        if (_transitionFrame == nullptr) {
+            debugln("ERROR: Not enough memory for transitions.");
+            return false;
+        }
+    }
+
+    /* A running transition is stopped, the half slid frame is redrawn */
+    if (isTransitioning()) {
+        _screenChanged = true;
+    }
+
+    _transitionType = type;
+    _transitionDirection = direction;
+    _transitionFrames = frames;
+    _transitionFrameTime = frameTime;
+    _transitionStep = frames;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the clock the time, the transitions and the scrolling
+            text advance with, for example a simulated clock when testing
+            on a computer.
+  @param    clock           Function that returns the time in ms
+*/
+/**************************************************************************/
+void SmartLedDisplay::setClockSource(unsigned long (*clock)()) {
+    Time time = getTime();
+
+    _clock = clock;
+    setTime(time);                                                          //Continue from the current time
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the transport the frames are sent with.
+  @param    transport       Transport, the SPI bus by default
+*/
+/**************************************************************************/
+void SmartLedDisplay::setTransport(MAX7219Transport* transport) {
+    _matrix.setTransport(transport);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Queues a change of the display for the next update(), so the
+            SPI bus is only used by the task that calls update(). Safe to
+            call from any task, for example a web server handler, never
+            blocks.
+  @param    type            COMMAND_POWER, _INTENSITY, _INVERTED, _SCREEN
+                            or _ROTATION
+  @param    value           Value for the setter of the command
+  @returns  True if queued, false if the queue is full
+*/
+/**************************************************************************/
+bool SmartLedDisplay::post(uint8_t type, uint32_t value) {
+    DisplayCommand command;
+    command.type = type;
+    command.value = value;
+
+    return _commands.push(command);
 }
 
 /**************************************************************************/
 /*!
-  @brief    Scrolls a string.
+  @brief    Sets a marquee up to scroll in a region of this display.
+  @param    marquee         Marquee to set up
+  @param    x               X coordinate of leftest column of leds
+  @param    y               Y coordinate of lowest row of leds
+  @param    width           Width of the region in pixels
+  @param    stepDelay       Time per one pixel step in ms
+*/
+/**************************************************************************/
+void SmartLedDisplay::beginMarquee(Marquee& marquee, uint8_t x, uint8_t y, uint8_t width, uint16_t stepDelay) {
+    marquee.begin(&_matrix, x, y, width, stepDelay);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets an animation up to play on this display. Call step() of
+            the animation from the main loop and display() when it
+            returns true.
+  @param    animation       Animation to set up
+  @param    reader          Reader of the animation file
+  @returns  True if the animation fits this display
+*/
+/**************************************************************************/
+bool SmartLedDisplay::beginAnimation(Animation& animation, AnimationReader* reader) {
+    return animation.begin(&_matrix, reader);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Scrolls a string once and returns when it has scrolled out.
+            Blocks the caller; use a Marquee to scroll without blocking.
   @param    x               X coordinate of leftest column of leds
   @param    y               Y coordinate of lowest row of leds
   @param    width           Maximum width in pixels
@@ -117,17 +313,17 @@ void SmartLedDisplay::setTime(Time time) {
 */
 /**************************************************************************/
 void SmartLedDisplay::showScrollingString(uint8_t x, uint8_t y, uint8_t width, char string[], uint8_t length, uint8_t value, uint8_t scrollDelay) {
-    int spacing = length*_matrix.getFontCols();
-    
-    for (int cursor = width-1; cursor > 0-spacing; cursor--) {
-        for (int character = 0; character < length; character++) {
-            if (x+character+(cursor+character*_matrix.getFontCols()) < x + width && x+character+(cursor+character*_matrix.getFontCols()) > x) {
-                _matrix.drawChar(x+character+(cursor+character*_matrix.getFontCols()), y, string[character], value);
-            }
+    Marquee marquee;
+
+    marquee.begin(&_matrix, x, y, width, scrollDelay);
+    marquee.setLoop(false);
+    marquee.setText(string, length, value);
+
+    while (!marquee.isFinished()) {
+        if (marquee.step(_clock())) {
+            display();
         }
-        display();
-        delay(scrollDelay);
-        clear();
+        yield();
     }
 }
 
@@ -140,23 +336,10 @@ void SmartLedDisplay::showScrollingString(uint8_t x, uint8_t y, uint8_t width, c
 */
 /**************************************************************************/
 void SmartLedDisplay::printDigitalTime(uint8_t x, uint8_t y, uint8_t value) {
-    uint8_t length = 0;
-
-    if (_time.second == 255) {
-        length = 5;                                                         //Without +1 for line ending, without second
-    } else {
-        length = 8+1;                                                       //+1 for line ending, with second
-    }
-
-    char timeString[length];
+    char timeString[TIME_SECONDS_LENGTH];
+    uint8_t length = TextFormat::time(timeString, _time.hour, _time.minute, _time.second);
 
-    if (_time.second == 255) {
-        sprintf(timeString, "%02d:%02d", _time.hour, _time.minute);         //Contruct string, without second
-    } else {
-        sprintf(timeString, "%02d:%02d:%02d", _time.hour, _time.minute, _time.second);   //Contruct string, with second
-    }
-
-    _matrix.drawString(x, y, timeString, length, 1);
+    _matrix.drawString(x, y, timeString, length, value);
 }
 
 /**************************************************************************/
@@ -172,18 +355,8 @@ void SmartLedDisplay::drawAnalogTime(uint8_t x, uint8_t y, uint8_t r, uint8_t va
     if (r < 5) {
         r = 5;
     }
-    
-    if (_time.second != 255) {
-        uint16_t angleSecond = 360/60*_time.second;
-        _matrix.drawLineAngle(x, y, r-1, angleSecond, value);
-    }
-    
-    uint16_t angleMinute = 360/60*_time.minute;
-    _matrix.drawLineAngle(x, y, r-2, angleMinute, value);
-    
-    uint16_t angleHour = 360/12*_time.hour;
-    _matrix.drawLineAngle(x, y, r-4, angleHour, value);
 
+    _drawClockHands(x, y, r, value);
     _matrix.drawCircle(x, y, r, value);
 }
 
@@ -197,17 +370,16 @@ void SmartLedDisplay::drawAnalogTime(uint8_t x, uint8_t y, uint8_t r, uint8_t va
 */
 /**************************************************************************/
 void SmartLedDisplay::printShortDate(uint8_t x, uint8_t y, Date date, uint8_t value) {
-    uint8_t length = 10+1;                                                  //+1 for line ending
-    char dateString[length];
-
-    sprintf(dateString, "%02d-%02d-%d", date.day, date.month, date.year);   //Contruct string
+    char dateString[SHORT_DATE_LENGTH];
+    uint8_t length = TextFormat::shortDate(dateString, date.day, date.month, date.year);
 
-    _matrix.drawString(x, y, dateString, length, 1);
+    _matrix.drawString(x, y, dateString, length, value);
 }
 
 /**************************************************************************/
 /*!
-  @brief    Prints date in notation [day] [date] [month].
+  @brief    Prints date in notation [day] [date] [month]. Scrolls without
+            blocking, call it every frame.
   @param    x               X coordinate of leftest column of leds
   @param    y               Y coordinate of lowest row of leds
   @param    date            Date object
@@ -215,12 +387,53 @@ void SmartLedDisplay::printShortDate(uint8_t x, uint8_t y, Date date, uint8_t va
 */
 /**************************************************************************/
 void SmartLedDisplay::printLongDate(uint8_t x, uint8_t y, LongDate date, uint8_t value) {
-    uint8_t length = date.dayName.length() + 2 + _months[date.month].length()+1;    //+1 for line ending
-    char dateString[length];
+    /* Only format and render the text again when the date or the region changed */
+    if (date.day != _longDate.day || date.month != _longDate.month || date.dayOfWeek != _longDate.dayOfWeek || x != _dateX || y != _dateY) {
+        char dateString[LONG_DATE_LENGTH];
+        uint8_t length = TextFormat::longDate(dateString, date.dayOfWeek, date.day, date.month);
+
+        _longDate = date;
+        _dateX = x;
+        _dateY = y;
+        _dateMarquee.begin(&_matrix, x, y, _matrix.getWidth()-x);
+        _dateMarquee.setText(dateString, length, value);
+    }
 
-    sprintf(dateString, "%s %d %s", date.dayName, date.day, _months[date.month]);   //Contruct string
-    showScrollingString(x, y, _matrix.getWidth()-x, dateString, length, value);
-    //drawString(x, y, dateString, length, 1);
+    if (!_dateMarquee.step(_clock())) {
+        _dateMarquee.draw();                                                //Buffer may have been cleared
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a 1 bit per pixel bitmap, for example an icon or a logo.
+  @param    x               X coordinate of leftest column of leds
+  @param    y               Y coordinate of lowest row of leds
+  @param    bitmap          Packed rows, ceil(w/8) bytes per row, may be
+                            in flash
+  @param    w               Width in pixels
+  @param    h               Height in pixels
+  @param    rasterOp        RASTER_OP_COPY, _OR, _AND, _XOR or _MASK
+  @param    mask            Packed rows, only pixels that are on in the
+                            mask are drawn. nullptr if none
+*/
+/**************************************************************************/
+void SmartLedDisplay::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], uint16_t w, uint16_t h, uint8_t rasterOp, const uint8_t mask[]) {
+    _matrix.drawBitmap(x, y, bitmap, w, h, rasterOp, mask);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a sprite of a sprite sheet.
+  @param    x               X coordinate of leftest column of leds
+  @param    y               Y coordinate of lowest row of leds
+  @param    sheet           Sprite sheet
+  @param    index           Sprite
+  @param    rasterOp        RASTER_OP_COPY, _OR, _AND, _XOR or _MASK
+*/
+/**************************************************************************/
+void SmartLedDisplay::drawSprite(int16_t x, int16_t y, SpriteSheet& sheet, uint16_t index, uint8_t rasterOp) {
+    sheet.draw(&_matrix, x, y, index, rasterOp);
 }
 
 /**************************************************************************/
@@ -229,11 +442,25 @@ void SmartLedDisplay::printLongDate(uint8_t x, uint8_t y, LongDate date, uint8_t
 */
 /**************************************************************************/
 void SmartLedDisplay::showScreen1() {
-    clear();
-    _matrix.drawRectangle(0, 0, getWidth(), getHeight(), 1);
-    drawAnalogTime(15, 15, 7, 1);
-    _time.second = 255;                                                     //Reset second to write short digital clock
-    printDigitalTime(6, 2, 1);
+    /* Border and clock face, only drawn after an invalidate */
+    if (_compositor.beginLayer(LAYER_BACKGROUND)) {
+        _matrix.drawRectangle(0, 0, getWidth(), getHeight(), 1);
+        _matrix.drawCircle(15, 15, 7, 1);
+        _compositor.endLayer();
+    }
+
+    _compositor.beginLayer(LAYER_CONTENT);
+    _drawClockHands(15, 15, 7, 1);
+    _compositor.endLayer();
+
+    /* Short digital clock, its layer keeps the digits that did not change */
+    if (!_compositor.editLayer(LAYER_OVERLAY)) {
+        _digitalClock.invalidate();
+    }
+    _digitalClock.draw(_time.hour, _time.minute);
+    _compositor.endLayer();
+
+    _compositor.compose();
     display();
 }
 
@@ -243,6 +470,7 @@ void SmartLedDisplay::showScreen1() {
 */
 /**************************************************************************/
 void SmartLedDisplay::showScreen2() {
+    _compositor.invalidateAll();                                            //Screen 1 draws its background again
     clear();
     _matrix.drawString(0, 0, "Screen2", 7, 1);
     display();
@@ -254,6 +482,7 @@ void SmartLedDisplay::showScreen2() {
 */
 /**************************************************************************/
 void SmartLedDisplay::showScreen3() {
+    _compositor.invalidateAll();
     clear();
     _matrix.drawString(0, 0, "Screen3", 7, 1);
     display();
@@ -265,7 +494,7 @@ void SmartLedDisplay::showScreen3() {
   @returns  width           Width in pixels
 */
 /**************************************************************************/
-uint8_t SmartLedDisplay::getWidth() {
+uint16_t SmartLedDisplay::getWidth() {
     return _matrix.getWidth();
 }
 
@@ -275,7 +504,7 @@ uint8_t SmartLedDisplay::getWidth() {
   @returns  height          Height in pixels
 */
 /**************************************************************************/
-uint8_t SmartLedDisplay::getHeight() {
+uint16_t SmartLedDisplay::getHeight() {
     return _matrix.getHeight();
 }
 
@@ -311,12 +540,90 @@ bool SmartLedDisplay::getInverted() {
 
 /**************************************************************************/
 /*!
-  @brief    Returns the time of the display.
-  @returns  _time           Time object
+  @brief    Returns the current time of the display, the time that was set
+            advanced by the clock source.
+  @returns  Time object
 */
 /**************************************************************************/
 Time SmartLedDisplay::getTime() {
-    return _time;
+    uint32_t seconds = _secondsOfDay();
+    Time time;
+
+    time.hour = seconds / 3600;
+    time.minute = (seconds / 60) % 60;
+    time.second = seconds % 60;
+    return time;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the screen update() shows.
+  @returns  _screen         Screen
+*/
+/**************************************************************************/
+uint8_t SmartLedDisplay::getScreen() {
+    return _screen;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how long the shown screen stays valid: the time until
+            the next second or minute it depends on. The main loop can
+            sleep this long, or until the state changes.
+  @returns  Time in ms, 0 if update() has work, NO_DEADLINE if the screen
+            does not depend on the time
+*/
+/**************************************************************************/
+uint32_t SmartLedDisplay::getTimeToUpdate() {
+    uint8_t dependencies = _dependencies[_screen];
+
+    if (_screenSwitched || !_commands.isEmpty()) {
+        return 0;
+    }
+
+    /* The next frame of the transition */
+    if (isTransitioning()) {
+        uint32_t elapsed = _clock() - _transitionStepAt;
+        return elapsed < _transitionFrameTime ? _transitionFrameTime - elapsed : 0;
+    }
+
+    if (_screenChanged || _changed != 0) {
+        return 0;
+    }
+
+    uint32_t period;
+    if (dependencies & DEPENDS_ON_SECOND) {
+        period = 1000;
+    } else if (dependencies & DEPENDS_ON_MINUTE) {
+        period = 60000;
+    } else {
+        return NO_DEADLINE;
+    }
+
+    uint32_t elapsed = _clock() - _timeSetAt;
+    uint32_t intoPeriod = ((_timeBase % (period/1000))*1000 + elapsed % period) % period;
+
+    return period - intoPeriod;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns how many times update() rendered a screen.
+  @returns  _numRenders     Number of renders
+*/
+/**************************************************************************/
+uint32_t SmartLedDisplay::getNumRenders() {
+    return _numRenders;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a transition between screens is running.
+  @returns  True if running
+*/
+/**************************************************************************/
+bool SmartLedDisplay::isTransitioning() {
+    return _transitionStep < _transitionFrames;
 }
 
 /**************************************************************************/
@@ -325,7 +632,9 @@ Time SmartLedDisplay::getTime() {
 */
 /**************************************************************************/
 void SmartLedDisplay::display() {
-    _matrix.display();
+    if (!_offscreen) {
+        _matrix.display();
+    }
 }
 
 /**************************************************************************/
@@ -336,3 +645,217 @@ void SmartLedDisplay::display() {
 void SmartLedDisplay::clear() {
     _matrix.clear();
 }
+
+/**************************************************************************/
+/*!
+  @brief    Applies the posted commands, then renders and sends the
+            screen, but only if state it depends on changed since the last
+            update. Cheap when nothing changed.
+  @returns  True if something has been sent
+*/
+/**************************************************************************/
+bool SmartLedDisplay::update() {
+    _applyCommands();
+
+    /* Other changes wait for the transition, unless the screen is switched again */
+    if (isTransitioning() && !_screenSwitched) {
+        return _stepTransition();
+    }
+
+    uint8_t dependencies = _dependencies[_screen];
+    uint32_t key = _timeKey(dependencies);
+
+    bool render = _screenChanged || (_changed & dependencies) != 0 || key != _renderedKey;
+    bool flush = render || (_changed & DEPENDS_ON_INVERTED) != 0;           //Inverting only resends the rows
+    bool switched = _screenSwitched;
+
+    _screenChanged = false;
+    _screenSwitched = false;
+    _changed = 0;
+
+    if (render) {
+        _renderedKey = key;
+        _numRenders++;
+
+        if (switched && _transitionType != TRANSITION_NONE) {
+            _startTransition();
+            return _stepTransition();
+        }
+        _renderScreen();
+    } else if (flush) {
+        display();
+    }
+    return flush;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Applies the commands posted since the last update(), in order.
+*/
+/**************************************************************************/
+void SmartLedDisplay::_applyCommands() {
+    DisplayCommand command;
+
+    while (_commands.pop(command)) {
+        switch (command.type) {
+            case COMMAND_POWER:
+                setPower(command.value);
+                break;
+            case COMMAND_INTENSITY:
+                setIntensity(command.value);
+                break;
+            case COMMAND_INVERTED:
+                setInverted(command.value);
+                break;
+            case COMMAND_SCREEN:
+                setScreen(command.value);
+                break;
+            case COMMAND_ROTATION:
+                setRotation(command.value);
+                break;
+            default:
+                debugln("ERROR: Unknown command.");
+                break;
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the hands of the analog clock.
+  @param    x               X coordinate of the center
+  @param    y               Y coordinate of the center
+  @param    r               Radius of clock (at least 5)
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void SmartLedDisplay::_drawClockHands(uint8_t x, uint8_t y, uint8_t r, uint8_t value) {
+    if (_time.second != 255) {
+        uint16_t angleSecond = _time.second*(FULL_ANGLE/60);
+        _matrix.drawLineFineAngle(x, y, r-1, angleSecond, value);
+    }
+    
+    uint16_t angleMinute = _time.minute*(FULL_ANGLE/60);
+    _matrix.drawLineFineAngle(x, y, r-2, angleMinute, value);
+    
+    /* Hour hand moves on with the minutes, 720 positions */
+    uint16_t angleHour = ((_time.hour % 12)*60 + _time.minute)*(FULL_ANGLE/720);
+    _matrix.drawLineFineAngle(x, y, r-4, angleHour, value);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Renders the current screen at the current time.
+*/
+/**************************************************************************/
+void SmartLedDisplay::_renderScreen() {
+    metricsStart(TIMER_RENDER);
+    _time = getTime();
+
+    /* Screens that do not depend on seconds do not show them */
+    if (!(_dependencies[_screen] & DEPENDS_ON_SECOND)) {
+        _time.second = 255;
+    }
+
+    switch (_screen) {
+        case 0:
+            showScreen1();
+            break;
+        case 1:
+            showScreen2();
+            break;
+        case 2:
+            showScreen3();
+            break;
+    }
+
+    metricsCount(COUNTER_RENDERS, 1);
+    metricsStop(TIMER_RENDER);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Renders the new screen into the frame of the transition
+            without sending it, the shown screen stays in the display
+            buffer.
+*/
+/**************************************************************************/
+void SmartLedDisplay::_startTransition() {
+    _offscreen = true;
+    _matrix.swapFrame(_transitionFrame);                                    //Keep the shown screen
+    _renderScreen();
+    _matrix.swapFrame(_transitionFrame);                                    //Shown screen back, the new one is the target
+    _offscreen = false;
+
+    _transitionStep = 0;
+    _transitionStepAt = _clock() - _transitionFrameTime;                    //First step right away
+    _transitionSeed += 23;                                                  //Another dither pattern every dissolve
+}
+
+/**************************************************************************/
+/*!
+  @brief    Runs the next step of the transition and sends the frame, if
+            the frame time has passed. A late step is not caught up, the
+            transition keeps its number of frames.
+  @returns  True if a frame has been sent
+*/
+/**************************************************************************/
+bool SmartLedDisplay::_stepTransition() {
+    uint32_t now = _clock();
+
+    if (now - _transitionStepAt < _transitionFrameTime) {
+        return false;
+    }
+    _transitionStepAt = now;
+    _transitionStep++;
+
+    bool horizontal = _transitionDirection == SHIFT_LEFT || _transitionDirection == SHIFT_RIGHT;
+    uint16_t size = horizontal ? getWidth() : getHeight();
+    uint16_t position = (uint32_t) size*_transitionStep/_transitionFrames;
+
+    switch (_transitionType) {
+        case TRANSITION_SLIDE: {
+            uint16_t previous = (uint32_t) size*(_transitionStep-1)/_transitionFrames;
+            _matrix.shiftFrame(_transitionDirection, position - previous, _transitionFrame, previous);
+            break;
+        }
+        case TRANSITION_WIPE:
+            _matrix.wipeFrame(_transitionFrame, _transitionDirection, position);
+            break;
+        case TRANSITION_DISSOLVE:
+            _matrix.dissolveFrame(_transitionFrame, (uint16_t) DISSOLVE_LEVELS*_transitionStep/_transitionFrames, _transitionSeed);
+            break;
+    }
+
+    display();
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the current time in seconds since midnight.
+  @returns  Seconds (0 to 86399)
+*/
+/**************************************************************************/
+uint32_t SmartLedDisplay::_secondsOfDay() {
+    uint32_t elapsed = (_clock() - _timeSetAt) / 1000;
+    return (_timeBase + elapsed) % 86400;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns a key of the time at the granularity a screen depends
+            on. The screen has to be rendered again when it changes.
+  @param    dependencies    DEPENDS_ON_ flags of the screen
+  @returns  Seconds or minutes since midnight, 0 if it does not depend on
+            the time
+*/
+/**************************************************************************/
+uint32_t SmartLedDisplay::_timeKey(uint8_t dependencies) {
+    if (dependencies & DEPENDS_ON_SECOND) {
+        return _secondsOfDay();
+    } else if (dependencies & DEPENDS_ON_MINUTE) {
+        return _secondsOfDay() / 60;
+    }
+    return 0;
+}
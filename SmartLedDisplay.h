@@ -10,6 +10,13 @@
 #ifndef SMART_LED_DISPLAY_H
 #define SMART_LED_DISPLAY_H
 #include "MAX7219CWGMatrix.h"
+#include "Marquee.h"
+#include "Compositor.h"
+#include "SpriteSheet.h"
+#include "Animation.h"
+#include "CommandQueue.h"
+#include "TextFormat.h"
+#include "DigitalClock.h"
 #include "Debugger.h"                                                       //For serial debugging
 
 /* Days */
@@ -35,6 +42,32 @@
 #define NOVEMBER        "November"
 #define DECEMBER        "December"
 
+#define NUMBER_OF_SCREENS   3
+
+/* State a screen depends on, it is only rendered again when that state changes */
+#define DEPENDS_ON_SECOND       0x01
+#define DEPENDS_ON_MINUTE       0x02
+#define DEPENDS_ON_INTENSITY    0x04
+#define DEPENDS_ON_INVERTED     0x08
+#define DEPENDS_ON_POWER        0x10
+
+#define NO_DEADLINE         0xFFFFFFFF                                      //Nothing to update until the state changes
+
+/* Transitions between screens, see setTransition() */
+#define TRANSITION_NONE         0
+#define TRANSITION_SLIDE        1                                           //The new screen pushes the old one out
+#define TRANSITION_WIPE         2                                           //An edge moves over the old screen
+#define TRANSITION_DISSOLVE     3                                           //Ordered dither from the old to the new screen
+#define TRANSITION_FRAMES       16                                          //Default number of frames
+#define TRANSITION_FRAME_TIME   20                                          //Default time per frame in ms, 50 frames per second
+
+/* Commands for post(), update() applies them between frames */
+#define COMMAND_POWER       0
+#define COMMAND_INTENSITY   1
+#define COMMAND_INVERTED    2
+#define COMMAND_SCREEN      3
+#define COMMAND_ROTATION    4
+
 struct Time {
     uint8_t hour;
     uint8_t minute;
@@ -48,23 +81,34 @@ struct Date {
 };
 
 struct LongDate {
-    String dayName;
+    uint8_t dayOfWeek;                                                      //0 is Monday
     uint8_t day;
-    uint8_t month;
+    uint8_t month;                                                          //0 is January
 };
 
 class SmartLedDisplay {
 	public:
-        SmartLedDisplay(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType = ZIGZAG_WIRING);
+        SmartLedDisplay(uint8_t numSegmentsHorizontal, uint8_t numSegmentsVertical, uint8_t csPin, uint8_t wiringType = ZIGZAG_WIRING, uint8_t* buffer = nullptr);
+        ~SmartLedDisplay();
+        SmartLedDisplay(const SmartLedDisplay&) = delete;
+        SmartLedDisplay& operator=(const SmartLedDisplay&) = delete;
 
         /* Config functions */
         void setPower(bool on);
         void setIntensity(uint8_t level);
         void setRotation(uint8_t rotation);
         void setInverted(bool inverted);
-        void setTime(Time time);
+        void setTime(Time time, uint16_t millis = 0);
+        void setScreen(uint8_t screen);
+        void setScreenDependencies(uint8_t screen, uint8_t dependencies);
+        bool setTransition(uint8_t type, uint8_t direction = SHIFT_LEFT, uint8_t frames = TRANSITION_FRAMES, uint16_t frameTime = TRANSITION_FRAME_TIME);
+        void setClockSource(unsigned long (*clock)());
+        void setTransport(MAX7219Transport* transport);
+        bool post(uint8_t type, uint32_t value);
 
         /* Draw functions*/
+        void beginMarquee(Marquee& marquee, uint8_t x, uint8_t y, uint8_t width, uint16_t stepDelay = 100);
+        bool beginAnimation(Animation& animation, AnimationReader* reader);
         void showScrollingString(uint8_t x, uint8_t y, uint8_t width, char string[], uint8_t length, uint8_t value, uint8_t scrollDelay = 100); //direction add to display class
 
         void printDigitalTime(uint8_t x, uint8_t y, uint8_t value);
@@ -73,7 +117,8 @@ class SmartLedDisplay {
         void printShortDate(uint8_t x, uint8_t y, Date date, uint8_t value);
         void printLongDate(uint8_t x, uint8_t y, LongDate date, uint8_t value);
 
-        void drawBitmap();
+        void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], uint16_t w, uint16_t h, uint8_t rasterOp = RASTER_OP_COPY, const uint8_t mask[] = nullptr);
+        void drawSprite(int16_t x, int16_t y, SpriteSheet& sheet, uint16_t index, uint8_t rasterOp = RASTER_OP_COPY);
 
         /* Screens */
         void showScreen1();
@@ -81,24 +126,64 @@ class SmartLedDisplay {
         void showScreen3();
 
         /* Getters */
-        uint8_t getWidth();
-        uint8_t getHeight();
+        uint16_t getWidth();
+        uint16_t getHeight();
         bool getPower();
         uint8_t getIntensity();
         bool getInverted();
         Time getTime();
+        uint8_t getScreen();
+        uint32_t getTimeToUpdate();
+        uint32_t getNumRenders();
+        bool isTransitioning();
         
         /* Display and clear functions */
         void display();
         void clear();
+        bool update();
 		
 	private:
+        void _applyCommands();
+        void _drawClockHands(uint8_t x, uint8_t y, uint8_t r, uint8_t value);
+        void _renderScreen();
+        void _startTransition();
+        bool _stepTransition();
+        uint32_t _secondsOfDay();
+        uint32_t _timeKey(uint8_t dependencies);
+
         Time _time;
-        String _months[12];
+        uint32_t _timeBase;                                                 //Seconds since midnight at setTime()
+        uint32_t _timeSetAt;                                                //Clock at setTime() in ms
+        unsigned long (*_clock)();                                          //Time source in ms, millis() by default
+
+        uint8_t _screen;
+        uint8_t _dependencies[NUMBER_OF_SCREENS];
+        uint8_t _changed;                                                   //DEPENDS_ON_ flags of state changed since update()
+        bool _screenChanged;
+        bool _screenSwitched;                                               //Another screen is shown, with a transition if set
+        CommandQueue _commands;                                             //From other tasks, applied by update()
+        uint32_t _renderedKey;                                              //Time key of the rendered screen
+        uint32_t _numRenders;
         Date _date;
         LongDate _longDate;
+        uint8_t _dateX;
+        uint8_t _dateY;
+        Marquee _dateMarquee;
+        DigitalClock _digitalClock;                                         //Of screen 1, keeps its digits in LAYER_OVERLAY
         
         MAX7219CWGMatrix _matrix;
+        Compositor _compositor;                                             //Static background, dynamic content
+        bool _offscreen;                                                    //True: display() does not send, the screen is rendered for a transition
+
+        /* Transitions: the old screen stays in the display buffer and is changed into _transitionFrame a step per frame */
+        uint8_t _transitionType;
+        uint8_t _transitionDirection;
+        uint8_t _transitionFrames;
+        uint16_t _transitionFrameTime;
+        uint8_t _transitionStep;                                            //Frames done, _transitionFrames if none is running
+        uint32_t _transitionStepAt;                                         //Clock at the last step in ms
+        uint8_t _transitionSeed;
+        uint8_t* _transitionFrame;                                          //The new screen
 };
 
 #endif /* SMART_LED_DISPLAY_H */
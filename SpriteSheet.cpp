@@ -0,0 +1,143 @@
+/*
+ * File:      SpriteSheet.cpp
+ * Authors:   Luke de Munk
+ * Class:     SpriteSheet
+ *
+ * Many 1 bit per pixel sprites in one blob. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "SpriteSheet.h"
+
+/**************************************************************************/
+/*!
+  @brief    Constructor without initialisation.
+*/
+/**************************************************************************/
+SpriteSheet::SpriteSheet() {
+    _sheet = nullptr;
+    _numSprites = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sets the blob with the sprites.
+  @param    sheet           Sprite sheet, may be in flash
+  @returns  True if the sheet is valid
+*/
+/**************************************************************************/
+bool SpriteSheet::begin(const uint8_t sheet[]) {
+    _sheet = nullptr;
+    _numSprites = 0;
+
+    if (pgm_read_byte(sheet) != SPRITE_SHEET_MAGIC || pgm_read_byte(sheet + 1) != SPRITE_SHEET_MAGIC) {
+        debugln("ERROR: Not a sprite sheet.");
+        return false;
+    }
+
+    _sheet = sheet;
+    _numSprites = pgm_read_byte(sheet + 2) | pgm_read_byte(sheet + 3) << 8;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a sprite, with its mask if it has one.
+  @param    matrix          Matrix to draw on
+  @param    x               X coordinate of the leftmost column
+  @param    y               Y coordinate of row 0
+  @param    index           Sprite
+  @param    rasterOp        RASTER_OP_COPY, _OR, _AND, _XOR or _MASK
+*/
+/**************************************************************************/
+void SpriteSheet::draw(MAX7219CWGMatrix* matrix, int16_t x, int16_t y, uint16_t index, uint8_t rasterOp) {
+    const uint8_t* sprite = _sprite(index);
+
+    if (sprite == nullptr) {
+        return;
+    }
+    matrix->drawBitmap(x, y, getBitmap(index), pgm_read_byte(sprite), pgm_read_byte(sprite + 1), rasterOp, getMask(index));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of sprites.
+  @returns  _numSprites     Number of sprites
+*/
+/**************************************************************************/
+uint16_t SpriteSheet::getNumSprites() {
+    return _numSprites;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width of a sprite.
+  @param    index           Sprite
+  @returns  Width in pixels, 0 if it does not exist
+*/
+/**************************************************************************/
+uint8_t SpriteSheet::getWidth(uint16_t index) {
+    const uint8_t* sprite = _sprite(index);
+    return sprite != nullptr ? pgm_read_byte(sprite) : 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the height of a sprite.
+  @param    index           Sprite
+  @returns  Height in pixels, 0 if it does not exist
+*/
+/**************************************************************************/
+uint8_t SpriteSheet::getHeight(uint16_t index) {
+    const uint8_t* sprite = _sprite(index);
+    return sprite != nullptr ? pgm_read_byte(sprite + 1) : 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the rows of a sprite.
+  @param    index           Sprite
+  @returns  Packed rows, nullptr if it does not exist
+*/
+/**************************************************************************/
+const uint8_t* SpriteSheet::getBitmap(uint16_t index) {
+    const uint8_t* sprite = _sprite(index);
+    return sprite != nullptr ? sprite + SPRITE_HEADER : nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the mask rows of a sprite.
+  @param    index           Sprite
+  @returns  Packed rows, nullptr if it has no mask
+*/
+/**************************************************************************/
+const uint8_t* SpriteSheet::getMask(uint16_t index) {
+    const uint8_t* sprite = _sprite(index);
+
+    if (sprite == nullptr || !(pgm_read_byte(sprite + 2) & SPRITE_HAS_MASK)) {
+        return nullptr;
+    }
+    return sprite + SPRITE_HEADER + ((pgm_read_byte(sprite) + 7) / 8) * pgm_read_byte(sprite + 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Looks a sprite up in the offset table.
+  @param    index           Sprite
+  @returns  Start of the sprite, nullptr if it does not exist
+*/
+/**************************************************************************/
+const uint8_t* SpriteSheet::_sprite(uint16_t index) {
+    if (_sheet == nullptr || index >= _numSprites) {
+        debugln("ERROR: Sprite does not exist.");
+        return nullptr;
+    }
+
+    const uint8_t* entry = _sheet + SPRITE_SHEET_HEADER + 4*index;
+    uint32_t offset = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        offset |= (uint32_t) pgm_read_byte(entry + i) << (8*i);
+    }
+    return _sheet + offset;
+}
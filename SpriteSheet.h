@@ -0,0 +1,58 @@
+/*
+ * File:      SpriteSheet.h
+ * Authors:   Luke de Munk
+ * Class:     SpriteSheet
+ *
+ * Many 1 bit per pixel sprites in one blob, for example in flash, found
+ * through an offset table. Layout, multi-byte values little endian:
+ *
+ *   0  'S' 'S'                         magic
+ *   2  uint16 count                    number of sprites
+ *   4  uint32 offset[count]            start of every sprite in the blob
+ *
+ * Every sprite:
+ *   0  uint8 width, uint8 height
+ *   2  uint8 flags                     SPRITE_HAS_MASK
+ *   3  uint8 reserved
+ *   4  rows                            ceil(width/8) bytes per row, like
+ *                                      MAX7219CWGMatrix::drawBitmap()
+ *      mask rows                       only with SPRITE_HAS_MASK
+ *
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef SPRITE_SHEET_H
+#define SPRITE_SHEET_H
+#include "MAX7219CWGMatrix.h"
+#include "Debugger.h"                                                       //For serial debugging
+
+#define SPRITE_SHEET_MAGIC      'S'
+#define SPRITE_SHEET_HEADER     4                                           //Bytes before the offset table
+#define SPRITE_HEADER           4                                           //Bytes before the rows of a sprite
+
+#define SPRITE_HAS_MASK         0x01                                        //Flag, mask rows follow the rows
+
+class SpriteSheet {
+	public:
+        SpriteSheet();
+
+        bool begin(const uint8_t sheet[]);
+
+        /* Draw functions */
+        void draw(MAX7219CWGMatrix* matrix, int16_t x, int16_t y, uint16_t index, uint8_t rasterOp = RASTER_OP_COPY);
+
+        /* Getters */
+        uint16_t getNumSprites();
+        uint8_t getWidth(uint16_t index);
+        uint8_t getHeight(uint16_t index);
+        const uint8_t* getBitmap(uint16_t index);
+        const uint8_t* getMask(uint16_t index);
+
+	private:
+        const uint8_t* _sprite(uint16_t index);
+
+        const uint8_t* _sheet;
+        uint16_t _numSprites;
+};
+
+#endif /* SPRITE_SHEET_H */
@@ -0,0 +1,166 @@
+/*
+ * File:      TextFormat.cpp
+ * Authors:   Luke de Munk
+ * Class:     TextFormat
+ *
+ * Formats times, dates and numbers without sprintf, String or the heap.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "TextFormat.h"
+
+/**************************************************************************/
+/*!
+  @brief    Writes a number as two digits, with a leading zero. Only the
+            last two digits of larger numbers are written.
+  @param    buffer          Buffer of at least 2 characters
+  @param    value           Number
+  @returns  Length, always 2
+*/
+/**************************************************************************/
+uint8_t TextFormat::twoDigits(char* buffer, uint8_t value) {
+    value %= 100;
+    buffer[0] = '0' + value/10;                                             //Division by a constant is a multiply
+    buffer[1] = '0' + value%10;
+    return 2;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a number without leading zeros.
+  @param    buffer          Buffer of at least NUMBER_LENGTH characters
+  @param    value           Number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t TextFormat::number(char* buffer, uint16_t value) {
+    char digits[NUMBER_LENGTH];
+    uint8_t length = 0;
+
+    /* Least significant digit first, then reversed into the buffer */
+    do {
+        digits[length++] = '0' + value%10;
+        value /= 10;
+    } while (value != 0);
+
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = digits[length-1 - i];
+    }
+    return length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the name of a day out of flash.
+  @param    buffer          Buffer of at least LONGEST_DAY_NAME characters
+  @param    dayOfWeek       Day, 0 is Monday
+  @returns  Length, 0 if the day does not exist
+*/
+/**************************************************************************/
+uint8_t TextFormat::dayName(char* buffer, uint8_t dayOfWeek) {
+    if (dayOfWeek >= NUMBER_OF_DAYS) {
+        debugln("ERROR: Day of the week out of range.");
+        return 0;
+    }
+    return _copyName(buffer, DayNames[dayOfWeek], pgm_read_byte(DayNameLengths + dayOfWeek));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies the name of a month out of flash.
+  @param    buffer          Buffer of at least LONGEST_MONTH_NAME characters
+  @param    month           Month, 0 is January
+  @returns  Length, 0 if the month does not exist
+*/
+/**************************************************************************/
+uint8_t TextFormat::monthName(char* buffer, uint8_t month) {
+    if (month >= NUMBER_OF_MONTHS) {
+        debugln("ERROR: Month out of range.");
+        return 0;
+    }
+    return _copyName(buffer, MonthNames[month], pgm_read_byte(MonthNameLengths + month));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a time in notation HH:MM or HH:MM:SS.
+  @param    buffer          Buffer of at least TIME_SECONDS_LENGTH
+                            characters
+  @param    hour            Hour
+  @param    minute          Minute
+  @param    second          Second, 255 to leave it out
+  @returns  Length, TIME_LENGTH or TIME_SECONDS_LENGTH
+*/
+/**************************************************************************/
+uint8_t TextFormat::time(char* buffer, uint8_t hour, uint8_t minute, uint8_t second) {
+    twoDigits(buffer, hour);
+    buffer[2] = ':';
+    twoDigits(buffer + 3, minute);
+
+    if (second == 255) {
+        return TIME_LENGTH;
+    }
+
+    buffer[5] = ':';
+    twoDigits(buffer + 6, second);
+    return TIME_SECONDS_LENGTH;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a date in notation DD-MM-YY.
+  @param    buffer          Buffer of at least SHORT_DATE_LENGTH characters
+  @param    day             Day of the month
+  @param    month           Month
+  @param    year            Year, last two digits
+  @returns  Length, SHORT_DATE_LENGTH
+*/
+/**************************************************************************/
+uint8_t TextFormat::shortDate(char* buffer, uint8_t day, uint8_t month, uint8_t year) {
+    twoDigits(buffer, day);
+    buffer[2] = '-';
+    twoDigits(buffer + 3, month);
+    buffer[5] = '-';
+    twoDigits(buffer + 6, year);
+    return SHORT_DATE_LENGTH;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a date in notation [day] [date] [month].
+  @param    buffer          Buffer of at least LONG_DATE_LENGTH characters
+  @param    dayOfWeek       Day, 0 is Monday
+  @param    day             Day of the month
+  @param    month           Month, 0 is January
+  @returns  Length, 0 if the day or month does not exist
+*/
+/**************************************************************************/
+uint8_t TextFormat::longDate(char* buffer, uint8_t dayOfWeek, uint8_t day, uint8_t month) {
+    if (dayOfWeek >= NUMBER_OF_DAYS || month >= NUMBER_OF_MONTHS) {
+        debugln("ERROR: Date out of range.");
+        return 0;
+    }
+
+    uint8_t length = dayName(buffer, dayOfWeek);
+    buffer[length++] = ' ';
+    length += number(buffer + length, day);
+    buffer[length++] = ' ';
+    length += monthName(buffer + length, month);
+    return length;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Copies a name out of flash.
+  @param    buffer          Buffer of at least length characters
+  @param    name            Name in flash
+  @param    length          Length of the name
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t TextFormat::_copyName(char* buffer, const char name[], uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[i] = pgm_read_byte(name + i);
+    }
+    return length;
+}
@@ -0,0 +1,78 @@
+/*
+ * File:      TextFormat.h
+ * Authors:   Luke de Munk
+ * Class:     TextFormat
+ *
+ * Formats times, dates and numbers into a caller's char buffer without
+ * sprintf, String or the heap. Day and month names are tables in flash,
+ * their lengths are computed by the compiler. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+#include "MAX7219CWGMatrix.h"                                               //For the day and month names
+#include "Debugger.h"                                                       //For serial debugging
+
+#define NUMBER_OF_DAYS          7
+#define NUMBER_OF_MONTHS        12
+#define NAME_SIZE               10                                          //Longest name plus terminator
+
+#define TIME_LENGTH             5                                           //HH:MM
+#define TIME_SECONDS_LENGTH     8                                           //HH:MM:SS
+#define SHORT_DATE_LENGTH       8                                           //DD-MM-YY
+#define NUMBER_LENGTH           5                                           //Digits of the largest uint16_t
+
+/* Length of a string literal, evaluated by the compiler */
+constexpr uint8_t textLength(const char text[]) {
+    return *text == '\0' ? 0 : 1 + textLength(text + 1);
+}
+
+/* Longest of the first n lengths of a table, evaluated by the compiler */
+constexpr uint8_t longestName(const uint8_t lengths[], uint8_t n, uint8_t longest = 0) {
+    return n == 0 ? longest : longestName(lengths, n-1, lengths[n-1] > longest ? lengths[n-1] : longest);
+}
+
+/* DayNames[0] is Monday */
+constexpr char DayNames[NUMBER_OF_DAYS][NAME_SIZE] PROGMEM = {
+    MONDAY, TUESDAY, WEDNESDAY, THURSDAY, FRIDAY, SATURDAY, SUNDAY
+};
+
+constexpr uint8_t DayNameLengths[NUMBER_OF_DAYS] PROGMEM = {
+    textLength(MONDAY), textLength(TUESDAY), textLength(WEDNESDAY), textLength(THURSDAY),
+    textLength(FRIDAY), textLength(SATURDAY), textLength(SUNDAY)
+};
+
+/* MonthNames[0] is January */
+constexpr char MonthNames[NUMBER_OF_MONTHS][NAME_SIZE] PROGMEM = {
+    JANUARY, FEBRUARY, MARCH, APRIL, MAY, JUNE,
+    JULY, AUGUST, SEPTEMBER, OCTOBER, NOVEMBER, DECEMBER
+};
+
+constexpr uint8_t MonthNameLengths[NUMBER_OF_MONTHS] PROGMEM = {
+    textLength(JANUARY), textLength(FEBRUARY), textLength(MARCH), textLength(APRIL),
+    textLength(MAY), textLength(JUNE), textLength(JULY), textLength(AUGUST),
+    textLength(SEPTEMBER), textLength(OCTOBER), textLength(NOVEMBER), textLength(DECEMBER)
+};
+
+constexpr uint8_t LONGEST_DAY_NAME = longestName(DayNameLengths, NUMBER_OF_DAYS);
+constexpr uint8_t LONGEST_MONTH_NAME = longestName(MonthNameLengths, NUMBER_OF_MONTHS);
+
+/* [day] [date] [month], for example "Wednesday 17 September", the date has up to 3 digits */
+constexpr uint8_t LONG_DATE_LENGTH = LONGEST_DAY_NAME + 1 + 3 + 1 + LONGEST_MONTH_NAME;
+
+class TextFormat {
+	public:
+        static uint8_t twoDigits(char* buffer, uint8_t value);
+        static uint8_t number(char* buffer, uint16_t value);
+        static uint8_t dayName(char* buffer, uint8_t dayOfWeek);
+        static uint8_t monthName(char* buffer, uint8_t month);
+
+        static uint8_t time(char* buffer, uint8_t hour, uint8_t minute, uint8_t second = 255);
+        static uint8_t shortDate(char* buffer, uint8_t day, uint8_t month, uint8_t year);
+        static uint8_t longDate(char* buffer, uint8_t dayOfWeek, uint8_t day, uint8_t month);
+
+	private:
+        static uint8_t _copyName(char* buffer, const char name[], uint8_t length);
+};
+
+#endif /* TEXT_FORMAT_H */
@@ -0,0 +1,219 @@
+/*
+ * File:      Animation_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Check and benchmark of the Animation class. Runs on Linux: a clip is
+ * drawn with the matrix, encoded with the AnimationEncoder and written to
+ * a file, then decoded from that file through the read window. Every
+ * decoded frame is compared with the drawn one. Prints the size of the
+ * clip, the frames per second of decoding and the bytes read per frame.
+ * No display has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <stdio.h>
+#include "Animation.h"
+
+#define CS_PIN          14
+#define WIDTH           8                                                   //8 segments horizontal
+#define HEIGHT          4                                                   //4 segments vertical
+#define FRAMES          600                                                 //Frames in the clip
+#define SCENE_LENGTH    200                                                 //Frames until the background inverts
+#define FRAME_DURATION  40                                                  //Time per frame in ms (25 fps)
+#define REPEATS         20                                                  //Times the clip is decoded for timing
+#define ANIMATION_PATH  "/tmp/animation.anm"
+
+/* Animation file read with stdio */
+class StdioReader : public AnimationReader {
+	public:
+        ~StdioReader() {
+            if (_file != nullptr) {
+                fclose(_file);
+            }
+        }
+
+        bool open(const char path[]) {
+            _file = fopen(path, "rb");
+            return _file != nullptr;
+        }
+
+        uint16_t read(uint8_t* buffer, uint16_t length) {
+            return fread(buffer, 1, length, _file);
+        }
+
+        bool seek(uint32_t position) {
+            return fseek(_file, position, SEEK_SET) == 0;
+        }
+
+	private:
+        FILE* _file = nullptr;
+};
+
+MAX7219CWGMatrix renderer(WIDTH, HEIGHT, CS_PIN);                           //Draws the expected frames
+MAX7219CWGMatrix player(WIDTH, HEIGHT, CS_PIN);                             //Plays the file
+MAX7219RecordingTransport recorder;
+uint8_t frame[WIDTH*HEIGHT*ROW_SIZE];
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the check and benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    renderer.setTransport(&recorder);
+    player.setTransport(&recorder);
+    renderer.setDrawBuffer(frame);
+
+    uint32_t fileSize = encodeClip();
+    if (fileSize == 0) {
+        return;
+    }
+
+    Serial.println("Animation encoding");
+    Serial.print("frames: ");
+    Serial.print(FRAMES);
+    Serial.print(", raw bytes/frame: ");
+    Serial.print(renderer.getFrameSize());
+    Serial.print(", encoded bytes/frame: ");
+    Serial.println((float) (fileSize - ANIMATION_HEADER) / FRAMES);
+
+    checkClip();
+    benchmarkClip();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a frame of the clip: a clock hand, a bouncing ball and a
+            background that inverts every scene.
+  @param    i               Frame number
+*/
+/**************************************************************************/
+void drawFrame(uint16_t i) {
+    uint8_t background = (i / SCENE_LENGTH) & 1;
+    uint8_t value = !background;
+    uint16_t ballX = i % 48;
+    uint16_t ballY = i % 40;
+
+    /* Bounce off the edges */
+    if (ballX >= 24) {
+        ballX = 48 - ballX;
+    }
+    if (ballY >= 20) {
+        ballY = 40 - ballY;
+    }
+
+    renderer.drawFillRectangle(0, 0, renderer.getWidth(), renderer.getHeight(), background);
+    renderer.drawCircle(15, 15, 14, value);
+    renderer.drawLineFineAngle(15, 15, 13, (uint32_t) i*FULL_ANGLE/120 % FULL_ANGLE, value);
+    renderer.drawFillCircle(36 + ballX, 5 + ballY, 3, value);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws and encodes the clip, and writes it to ANIMATION_PATH.
+  @returns  Size of the file in bytes, 0 on error
+*/
+/**************************************************************************/
+uint32_t encodeClip() {
+    AnimationEncoder encoder;
+    FILE* file = fopen(ANIMATION_PATH, "wb");
+
+    if (file == nullptr || !encoder.begin(WIDTH, HEIGHT)) {
+        Serial.println("Could not create " ANIMATION_PATH);
+        return 0;
+    }
+
+    uint8_t output[WIDTH*HEIGHT*ROW_SIZE + WIDTH*HEIGHT*ROW_SIZE/ANIMATION_MAX_RUN + ANIMATION_FRAME_HEADER + 1];
+    uint32_t fileSize = encoder.encodeHeader(output, FRAMES);
+
+    fwrite(output, 1, fileSize, file);
+
+    for (uint16_t i = 0; i < FRAMES; i++) {
+        drawFrame(i);
+
+        uint16_t length = encoder.encodeFrame(frame, FRAME_DURATION, output);
+        fwrite(output, 1, length, file);
+        fileSize += length;
+    }
+    fclose(file);
+
+    return fileSize;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Plays the clip twice, so it loops once, and counts the pixels
+            that differ from the drawn frames.
+*/
+/**************************************************************************/
+void checkClip() {
+    StdioReader reader;
+    Animation animation;
+    uint32_t mismatches = 0;
+
+    if (!reader.open(ANIMATION_PATH) || !animation.begin(&player, &reader)) {
+        Serial.println("Could not open " ANIMATION_PATH);
+        return;
+    }
+
+    for (uint16_t i = 0; i < 2*FRAMES; i++) {
+        animation.nextFrame();
+        drawFrame(i % FRAMES);
+
+        for (uint16_t x = 0; x < player.getWidth(); x++) {
+            for (uint16_t y = 0; y < player.getHeight(); y++) {
+                if (player.getPixel(x, y) != renderer.getPixel(x, y)) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    Serial.println("Animation check");
+    Serial.print("frames: ");
+    Serial.print(2*FRAMES);
+    Serial.print(", differing pixels: ");
+    Serial.println(mismatches);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Decodes the clip REPEATS times and prints the frames per second
+            and the bytes read from the file per frame.
+*/
+/**************************************************************************/
+void benchmarkClip() {
+    StdioReader reader;
+    Animation animation;
+
+    if (!reader.open(ANIMATION_PATH) || !animation.begin(&player, &reader)) {
+        Serial.println("Could not open " ANIMATION_PATH);
+        return;
+    }
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < (uint32_t) REPEATS*FRAMES; i++) {
+        animation.nextFrame();
+    }
+    uint32_t time = micros() - start;
+
+    Serial.println("Animation benchmark (decoding from a file)");
+    Serial.println("frames\tus/frame\tframes/s\tbytes read/frame");
+    Serial.print(REPEATS*FRAMES);
+    Serial.print("\t");
+    Serial.print((float) time / (REPEATS*FRAMES));
+    Serial.print("\t");
+    Serial.print(1000000.0 * REPEATS*FRAMES / time);
+    Serial.print("\t");
+    Serial.println((float) animation.getBytesRead() / (REPEATS*FRAMES));
+}
@@ -0,0 +1,362 @@
+/*
+ * File:      ClockService_loopback.ino
+ * Authors:   Luke de Munk
+ *
+ * Check of the ClockService against a stand-in time server on the
+ * loopback interface. Runs on Linux: the server is a thread with its own
+ * UDP socket that loses requests and holds replies back, the local clock
+ * is simulated and runs fast. Prints the synchronisation statistics, the
+ * largest error of the interpolated time, the longest update() call and
+ * the number of lookups of the server name. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ClockService.h"
+
+#define DURATION        (6*3600000UL)                                       //Simulated time in ms
+#define SYNC_INTERVAL   600000                                              //Time between synchronisations in ms
+#define LOCAL_DRIFT     150                                                 //Local clock runs fast in ppm
+#define START_TIME      1767225600UL                                        //Unix time at the start
+#define NETWORK_DELAY   20                                                  //Round trip of the network in ms
+#define LOSS_PERCENT    20                                                  //Requests the server drops
+#define SLOW_PERCENT    20                                                  //Replies the server holds back
+#define SLOW_DELAY      1500                                                //Longer than the reply timeout in ms
+
+/* Arduino UDP on a non-blocking loopback socket */
+class LoopbackUDP : public UDP {
+	public:
+        uint8_t begin(uint16_t port) {
+            sockaddr_in address = {};
+
+            _socket = socket(AF_INET, SOCK_DGRAM, 0);
+            fcntl(_socket, F_SETFL, O_NONBLOCK);
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(port);
+            return bind(_socket, (sockaddr*) &address, sizeof(address)) == 0;
+        }
+
+        void stop() {
+            close(_socket);
+        }
+
+        int beginPacket(IPAddress ip, uint16_t port) {
+            _remote = {};
+            _remote.sin_family = AF_INET;
+            _remote.sin_addr.s_addr = htonl(ip[0] << 24 | ip[1] << 16 | ip[2] << 8 | ip[3]);
+            _remote.sin_port = htons(port);
+            _length = 0;
+            return 1;
+        }
+
+        int beginPacket(const char* host, uint16_t port) {
+            in_addr address;
+            inet_aton(host, &address);                                      //Stands in for the DNS lookup
+            _numLookups++;
+            uint32_t ip = ntohl(address.s_addr);
+            return beginPacket(IPAddress(ip >> 24, ip >> 16, ip >> 8, ip), port);
+        }
+
+        int endPacket() {
+            return sendto(_socket, _packet, _length, 0, (sockaddr*) &_remote, sizeof(_remote)) == _length;
+        }
+
+        size_t write(uint8_t data) {
+            return write(&data, 1);
+        }
+
+        size_t write(const uint8_t* buffer, size_t size) {
+            size = min(size, sizeof(_packet) - _length);
+            memcpy(_packet + _length, buffer, size);
+            _length += size;
+            return size;
+        }
+
+        int parsePacket() {
+            socklen_t length = sizeof(_sender);
+            int size = recvfrom(_socket, _packet, sizeof(_packet), 0, (sockaddr*) &_sender, &length);
+            _length = size > 0 ? size : 0;
+            _position = 0;
+            return _length;
+        }
+
+        int available() {
+            return _length - _position;
+        }
+
+        int read() {
+            return _position < _length ? _packet[_position++] : -1;
+        }
+
+        int read(unsigned char* buffer, size_t length) {
+            length = min(length, (size_t) available());
+            memcpy(buffer, _packet + _position, length);
+            _position += length;
+            return length;
+        }
+
+        int read(char* buffer, size_t length) {
+            return read((unsigned char*) buffer, length);
+        }
+
+        int peek() {
+            return _position < _length ? _packet[_position] : -1;
+        }
+
+        void flush() {
+            _position = _length;
+        }
+
+        IPAddress remoteIP() {
+            uint32_t ip = ntohl(_sender.sin_addr.s_addr);
+            return IPAddress(ip >> 24, ip >> 16, ip >> 8, ip);
+        }
+
+        uint16_t remotePort() {
+            return ntohs(_sender.sin_port);
+        }
+
+        uint32_t getNumLookups() {
+            return _numLookups;
+        }
+
+	private:
+        int _socket = -1;
+        sockaddr_in _remote = {};
+        sockaddr_in _sender = {};                                           //Of the last packet read
+        uint32_t _numLookups = 0;                                           //Packets sent to a host name
+        uint8_t _packet[NTP_PACKET_SIZE*2];
+        int _length = 0;
+        int _position = 0;
+};
+
+/* Request held by the stand-in server */
+struct HeldRequest {
+    uint8_t packet[NTP_PACKET_SIZE];
+    sockaddr_in client;
+    uint32_t receivedAt;                                                    //Simulated time in ms
+    uint32_t sendAt;
+};
+
+LoopbackUDP udp;
+ClockService clockService;
+
+int serverSocket;
+uint16_t serverPort;
+std::atomic<uint32_t> simulatedTime{0};
+std::atomic<uint32_t> tick{0};                                              //Set by the main thread per step
+std::atomic<uint32_t> handledTick{0};                                       //Set by the server when done with a step
+std::atomic<bool> running{true};
+uint32_t numDropped = 0;
+uint32_t numHeld = 0;
+uint32_t randomState = 12345;
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the check once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    startServer();
+    std::thread server(runServer);
+
+    clockService.begin(&udp, "127.0.0.1", serverPort, 0);
+    clockService.setSyncInterval(SYNC_INTERVAL);
+
+    uint32_t maxError = 0;
+    uint32_t maxSettledError = 0;                                           //After the first hour, drift corrected
+    uint32_t maxUpdateTime = 0;
+    uint32_t now = 0;
+
+    while (now < DURATION) {
+        uint32_t start = micros();
+        bool synced = clockService.update(now);
+        maxUpdateTime = max(maxUpdateTime, (uint32_t) (micros() - start));
+
+        /* Error just before every synchronisation is the largest */
+        if (clockService.isSynced() && !synced) {
+            int64_t error = (int64_t) clockService.getEpochTime(now)*1000 + clockService.getMillis(now) - trueTime(now);
+            maxError = max(maxError, (uint32_t) llabs(error));
+
+            if (now >= 3600000) {
+                maxSettledError = max(maxSettledError, (uint32_t) llabs(error));
+            }
+        }
+
+        /* Let the server handle this step, then sleep until the deadline */
+        tick++;
+        while (handledTick != tick) {
+            std::this_thread::yield();
+        }
+        now += max(clockService.getTimeToUpdate(now), (uint32_t) 1);
+        simulatedTime = now;
+    }
+
+    running = false;
+    server.join();
+
+    Serial.println("Clock service on a loopback server, 6 simulated hours");
+    Serial.print("syncs: ");
+    Serial.println(clockService.getNumSyncs());
+    Serial.print("timeouts: ");
+    Serial.println(clockService.getNumTimeouts());
+    Serial.print("rejected (late replies): ");
+    Serial.println(clockService.getNumRejected());
+    Serial.print("server dropped / held back: ");
+    Serial.print(numDropped);
+    Serial.print(" / ");
+    Serial.println(numHeld);
+    Serial.print("drift ppm (local runs fast by ");
+    Serial.print(LOCAL_DRIFT);
+    Serial.print("): ");
+    Serial.println(clockService.getDrift());
+    Serial.print("last offset ms: ");
+    Serial.println(clockService.getLastOffset());
+    Serial.print("round trip ms: ");
+    Serial.println(clockService.getRoundTrip());
+    Serial.print("sync age ms: ");
+    Serial.println(clockService.getSyncAge(now));
+    Serial.print("max error ms: ");
+    Serial.print(maxError);
+    Serial.print(", after the first hour: ");
+    Serial.println(maxSettledError);
+    Serial.print("max update() us: ");
+    Serial.println(maxUpdateTime);
+    Serial.print("server name lookups: ");
+    Serial.println(udp.getNumLookups());
+
+    /* Only the first request and the ones after CLOCK_RESOLVE_TIMEOUTS lost replies look the name up */
+    if (udp.getNumLookups() > 1 + clockService.getNumTimeouts()/CLOCK_RESOLVE_TIMEOUTS) {
+        Serial.println("FAILED: the server name was looked up for every request");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the true Unix time in ms. The local clock runs
+            LOCAL_DRIFT ppm fast, so less true time has passed.
+  @param    localMs         Simulated local time in ms
+  @returns  Time in ms since 1970
+*/
+/**************************************************************************/
+int64_t trueTime(uint32_t localMs) {
+    return (int64_t) START_TIME*1000 + localMs - (int64_t) localMs*LOCAL_DRIFT/1000000;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the next number of a fixed pseudo random sequence.
+  @returns  Number (0-99)
+*/
+/**************************************************************************/
+uint8_t randomPercent() {
+    randomState = randomState*1103515245 + 12345;
+    return (randomState >> 16) % 100;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a true time as NTP timestamp into a packet.
+  @param    data            First byte of the timestamp
+  @param    localMs         Simulated local time in ms
+*/
+/**************************************************************************/
+void writeTimestamp(uint8_t* data, uint32_t localMs) {
+    int64_t ms = trueTime(localMs);
+    uint32_t seconds = ms/1000 + NTP_UNIX_OFFSET;
+    uint32_t fraction = ((uint64_t) (ms % 1000) << 32) / 1000;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i] = seconds >> (24 - 8*i);
+        data[4+i] = fraction >> (24 - 8*i);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Opens the socket of the stand-in server on a free port.
+*/
+/**************************************************************************/
+void startServer() {
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+
+    serverSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    fcntl(serverSocket, F_SETFL, O_NONBLOCK);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(serverSocket, (sockaddr*) &address, sizeof(address));
+    getsockname(serverSocket, (sockaddr*) &address, &length);
+    serverPort = ntohs(address.sin_port);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Stand-in time server. Every step it takes the requests in,
+            drops some, and sends the replies that are due. Half the
+            network delay is before the request is stamped, half after.
+*/
+/**************************************************************************/
+void runServer() {
+    std::vector<HeldRequest> held;
+
+    while (running) {
+        uint32_t step = tick;
+        if (step == handledTick) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t now = simulatedTime;
+        HeldRequest request;
+        socklen_t length = sizeof(request.client);
+
+        while (recvfrom(serverSocket, request.packet, NTP_PACKET_SIZE, 0, (sockaddr*) &request.client, &length) == NTP_PACKET_SIZE) {
+            if (randomPercent() < LOSS_PERCENT) {
+                numDropped++;
+                continue;
+            }
+            request.receivedAt = now + NETWORK_DELAY/2;
+            request.sendAt = request.receivedAt;
+
+            if (randomPercent() < SLOW_PERCENT) {
+                request.sendAt += SLOW_DELAY;
+                numHeld++;
+            }
+            held.push_back(request);
+        }
+
+        for (size_t i = 0; i < held.size(); ) {
+            if (now < held[i].sendAt + NETWORK_DELAY/2) {
+                i++;
+                continue;
+            }
+            uint8_t reply[NTP_PACKET_SIZE] = {};
+
+            reply[0] = 0x1C;                                                //No leap warning, version 3, server
+            reply[1] = 2;                                                   //Stratum
+            memcpy(reply + 24, held[i].packet + 40, 8);                     //Originate: transmit of the request
+            writeTimestamp(reply + 32, held[i].receivedAt);
+            writeTimestamp(reply + 40, held[i].sendAt);
+            sendto(serverSocket, reply, NTP_PACKET_SIZE, 0, (sockaddr*) &held[i].client, sizeof(held[i].client));
+            held.erase(held.begin() + i);
+        }
+        handledTick = step;
+    }
+}
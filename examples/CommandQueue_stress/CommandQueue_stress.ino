@@ -0,0 +1,215 @@
+/*
+ * File:      CommandQueue_stress.ino
+ * Authors:   Luke de Munk
+ *
+ * Stress test of the CommandQueue. Runs on Linux: producer threads push
+ * numbered commands as fast as they can, retrying when the queue is full,
+ * while this thread takes them out. Checks that no command is lost,
+ * doubled or reordered per producer, and prints the time from push to
+ * pop. Then a producer thread posts commands to a SmartLedDisplay while
+ * this thread runs update(), like the web server and the render loop,
+ * and checks the display ends in the last posted state. For more info,
+ * checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <atomic>
+#include <thread>
+#include "SmartLedDisplay.h"
+
+#define CS_PIN          14
+#define WIDTH           4                                                   //4 segments horizontal
+#define HEIGHT          3                                                   //3 segments vertical
+#define MAX_PRODUCERS   4
+#define COMMANDS        100000                                              //Commands per producer
+#define DISPLAY_COMMANDS 10000                                              //Commands posted to the display
+#define LATENCY_BUCKETS 1000                                                //Latency histogram, 1 us per bucket
+
+SmartLedDisplay display(WIDTH, HEIGHT, CS_PIN);
+MAX7219RecordingTransport recorder;
+
+CommandQueue queue;
+uint32_t pushedAt[MAX_PRODUCERS][COMMANDS];                                 //Written before the push publishes it
+uint32_t latencies[LATENCY_BUCKETS + 1];                                    //Last bucket: longer
+std::atomic<uint32_t> retries{0};
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the tests once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    Serial.println("Command queue stress test");
+    Serial.println("producers\tcommands\tlost\tunordered\tfull\tMcommands/s\tavg us\tp99 us\tmax us");
+
+    for (uint8_t producers = 1; producers <= MAX_PRODUCERS; producers *= 2) {
+        stressQueue(producers);
+    }
+
+    checkDisplay();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Pushes COMMANDS numbered commands, the type is the producer.
+  @param    producer        Number of the producer
+*/
+/**************************************************************************/
+void produce(uint8_t producer) {
+    DisplayCommand command;
+    command.type = producer;
+
+    for (uint32_t i = 0; i < COMMANDS; i++) {
+        command.value = i;
+        pushedAt[producer][i] = micros();
+
+        while (!queue.push(command)) {
+            retries++;
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Runs producers against this thread as the consumer and prints
+            one line of results.
+  @param    numProducers    Number of producer threads
+*/
+/**************************************************************************/
+void stressQueue(uint8_t numProducers) {
+    std::thread producers[MAX_PRODUCERS];
+    uint32_t expected[MAX_PRODUCERS] = {0};
+    uint32_t total = (uint32_t) numProducers*COMMANDS;
+    uint32_t received = 0;
+    uint32_t unordered = 0;
+    uint32_t maxLatency = 0;
+    uint64_t sumLatency = 0;
+
+    memset(latencies, 0, sizeof(latencies));
+    retries = 0;
+
+    uint32_t start = micros();
+    for (uint8_t p = 0; p < numProducers; p++) {
+        producers[p] = std::thread(produce, p);
+    }
+
+    /* Stop when everything arrived, or when nothing arrives for a second */
+    uint32_t lastReceived = micros();
+    while (received < total && micros() - lastReceived < 1000000) {
+        DisplayCommand command;
+
+        if (!queue.pop(command)) {
+            std::this_thread::yield();                                      //Lets producers run on a single core
+            continue;
+        }
+
+        uint32_t latency = micros() - pushedAt[command.type][command.value];
+
+        if (command.value != expected[command.type]) {
+            unordered++;
+        }
+        expected[command.type] = command.value + 1;
+        received++;
+        lastReceived = micros();
+
+        sumLatency += latency;
+        latencies[latency < LATENCY_BUCKETS ? latency : LATENCY_BUCKETS]++;
+        if (latency > maxLatency) {
+            maxLatency = latency;
+        }
+    }
+    uint32_t time = micros() - start;
+
+    for (uint8_t p = 0; p < numProducers; p++) {
+        producers[p].join();
+    }
+
+    /* 99th percentile from the histogram */
+    uint32_t p99 = 0;
+    uint32_t count = 0;
+    while (p99 < LATENCY_BUCKETS && count + latencies[p99] < received - received/100) {
+        count += latencies[p99];
+        p99++;
+    }
+
+    Serial.print(numProducers);
+    Serial.print("\t");
+    Serial.print(total);
+    Serial.print("\t");
+    Serial.print(total - received);
+    Serial.print("\t");
+    Serial.print(unordered);
+    Serial.print("\t");
+    Serial.print((uint32_t) retries);
+    Serial.print("\t");
+    Serial.print((float) received / time);
+    Serial.print("\t");
+    Serial.print(received != 0 ? (float) sumLatency / received : 0);
+    Serial.print("\t");
+    Serial.print(p99);
+    Serial.print("\t");
+    Serial.println(maxLatency);
+
+    if (total != received || unordered != 0 || !queue.isEmpty()) {
+        Serial.println("FAILED: commands lost, doubled or out of order");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Posts intensity and invert commands from another thread while
+            this thread runs update(), and checks the last ones won.
+*/
+/**************************************************************************/
+void checkDisplay() {
+    std::atomic<bool> done{false};
+
+    display.setTransport(&recorder);
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < DISPLAY_COMMANDS; i++) {
+            while (!display.post(i & 1 ? COMMAND_INVERTED : COMMAND_INTENSITY, i % (MAX_INTENSITY + 1))) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    uint32_t updates = 0;
+    while (!done) {
+        display.update();
+        updates++;
+        std::this_thread::yield();
+    }
+    producer.join();
+    display.update();                                                       //Apply the rest
+
+    /* Last intensity is from an even i, last invert from an odd one */
+    uint8_t lastIntensity = (DISPLAY_COMMANDS - 2) % (MAX_INTENSITY + 1);
+    bool lastInverted = (DISPLAY_COMMANDS - 1) % (MAX_INTENSITY + 1);
+
+    Serial.println("Display commands");
+    Serial.print("commands: ");
+    Serial.print(DISPLAY_COMMANDS);
+    Serial.print(", updates: ");
+    Serial.print(updates);
+    Serial.print(", intensity: ");
+    Serial.print(display.getIntensity());
+    Serial.print(", inverted: ");
+    Serial.println(display.getInverted());
+
+    if (display.getIntensity() != lastIntensity || display.getInverted() != lastInverted) {
+        Serial.println("FAILED: display not in the last posted state");
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ * File:      DigitalClock_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Check and benchmark of the DigitalClock class. Runs on Linux: a day is
+ * simulated a second at a time, the time is drawn the way printDigitalTime()
+ * did (the region cleared and the whole string drawn) and with the clock
+ * that only redraws changed digits, in the font and as seven-segment
+ * numerals of the panel height. The draw calls are recorded in a display
+ * list to count the pixels they write, every frame is compared with the
+ * full redraw. Prints the pixel writes, cells and bus words per second
+ * and the time per frame. No display has to be connected. For more info,
+ * checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "DigitalClock.h"
+#include "DisplayList.h"
+
+#define CS_PIN          14
+#define WIDTH           8                                                   //8 segments horizontal
+#define HEIGHT          2                                                   //2 segments vertical
+#define SECONDS_PER_DAY 86400
+#define CLOCK_X         1
+#define CLOCK_Y         0
+#define LIST_SIZE       512                                                 //Bytes per display list
+
+MAX7219CWGMatrix matrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219CWGMatrix reference(WIDTH, HEIGHT, CS_PIN);                          //Redrawn completely every second
+MAX7219RecordingTransport recorder;
+MAX7219RecordingTransport referenceRecorder;
+DigitalClock digitalClock;
+DigitalClock referenceClock;
+DisplayList list;
+
+/**************************************************************************/
+/*!
+  @brief    Setup the matrices and run the check and benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    matrix.setTransport(&recorder);
+    reference.setTransport(&referenceRecorder);
+    list.begin(&matrix, LIST_SIZE);
+
+    Serial.println("Digital clock, one simulated day");
+    Serial.println("mode\t\tpixels/s\tcells/s\twords/s\tus/frame\tdiffering frames");
+    runMode("string\t\t", DIGITAL_CLOCK_FONT, false);
+    runMode("font cells\t", DIGITAL_CLOCK_FONT, true);
+    runMode("segments full\t", DIGITAL_CLOCK_FULL_HEIGHT, false);
+    runMode("segments cells\t", DIGITAL_CLOCK_FULL_HEIGHT, true);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the time of a second of the day. In the font HH:MM:SS is
+            shown, the seven-segment numerals only fit HH:MM.
+  @param    target          Matrix to draw on
+  @param    targetClock     Clock of the matrix
+  @param    height          DIGITAL_CLOCK_FONT or DIGITAL_CLOCK_FULL_HEIGHT
+  @param    incremental     False to draw everything again, in the font as
+                            printDigitalTime() on a cleared region
+  @param    second          Second of the day
+*/
+/**************************************************************************/
+void drawTime(MAX7219CWGMatrix& target, DigitalClock& targetClock, uint8_t height, bool incremental, uint32_t second) {
+    uint8_t hour = second / 3600;
+    uint8_t minute = second / 60 % 60;
+
+    if (height == DIGITAL_CLOCK_FONT && !incremental) {
+        char text[TIME_SECONDS_LENGTH];
+        uint8_t length = TextFormat::time(text, hour, minute, second % 60);
+
+        target.drawFillRectangle(CLOCK_X, CLOCK_Y, length*(target.getFontCols() + 1), target.getFontRows(), 0);
+        target.drawString(CLOCK_X, CLOCK_Y, text, length, 1);
+        return;
+    }
+
+    if (!incremental) {
+        targetClock.invalidate();
+    }
+    targetClock.draw(hour, minute, height == DIGITAL_CLOCK_FONT ? second % 60 : 255);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Counts the pixels the draw calls in the list cover.
+  @returns  Number of pixels
+*/
+/**************************************************************************/
+uint32_t countPixelWrites() {
+    static uint8_t buffer[LIST_SIZE + DISPLAY_LIST_HEADER];
+    uint32_t length = list.serialise(buffer, sizeof(buffer));
+    uint32_t pixels = 0;
+    uint16_t glyph = matrix.getFontCols()*matrix.getFontRows();
+
+    for (uint32_t offset = DISPLAY_LIST_HEADER; offset < length; offset += buffer[offset + 2] | buffer[offset + 3] << 8) {
+        const uint8_t* command = buffer + offset;
+        uint16_t commandLength = command[2] | command[3] << 8;
+
+        switch (command[0]) {
+            case DISPLAY_LIST_FILL_RECTANGLE:
+            case DISPLAY_LIST_BITMAP:
+                pixels += (int16_t) (command[8] | command[9] << 8) * (int16_t) (command[10] | command[11] << 8);
+                break;
+            case DISPLAY_LIST_CHAR:
+                pixels += glyph;
+                break;
+            case DISPLAY_LIST_STRING:
+                pixels += (commandLength - DISPLAY_LIST_COMMAND_HEADER - 4)*glyph;
+                break;
+        }
+    }
+    return pixels;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Compares the matrix with the reference.
+  @returns  True if every pixel is the same
+*/
+/**************************************************************************/
+bool isEqual() {
+    for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+        for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+            if (matrix.getPixel(x, y) != reference.getPixel(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Simulates a day twice: once recorded, to count the pixel writes
+            and compare every frame with a full redraw, and once timed.
+  @param    name            Name to print
+  @param    height          DIGITAL_CLOCK_FONT or DIGITAL_CLOCK_FULL_HEIGHT
+  @param    incremental     True to only redraw changed digits
+*/
+/**************************************************************************/
+void runMode(const char name[], uint8_t height, bool incremental) {
+    uint32_t pixels = 0;
+    uint32_t differing = 0;
+
+    matrix.clear();
+    reference.clear();
+    digitalClock.begin(&matrix, CLOCK_X, CLOCK_Y, height);
+    referenceClock.begin(&reference, CLOCK_X, CLOCK_Y, height);
+    recorder.reset();
+
+    for (uint32_t second = 0; second < SECONDS_PER_DAY; second++) {
+        list.startRecording();
+        drawTime(matrix, digitalClock, height, incremental, second);
+        list.stopRecording();
+        pixels += countPixelWrites();
+        list.replay();
+        matrix.display();
+
+        drawTime(reference, referenceClock, height, false, second);
+        if (!isEqual()) {
+            differing++;
+        }
+    }
+    uint32_t cells = digitalClock.getNumCellsDrawn();
+    if (height == DIGITAL_CLOCK_FONT && !incremental) {
+        cells = (uint32_t) SECONDS_PER_DAY*TIME_SECONDS_LENGTH;             //Every character of the string
+    }
+    uint32_t words = recorder.getWords();
+
+    /* Timed without recording */
+    matrix.clear();
+    digitalClock.begin(&matrix, CLOCK_X, CLOCK_Y, height);
+    uint32_t start = micros();
+    for (uint32_t second = 0; second < SECONDS_PER_DAY; second++) {
+        drawTime(matrix, digitalClock, height, incremental, second);
+        matrix.display();
+    }
+    uint32_t time = micros() - start;
+
+    Serial.print(name);
+    Serial.print((float) pixels / SECONDS_PER_DAY);
+    Serial.print("\t\t");
+    Serial.print((float) cells / SECONDS_PER_DAY);
+    Serial.print("\t");
+    Serial.print((float) words / SECONDS_PER_DAY);
+    Serial.print("\t");
+    Serial.print((float) time / SECONDS_PER_DAY);
+    Serial.print("\t\t");
+    Serial.println(differing);
+
+    if (differing != 0) {
+        Serial.println("FAILED: differs from a full redraw");
+    }
+}
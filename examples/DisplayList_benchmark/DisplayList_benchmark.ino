@@ -0,0 +1,339 @@
+/*
+ * File:      DisplayList_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Check and benchmark of the DisplayList class. Runs on Linux: every
+ * frame of a clip is drawn directly and recorded in a display list. The
+ * lists are written to a capture file, read back, replayed and culled,
+ * and every replayed frame is compared with the drawn one. Prints the
+ * bytes per list, the removed commands and the time per frame of drawing
+ * and replaying.
+ *
+ * Set DISPLAY_LIST_FILE to a capture of a real display (lists saved with
+ * DisplayList::save() one after another) to replay and time that
+ * instead. No display has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "DisplayList.h"
+
+#define CS_PIN          14
+#define WIDTH           8                                                   //8 segments horizontal
+#define HEIGHT          4                                                   //4 segments vertical
+#define FRAMES          300                                                 //Frames in the clip
+#define REPEATS         20                                                  //Times the clip is replayed for timing
+#define LIST_SIZE       2048                                                //Bytes per display list
+#define CAPTURE_PATH    "/tmp/frames.dl"
+#define MAX_CAPTURE     (FRAMES*(LIST_SIZE + DISPLAY_LIST_HEADER))
+
+MAX7219CWGMatrix direct(WIDTH, HEIGHT, CS_PIN);                             //Draws the expected frames
+MAX7219CWGMatrix player(WIDTH, HEIGHT, CS_PIN);                             //Records and replays
+MAX7219RecordingTransport recorder;
+DisplayList list;
+
+uint8_t capture[MAX_CAPTURE];
+uint32_t captureLength = 0;
+
+/* 8x8 sprite of a bell, drawn with a mask */
+const uint8_t bell[] PROGMEM = {0x18, 0x3C, 0x3C, 0x3C, 0x7E, 0xFF, 0x00, 0x18};
+const uint8_t bellMask[] PROGMEM = {0x18, 0x3C, 0x3C, 0x3C, 0x7E, 0xFF, 0xFF, 0x18};
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the check and benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    direct.setTransport(&recorder);
+    player.setTransport(&recorder);
+    list.begin(&player, LIST_SIZE);
+
+    const char* path = getenv("DISPLAY_LIST_FILE");
+    if (path != nullptr) {
+        if (readCapture(path)) {
+            benchmarkCapture(path);
+        }
+        return;
+    }
+
+    if (!captureClip() || !readCapture(CAPTURE_PATH)) {
+        return;
+    }
+    checkCapture();
+    benchmarkCapture(CAPTURE_PATH);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a frame like a clock screen: a face with hands, the date,
+            a notification that slides in over it and text scrolling off
+            the display.
+  @param    matrix          Matrix to draw on
+  @param    i               Frame number
+*/
+/**************************************************************************/
+void drawFrame(MAX7219CWGMatrix& matrix, uint16_t i) {
+    char text[] = "12:34 Monday 17 October";
+    int16_t panelX = 64 - min((int) i % 150, 40);                           //Slides in and stays
+
+    matrix.clear();
+    matrix.setFont(FONT_3X5);
+
+    /* Clock face, mostly covered once the panel is in */
+    matrix.drawCircle(15, 15, 14, 1);
+    for (uint16_t hour = 0; hour < 12; hour++) {
+        matrix.drawLineFineAngle(15, 15, 13, hour*FULL_ANGLE/12, 1);
+    }
+    matrix.drawFillCircle(15, 15, 10, 0);
+    matrix.drawLineFineAngle(15, 15, 9, (uint32_t) i*FULL_ANGLE/60 % FULL_ANGLE, 1);
+    matrix.drawLineAngle(15, 15, 6, i % 360, 1);
+    matrix.drawArc(15, 15, 12, 0, (uint32_t) i*FULL_ANGLE/FRAMES % FULL_ANGLE, 1);
+
+    /* Date, the weekday scrolls off to the left */
+    matrix.drawString(34 - i % 60, 2, text + 6, 6, 1);
+    matrix.setFont(FONT_4X6);
+    matrix.drawString(34, 10, text, 5, 1);
+    matrix.drawTriangle(34, 24, 44, 18, 54, 24, 1);
+    matrix.drawFillTriangle(36, 30, 46, 26, 56, 30, 1);
+    matrix.drawRectangle(32, 0, 32, 32, 1);
+
+    /* Notification panel */
+    matrix.drawFillRectangle(panelX, 4, 40, 24, 0);
+    matrix.drawRectangle(panelX, 4, 40, 24, 1);
+    matrix.drawBitmap(panelX + 3, 8, bell, 8, 8, RASTER_OP_OR, bellMask);
+    matrix.setFont(FONT_3X5);
+    matrix.drawString(panelX + 14, 10, "Alarm", 5, 1);
+    matrix.drawHLine(panelX + 2, 20, 36, 1);
+    matrix.drawVLine(panelX + 20, 21, 5, 1);
+    matrix.drawRow(panelX + 3, 24, 0xAA, 1);
+    matrix.drawPixel(panelX + 38, 25, 1);
+    matrix.drawChar(panelX + 30, 21, '!', 1);
+
+    /* Off the display, culled */
+    matrix.drawString(-40, 2, "gone", 4, 1);
+    matrix.drawCircle(100, 100, 5, 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Records every frame of the clip and writes the lists to
+            CAPTURE_PATH, one after another.
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool captureClip() {
+    FILE* file = fopen(CAPTURE_PATH, "wb");
+    uint8_t buffer[LIST_SIZE + DISPLAY_LIST_HEADER];
+
+    if (file == nullptr) {
+        Serial.println("Could not create " CAPTURE_PATH);
+        return false;
+    }
+
+    for (uint16_t i = 0; i < FRAMES; i++) {
+        list.startRecording();
+        drawFrame(player, i);
+        list.stopRecording();
+
+        if (list.isOverflowed()) {
+            Serial.println("List too small, increase LIST_SIZE");
+            fclose(file);
+            return false;
+        }
+        fwrite(buffer, 1, list.serialise(buffer, sizeof(buffer)), file);
+    }
+    fclose(file);
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads a capture file into memory.
+  @param    path            Path of the file
+  @returns  True if successful
+*/
+/**************************************************************************/
+bool readCapture(const char path[]) {
+    FILE* file = fopen(path, "rb");
+
+    if (file == nullptr) {
+        Serial.print("Could not open ");
+        Serial.println(path);
+        return false;
+    }
+    captureLength = fread(capture, 1, sizeof(capture), file);
+    fclose(file);
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Loads the next list of the capture.
+  @param    offset          Offset in the capture, moved past the list
+  @returns  True if a list has been loaded
+*/
+/**************************************************************************/
+bool loadList(uint32_t& offset) {
+    if (offset + DISPLAY_LIST_HEADER > captureLength) {
+        return false;
+    }
+
+    const uint8_t* header = capture + offset;
+    uint32_t length = DISPLAY_LIST_HEADER + (header[8] | header[9] << 8 | (uint32_t) header[10] << 16 | (uint32_t) header[11] << 24);
+
+    if (offset + length > captureLength || !list.deserialise(header, length)) {
+        return false;
+    }
+    offset += length;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Counts the pixels that differ between the two matrices.
+  @returns  Number of differing pixels
+*/
+/**************************************************************************/
+uint32_t countMismatches() {
+    uint32_t mismatches = 0;
+
+    for (uint16_t x = 0; x < player.getWidth(); x++) {
+        for (uint16_t y = 0; y < player.getHeight(); y++) {
+            if (player.getPixel(x, y) != direct.getPixel(x, y)) {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Replays every list of the capture as it is and culled, and
+            counts the pixels that differ from the drawn frames.
+*/
+/**************************************************************************/
+void checkCapture() {
+    uint32_t offset = 0;
+    uint32_t mismatches = 0;
+    uint32_t culledMismatches = 0;
+    uint32_t commands = 0;
+    uint32_t culled = 0;
+    uint32_t bytes = 0;
+    uint32_t culledBytes = 0;
+    uint16_t frames = 0;
+
+    while (loadList(offset)) {
+        drawFrame(direct, frames);
+
+        list.replay();
+        mismatches += countMismatches();
+        commands += list.getNumCommands();
+        bytes += list.getLength();
+
+        culled += list.cull();
+        culledBytes += list.getLength();
+        player.clear();
+        list.replay();
+        culledMismatches += countMismatches();
+        frames++;
+    }
+
+    Serial.println("Display list check");
+    Serial.print("frames: ");
+    Serial.print(frames);
+    Serial.print(", commands/frame: ");
+    Serial.print((float) commands / frames);
+    Serial.print(", bytes/frame: ");
+    Serial.print((float) bytes / frames);
+    Serial.print(", culled commands/frame: ");
+    Serial.print((float) culled / frames);
+    Serial.print(", culled bytes/frame: ");
+    Serial.println((float) culledBytes / frames);
+    Serial.print("differing pixels replayed: ");
+    Serial.print(mismatches);
+    Serial.print(", culled: ");
+    Serial.println(culledMismatches);
+
+    if (frames != FRAMES || mismatches != 0 || culledMismatches != 0) {
+        Serial.println("FAILED: replay differs from drawing");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Times drawing the clip (only without a capture file), replaying
+            the lists and replaying the culled lists. The lists are loaded
+            outside the timed part.
+  @param    path            Capture that is replayed
+*/
+/**************************************************************************/
+void benchmarkCapture(const char path[]) {
+    uint32_t drawTime = 0;
+    uint32_t replayTime = 0;
+    uint32_t culledTime = 0;
+    uint32_t frames = 0;
+    bool synthetic = strcmp(path, CAPTURE_PATH) == 0;
+
+    for (uint16_t r = 0; r < REPEATS; r++) {
+        uint32_t offset = 0;
+        uint16_t i = 0;
+
+        while (loadList(offset)) {
+            /* Replay on the geometry it was recorded on */
+            if (player.getSegmentsHorizontal() != list.getSegmentsHorizontal() || player.getSegmentsVertical() != list.getSegmentsVertical()) {
+                player.initialiseMatrix(list.getSegmentsHorizontal(), list.getSegmentsVertical(), CS_PIN);
+                player.setTransport(&recorder);
+            }
+            player.setRotation(list.getRotation());
+
+            uint32_t start;
+            if (synthetic) {
+                start = micros();
+                drawFrame(direct, i);
+                drawTime += micros() - start;
+            }
+
+            start = micros();
+            list.replay();
+            replayTime += micros() - start;
+
+            list.cull();
+            start = micros();
+            list.replay();
+            culledTime += micros() - start;
+
+            frames++;
+            i++;
+        }
+    }
+
+    if (frames == 0) {
+        Serial.println("No display lists in the capture");
+        return;
+    }
+
+    Serial.print("Display list benchmark, ");
+    Serial.println(path);
+    Serial.println("mode\tus/frame");
+    if (synthetic) {
+        Serial.print("draw\t");
+        Serial.println((float) drawTime / frames);
+    }
+    Serial.print("replay\t");
+    Serial.println((float) replayTime / frames);
+    Serial.print("culled\t");
+    Serial.println((float) culledTime / frames);
+}
@@ -0,0 +1,211 @@
+/*
+ * File:      MAX7219CWGMatrix_angles.ino
+ * Authors:   Luke de Munk
+ *
+ * Check and benchmark of the fixed-point angles of the MAX7219CWGMatrix
+ * library. Compares the end pixels of lines under an angle with the
+ * floating point result for every clock position, and times the sine
+ * table against the floating point path it replaces. Uses a recording
+ * transport, so no display has to be connected. Results are printed on
+ * the serial port. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+
+#define CS_PIN          14
+#define WIDTH           4                                                   //4 segments horizontal
+#define HEIGHT          4                                                   //4 segments vertical
+#define MAX_LENGTH      15                                                  //Longest hand that fits from the center
+#define ITERATIONS      20000                                               //Repetitions per timed path
+#define TIE_MARGIN      0.001                                               //Distance to half a pixel that counts as a tie
+
+MAX7219CWGMatrix matrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219CWGMatrix reference(WIDTH, HEIGHT, CS_PIN);
+MAX7219RecordingTransport recorder;
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the check and benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    matrix.setTransport(&recorder);
+    reference.setTransport(&recorder);
+
+    Serial.println("Angle accuracy (end pixels differing from floating point)");
+    Serial.println("positions\tstep\tendpoints\tties\tdiffer\timages differ");
+    checkPositions(60, FULL_ANGLE/60);                                      //Seconds and minutes
+    checkPositions(720, FULL_ANGLE/720);                                    //Hours with minutes
+    checkPositions(360, ANGLE_STEPS_PER_DEGREE);                            //Whole degrees
+    checkPositions(FULL_ANGLE, 1);                                          //Finest steps
+
+    benchmarkAngles();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Compares the end pixel of every position and length with the
+            rounded floating point result, and the drawn line with a line
+            drawn to that pixel. Ties are counted, not compared.
+  @param    positions       Number of positions in a full turn
+  @param    step            Fine angle between two positions
+*/
+/**************************************************************************/
+void checkPositions(uint16_t positions, uint16_t step) {
+    int16_t x0 = matrix.getWidth()/2;
+    int16_t y0 = matrix.getHeight()/2;
+    uint32_t endpoints = 0;
+    uint32_t ties = 0;
+    uint32_t differ = 0;
+    uint32_t imagesDiffer = 0;
+
+    for (int16_t l = 1; l <= MAX_LENGTH; l++) {
+        for (uint16_t p = 0; p < positions; p++) {
+            uint16_t angle = p*step;
+            double radians = angle * M_PI / (FULL_ANGLE/2);
+            int16_t expectedX = x0 + lround(l * sin(radians));
+            int16_t expectedY = y0 + lround(l * cos(radians));
+            int16_t x;
+            int16_t y;
+
+            matrix.getAnglePoint(x0, y0, l, angle, x, y);
+            endpoints++;
+
+            /* Exactly half a pixel may round either way */
+            if (isTie(l * sin(radians)) || isTie(l * cos(radians))) {
+                ties++;
+                continue;
+            }
+            if (x != expectedX || y != expectedY) {
+                differ++;
+            }
+
+            matrix.clear();
+            reference.clear();
+            matrix.drawLineFineAngle(x0, y0, l, angle, 1);
+            reference.drawLine(x0, y0, expectedX, expectedY, 1);
+
+            if (!sameImage()) {
+                imagesDiffer++;
+            }
+        }
+    }
+
+    Serial.print(positions);
+    Serial.print("\t");
+    Serial.print((float) step / ANGLE_STEPS_PER_DEGREE);
+    Serial.print("\t");
+    Serial.print(endpoints);
+    Serial.print("\t");
+    Serial.print(ties);
+    Serial.print("\t");
+    Serial.print(differ);
+    Serial.print("\t");
+    Serial.println(imagesDiffer);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a coordinate is (almost) exactly between two pixels.
+  @param    value           Coordinate
+  @returns  True if it is a tie
+*/
+/**************************************************************************/
+bool isTie(double value) {
+    double fraction = fabs(value - floor(value));
+    return fabs(fraction - 0.5) < TIE_MARGIN;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if both matrices show the same pixels.
+  @returns  True if equal
+*/
+/**************************************************************************/
+bool sameImage() {
+    for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+        for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+            if (matrix.getPixel(x, y) != reference.getPixel(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the time per end point and per clock hand of the
+            floating point path and of the sine table.
+*/
+/**************************************************************************/
+void benchmarkAngles() {
+    int16_t x0 = matrix.getWidth()/2;
+    int16_t y0 = matrix.getHeight()/2;
+    volatile int16_t sink = 0;                                              //Keeps the end points from being optimised out
+    uint32_t start;
+    uint32_t floatTime;
+
+    Serial.println("Angle benchmark (us per call)");
+    Serial.println("path\tfloat\ttable");
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        uint16_t angle = i % 360;
+        sink += x0 + (int16_t) ((i % MAX_LENGTH) * sin(angle * 0.0174532925));
+        sink += y0 + (int16_t) ((i % MAX_LENGTH) * cos(angle * 0.0174532925));
+    }
+    floatTime = micros() - start;
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        int16_t x;
+        int16_t y;
+
+        matrix.getAnglePoint(x0, y0, i % MAX_LENGTH, (i % 360)*ANGLE_STEPS_PER_DEGREE, x, y);
+        sink += x + y;
+    }
+    printAngleResult("endpoint", floatTime, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        uint16_t angle = i % 360;
+        int16_t x = x0 + (int16_t) (MAX_LENGTH * sin(angle * 0.0174532925));
+        int16_t y = y0 + (int16_t) (MAX_LENGTH * cos(angle * 0.0174532925));
+        matrix.drawLine(x0, y0, x, y, i & 1);
+    }
+    floatTime = micros() - start;
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawLineAngle(x0, y0, MAX_LENGTH, i % 360, i & 1);
+    }
+    printAngleResult("hand", floatTime, micros() - start);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints one line of the angle benchmark.
+  @param    name            Name of the path
+  @param    floatTime       Total time of the floating point path in us
+  @param    tableTime       Total time of the sine table in us
+*/
+/**************************************************************************/
+void printAngleResult(const char* name, uint32_t floatTime, uint32_t tableTime) {
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.print((float) floatTime / ITERATIONS);
+    Serial.print("\t");
+    Serial.println((float) tableTime / ITERATIONS);
+}
@@ -0,0 +1,191 @@
+/*
+ * File:      MAX7219CWGMatrix_async.ino
+ * Authors:   Luke de Munk
+ *
+ * Check of displayAsync() of the MAX7219CWGMatrix library. One matrix
+ * sends its frames with display(), a second one draws the same frames
+ * and sends them with displayAsync(). Its transport holds every flush
+ * until the matrix waits for the bus, so the next frame is drawn and
+ * packed while the last one is still in flight. The bytes in flight
+ * may not change until they are sent, and both matrices must send the
+ * same words in the same transactions. No display has to be connected.
+ * Results are printed on the serial port. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+
+#define CS_PIN          14
+#define WIDTH           4                                                   //4 segments horizontal
+#define HEIGHT          3                                                   //3 segments vertical
+#define FRAMES          24                                                  //Frames compared
+#define LOG_SIZE        (FRAMES*ROW_SIZE*(WIDTH*HEIGHT + 2) + 64)           //Every row of every frame, and the setup commands
+#define FLIGHT_SIZE     (MAX7219_MAX_FRAMES*2*WIDTH*HEIGHT)                 //Largest writeAsync()
+
+/* Transport that keeps a flush in flight until the bus is polled, then
+ * checks the bytes did not change and sends them */
+class HeldTransport : public MAX7219Transport {
+	public:
+        HeldTransport(MAX7219Transport* target) {
+            _target = target;
+        }
+
+        void begin(uint8_t csPin) {
+            _target->begin(csPin);
+        }
+
+        void write(const uint8_t* data, uint16_t length) {
+            _target->write(data, length);
+        }
+
+        void writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames) {
+            _data = data;
+            _length = frameLength*numFrames;
+            _frameLength = frameLength;
+            memcpy(_sent, data, _length);
+            _numFlushes++;
+        }
+
+        bool isBusy() {
+            if (_data == nullptr) {
+                return false;
+            }
+
+            /* The bus is done: what is sent now is what was handed over */
+            if (memcmp(_data, _sent, _length) != 0) {
+                _numChanged++;
+            }
+            for (uint16_t i = 0; i < _length; i += _frameLength) {
+                _target->write(_data + i, _frameLength);
+            }
+            _data = nullptr;
+            _complete();
+            return false;
+        }
+
+        uint32_t getNumFlushes() {
+            return _numFlushes;
+        }
+
+        uint32_t getNumChanged() {
+            return _numChanged;
+        }
+
+	private:
+        MAX7219Transport* _target;
+        const uint8_t* _data = nullptr;                                     //In flight, nullptr if none
+        uint16_t _length = 0;
+        uint16_t _frameLength = 0;
+        uint8_t _sent[FLIGHT_SIZE];                                         //Copy of the bytes handed over
+        uint32_t _numFlushes = 0;
+        uint32_t _numChanged = 0;                                           //Flushes changed while in flight
+};
+
+MAX7219Event syncLog[LOG_SIZE];
+MAX7219Event asyncLog[LOG_SIZE];
+MAX7219RecordingTransport syncRecorder(syncLog, LOG_SIZE);
+MAX7219RecordingTransport asyncRecorder(asyncLog, LOG_SIZE);
+HeldTransport held(&asyncRecorder);
+
+MAX7219CWGMatrix syncMatrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219CWGMatrix asyncMatrix(WIDTH, HEIGHT, CS_PIN);
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controllers and run the check once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    syncMatrix.setTransport(&syncRecorder);
+    asyncMatrix.setTransport(&held);
+
+    for (uint16_t i = 0; i < FRAMES; i++) {
+        drawFrame(syncMatrix, i);
+        syncMatrix.display();
+
+        /* Packed while the last frame is still in flight */
+        drawFrame(asyncMatrix, i);
+        asyncMatrix.displayAsync();
+
+        /* Drawn while this frame is in flight, never sent */
+        asyncMatrix.drawFillRectangle(0, 0, asyncMatrix.getWidth(), asyncMatrix.getHeight()/2, 1);
+        asyncMatrix.drawString(1, 1, "ASYNC", 5, 0);
+    }
+    asyncMatrix.isFlushing();                                               //Sends the last frame
+
+    uint16_t numEvents = syncRecorder.getNumEvents();
+    uint16_t differ = 0;
+
+    if (asyncRecorder.getNumEvents() != numEvents) {
+        differ = abs(asyncRecorder.getNumEvents() - numEvents);
+        numEvents = min(numEvents, asyncRecorder.getNumEvents());
+    }
+    for (uint16_t e = 0; e < numEvents; e++) {
+        MAX7219Event syncEvent = syncRecorder.getEvent(e);
+        MAX7219Event asyncEvent = asyncRecorder.getEvent(e);
+
+        if (syncEvent.type != asyncEvent.type || syncEvent.word != asyncEvent.word) {
+            differ++;
+        }
+    }
+
+    Serial.println("displayAsync() check");
+    Serial.print("frames: ");
+    Serial.print(FRAMES);
+    Serial.print(", flushes: ");
+    Serial.print(held.getNumFlushes());
+    Serial.print(", words: ");
+    Serial.print(syncRecorder.getWords());
+    Serial.print(" display(), ");
+    Serial.print(asyncRecorder.getWords());
+    Serial.println(" displayAsync()");
+    Serial.print("differing events: ");
+    Serial.print(differ);
+    Serial.print(", changed in flight: ");
+    Serial.println(held.getNumChanged());
+
+    if (syncRecorder.isOverflowed() || asyncRecorder.isOverflowed()) {
+        Serial.println("FAILED: the log is too small");
+    }
+    if (differ != 0) {
+        Serial.println("FAILED: displayAsync() sent other words than display()");
+    }
+    if (held.getNumChanged() != 0) {
+        Serial.println("FAILED: drawing changed a flush in flight");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws frame i of the check. Every frame changes some rows and
+            keeps others, so rows are both sent and skipped.
+  @param    target          Matrix to draw on
+  @param    i               Number of the frame
+*/
+/**************************************************************************/
+void drawFrame(MAX7219CWGMatrix& target, uint16_t i) {
+    char text[4];
+
+    text[0] = '0' + (i / 10) % 10;
+    text[1] = '0' + i % 10;
+    text[2] = i & 1 ? ':' : ' ';
+    text[3] = 0;
+
+    target.clear();
+    target.drawRectangle(0, 0, target.getWidth(), target.getHeight(), 1);
+    target.drawString(2, 2, text, 3, 1);
+
+    if (i % 4 != 3) {                                                       //Every 4th frame the lower half stays empty
+        target.drawFillCircle(target.getWidth()/2, 16, i % 7, 1);
+    }
+}
@@ -0,0 +1,809 @@
+/*
+ * File:      MAX7219CWGMatrix_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Benchmark for the MAX7219CWGMatrix library. Uses a recording transport,
+ * so no display has to be connected. Also checks the clock screen
+ * against redrawing it and the bitmap blitter against drawing pixel by
+ * pixel. Results are printed on the serial port. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+#include "BitReverse.h"
+#include "MAX7219Simulator.h"
+#include "SmartLedDisplay.h"
+#include "SpriteSheet.h"
+#include "TextFormat.h"
+
+#define CS_PIN          14
+#define ITERATIONS      200                                                 //Repetitions per timed primitive
+
+MAX7219CWGMatrix matrix;                                                    //Initialised per geometry
+MAX7219RecordingTransport recorder;                                         //Counts words and transactions
+
+uint8_t wiringFrame[8*4*ROW_SIZE];                                          //Frame of the wiring benchmark
+uint16_t wiringMap[8*4];                                                    //Chain position per segment
+
+/* Sprite sheet: a 13x11 face with a mask and a 16x16 pattern */
+const uint8_t sprites[] PROGMEM = {
+    'S', 'S', 2, 0,                                                         //Magic, 2 sprites
+    12, 0, 0, 0,                                                            //Offset of sprite 0
+    60, 0, 0, 0,                                                            //Offset of sprite 1
+
+    13, 11, SPRITE_HAS_MASK, 0,
+    0x0F, 0x80,   // ....#####....
+    0x30, 0x60,   // ..##.....##..
+    0x40, 0x10,   // .#.........#.
+    0x8D, 0x88,   // #...##.##...#
+    0x80, 0x08,   // #...........#
+    0x90, 0x48,   // #..#.....#..#
+    0x8F, 0x88,   // #...#####...#
+    0x40, 0x10,   // .#.........#.
+    0x30, 0x60,   // ..##.....##..
+    0x0F, 0x80,   // ....#####....
+    0x00, 0x00,   // .............
+
+    0x0F, 0x80,   // ....#####....
+    0x3F, 0xE0,   // ..#########..
+    0x7F, 0xF0,   // .###########.
+    0xFF, 0xF8,   // #############
+    0xFF, 0xF8,   // #############
+    0xFF, 0xF8,   // #############
+    0xFF, 0xF8,   // #############
+    0x7F, 0xF0,   // .###########.
+    0x3F, 0xE0,   // ..#########..
+    0x0F, 0x80,   // ....#####....
+    0x00, 0x00,   // .............
+
+    16, 16, 0, 0,
+    0xFF, 0xFF,   // ################
+    0x8F, 0x0F,   // #...####....####
+    0x8F, 0x0F,   // #...####....####
+    0x8F, 0x0F,   // #...####....####
+    0xF0, 0xF1,   // ####....####...#
+    0xF0, 0xF1,   // ####....####...#
+    0xF0, 0xF1,   // ####....####...#
+    0xF0, 0xF1,   // ####....####...#
+    0x8F, 0x0F,   // #...####....####
+    0x8F, 0x0F,   // #...####....####
+    0x8F, 0x0F,   // #...####....####
+    0x8F, 0x0F,   // #...####....####
+    0xF0, 0xF1,   // ####....####...#
+    0xF0, 0xF1,   // ####....####...#
+    0xF0, 0xF1,   // ####....####...#
+    0xFF, 0xFF    // ################
+};
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the benchmarks once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    benchmarkBus();
+    benchmarkWiring();
+    benchmarkPrimitives();
+    benchmarkText();
+    benchmarkScreen();
+    benchmarkBitmaps();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the render time, words/frame, transactions/frame,
+            estimated bus time and flush time of a full frame and of a
+            frame with one changed pixel, for every panel geometry from 1x1
+            up to MAX_HORIZONTAL_SEGMENTS x MAX_VERTICAL_SEGMENTS.
+*/
+/**************************************************************************/
+void benchmarkBus() {
+    Serial.println("Bus benchmark");
+    Serial.println("HxV\tframe\trender us\twords\ttrans\t5MHz us\t10MHz us\tflush us");
+
+    for (uint8_t v = 1; v <= MAX_VERTICAL_SEGMENTS; v++) {
+        for (uint8_t h = 1; h <= MAX_HORIZONTAL_SEGMENTS; h++) {
+            matrix.initialiseMatrix(h, v, CS_PIN);
+            matrix.setTransport(&recorder);
+
+            /* Full frame, every row changes */
+            uint32_t start = micros();
+            matrix.drawFillRectangle(0, 0, matrix.getWidth(), matrix.getHeight(), 1);
+            printBusFrame(h, v, "full", micros() - start);
+
+            /* Second hand moved, one pixel changes */
+            start = micros();
+            matrix.drawPixel(0, 0, 0);
+            printBusFrame(h, v, "pixel", micros() - start);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends the current frame and prints one line of results.
+  @param    h               Number of horizontal segments
+  @param    v               Number of vertical segments
+  @param    name            Name of the frame
+  @param    renderTime      Time drawing the frame took in us
+*/
+/**************************************************************************/
+void printBusFrame(uint8_t h, uint8_t v, const char* name, uint32_t renderTime) {
+    recorder.reset();
+    uint32_t start = micros();
+    matrix.display();
+    uint32_t cpuTime = micros() - start;
+
+    Serial.print(h);
+    Serial.print("x");
+    Serial.print(v);
+    Serial.print("\t");
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.print(renderTime);
+    Serial.print("\t");
+    Serial.print(recorder.getWords());
+    Serial.print("\t");
+    Serial.print(recorder.getTransactions());
+    Serial.print("\t");
+    recorder.setClock(MAX7219_SPI_CLOCK);
+    Serial.print(recorder.getBusTime());
+    Serial.print("\t");
+    recorder.setClock(MAX7219_MAX_SPI_CLOCK);
+    Serial.print(recorder.getBusTime());
+    Serial.print("\t");
+    Serial.println(cpuTime);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the render and flush time per full frame for every
+            wiring type and rotation, on an 8x4 panel. Then the same frame
+            is sent once with the chain positions looked up in a map
+            resolved once, as display() does, and once with the wiring
+            branched on per segment, as display() did before. The
+            difference is the time the branches cost per frame.
+*/
+/**************************************************************************/
+void benchmarkWiring() {
+    const uint8_t wirings[] = {ZIGZAG_WIRING, SERPENTINE_WIRING, PROGRESSIVE_WIRING, COLUMN_WIRING};
+    const uint8_t rotations[] = {STANDARD_ROTATION, UPSIDE_DOWN_ROTATION, CLOCKWISE_ROTATION, COUNTERCLOCKWISE_ROTATION | MIRRORED_ROTATION};
+
+    Serial.println("Wiring benchmark (us per frame)");
+    Serial.println("wiring\trotation\trender\tflush\tmapped\tbranching\tdifference");
+
+    matrix.initialiseMatrix(8, 4, CS_PIN);
+    matrix.setTransport(&recorder);
+
+    for (uint8_t w = 0; w < sizeof(wirings); w++) {
+        matrix.setWiring(wirings[w]);
+        resolveWiring(wirings[w]);
+
+        for (uint8_t r = 0; r < sizeof(rotations); r++) {
+            uint32_t renderTime = 0;
+            uint32_t flushTime = 0;
+            uint32_t mappedTime = 0;
+            uint32_t branchingTime = 0;
+
+            matrix.setRotation(rotations[r]);
+
+            for (uint16_t i = 0; i < ITERATIONS; i++) {
+                uint32_t start = micros();
+                matrix.clear();
+                matrix.drawFillCircle(matrix.getWidth()/2, matrix.getHeight()/2, i % (matrix.getHeight()/2), 1);
+                matrix.drawString(0, 0, "12:34", 5, 1);
+                renderTime += micros() - start;
+
+                start = micros();
+                matrix.display();
+                flushTime += micros() - start;
+
+                matrix.swapFrame(wiringFrame);                              //Redrawn next frame
+
+                start = micros();
+                sendFrame(wirings[w], true);
+                mappedTime += micros() - start;
+
+                start = micros();
+                sendFrame(wirings[w], false);
+                branchingTime += micros() - start;
+            }
+
+            Serial.print(wirings[w]);
+            Serial.print("\t");
+            Serial.print(rotations[r]);
+            Serial.print("\t");
+            Serial.print((float) renderTime / ITERATIONS);
+            Serial.print("\t");
+            Serial.print((float) flushTime / ITERATIONS);
+            Serial.print("\t");
+            Serial.print((float) mappedTime / ITERATIONS);
+            Serial.print("\t");
+            Serial.print((float) branchingTime / ITERATIONS);
+            Serial.print("\t");
+            Serial.println(((float) branchingTime - mappedTime) / ITERATIONS);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Resolves the chain position and orientation of every segment
+            of the matrix into wiringMap, like setWiring() does.
+  @param    wiringType      Type of circuit (no custom wiring)
+*/
+/**************************************************************************/
+void resolveWiring(uint8_t wiringType) {
+    uint8_t segmentsHorizontal = matrix.getSegmentsHorizontal();
+    uint8_t segmentsVertical = matrix.getSegmentsVertical();
+
+    for (uint8_t segRow = 0; segRow < segmentsVertical; segRow++) {
+        for (uint8_t d = 0; d < segmentsHorizontal; d++) {
+            wiringMap[segRow*segmentsHorizontal + d] = chainPosition(wiringType, segmentsHorizontal, segmentsVertical, segRow, d);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the chain position of a segment, branching on the
+            wiring type the way display() did before setWiring().
+  @param    wiringType          Type of circuit (no custom wiring)
+  @param    segmentsHorizontal  Number of horizontal segments
+  @param    segmentsVertical    Number of vertical segments
+  @param    segRow              Row of the segment
+  @param    d                   Column of the segment
+  @returns  Chain position, with SEGMENT_FLIPPED if upside down
+*/
+/**************************************************************************/
+uint16_t chainPosition(uint8_t wiringType, uint8_t segmentsHorizontal, uint8_t segmentsVertical, uint8_t segRow, uint8_t d) {
+    bool odd = segRow % 2 == 1;
+    uint16_t position = segRow*segmentsHorizontal + d;
+
+    if (odd && (wiringType == ZIGZAG_WIRING || wiringType == SERPENTINE_WIRING)) {
+        position = segRow*segmentsHorizontal + segmentsHorizontal-1 - d;
+    } else if (wiringType == COLUMN_WIRING) {
+        position = d*segmentsVertical + segRow;
+    }
+
+    if (odd && wiringType == ZIGZAG_WIRING) {
+        position |= SEGMENT_FLIPPED;
+    }
+    return position;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends every digit row of wiringFrame to the recorder.
+  @param    wiringType      Type of circuit (no custom wiring)
+  @param    mapped          True to look the chain positions up in
+                            wiringMap and reverse with BitReverse, false
+                            to branch on the wiring type per segment and
+                            reverse with shifts, as before setWiring()
+*/
+/**************************************************************************/
+void sendFrame(uint8_t wiringType, bool mapped) {
+    uint8_t segmentsHorizontal = matrix.getSegmentsHorizontal();
+    uint8_t segmentsVertical = matrix.getSegmentsVertical();
+    uint8_t buffer[2*sizeof(wiringMap)/sizeof(wiringMap[0])];
+
+    for (uint8_t r = 0; r < ROW_SIZE; r++) {
+        for (uint8_t segRow = 0; segRow < segmentsVertical; segRow++) {
+            const uint8_t* row = wiringFrame + (r + segRow*ROW_SIZE)*segmentsHorizontal;
+
+            for (uint8_t d = 0; d < segmentsHorizontal; d++) {
+                uint16_t position;
+                uint8_t data = row[d];
+
+                if (mapped) {
+                    position = wiringMap[segRow*segmentsHorizontal + d];
+                } else {
+                    position = chainPosition(wiringType, segmentsHorizontal, segmentsVertical, segRow, d);
+                }
+
+                uint8_t* word = buffer + 2*(position & ~SEGMENT_FLIPPED);
+
+                if (!(position & SEGMENT_FLIPPED)) {
+                    word[0] = ROW_SIZE - r;
+                } else if (mapped) {
+                    word[0] = r + 1;
+                    data = pgm_read_byte(&BitReverse[data]);
+                } else {
+                    word[0] = r + 1;
+                    data = (data & 0xF0) >> 4 | (data & 0x0F) << 4;
+                    data = (data & 0xCC) >> 2 | (data & 0x33) << 2;
+                    data = (data & 0xAA) >> 1 | (data & 0x55) << 1;
+                }
+                word[1] = data;
+            }
+        }
+        recorder.write(buffer, 2*segmentsHorizontal*segmentsVertical);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the average time per call of the span based primitives,
+            next to the per-pixel path they replace, on a 4x3 panel.
+*/
+/**************************************************************************/
+void benchmarkPrimitives() {
+    matrix.initialiseMatrix(4, 3, CS_PIN);
+    matrix.setTransport(&recorder);
+    matrix.setRotation(UPSIDE_DOWN_ROTATION);
+
+    uint16_t w = matrix.getWidth();
+    uint16_t h = matrix.getHeight();
+    uint32_t start;
+    uint32_t oldTime;
+
+    Serial.println("Primitive benchmark (us per call)");
+    Serial.println("primitive\tpixel path\tspan path\tspeedup");
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawLine(0, i % h, w-1, i % h, i & 1);
+    }
+    oldTime = micros() - start;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawHLine(0, i % h, w, i & 1);
+    }
+    printPrimitive("hline", oldTime, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawLine(i % w, 0, i % w, h-1, i & 1);
+    }
+    oldTime = micros() - start;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawVLine(i % w, 0, h, i & 1);
+    }
+    printPrimitive("vline", oldTime, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        for (uint16_t x = 0; x < w; x++) {
+            matrix.drawLine(x, 0, x, h-1, i & 1);
+        }
+    }
+    oldTime = micros() - start;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawFillRectangle(0, 0, w, h, i & 1);
+    }
+    printPrimitive("fillrect", oldTime, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        drawFillTriangleLines(0, 0, w-1, h/2, 2, h-1, i & 1);
+    }
+    oldTime = micros() - start;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawFillTriangle(0, 0, w-1, h/2, 2, h-1, i & 1);
+    }
+    printPrimitive("filltriangle", oldTime, micros() - start);
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        drawFillCircleLines(w/2, h/2, h/2-1, i & 1);
+    }
+    oldTime = micros() - start;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawFillCircle(w/2, h/2, h/2-1, i & 1);
+    }
+    printPrimitive("fillcircle", oldTime, micros() - start);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a filled triangle the way it was done before the span
+            kernels: a scanline per row, drawn with drawLine().
+  @param    x0              Vertex #0 x coordinate
+  @param    y0              Vertex #0 y coordinate
+  @param    x1              Vertex #1 x coordinate
+  @param    y1              Vertex #1 y coordinate
+  @param    x2              Vertex #2 x coordinate
+  @param    y2              Vertex #2 y coordinate
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void drawFillTriangleLines(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t value) {
+    int16_t swap;
+
+    /* Sort coordinates by Y order (y2 >= y1 >= y0) */
+    if (y0 > y1) {
+        swap = y0; y0 = y1; y1 = swap;
+        swap = x0; x0 = x1; x1 = swap;
+    }
+    if (y1 > y2) {
+        swap = y1; y1 = y2; y2 = swap;
+        swap = x1; x1 = x2; x2 = swap;
+    }
+    if (y0 > y1) {
+        swap = y0; y0 = y1; y1 = swap;
+        swap = x0; x0 = x1; x1 = swap;
+    }
+
+    for (int16_t y = y0; y <= y2; y++) {
+        int16_t a;
+        int16_t b = x0 + (int32_t) (x2 - x0)*(y - y0) / (y2 - y0);
+
+        if (y < y1 || (y == y1 && y1 == y2)) {
+            a = y1 == y0 ? x1 : x0 + (int32_t) (x1 - x0)*(y - y0) / (y1 - y0);
+        } else {
+            a = x1 + (int32_t) (x2 - x1)*(y - y1) / (y2 - y1);
+        }
+        if (a > b) {
+            swap = a; a = b; b = swap;
+        }
+        matrix.drawLine(a, y, b, y, value);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a filled circle the way it was done before the span
+            kernels: vertical lines drawn with drawLine().
+  @param    x0              Center x coordinate
+  @param    y0              Center y coordinate
+  @param    r               Radius of circle
+  @param    value           Value to fill (0-1)
+*/
+/**************************************************************************/
+void drawFillCircleLines(int16_t x0, int16_t y0, int16_t r, uint8_t value) {
+    int16_t f = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+    int16_t px = x;
+    int16_t py = y;
+
+    matrix.drawLine(x0, y0-r, x0, y0+r, value);
+
+    while (x < y) {
+        if (f >= 0) {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        if (x < (y + 1)) {
+            matrix.drawLine(x0+x, y0-y, x0+x, y0+y, value);
+            matrix.drawLine(x0-x, y0-y, x0-x, y0+y, value);
+        }
+
+        if (y != py) {
+            matrix.drawLine(x0+py, y0-px, x0+py, y0+px, value);
+            matrix.drawLine(x0-py, y0-px, x0-py, y0+px, value);
+            py = y;
+        }
+        px = x;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints one line of the primitive benchmark.
+  @param    name            Name of the primitive
+  @param    oldTime         Total time of the old path in us
+  @param    newTime         Total time of the new path in us
+*/
+/**************************************************************************/
+void printPrimitive(const char* name, uint32_t oldTime, uint32_t newTime) {
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.print((float) oldTime / ITERATIONS);
+    Serial.print("\t");
+    Serial.print((float) newTime / ITERATIONS);
+    Serial.print("\t");
+    Serial.println(newTime == 0 ? 0 : (float) oldTime / newTime);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the number of glyphs per second drawChar() draws, for
+            every font, on a 4x3 panel.
+*/
+/**************************************************************************/
+void benchmarkText() {
+    const char text[] = "12:34 Monday 5 January {|}";
+    const uint8_t fonts[] = {FONT_3X5, FONT_4X6, FONT_5X7};
+    uint8_t length = sizeof(text) - 1;
+
+    matrix.initialiseMatrix(4, 3, CS_PIN);
+    matrix.setTransport(&recorder);
+    matrix.setRotation(UPSIDE_DOWN_ROTATION);
+
+    Serial.println("Text benchmark");
+    Serial.println("font\tglyphs/s");
+
+    for (uint8_t f = 0; f < sizeof(fonts); f++) {
+        matrix.setFont(fonts[f]);
+
+        uint32_t start = micros();
+        for (uint16_t i = 0; i < ITERATIONS; i++) {
+            for (uint8_t c = 0; c < length; c++) {
+                matrix.drawChar((c*(matrix.getFontCols()+1)) % matrix.getWidth(), i % matrix.getHeight(), text[c], i & 1);
+            }
+        }
+        uint32_t time = micros() - start;
+
+        Serial.print(matrix.getFontCols());
+        Serial.print("x");
+        Serial.print(fonts[f] == FONT_3X5 ? FONT_3X5_ROWS : (fonts[f] == FONT_4X6 ? FONT_4X6_ROWS : FONT_5X7_ROWS));
+        Serial.print("\t");
+        Serial.println((float) ITERATIONS * length * 1000000 / time);
+    }
+    matrix.setFont(FONT_3X5);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the time and words per frame of showScreen1() of the
+            SmartLedDisplay on a 4x3 panel, next to the old screen that
+            cleared and redrew everything every frame. Then checks both
+            send the same image to simulated chips.
+*/
+/**************************************************************************/
+void benchmarkScreen() {
+    SmartLedDisplay screen(4, 3, CS_PIN);
+    uint32_t start;
+    uint32_t oldTime;
+    uint32_t oldWords;
+
+    matrix.initialiseMatrix(4, 3, CS_PIN);
+    matrix.setTransport(&recorder);
+    matrix.setRotation(UPSIDE_DOWN_ROTATION);
+    screen.setTransport(&recorder);
+
+    Serial.println("Screen benchmark (us per frame)");
+    Serial.println("screen\tredraw\tcomposed\twords redraw\twords composed");
+
+    /* Everything drawn every frame */
+    recorder.reset();
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        redrawScreen1(12, i / 60, i % 60);
+    }
+    oldTime = micros() - start;
+    oldWords = recorder.getWords();
+
+    /* Border and clock face cached, only changed digits drawn */
+    recorder.reset();
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        screen.setTime({12, (uint8_t) (i / 60), (uint8_t) (i % 60)});
+        screen.showScreen1();
+    }
+
+    Serial.print("clock\t");
+    Serial.print((float) oldTime / ITERATIONS);
+    Serial.print("\t");
+    Serial.print((float) (micros() - start) / ITERATIONS);
+    Serial.print("\t");
+    Serial.print((float) oldWords / ITERATIONS);
+    Serial.print("\t");
+    Serial.println((float) recorder.getWords() / ITERATIONS);
+
+    /* Both screens on their own chips, compared every frame */
+    MAX7219Simulator oldChips(4, 3);
+    MAX7219Simulator newChips(4, 3);
+    uint32_t mismatches = 0;
+
+    matrix.setTransport(&oldChips);
+    screen.setTransport(&newChips);
+
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        redrawScreen1(12, i / 60, i % 60);
+        screen.setTime({12, (uint8_t) (i / 60), (uint8_t) (i % 60)});
+        screen.showScreen1();
+
+        for (uint16_t p = 0; p < 4*3; p++) {
+            for (uint8_t d = 0; d < ROW_SIZE; d++) {
+                if (oldChips.getChip(p)->digits[d] != newChips.getChip(p)->digits[d]) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+    matrix.setTransport(&recorder);
+
+    Serial.print("frames: ");
+    Serial.print(ITERATIONS);
+    Serial.print(", differing rows: ");
+    Serial.println(mismatches);
+    if (mismatches != 0) {
+        Serial.println("FAILED: showScreen1() differs from the redrawn screen");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the clock screen the way showScreen1() did before the
+            compositor: clear, border, analog clock with a second hand and
+            the digital time without seconds, then sends it.
+  @param    hour            Hour (0-23)
+  @param    minute          Minute (0-59)
+  @param    second          Second (0-59)
+*/
+/**************************************************************************/
+void redrawScreen1(uint8_t hour, uint8_t minute, uint8_t second) {
+    char timeString[TIME_SECONDS_LENGTH];
+    uint8_t length = TextFormat::time(timeString, hour, minute, 255);
+
+    matrix.clear();
+    matrix.drawRectangle(0, 0, matrix.getWidth(), matrix.getHeight(), 1);
+
+    matrix.drawLineFineAngle(15, 15, 6, second*(FULL_ANGLE/60), 1);
+    matrix.drawLineFineAngle(15, 15, 5, minute*(FULL_ANGLE/60), 1);
+    matrix.drawLineFineAngle(15, 15, 3, ((hour % 12)*60 + minute)*(FULL_ANGLE/720), 1);
+    matrix.drawCircle(15, 15, 7, 1);
+
+    matrix.drawString(6, 2, timeString, length, 1);
+    matrix.display();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Checks drawBitmap() against drawing the same bitmap pixel by
+            pixel, for every rotation, raster operation and an offset on
+            every bit position, partly off the display. Then prints the
+            time per blit of both, on a 4x3 panel.
+*/
+/**************************************************************************/
+void benchmarkBitmaps() {
+    MAX7219CWGMatrix reference(4, 3, CS_PIN);
+    SpriteSheet sheet;
+    const uint8_t rotations[] = {STANDARD_ROTATION, UPSIDE_DOWN_ROTATION, CLOCKWISE_ROTATION, COUNTERCLOCKWISE_ROTATION,
+                                 STANDARD_ROTATION | MIRRORED_ROTATION, UPSIDE_DOWN_ROTATION | MIRRORED_ROTATION,
+                                 CLOCKWISE_ROTATION | MIRRORED_ROTATION, COUNTERCLOCKWISE_ROTATION | MIRRORED_ROTATION};
+    uint32_t blits = 0;
+    uint32_t mismatches = 0;
+
+    sheet.begin(sprites);
+    matrix.initialiseMatrix(4, 3, CS_PIN);
+    matrix.setTransport(&recorder);
+    reference.setTransport(&recorder);
+
+    for (uint8_t r = 0; r < sizeof(rotations); r++) {
+        matrix.setRotation(rotations[r]);
+        reference.setRotation(rotations[r]);
+
+        for (uint8_t op = RASTER_OP_COPY; op <= RASTER_OP_MASK; op++) {
+            for (uint16_t index = 0; index < sheet.getNumSprites(); index++) {
+                for (int16_t x = -9; x < 12; x++) {
+                    int16_t y = x - 3;
+
+                    drawBackground(matrix);
+                    drawBackground(reference);
+                    sheet.draw(&matrix, x, y, index, op);
+                    drawBitmapPixels(reference, x, y, sheet.getBitmap(index), sheet.getWidth(index), sheet.getHeight(index), op, sheet.getMask(index));
+                    blits++;
+
+                    for (uint16_t px = 0; px < matrix.getWidth(); px++) {
+                        for (uint16_t py = 0; py < matrix.getHeight(); py++) {
+                            if (matrix.getPixel(px, py) != reference.getPixel(px, py)) {
+                                mismatches++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    Serial.println("Bitmap check");
+    Serial.print("blits: ");
+    Serial.print(blits);
+    Serial.print(", differing pixels: ");
+    Serial.println(mismatches);
+
+    /* Throughput of a 16x16 sprite on an odd column */
+    matrix.setRotation(UPSIDE_DOWN_ROTATION);
+    const uint8_t* bitmap = sheet.getBitmap(1);
+    uint32_t start;
+    uint32_t oldTime;
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        drawBitmapPixels(matrix, 3 + (i & 7), 2, bitmap, 16, 16, RASTER_OP_COPY, nullptr);
+    }
+    oldTime = micros() - start;
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        matrix.drawBitmap(3 + (i & 7), 2, bitmap, 16, 16, RASTER_OP_COPY);
+    }
+    uint32_t newTime = micros() - start;
+
+    Serial.println("Bitmap benchmark (us per 16x16 blit)");
+    Serial.println("op\tpixel path\tblit\tMpixels/s");
+    Serial.print("copy\t");
+    Serial.print((float) oldTime / ITERATIONS);
+    Serial.print("\t");
+    Serial.print((float) newTime / ITERATIONS);
+    Serial.print("\t");
+    Serial.println((float) ITERATIONS*16*16 / newTime);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Fills a matrix with a diagonal pattern, so every raster
+            operation has both on and off pixels to work with.
+  @param    target          Matrix to draw on
+*/
+/**************************************************************************/
+void drawBackground(MAX7219CWGMatrix& target) {
+    for (uint16_t x = 0; x < target.getWidth(); x++) {
+        for (uint16_t y = 0; y < target.getHeight(); y++) {
+            target.drawPixel(x, y, ((x + 2*y) % 5) < 2);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a bitmap with drawPixel(), the way it was done before
+            drawBitmap() existed.
+  @param    target          Matrix to draw on
+  @param    x               X coordinate of the leftmost column
+  @param    y               Y coordinate of row 0
+  @param    bitmap          Packed rows
+  @param    w               Width in pixels
+  @param    h               Height in pixels
+  @param    rasterOp        Raster operation
+  @param    mask            Packed mask rows, nullptr if none
+*/
+/**************************************************************************/
+void drawBitmapPixels(MAX7219CWGMatrix& target, int16_t x, int16_t y, const uint8_t* bitmap, uint16_t w, uint16_t h, uint8_t rasterOp, const uint8_t* mask) {
+    uint16_t rowBytes = (w + 7) / 8;
+
+    for (uint16_t r = 0; r < h; r++) {
+        for (uint16_t c = 0; c < w; c++) {
+            uint8_t bit = 0x80 >> (c & 7);
+            int16_t px = x + c;
+            int16_t py = y + r;
+
+            if (px < 0 || py < 0 || px >= target.getWidth() || py >= target.getHeight()) {
+                continue;                                                   //Clipped
+            }
+            if (mask != nullptr && !(pgm_read_byte(mask + r*rowBytes + c/8) & bit)) {
+                continue;
+            }
+
+            bool source = pgm_read_byte(bitmap + r*rowBytes + c/8) & bit;
+            bool current = target.getPixel(px, py);
+            bool value = source;
+
+            if (rasterOp == RASTER_OP_OR) {
+                value = current || source;
+            } else if (rasterOp == RASTER_OP_AND) {
+                value = current && source;
+            } else if (rasterOp == RASTER_OP_XOR) {
+                value = current != source;
+            } else if (rasterOp == RASTER_OP_MASK) {
+                value = current && !source;
+            }
+            target.drawPixel(px, py, value);
+        }
+    }
+}
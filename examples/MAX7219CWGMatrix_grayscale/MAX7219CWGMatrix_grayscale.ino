@@ -0,0 +1,216 @@
+/*
+ * File:      MAX7219CWGMatrix_grayscale.ino
+ * Authors:   Luke de Munk
+ *
+ * Check of the grayscale mode of the MAX7219CWGMatrix library. Uses a
+ * recording transport and a simulated clock, so no display has to be
+ * connected. The recorded words are decoded into the latched state of
+ * the chips, the time every led is on is compared with its gray level.
+ * Also prints the sub-frame rate every panel size can sustain. Results
+ * are printed on the serial port. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+
+#define CS_PIN          14
+#define WIDTH           4                                                   //4 segments horizontal
+#define HEIGHT          2                                                   //2 segments vertical
+#define PERIODS         20                                                  //Grayscale periods to average over
+#define TIME_STEP       10                                                  //Simulated us per update
+#define ITERATIONS      100                                                 //Sub-frames per timed panel size
+
+MAX7219CWGMatrix matrix;
+MAX7219Event events[WIDTH*HEIGHT*ROW_SIZE + 2*ROW_SIZE];                    //One sub-frame
+MAX7219RecordingTransport recorder(events, sizeof(events)/sizeof(events[0]));
+
+uint8_t latched[WIDTH*HEIGHT][ROW_SIZE];                                    //Digit registers of every chip
+uint32_t onTime[WIDTH*COLUMN_SIZE][HEIGHT*ROW_SIZE];
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the checks once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    Serial.println("Grayscale brightness check");
+    Serial.println("bpp\tlevels\tmax error %");
+
+    for (uint8_t bitsPerPixel = 2; bitsPerPixel <= MAX_BITS_PER_PIXEL; bitsPerPixel++) {
+        checkBrightness(bitsPerPixel);
+    }
+
+    benchmarkSubFrames();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws every gray level, runs the sub-frames on a simulated
+            clock and prints the largest difference between the time a
+            led is on and its level.
+  @param    bitsPerPixel    Bits per pixel (2 to MAX_BITS_PER_PIXEL)
+*/
+/**************************************************************************/
+void checkBrightness(uint8_t bitsPerPixel) {
+    uint8_t levels = 1 << bitsPerPixel;
+
+    /* Progressive wiring keeps decoding simple: word n of a frame is segment n */
+    matrix.initialiseMatrix(WIDTH, HEIGHT, CS_PIN, PROGRESSIVE_WIRING);
+    matrix.setTransport(&recorder);
+    matrix.setGrayscale(bitsPerPixel);
+
+    for (uint8_t x = 0; x < matrix.getWidth(); x++) {
+        for (uint8_t y = 0; y < matrix.getHeight(); y++) {
+            matrix.drawPixel(x, y, (x + y*matrix.getWidth()) % levels);
+        }
+    }
+
+    memset(latched, 0, sizeof(latched));
+    memset(onTime, 0, sizeof(onTime));
+
+    uint32_t period = matrix.getSubFrameTime() * (levels - 1);
+    uint32_t now = 0;
+
+    /* Start on a period boundary, then add up the on time */
+    matrix.updateGrayscale(now);
+    decodeEvents();
+
+    for (now = TIME_STEP; now <= PERIODS*period; now += TIME_STEP) {
+        addOnTime(TIME_STEP);
+        matrix.updateGrayscale(now);
+        decodeEvents();
+    }
+
+    float maxError = 0;
+
+    for (uint8_t x = 0; x < matrix.getWidth(); x++) {
+        for (uint8_t y = 0; y < matrix.getHeight(); y++) {
+            float expected = (float) ((x + y*matrix.getWidth()) % levels) / (levels - 1);
+            float error = fabs((float) onTime[x][y] / (PERIODS*period) - expected);
+
+            if (error > maxError) {
+                maxError = error;
+            }
+        }
+    }
+
+    Serial.print(bitsPerPixel);
+    Serial.print("\t");
+    Serial.print(levels);
+    Serial.print("\t");
+    Serial.println(maxError * 100);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Applies the recorded frames to the latched state of the chips.
+*/
+/**************************************************************************/
+void decodeEvents() {
+    uint16_t position = 0;
+
+    for (uint16_t i = 0; i < recorder.getNumEvents(); i++) {
+        MAX7219Event event = recorder.getEvent(i);
+
+        if (event.type == EVENT_CS_LOW) {
+            position = 0;
+        } else if (event.type == EVENT_WORD) {
+            uint8_t digit = event.word >> 8;
+
+            if (digit >= 1 && digit <= ROW_SIZE) {
+                latched[position][digit-1] = event.word & 0xFF;
+            }
+            position++;
+        }
+    }
+    recorder.reset();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Adds time to every led that is latched on.
+  @param    time            Time in us
+*/
+/**************************************************************************/
+void addOnTime(uint32_t time) {
+    for (uint16_t segment = 0; segment < WIDTH*HEIGHT; segment++) {
+        for (uint8_t r = 0; r < ROW_SIZE; r++) {
+            uint8_t data = latched[segment][ROW_SIZE-1 - r];                //Digit 8 - r holds buffer row r
+
+            for (uint8_t b = 0; b < COLUMN_SIZE; b++) {
+                if (data & (0x80 >> b)) {
+                    onTime[(segment % WIDTH)*COLUMN_SIZE + b][(segment / WIDTH)*ROW_SIZE + r] += time;
+                }
+            }
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the time one sub-frame takes for every panel size, and
+            the grayscale refresh rate that follows from it. The least
+            significant sub-frame can not be shorter than one sub-frame.
+*/
+/**************************************************************************/
+void benchmarkSubFrames() {
+    MAX7219RecordingTransport counter;
+
+    Serial.println("Sub-frame rate (10MHz bus)");
+    Serial.println("HxV\tcpu us\tbus us\tsub-frames/s\t2bpp Hz\t3bpp Hz\t4bpp Hz");
+
+    for (uint8_t v = 1; v <= 4; v++) {
+        for (uint8_t h = 1; h <= 8; h *= 2) {
+            matrix.initialiseMatrix(h, v, CS_PIN);
+            matrix.setTransport(&counter);
+            matrix.setClock(MAX7219_MAX_SPI_CLOCK);
+            matrix.setGrayscale(MAX_BITS_PER_PIXEL, 1);
+
+            /* Every plane differs, so every sub-frame sends all rows */
+            for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+                for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+                    matrix.drawPixel(x, y, (x + y) & 0x0F);
+                }
+            }
+
+            uint32_t now = 0;
+            matrix.updateGrayscale(now);
+            counter.reset();
+
+            uint32_t start = micros();
+            for (uint16_t i = 0; i < ITERATIONS; i++) {
+                now += 1 << MAX_BITS_PER_PIXEL;                             //Always due
+                matrix.updateGrayscale(now);
+            }
+            float cpuTime = (float) (micros() - start) / ITERATIONS;
+            float busTime = (float) counter.getBusTime() / ITERATIONS;
+            float rate = 1000000 / (cpuTime + busTime);
+
+            Serial.print(h);
+            Serial.print("x");
+            Serial.print(v);
+            Serial.print("\t");
+            Serial.print(cpuTime);
+            Serial.print("\t");
+            Serial.print(busTime);
+            Serial.print("\t");
+            Serial.print(rate);
+
+            for (uint8_t bitsPerPixel = 2; bitsPerPixel <= MAX_BITS_PER_PIXEL; bitsPerPixel++) {
+                Serial.print("\t");
+                Serial.print(rate / ((1 << bitsPerPixel) - 1));
+            }
+            Serial.println();
+        }
+    }
+}
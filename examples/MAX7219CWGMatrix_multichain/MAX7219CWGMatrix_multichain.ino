@@ -0,0 +1,242 @@
+/*
+ * File:      MAX7219CWGMatrix_multichain.ino
+ * Authors:   Luke de Munk
+ *
+ * Simulation of a display driven by several chains that flush in
+ * parallel. Every chain is a recording transport that takes as long as
+ * the real bus would and sends on its own thread, like the flush task
+ * of the SPI transport does on the ESP32. Prints the frame time of one
+ * chain and of 2 and 4 chains, and the speedup. Then checks a display
+ * split into a left and a right chain, with every wiring, on simulated
+ * chips. No display has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <atomic>
+#include <thread>
+#include "MAX7219CWGMatrix.h"
+#include "MAX7219Simulator.h"
+
+#define CS_PIN          14
+#define WIDTH           8                                                   //8 segments horizontal
+#define HEIGHT          4                                                   //4 segments vertical
+#define FRAMES          50                                                  //Frames per measurement
+#define SPLIT_WIDTH     4                                                   //Split display, a 2x2 chain per half
+#define SPLIT_HEIGHT    2
+#define U               SEGMENT_FLIPPED                                     //Chip mounted upside down
+
+/* Wiring of the split display and, per half, the chain position of every
+ * chip as seen from the front, row by row from the top left */
+struct SplitCase {
+    const char* name;
+    uint8_t wiringType;
+    uint16_t map[SPLIT_WIDTH*SPLIT_HEIGHT];                                 //Only for CUSTOM_WIRING
+    uint16_t left[4];
+    uint16_t right[4];
+};
+
+const SplitCase SplitCases[] = {
+    {"zigzag", ZIGZAG_WIRING, {}, {0, 1, U|3, U|2}, {0, 1, U|3, U|2}},
+    {"serpentine", SERPENTINE_WIRING, {}, {0, 1, 3, 2}, {0, 1, 3, 2}},
+    {"progressive", PROGRESSIVE_WIRING, {}, {0, 1, 2, 3}, {0, 1, 2, 3}},
+    {"column", COLUMN_WIRING, {}, {0, 2, 1, 3}, {0, 2, 1, 3}},
+    {"custom", CUSTOM_WIRING, {U|7, 2, 5, U|0, 3, U|6, 1, 4}, {U|3, 0, 1, U|2}, {3, U|0, 1, 2}}
+};
+
+/* Recording transport that sends in the background on its own thread */
+class ThreadedRecordingTransport : public MAX7219RecordingTransport {
+	public:
+        ~ThreadedRecordingTransport() {
+            if (_thread.joinable()) {
+                _thread.join();
+            }
+        }
+
+        void writeAsync(const uint8_t* data, uint16_t frameLength, uint8_t numFrames) {
+            if (_thread.joinable()) {
+                _thread.join();                                             //One job at a time
+            }
+
+            _busy = true;
+            _thread = std::thread([=]() {
+                for (uint8_t f = 0; f < numFrames; f++) {
+                    write(data + f*frameLength, frameLength);
+                }
+                _busy = false;
+                _complete();
+            });
+        }
+
+        bool isBusy() {
+            return _busy;
+        }
+
+	private:
+        std::thread _thread;
+        std::atomic<bool> _busy{false};
+};
+
+MAX7219CWGMatrix matrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219RecordingTransport recorder;                                         //Single chain
+uint32_t singleTime;
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the simulation once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    Serial.println("Multi-chain simulation");
+    Serial.println("chains\twords\tus/frame\tspeedup");
+
+    /* One chain, the reference */
+    recorder.setBusDelay(true);
+    matrix.setTransport(&recorder);
+    matrix.setClock(MAX7219_MAX_SPI_CLOCK);
+    singleTime = measureFrames();
+    printResult(1, recorder.getWords(), singleTime);
+
+    simulateChains(2);
+    simulateChains(4);
+
+    matrix.setTransport(&recorder);
+
+    checkSplitChains();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Splits the display into bands of segment rows, one chain per
+            band, and measures the frame time.
+  @param    numChains       Number of chains, a divider of HEIGHT
+*/
+/**************************************************************************/
+void simulateChains(uint8_t numChains) {
+    ThreadedRecordingTransport chains[MAX7219_MAX_CHAINS];
+    MAX7219MultiChainTransport transport(WIDTH, HEIGHT);
+    uint8_t bandHeight = HEIGHT / numChains;
+
+    for (uint8_t c = 0; c < numChains; c++) {
+        chains[c].setBusDelay(true);
+        transport.addChain(&chains[c], CS_PIN + c, 0, c*bandHeight, WIDTH, bandHeight);
+    }
+
+    matrix.setTransport(&transport);
+    matrix.setClock(MAX7219_MAX_SPI_CLOCK);
+
+    uint32_t time = measureFrames();
+    uint32_t words = 0;
+
+    for (uint8_t c = 0; c < numChains; c++) {
+        words += chains[c].getWords();
+    }
+    printResult(numChains, words, time);
+
+    matrix.setTransport(&recorder);                                         //Transport goes out of scope
+}
+
+/**************************************************************************/
+/*!
+  @brief    Splits a display into a left and a right chain of 2x2 chips
+            and checks every led of both against the matrix, for every
+            wiring.
+*/
+/**************************************************************************/
+void checkSplitChains() {
+    MAX7219CWGMatrix split(SPLIT_WIDTH, SPLIT_HEIGHT, CS_PIN);
+    MAX7219Simulator left(SPLIT_WIDTH/2, SPLIT_HEIGHT);
+    MAX7219Simulator right(SPLIT_WIDTH/2, SPLIT_HEIGHT);
+    MAX7219MultiChainTransport transport(SPLIT_WIDTH, SPLIT_HEIGHT);
+    uint16_t halfWidth = left.getWidth();
+
+    transport.addChain(&left, CS_PIN, 0, 0, SPLIT_WIDTH/2, SPLIT_HEIGHT);
+    transport.addChain(&right, CS_PIN + 1, SPLIT_WIDTH/2, 0, SPLIT_WIDTH/2, SPLIT_HEIGHT);
+    split.setTransport(&transport);
+    split.setPower(true);
+
+    Serial.println("split\terrors");
+
+    for (uint8_t i = 0; i < sizeof(SplitCases)/sizeof(SplitCases[0]); i++) {
+        const SplitCase& test = SplitCases[i];
+
+        if (test.wiringType == CUSTOM_WIRING) {
+            split.setWiringMap(test.map);
+        } else {
+            split.setWiring(test.wiringType);
+        }
+        left.setLayout(test.left);
+        right.setLayout(test.right);
+
+        /* Irregular pattern, every segment differs in every turn */
+        for (uint16_t y = 0; y < split.getHeight(); y++) {
+            for (uint16_t x = 0; x < split.getWidth(); x++) {
+                split.drawPixel(x, y, (x*7 + y*13 + x*y) % 3 == 0);
+            }
+        }
+        split.display();
+
+        uint32_t errors = 0;
+        for (uint16_t y = 0; y < split.getHeight(); y++) {
+            for (uint16_t x = 0; x < split.getWidth(); x++) {
+                bool led = x < halfWidth ? left.getPixel(x, y) : right.getPixel(x - halfWidth, y);
+
+                if (led != split.getPixel(x, y)) {
+                    errors++;
+                }
+            }
+        }
+
+        Serial.print(test.name);
+        Serial.print("\t");
+        Serial.println(errors);
+        if (errors != 0) {
+            Serial.println("FAILED: split chains show another image");
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws and flushes FRAMES frames in which every row changes.
+  @returns  Total time in us
+*/
+/**************************************************************************/
+uint32_t measureFrames() {
+    uint32_t start = micros();
+
+    for (uint16_t i = 0; i < FRAMES; i++) {
+        matrix.drawFillRectangle(0, 0, matrix.getWidth(), matrix.getHeight(), i & 1);
+        matrix.displayAsync();
+    }
+    matrix.waitForFlush();
+
+    return micros() - start;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints one line of results.
+  @param    numChains       Number of chains
+  @param    words           Words sent by all chains together
+  @param    time            Total time of FRAMES frames in us
+*/
+/**************************************************************************/
+void printResult(uint8_t numChains, uint32_t words, uint32_t time) {
+    Serial.print(numChains);
+    Serial.print("\t");
+    Serial.print(words);
+    Serial.print("\t");
+    Serial.print((float) time / FRAMES);
+    Serial.print("\t");
+    Serial.println((float) singleTime / time);
+}
@@ -0,0 +1,338 @@
+/*
+ * File:      MAX7219CWGMatrix_segments.ino
+ * Authors:   Luke de Munk
+ *
+ * Check of the commands for single segments of the MAX7219CWGMatrix
+ * library. Every chip-select frame is recorded and decoded per chain
+ * position: the addressed chips must get their intensity, shutdown or
+ * scan limit command, every other chip a no-op. Also checks the frames
+ * of power saving. The chain positions are written out below for the
+ * display upright and upside down. No display has to be connected.
+ * Results are printed on the serial port. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+
+#define CS_PIN          14
+#define WIDTH           3                                                   //3 segments horizontal
+#define HEIGHT          2                                                   //2 segments vertical
+#define NUM_SEGMENTS    (WIDTH*HEIGHT)
+#define LOG_SIZE        1024                                                //Recorded events
+
+/* Chain position of every segment of the zigzag wiring, index is
+ * segmentY*WIDTH + segmentX in drawing coordinates. Position 0 is sent
+ * first */
+const uint16_t UprightPositions[NUM_SEGMENTS] = {
+    0, 1, 2,
+    5, 4, 3
+};
+const uint16_t UpsideDownPositions[NUM_SEGMENTS] = {
+    3, 4, 5,
+    2, 1, 0
+};
+
+MAX7219CWGMatrix matrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219Event events[LOG_SIZE];
+MAX7219RecordingTransport recorder(events, LOG_SIZE);
+
+uint16_t numChecks = 0;
+uint16_t numFailed = 0;
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the checks once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    matrix.setTransport(&recorder);
+    matrix.setPower(true);
+
+    Serial.println("Segment commands");
+    Serial.println("check\tresult");
+
+    checkSegmentCommands("upright", UprightPositions);
+
+    matrix.setRotation(UPSIDE_DOWN_ROTATION);
+    checkSegmentCommands("upside_down", UpsideDownPositions);
+    matrix.setRotation(STANDARD_ROTATION);
+
+    checkPowerSaving();
+
+    Serial.print("checks: ");
+    Serial.print(numChecks);
+    Serial.print(", failed: ");
+    Serial.println(numFailed);
+    if (numFailed != 0) {
+        Serial.println("FAILED: a chip got another command");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Checks the commands for one segment on every segment, and a
+            frame with a command per segment.
+  @param    name            Name of the rotation
+  @param    positions       Chain position per segment in drawing
+                            coordinates
+*/
+/**************************************************************************/
+void checkSegmentCommands(const char name[], const uint16_t positions[]) {
+    bool intensity = true;
+    bool clamped = true;
+    bool shutdown = true;
+    bool wakeup = true;
+    bool scanLimit = true;
+
+    for (uint8_t segmentY = 0; segmentY < HEIGHT; segmentY++) {
+        for (uint8_t segmentX = 0; segmentX < WIDTH; segmentX++) {
+            uint16_t position = positions[segmentY*WIDTH + segmentX];
+
+            recorder.reset();
+            matrix.setSegmentIntensity(segmentX, segmentY, 9);
+            intensity &= isSingleCommand(position, OPCODE_INTENSITY | 9);
+
+            recorder.reset();
+            matrix.setSegmentIntensity(segmentX, segmentY, 20);
+            clamped &= isSingleCommand(position, OPCODE_INTENSITY | MAX_INTENSITY);
+
+            recorder.reset();
+            matrix.setSegmentPower(segmentX, segmentY, false);
+            shutdown &= isSingleCommand(position, OPCODE_ENABLE | 0);
+
+            recorder.reset();
+            matrix.setSegmentPower(segmentX, segmentY, true);
+            wakeup &= isSingleCommand(position, OPCODE_ENABLE | 1);
+
+            recorder.reset();
+            matrix.setSegmentScanLimit(segmentX, segmentY, 3);
+            scanLimit &= isSingleCommand(position, OPCODE_SCAN_LIMIT | 3);
+        }
+    }
+
+    /* Mixed commands, every other segment untouched */
+    const uint16_t commands[NUM_SEGMENTS] = {
+        OPCODE_INTENSITY | 2, OPCODE_NOOP, OPCODE_SCAN_LIMIT | 5,
+        OPCODE_NOOP, OPCODE_ENABLE | 0, OPCODE_NOOP
+    };
+    uint16_t expected[NUM_SEGMENTS];
+
+    for (uint8_t i = 0; i < NUM_SEGMENTS; i++) {
+        expected[positions[i]] = commands[i];
+    }
+
+    recorder.reset();
+    matrix.sendSegmentCommands(commands);
+    bool mixed = isFrames(expected, 1);
+
+    printCheck(name, "intensity", intensity);
+    printCheck(name, "intensity_clamped", clamped);
+    printCheck(name, "shutdown", shutdown);
+    printCheck(name, "wakeup", wakeup);
+    printCheck(name, "scan_limit", scanLimit);
+    printCheck(name, "segment_commands", mixed);
+
+    matrix.setPower(true);                                                  //Undo the mixed commands
+    matrix.setScanLimit(ROW_SIZE-1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Checks that display() shuts down blank segments and turns lit
+            ones back on, in one frame before the rows and only when a
+            segment changes state.
+*/
+/**************************************************************************/
+void checkPowerSaving() {
+    uint16_t expected[NUM_SEGMENTS];
+
+    matrix.clear();
+    matrix.display();
+    matrix.setPowerSaving(true);
+
+    /* Only the top left segment has a led on, the others shut down */
+    matrix.drawPixel(0, 0, 1);
+    recorder.reset();
+    matrix.display();
+
+    for (uint8_t i = 0; i < NUM_SEGMENTS; i++) {
+        expected[UprightPositions[i]] = i == 0 ? OPCODE_NOOP : OPCODE_ENABLE | 0;
+    }
+    printCheck("power_saving", "blank_off", isFirstFrame(expected));
+
+    /* Nothing changed, nothing is sent */
+    recorder.reset();
+    matrix.display();
+    printCheck("power_saving", "unchanged", recorder.getTransactions() == 0);
+
+    /* A led on in the bottom right segment turns only that one on */
+    matrix.drawPixel(matrix.getWidth() - 1, matrix.getHeight() - 1, 1);
+    recorder.reset();
+    matrix.display();
+
+    for (uint8_t i = 0; i < NUM_SEGMENTS; i++) {
+        expected[UprightPositions[i]] = i == NUM_SEGMENTS-1 ? OPCODE_ENABLE | 1 : OPCODE_NOOP;
+    }
+    printCheck("power_saving", "lit_on", isFirstFrame(expected));
+
+    /* Turning it off turns every segment back on, in one broadcast */
+    recorder.reset();
+    matrix.setPowerSaving(false);
+
+    for (uint8_t i = 0; i < NUM_SEGMENTS; i++) {
+        expected[i] = OPCODE_ENABLE | 1;
+    }
+    printCheck("power_saving", "disabled", isFrames(expected, 1));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if exactly one frame was recorded, with a command for
+            one chain position and a no-op for every other chip.
+  @param    position        Chain position of the addressed chip
+  @param    command         Command it must get
+  @returns  True if so
+*/
+/**************************************************************************/
+bool isSingleCommand(uint16_t position, uint16_t command) {
+    uint16_t expected[NUM_SEGMENTS];
+
+    for (uint8_t i = 0; i < NUM_SEGMENTS; i++) {
+        expected[i] = i == position ? command : OPCODE_NOOP;
+    }
+    return isFrames(expected, 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the recorded frames are a number of times the same
+            frame.
+  @param    expected        Word per chain position
+  @param    numFrames       Number of frames that must be recorded
+  @returns  True if so
+*/
+/**************************************************************************/
+bool isFrames(const uint16_t expected[], uint8_t numFrames) {
+    uint16_t words[NUM_SEGMENTS];
+
+    if (countFrames() != numFrames) {
+        return false;
+    }
+    for (uint8_t f = 0; f < numFrames; f++) {
+        if (!decodeFrame(f, words) || memcmp(words, expected, sizeof(words)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the first recorded frame is the expected frame,
+            followed by row frames only.
+  @param    expected        Word per chain position
+  @returns  True if so
+*/
+/**************************************************************************/
+bool isFirstFrame(const uint16_t expected[]) {
+    uint16_t words[NUM_SEGMENTS];
+
+    if (!decodeFrame(0, words) || memcmp(words, expected, sizeof(words)) != 0) {
+        return false;
+    }
+    for (uint8_t f = 1; f < countFrames(); f++) {
+        if (!decodeFrame(f, words)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < NUM_SEGMENTS; i++) {
+            uint8_t address = words[i] >> 8;
+
+            if (address < 1 || address > ROW_SIZE) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the number of recorded chip-select frames.
+  @returns  Number of frames
+*/
+/**************************************************************************/
+uint8_t countFrames() {
+    uint8_t frames = 0;
+
+    for (uint16_t e = 0; e < recorder.getNumEvents(); e++) {
+        frames += recorder.getEvent(e).type == EVENT_CS_HIGH;
+    }
+    return frames;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Decodes a recorded chip-select frame per chain position. The
+            first word is shifted to the end of the chain, position 0.
+  @param    index           Index of the frame
+  @param    words           Word per chain position
+  @returns  True if the frame has one word per chip
+*/
+/**************************************************************************/
+bool decodeFrame(uint8_t index, uint16_t words[]) {
+    uint16_t e = 0;
+
+    if (recorder.isOverflowed()) {
+        return false;
+    }
+
+    /* Skip to the start of the frame */
+    for (uint8_t f = 0; f < index; e++) {
+        if (e >= recorder.getNumEvents()) {
+            return false;
+        }
+        f += recorder.getEvent(e).type == EVENT_CS_HIGH;
+    }
+
+    if (e >= recorder.getNumEvents() || recorder.getEvent(e++).type != EVENT_CS_LOW) {
+        return false;
+    }
+
+    uint16_t position = 0;
+    for (; e < recorder.getNumEvents() && recorder.getEvent(e).type == EVENT_WORD; e++) {
+        if (position >= NUM_SEGMENTS) {
+            return false;
+        }
+        words[position++] = recorder.getEvent(e).word;
+    }
+    return position == NUM_SEGMENTS && e < recorder.getNumEvents() && recorder.getEvent(e).type == EVENT_CS_HIGH;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints and counts the result of one check.
+  @param    group           Group of the check
+  @param    name            Name of the check
+  @param    passed          True if the check passed
+*/
+/**************************************************************************/
+void printCheck(const char group[], const char name[], bool passed) {
+    numChecks++;
+    numFailed += !passed;
+
+    Serial.print(group);
+    Serial.print("/");
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.println(passed ? "ok" : "differs");
+}
@@ -0,0 +1,209 @@
+/*
+ * File:      MAX7219CWGMatrix_wiring.ino
+ * Authors:   Luke de Munk
+ *
+ * Check of the wiring and rotation mapping of the MAX7219CWGMatrix
+ * library. Every pixel is drawn on its own, with every wiring and every
+ * rotation, mirrored ones included, and sent to simulated chips. Exactly
+ * one led may go on: the one a reference mapping expects, by chain
+ * position, digit register and bit. The reference is written from the
+ * panel: chain positions per wiring in the tables below, the image
+ * turned in quarter steps and the layout of the leds of a module. No
+ * display has to be connected. Results are printed on the serial port.
+ * For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+#include "MAX7219Simulator.h"
+
+#define CS_PIN          14
+#define WIDTH           3                                                   //3 segments horizontal
+#define HEIGHT          2                                                   //2 segments vertical
+#define NUM_SEGMENTS    (WIDTH*HEIGHT)
+#define U               SEGMENT_FLIPPED                                     //Chip mounted upside down
+
+/* Chain position of every chip as seen from the front, row by row from
+ * the top left. Position 0 is the end of the chain */
+struct Wiring {
+    const char* name;
+    uint8_t wiringType;
+    uint16_t positions[NUM_SEGMENTS];
+};
+
+const Wiring Wirings[] = {
+    {"zigzag", ZIGZAG_WIRING, {0, 1, 2, U|5, U|4, U|3}},
+    {"serpentine", SERPENTINE_WIRING, {0, 1, 2, 5, 4, 3}},
+    {"progressive", PROGRESSIVE_WIRING, {0, 1, 2, 3, 4, 5}},
+    {"column", COLUMN_WIRING, {0, 2, 4, 1, 3, 5}},
+    {"custom", CUSTOM_WIRING, {U|4, 0, U|3, 5, U|1, 2}}
+};
+
+/* Rotations and the quarter turns clockwise of the image on the panel */
+struct Rotation {
+    const char* name;
+    uint8_t rotation;
+    uint8_t quarterTurns;
+    bool mirrored;
+};
+
+const Rotation Rotations[] = {
+    {"standard", STANDARD_ROTATION, 0, false},
+    {"clockwise", CLOCKWISE_ROTATION, 1, false},
+    {"upside_down", UPSIDE_DOWN_ROTATION, 2, false},
+    {"counterclockwise", COUNTERCLOCKWISE_ROTATION, 3, false},
+    {"standard_mirrored", STANDARD_ROTATION | MIRRORED_ROTATION, 0, true},
+    {"clockwise_mirrored", CLOCKWISE_ROTATION | MIRRORED_ROTATION, 1, true},
+    {"upside_down_mirrored", UPSIDE_DOWN_ROTATION | MIRRORED_ROTATION, 2, true},
+    {"counterclockwise_mirrored", COUNTERCLOCKWISE_ROTATION | MIRRORED_ROTATION, 3, true}
+};
+
+MAX7219CWGMatrix matrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219Simulator chips(WIDTH, HEIGHT);                                      //Only its registers are read
+
+uint16_t numChecks = 0;
+uint16_t numFailed = 0;
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the check once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    matrix.setTransport(&chips);
+    matrix.setPower(true);
+
+    Serial.println("Wiring and rotation mapping");
+    Serial.println("wiring\trotation\tpixels\tdiffer");
+
+    for (uint8_t w = 0; w < sizeof(Wirings)/sizeof(Wirings[0]); w++) {
+        if (Wirings[w].wiringType == CUSTOM_WIRING) {
+            matrix.setWiringMap(Wirings[w].positions);
+        } else {
+            matrix.setWiring(Wirings[w].wiringType);
+        }
+
+        for (uint8_t r = 0; r < sizeof(Rotations)/sizeof(Rotations[0]); r++) {
+            checkPixels(w, r);
+        }
+    }
+    matrix.setWiring(ZIGZAG_WIRING);
+    matrix.setRotation(STANDARD_ROTATION);
+
+    Serial.print("checks: ");
+    Serial.print(numChecks);
+    Serial.print(", failed: ");
+    Serial.println(numFailed);
+    if (numFailed != 0) {
+        Serial.println("FAILED: a pixel lit another led");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws every pixel on its own and checks the led that goes on.
+  @param    w               Index of the wiring in Wirings
+  @param    r               Index of the rotation in Rotations
+*/
+/**************************************************************************/
+void checkPixels(uint8_t w, uint8_t r) {
+    const Wiring& wiring = Wirings[w];
+    const Rotation& rotation = Rotations[r];
+    uint16_t panelWidth = WIDTH*COLUMN_SIZE;
+    uint16_t panelHeight = HEIGHT*ROW_SIZE;
+    bool turned = rotation.quarterTurns % 2 == 1;
+    uint16_t width = turned ? panelHeight : panelWidth;
+    uint16_t height = turned ? panelWidth : panelHeight;
+    uint32_t differ = 0;
+
+    matrix.setRotation(rotation.rotation);
+    matrix.clear();
+    matrix.display();
+
+    if (matrix.getWidth() != width || matrix.getHeight() != height) {
+        differ = width*height;
+    }
+
+    for (uint16_t y = 0; y < height && differ == 0; y++) {
+        for (uint16_t x = 0; x < width; x++) {
+            matrix.drawPixel(x, y, 1);
+            matrix.display();
+
+            /* Where the reference puts the pixel on the panel */
+            uint16_t panelX = rotation.mirrored ? width-1 - x : x;
+            uint16_t panelY = y;
+            uint16_t turnWidth = width;
+            uint16_t turnHeight = height;
+
+            for (uint8_t q = 0; q < rotation.quarterTurns; q++) {
+                uint16_t turnedX = turnHeight-1 - panelY;                   //A quarter clockwise: the left column becomes the top row
+                panelY = panelX;
+                panelX = turnedX;
+
+                uint16_t swap = turnWidth;
+                turnWidth = turnHeight;
+                turnHeight = swap;
+            }
+
+            if (!isOnlyLed(w, panelX, panelY)) {
+                differ++;
+            }
+
+            matrix.drawPixel(x, y, 0);
+        }
+    }
+
+    numChecks++;
+    numFailed += differ != 0;
+
+    Serial.print(wiring.name);
+    Serial.print("\t");
+    Serial.print(rotation.name);
+    Serial.print("\t");
+    Serial.print(width*height);
+    Serial.print("\t");
+    Serial.println(differ);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the led of a panel pixel is the only led on. An
+            upright module has digit 7 as its top row and bit 7 as its
+            left column, a module upside down digit 0 and bit 0.
+  @param    w               Index of the wiring in Wirings
+  @param    panelX          X coordinate on the panel, from the left
+  @param    panelY          Y coordinate on the panel, from the top
+  @returns  True if so
+*/
+/**************************************************************************/
+bool isOnlyLed(uint8_t w, uint16_t panelX, uint16_t panelY) {
+    uint16_t chip = Wirings[w].positions[(panelY/ROW_SIZE)*WIDTH + panelX/COLUMN_SIZE];
+    uint16_t position = chip & ~U;
+    uint8_t row = panelY % ROW_SIZE;
+    uint8_t column = panelX % COLUMN_SIZE;
+    uint8_t digit = chip & U ? row : ROW_SIZE-1 - row;
+    uint8_t bit = chip & U ? column : COLUMN_SIZE-1 - column;
+
+    for (uint16_t p = 0; p < NUM_SEGMENTS; p++) {
+        const MAX7219Chip* registers = chips.getChip(p);
+
+        for (uint8_t d = 0; d < ROW_SIZE; d++) {
+            uint8_t expected = p == position && d == digit ? 1 << bit : 0;
+
+            if (registers->digits[d] != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
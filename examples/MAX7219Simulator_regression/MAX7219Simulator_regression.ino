@@ -0,0 +1,527 @@
+/*
+ * File:      MAX7219Simulator_regression.ino
+ * Authors:   Luke de Munk
+ *
+ * Regression and performance suite on the MAX7219Simulator. Runs on
+ * Linux: every draw primitive, every wiring and rotation and every screen
+ * of the SmartLedDisplay is drawn and sent to simulated chips. The image
+ * decoded from the register stream is compared with what the matrix holds
+ * and with a golden image in the golden folder next to this sketch, and
+ * written to OUTPUT_PATH as PBM. Every case and display() are timed. The
+ * panels are described by the tables below, written from the wiring
+ * diagram, never by the mapping of the library itself.
+ *
+ * After an intended change of the output, run once with
+ * SIMULATOR_UPDATE_GOLDEN=1 to write new golden images, look at them and
+ * commit them. No display has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include "SmartLedDisplay.h"
+#include "MAX7219Simulator.h"
+
+#define CS_PIN          14
+#define WIDTH           8                                                   //8 segments horizontal
+#define HEIGHT          4                                                   //4 segments vertical
+#define SCREEN_WIDTH    4                                                   //Segments of the SmartLedDisplay
+#define SCREEN_HEIGHT   3
+#define ITERATIONS      200                                                 //Repetitions per timed case
+#define OUTPUT_PATH     "/tmp/simulator"
+#define MAX_PBM_SIZE    4096
+
+MAX7219CWGMatrix matrix(WIDTH, HEIGHT, CS_PIN);
+MAX7219Simulator simulator(WIDTH, HEIGHT);
+MAX7219RecordingTransport recorder;                                         //Times display() without the simulator
+
+SmartLedDisplay display(SCREEN_WIDTH, SCREEN_HEIGHT, CS_PIN);
+MAX7219Simulator screenSimulator(SCREEN_WIDTH, SCREEN_HEIGHT);
+unsigned long simulatedTime = 0;
+
+bool updateGolden = false;
+uint16_t numCases = 0;
+uint16_t numFailed = 0;
+
+/* Chain position of every chip as seen from the front, row by row from
+ * the top left. U: mounted upside down */
+#define U               SEGMENT_FLIPPED
+
+const uint16_t ZigzagPanel[HEIGHT*WIDTH] = {
+      0,    1,    2,    3,    4,    5,    6,    7,
+    U|15, U|14, U|13, U|12, U|11, U|10, U|9,  U|8,
+     16,   17,   18,   19,   20,   21,   22,   23,
+    U|31, U|30, U|29, U|28, U|27, U|26, U|25, U|24
+};
+const uint16_t SerpentinePanel[HEIGHT*WIDTH] = {
+      0,    1,    2,    3,    4,    5,    6,    7,
+     15,   14,   13,   12,   11,   10,    9,    8,
+     16,   17,   18,   19,   20,   21,   22,   23,
+     31,   30,   29,   28,   27,   26,   25,   24
+};
+const uint16_t ProgressivePanel[HEIGHT*WIDTH] = {
+      0,    1,    2,    3,    4,    5,    6,    7,
+      8,    9,   10,   11,   12,   13,   14,   15,
+     16,   17,   18,   19,   20,   21,   22,   23,
+     24,   25,   26,   27,   28,   29,   30,   31
+};
+const uint16_t ColumnPanel[HEIGHT*WIDTH] = {
+      0,    4,    8,   12,   16,   20,   24,   28,
+      1,    5,    9,   13,   17,   21,   25,   29,
+      2,    6,   10,   14,   18,   22,   26,   30,
+      3,    7,   11,   15,   19,   23,   27,   31
+};
+const uint16_t* const Panels[] = {ZigzagPanel, SerpentinePanel, ProgressivePanel, ColumnPanel};
+
+const uint16_t ScreenPanel[SCREEN_HEIGHT*SCREEN_WIDTH] = {                 //Zigzag
+      0,    1,    2,    3,
+    U|7,  U|6,  U|5,  U|4,
+      8,    9,   10,   11
+};
+
+/* 16x8 arrow and its mask */
+const uint8_t arrow[] PROGMEM = {0x00, 0x80, 0x00, 0xC0, 0xFF, 0xE0, 0xFF, 0xF0, 0xFF, 0xF0, 0xFF, 0xE0, 0x00, 0xC0, 0x00, 0x80};
+const uint8_t arrowMask[] PROGMEM = {0x01, 0xC0, 0x01, 0xE0, 0xFF, 0xF0, 0xFF, 0xF8, 0xFF, 0xF8, 0xFF, 0xF0, 0x01, 0xE0, 0x01, 0xC0};
+
+struct Case {
+    const char* name;
+    void (*draw)();
+};
+
+/* One case per draw primitive, with clipping at every edge */
+const Case Primitives[] = {
+    {"pixel", []() {
+        matrix.drawPixel(0, 0, 1);
+        matrix.drawPixel(63, 31, 1);
+        matrix.drawPixel(7, 8, 1);
+        matrix.drawPixel(8, 7, 1);
+        matrix.drawPixel(-1, 5, 1);
+        matrix.drawPixel(64, 5, 1);
+    }},
+    {"line", []() {
+        matrix.drawLine(0, 0, 63, 31, 1);
+        matrix.drawLine(0, 31, 63, 0, 1);
+        matrix.drawLine(10, -5, 20, 40, 1);
+        matrix.drawLine(-10, 16, 80, 20, 1);
+    }},
+    {"line_angle", []() {
+        for (uint16_t angle = 0; angle < 360; angle += 30) {
+            matrix.drawLineAngle(31, 15, 14, angle, 1);
+        }
+    }},
+    {"line_fine_angle", []() {
+        for (uint16_t minute = 0; minute < 60; minute += 7) {
+            matrix.drawLineFineAngle(31, 15, 15, minute*FULL_ANGLE/60, 1);
+        }
+    }},
+    {"arc", []() {
+        matrix.drawArc(16, 16, 12, 0, FULL_ANGLE/4, 1);
+        matrix.drawArc(16, 16, 8, FULL_ANGLE/2, FULL_ANGLE/8, 1);
+        matrix.drawArc(48, 16, 14, 0, 0, 1);
+    }},
+    {"vline", []() {
+        matrix.drawVLine(0, 0, 32, 1);
+        matrix.drawVLine(9, 4, 10, 1);
+        matrix.drawVLine(63, -4, 12, 1);
+        matrix.drawVLine(30, 25, 0, 1);
+    }},
+    {"hline", []() {
+        matrix.drawHLine(0, 0, 64, 1);
+        matrix.drawHLine(3, 9, 30, 1);
+        matrix.drawHLine(-5, 31, 20, 1);
+        matrix.drawHLine(50, 20, 0, 1);
+    }},
+    {"rectangle", []() {
+        matrix.drawRectangle(0, 0, 64, 32, 1);
+        matrix.drawRectangle(5, 5, 20, 10, 1);
+        matrix.drawRectangle(50, 20, 30, 30, 1);
+    }},
+    {"fill_rectangle", []() {
+        matrix.drawFillRectangle(3, 3, 21, 13, 1);
+        matrix.drawFillRectangle(7, 6, 9, 5, 0);
+        matrix.drawFillRectangle(40, -3, 30, 12, 1);
+    }},
+    {"circle", []() {
+        matrix.drawCircle(15, 15, 14, 1);
+        matrix.drawCircle(45, 16, 5, 1);
+        matrix.drawCircle(63, 31, 10, 1);
+    }},
+    {"fill_circle", []() {
+        matrix.drawFillCircle(15, 15, 12, 1);
+        matrix.drawFillCircle(15, 15, 5, 0);
+        matrix.drawFillCircle(60, 2, 8, 1);
+    }},
+    {"triangle", []() {
+        matrix.drawTriangle(2, 29, 20, 2, 40, 25, 1);
+        matrix.drawTriangle(45, 5, 70, 15, 50, 40, 1);
+    }},
+    {"fill_triangle", []() {
+        matrix.drawFillTriangle(2, 29, 20, 2, 40, 25, 1);
+        matrix.drawFillTriangle(45, 5, 70, 15, 50, 40, 1);
+        matrix.drawFillTriangle(10, 10, 30, 10, 20, 10, 0);
+    }},
+    {"char", []() {
+        matrix.setFont(FONT_3X5);
+        matrix.drawChar(1, 1, 'A', 1);
+        matrix.setFont(FONT_4X6);
+        matrix.drawChar(10, 1, 'g', 1);
+        matrix.setFont(FONT_5X7);
+        matrix.drawChar(20, 1, '&', 1);
+        matrix.drawChar(62, 28, 'W', 1);
+    }},
+    {"row", []() {
+        matrix.drawRow(0, 0, 0xA5, 1);
+        matrix.drawRow(5, 10, 0xFF, 1);
+        matrix.drawRow(60, 20, 0xF0, 1);
+        matrix.drawRow(-4, 30, 0x0F, 1);
+    }},
+    {"string", []() {
+        matrix.setFont(FONT_3X5);
+        matrix.drawString(1, 1, "12:34", 5, 1);
+        matrix.setFont(FONT_4X6);
+        matrix.drawString(1, 9, "Monday", 6, 1);
+        matrix.setFont(FONT_5X7);
+        matrix.drawString(-3, 20, "Clipped text", 12, 1);
+        matrix.setFont(FONT_3X5);
+    }},
+    {"bitmap", []() {
+        matrix.drawFillRectangle(32, 0, 32, 32, 1);
+        matrix.drawBitmap(2, 2, arrow, 16, 8, RASTER_OP_COPY);
+        matrix.drawBitmap(2, 12, arrow, 16, 8, RASTER_OP_OR, arrowMask);
+        matrix.drawBitmap(36, 2, arrow, 16, 8, RASTER_OP_XOR);
+        matrix.drawBitmap(36, 12, arrow, 16, 8, RASTER_OP_MASK);
+        matrix.drawBitmap(54, 22, arrow, 16, 8, RASTER_OP_AND);
+    }},
+};
+
+/**************************************************************************/
+/*!
+  @brief    Simulated clock of the SmartLedDisplay, replaces millis().
+  @returns  simulatedTime   Time in ms
+*/
+/**************************************************************************/
+unsigned long simulatedClock() {
+    return simulatedTime;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the suite once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    updateGolden = getenv("SIMULATOR_UPDATE_GOLDEN") != nullptr;
+    mkdir(OUTPUT_PATH, 0755);
+
+    simulator.setLayout(ZigzagPanel);
+    screenSimulator.setLayout(ScreenPanel);
+    matrix.setTransport(&simulator);
+    matrix.setPower(true);
+
+    Serial.println("Simulator regression");
+    Serial.println("case\tus\tdecoded\tgolden");
+
+    for (uint8_t i = 0; i < sizeof(Primitives)/sizeof(Primitives[0]); i++) {
+        runCase(Primitives[i].name, Primitives[i].draw, true);
+    }
+
+    checkWirings();
+    checkRotations();
+    checkScreens();
+    benchmarkDisplay();
+
+    Serial.print("cases: ");
+    Serial.print(numCases);
+    Serial.print(", failed: ");
+    Serial.println(numFailed);
+    if (numFailed != 0) {
+        Serial.println("FAILED: output differs, see " OUTPUT_PATH);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws a case on the matrix, sends it to the simulator, checks
+            the decoded image and prints one line.
+  @param    name            Name of the case and the golden image
+  @param    draw            Draws the case
+  @param    timed           True to time draw
+*/
+/**************************************************************************/
+void runCase(const char name[], void (*draw)(), bool timed) {
+    uint32_t time = 0;
+
+    if (timed) {
+        uint32_t start = micros();
+        for (uint16_t i = 0; i < ITERATIONS; i++) {
+            draw();
+        }
+        time = micros() - start;
+    }
+
+    matrix.clear();
+    draw();
+    matrix.display();
+
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.print(timed ? (float) time / ITERATIONS : 0);
+    Serial.print("\t");
+    printResult(countDecodeErrors(matrix, simulator), checkGolden(name, simulator));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the string case with every wiring, on chips mounted that
+            way. The panel must show the same image every time.
+*/
+/**************************************************************************/
+void checkWirings() {
+    const char* names[] = {"wiring_zigzag", "wiring_serpentine", "wiring_progressive", "wiring_column"};
+
+    for (uint8_t wiring = ZIGZAG_WIRING; wiring <= COLUMN_WIRING; wiring++) {
+        matrix.setWiring(wiring);
+        simulator.setLayout(Panels[wiring]);
+        matrix.clear();
+        Primitives[15].draw();                                              //String
+        matrix.display();
+
+        Serial.print(names[wiring]);
+        Serial.print("\t-\t");
+        printResult(countDecodeErrors(matrix, simulator), checkGolden("string", simulator));
+    }
+
+    matrix.setWiring(ZIGZAG_WIRING);
+    simulator.setLayout(ZigzagPanel);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the string case with every rotation and inverted, the
+            panel shows it turned.
+*/
+/**************************************************************************/
+void checkRotations() {
+    const uint8_t rotations[] = {UPSIDE_DOWN_ROTATION, CLOCKWISE_ROTATION, COUNTERCLOCKWISE_ROTATION, STANDARD_ROTATION | MIRRORED_ROTATION};
+    const char* names[] = {"rotation_upside_down", "rotation_clockwise", "rotation_counterclockwise", "rotation_mirrored"};
+
+    for (uint8_t i = 0; i < sizeof(rotations); i++) {
+        matrix.setRotation(rotations[i]);
+        matrix.clear();
+        matrix.setFont(FONT_4X6);
+        matrix.drawString(1, 1, "Rot", 3, 1);
+        matrix.drawLine(0, 0, matrix.getWidth() - 1, matrix.getHeight() - 1, 1);
+        matrix.display();
+
+        Serial.print(names[i]);
+        Serial.print("\t-\t");
+        printResult(-1, checkGolden(names[i], simulator));
+    }
+    matrix.setRotation(STANDARD_ROTATION);
+    matrix.setFont(FONT_3X5);
+
+    matrix.setInverted(true);
+    runCase("inverted", Primitives[15].draw, false);
+    matrix.setInverted(false);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Shows every screen of the SmartLedDisplay at a fixed time,
+            checks it and times showScreenN().
+*/
+/**************************************************************************/
+void checkScreens() {
+    void (SmartLedDisplay::*screens[])() = {&SmartLedDisplay::showScreen1, &SmartLedDisplay::showScreen2, &SmartLedDisplay::showScreen3};
+    const char* names[] = {"screen1", "screen2", "screen3"};
+
+    display.setClockSource(simulatedClock);
+    display.setTime({12, 34, 56});
+
+    for (uint8_t i = 0; i < NUMBER_OF_SCREENS; i++) {
+        /* Time on the recorder, the simulator takes longer than the bus */
+        display.setTransport(&recorder);
+        uint32_t start = micros();
+        for (uint16_t n = 0; n < ITERATIONS; n++) {
+            (display.*screens[i])();
+        }
+        uint32_t time = micros() - start;
+
+        display.setTransport(&screenSimulator);
+        (display.*screens[i])();
+
+        Serial.print(names[i]);
+        Serial.print("\t");
+        Serial.print((float) time / ITERATIONS);
+        Serial.print("\t");
+        printResult(-1, checkGolden(names[i], screenSimulator));
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Times display() for a full frame and for an unchanged frame,
+            on the recorder and on the simulator.
+*/
+/**************************************************************************/
+void benchmarkDisplay() {
+    MAX7219Transport* transports[] = {&recorder, &simulator};
+    const char* names[] = {"display_recorder", "display_simulator"};
+
+    for (uint8_t t = 0; t < 2; t++) {
+        matrix.setTransport(transports[t]);
+
+        /* Every row changes: alternate between two frames */
+        uint32_t start = micros();
+        for (uint16_t i = 0; i < ITERATIONS; i++) {
+            matrix.drawFillRectangle(0, 0, matrix.getWidth(), matrix.getHeight(), i & 1);
+            matrix.display();
+        }
+        uint32_t fullTime = micros() - start;
+
+        start = micros();
+        for (uint16_t i = 0; i < ITERATIONS; i++) {
+            matrix.display();
+        }
+        uint32_t unchangedTime = micros() - start;
+
+        Serial.print(names[t]);
+        Serial.print("\t");
+        Serial.print((float) fullTime / ITERATIONS);
+        Serial.print("\tunchanged ");
+        Serial.println((float) unchangedTime / ITERATIONS);
+    }
+    matrix.setTransport(&simulator);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Counts the leds that differ from the pixels of the matrix.
+            Only for the standard rotation, not inverted.
+  @param    source          Matrix that was sent
+  @param    chips           Simulator it was sent to
+  @returns  Number of differing pixels
+*/
+/**************************************************************************/
+uint32_t countDecodeErrors(MAX7219CWGMatrix& source, MAX7219Simulator& chips) {
+    uint32_t errors = 0;
+
+    for (uint16_t y = 0; y < chips.getHeight(); y++) {
+        for (uint16_t x = 0; x < chips.getWidth(); x++) {
+            if (chips.getPixel(x, y) != (bool) (source.getPixel(x, y) ^ source.getInverted())) {
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes the image of the simulator to OUTPUT_PATH and compares
+            it with the golden image, or replaces the golden image.
+  @param    name            Name of the image
+  @param    chips           Simulator
+  @returns  Number of differing pixels, -1 if there is no golden image
+*/
+/**************************************************************************/
+int32_t checkGolden(const char name[], MAX7219Simulator& chips) {
+    char image[MAX_PBM_SIZE];
+    char golden[MAX_PBM_SIZE];
+    uint32_t length = chips.toPbm(image, sizeof(image));
+
+    std::string directory = __FILE__;
+    directory = directory.substr(0, directory.rfind('/')) + "/golden/";
+    std::string goldenPath = directory + name + ".pbm";
+    std::string outputPath = std::string(OUTPUT_PATH "/") + name + ".pbm";
+
+    writeFile(outputPath.c_str(), image, length);
+    if (updateGolden) {
+        mkdir(directory.c_str(), 0755);
+        writeFile(goldenPath.c_str(), image, length);
+    }
+
+    FILE* file = fopen(goldenPath.c_str(), "rb");
+    if (file == nullptr) {
+        return -1;
+    }
+    uint32_t goldenLength = fread(golden, 1, sizeof(golden), file);
+    fclose(file);
+
+    /* Same header: count the differing pixels */
+    if (goldenLength != length || strncmp(image, golden, strchr(strchr(image, '\n') + 1, '\n') - image) != 0) {
+        return chips.getWidth()*chips.getHeight();
+    }
+
+    int32_t differences = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        if (image[i] != golden[i]) {
+            differences++;
+        }
+    }
+    return differences;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints the result of a case and counts it.
+  @param    decodeErrors    Pixels that differ from the matrix, -1 if
+                            not checked
+  @param    goldenErrors    Pixels that differ from the golden image, -1
+                            if there is none
+*/
+/**************************************************************************/
+void printResult(int32_t decodeErrors, int32_t goldenErrors) {
+    if (decodeErrors < 0) {
+        Serial.print("-\t");
+    } else {
+        Serial.print(decodeErrors);
+        Serial.print("\t");
+    }
+
+    if (goldenErrors < 0) {
+        Serial.println("missing");
+    } else if (goldenErrors == 0) {
+        Serial.println("ok");
+    } else {
+        Serial.print("differs ");
+        Serial.println(goldenErrors);
+    }
+
+    numCases++;
+    if (decodeErrors > 0 || goldenErrors != 0) {
+        numFailed++;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Writes a file.
+  @param    path            Path of the file
+  @param    data            Contents
+  @param    length          Number of bytes
+*/
+/**************************************************************************/
+void writeFile(const char path[], const char data[], uint32_t length) {
+    FILE* file = fopen(path, "wb");
+
+    if (file == nullptr) {
+        Serial.print("Could not create ");
+        Serial.println(path);
+        return;
+    }
+    fwrite(data, 1, length, file);
+    fclose(file);
+}
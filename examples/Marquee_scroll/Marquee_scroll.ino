@@ -0,0 +1,295 @@
+/*
+ * File:      Marquee_scroll.ino
+ * Authors:   Luke de Munk
+ *
+ * Check of the Marquee class. Three marquees with their own region,
+ * font, text and speed scroll at once on a simulated clock that runs
+ * over the 32-bit wrap of millis(), with steps of a few ms, of several
+ * steps at once and jumps of many loops. After every step the pixels
+ * of every region are compared with the text at the expected position:
+ * the start at the right edge, one pixel per step delay, starting again
+ * after a full loop, or staying empty when a marquee does not loop. The
+ * pixels around the regions may not change. No display has to be
+ * connected. Results are printed on the serial port. For more info,
+ * checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "MAX7219CWGMatrix.h"
+#include "Marquee.h"
+
+#define CS_PIN          14
+#define TICKS           3000                                                //Clock advances checked
+#define CLOCK_START     (0xFFFFFFFF - 20000)                                //millis() wraps during the check
+#define NUM_MARQUEES    3
+
+/* Region, text and speed of every marquee */
+struct MarqueeCase {
+    const char* name;
+    const char* text;
+    uint8_t font;
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t stepDelay;
+    bool loop;
+};
+
+const MarqueeCase MarqueeCases[NUM_MARQUEES] = {
+    {"full_width", "Monday 5 January", FONT_3X5, 0, 0, 32, 40, true},
+    {"odd_region", "12:34:56", FONT_5X7, 3, 7, 21, 25, true},
+    {"no_loop", "Alarm", FONT_4X6, 5, 16, 13, 60, false}
+};
+
+MAX7219CWGMatrix matrix(4, 3, CS_PIN);                                      //No transport, only the buffer is read
+Marquee marquees[NUM_MARQUEES];
+
+/* What every marquee should show */
+bool started[NUM_MARQUEES];
+bool finished[NUM_MARQUEES];
+uint32_t startMs[NUM_MARQUEES];
+uint32_t lastSteps[NUM_MARQUEES];
+uint16_t finishedTicks[NUM_MARQUEES];
+
+uint32_t numRedraws[NUM_MARQUEES];
+uint32_t numLoops[NUM_MARQUEES];
+uint32_t numDiffer[NUM_MARQUEES];
+
+/**************************************************************************/
+/*!
+  @brief    Setup the matrix and the marquees and run the check once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    uint32_t nowMs = CLOCK_START;
+    uint32_t seed = 1;
+    uint32_t backgroundDiffer = 0;
+
+    drawBackground();
+
+    for (uint8_t m = 0; m < NUM_MARQUEES; m++) {
+        const MarqueeCase& marqueeCase = MarqueeCases[m];
+
+        matrix.setFont(marqueeCase.font);
+        marquees[m].begin(&matrix, marqueeCase.x, marqueeCase.y, marqueeCase.width, marqueeCase.stepDelay);
+        marquees[m].setLoop(marqueeCase.loop);
+        marquees[m].setText(marqueeCase.text, strlen(marqueeCase.text));
+
+        if (marquees[m].getTextWidth() != getTextWidth(m)) {
+            numDiffer[m]++;
+        }
+    }
+
+    for (uint16_t tick = 0; tick < TICKS; tick++) {
+        for (uint8_t m = 0; m < NUM_MARQUEES; m++) {
+            checkStep(m, nowMs);
+        }
+        backgroundDiffer += checkBackground();
+
+        /* Mostly a few ms, sometimes several steps, now and then many loops */
+        seed = seed*1103515245 + 12345;
+        if (tick % 97 == 96) {
+            nowMs += 30000 + (seed >> 16) % 1000;
+        } else {
+            nowMs += (seed >> 16) % 130;
+        }
+    }
+
+    Serial.println("Marquee check");
+    Serial.println("marquee\tredraws\tloops\tdiffer");
+
+    uint32_t totalDiffer = backgroundDiffer;
+
+    for (uint8_t m = 0; m < NUM_MARQUEES; m++) {
+        Serial.print(MarqueeCases[m].name);
+        Serial.print("\t");
+        Serial.print(numRedraws[m]);
+        Serial.print("\t");
+        Serial.print(numLoops[m]);
+        Serial.print("\t");
+        Serial.println(numDiffer[m]);
+        totalDiffer += numDiffer[m];
+    }
+    Serial.print("background differ: ");
+    Serial.println(backgroundDiffer);
+
+    if (totalDiffer != 0) {
+        Serial.println("FAILED: a marquee showed another image than expected");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Steps a marquee and checks if it redrew when it should and
+            shows the text at the expected position. A marquee that does
+            not loop is restarted a while after it has finished.
+  @param    m               Index of the marquee
+  @param    nowMs           Time of the simulated clock in ms
+*/
+/**************************************************************************/
+void checkStep(uint8_t m, uint32_t nowMs) {
+    const MarqueeCase& marqueeCase = MarqueeCases[m];
+    int32_t period = marqueeCase.width - 1 + getTextWidth(m);               //Steps from the right edge until the text is in again
+    bool expectRedraw;
+
+    if (!started[m]) {
+        started[m] = true;
+        startMs[m] = nowMs;
+        lastSteps[m] = 0;
+        expectRedraw = true;
+    } else {
+        uint32_t steps = (nowMs - startMs[m]) / marqueeCase.stepDelay;      //Also right over the wrap of the clock
+
+        expectRedraw = !finished[m] && steps != lastSteps[m];
+        if (marqueeCase.loop && steps/period != lastSteps[m]/period) {
+            numLoops[m]++;
+        }
+        lastSteps[m] = steps;
+    }
+
+    if (!marqueeCase.loop && lastSteps[m] >= (uint32_t) period) {
+        finished[m] = true;
+    }
+
+    if (marquees[m].step(nowMs) != expectRedraw) {
+        numDiffer[m]++;
+    }
+    if (marquees[m].isFinished() != finished[m]) {
+        numDiffer[m]++;
+    }
+    if (expectRedraw) {
+        numRedraws[m]++;
+    }
+
+    /* Where the first column of the text is in the region */
+    int32_t cursor;
+
+    if (marqueeCase.loop) {
+        cursor = marqueeCase.width - 1 - (int32_t) (lastSteps[m] % period);
+    } else if (finished[m]) {
+        cursor = -(int32_t) getTextWidth(m);
+    } else {
+        cursor = marqueeCase.width - 1 - (int32_t) lastSteps[m];
+    }
+    numDiffer[m] += checkRegion(m, cursor);
+
+    if (finished[m] && ++finishedTicks[m] == 50) {
+        finishedTicks[m] = 0;
+        finished[m] = false;
+        started[m] = false;
+        marquees[m].restart();
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Compares the region of a marquee with its text drawn at a
+            position, pixel by pixel with the glyphs of its font.
+  @param    m               Index of the marquee
+  @param    cursor          Region x of the first column of the text
+  @returns  Number of differing pixels
+*/
+/**************************************************************************/
+uint32_t checkRegion(uint8_t m, int32_t cursor) {
+    const MarqueeCase& marqueeCase = MarqueeCases[m];
+    uint32_t differ = 0;
+
+    matrix.setFont(marqueeCase.font);
+
+    uint8_t cols = matrix.getFontCols();
+    int32_t textWidth = getTextWidth(m);
+
+    for (uint8_t row = 0; row < matrix.getFontRows(); row++) {
+        for (uint16_t k = 0; k < marqueeCase.width; k++) {
+            int32_t position = k - cursor;                                  //Column of the text
+            bool expected = false;
+
+            if (position >= 0 && position < textWidth && position % (cols+1) != cols) {
+                char character = marqueeCase.text[position / (cols+1)];
+                expected = matrix.getGlyphRow(character, row) & (0x80 >> (position % (cols+1)));
+            }
+
+            if ((bool) matrix.getPixel(marqueeCase.x + k, marqueeCase.y + row) != expected) {
+                differ++;
+            }
+        }
+    }
+    return differ;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the width of the text of a marquee, one empty column
+            after every character like drawString().
+  @param    m               Index of the marquee
+  @returns  Width in pixels
+*/
+/**************************************************************************/
+uint16_t getTextWidth(uint8_t m) {
+    matrix.setFont(MarqueeCases[m].font);
+    return strlen(MarqueeCases[m].text) * (matrix.getFontCols() + 1);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if a pixel lies in the region of a marquee.
+  @param    x               X coordinate
+  @param    y               Y coordinate
+  @returns  True if so
+*/
+/**************************************************************************/
+bool isInRegion(uint16_t x, uint16_t y) {
+    for (uint8_t m = 0; m < NUM_MARQUEES; m++) {
+        const MarqueeCase& marqueeCase = MarqueeCases[m];
+
+        matrix.setFont(marqueeCase.font);
+        if (x >= marqueeCase.x && x < marqueeCase.x + marqueeCase.width &&
+            y >= marqueeCase.y && y < marqueeCase.y + matrix.getFontRows()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Fills the matrix with a checkerboard, the marquees draw over
+            their own regions.
+*/
+/**************************************************************************/
+void drawBackground() {
+    for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+        for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+            matrix.drawPixel(x, y, (x + y) & 1);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Checks the checkerboard outside the regions is untouched.
+  @returns  Number of differing pixels
+*/
+/**************************************************************************/
+uint32_t checkBackground() {
+    uint32_t differ = 0;
+
+    for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+        for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+            if (!isInRegion(x, y) && matrix.getPixel(x, y) != ((x + y) & 1)) {
+                differ++;
+            }
+        }
+    }
+    return differ;
+}
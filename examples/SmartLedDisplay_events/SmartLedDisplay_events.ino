@@ -0,0 +1,171 @@
+/*
+ * File:      SmartLedDisplay_events.ino
+ * Authors:   Luke de Munk
+ *
+ * Simulation of an hour of the clock screen of the SmartLedDisplay, on
+ * a simulated clock and with a recording transport, so it runs without
+ * a display and without waiting. Compares rendering every 100 ms with
+ * rendering only when the shown second or minute changes, and checks
+ * that every change is rendered exactly once. The performance counters
+ * are checked against the recorded bus. Results are printed on the serial
+ * port. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "SmartLedDisplay.h"
+
+#define CS_PIN          14
+#define WIDTH           4                                                   //4 segments horizontal
+#define HEIGHT          3                                                   //3 segments vertical
+#define DURATION        3600000                                             //Simulated time in ms
+#define POLL_INTERVAL   100                                                 //Delay of the polling loop in ms
+
+SmartLedDisplay display(WIDTH, HEIGHT, CS_PIN);
+MAX7219RecordingTransport recorder;
+unsigned long simulatedTime = 0;
+
+/**************************************************************************/
+/*!
+  @brief    Simulated clock, replaces millis().
+  @returns  simulatedTime   Time in ms
+*/
+/**************************************************************************/
+unsigned long simulatedClock() {
+    return simulatedTime;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Setup the controller and run the simulation once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    display.setTransport(&recorder);
+    display.setClockSource(simulatedClock);
+
+    Serial.println("Event-driven redraw, one simulated hour");
+    Serial.println("loop\twakeups\trenders\twords\ttransactions\tframes\tskipped\tflush us");
+
+    /* Polling: render and send every 100 ms */
+    uint32_t wakeups = 0;
+    simulatedTime = 0;
+    recorder.reset();
+    Metrics::reset();
+
+    for (simulatedTime = 0; simulatedTime < DURATION; simulatedTime += POLL_INTERVAL) {
+        display.setTime(timeAt(simulatedTime));                             //Like asking the time server
+        display.showScreen1();
+        wakeups++;
+    }
+    printResult("polling", wakeups, wakeups);
+
+    /* Event-driven: with and without the second hand */
+    simulateEvents("seconds", DEPENDS_ON_SECOND, DURATION/1000);
+    simulateEvents("minutes", DEPENDS_ON_MINUTE, DURATION/60000 + 1);      //Starts halfway a minute
+}
+
+/**************************************************************************/
+/*!
+  @brief    Runs the clock screen event-driven: the loop sleeps until the
+            deadline and only renders when the shown time changed. Checks
+            that every second or minute is rendered exactly once.
+  @param    name            Name of the loop
+  @param    dependencies    DEPENDS_ON_ flags of the clock screen
+  @param    expected        Number of renders expected
+*/
+/**************************************************************************/
+void simulateEvents(const char* name, uint8_t dependencies, uint32_t expected) {
+    uint32_t renders = display.getNumRenders();
+    uint32_t wakeups = 0;
+    uint32_t changes = 0;
+    uint32_t lastKey = 0xFFFFFFFF;
+    bool failed = false;
+
+    simulatedTime = 0;
+    display.setTime(timeAt(0));
+    display.setScreenDependencies(0, dependencies);                         //Also forces the first render
+    recorder.reset();
+    Metrics::reset();
+
+    while (simulatedTime < DURATION) {
+        if (display.update()) {
+            Time time = display.getTime();
+            uint32_t key = time.hour*60 + time.minute;
+
+            if (dependencies & DEPENDS_ON_SECOND) {
+                key = key*60 + time.second;
+            }
+            if (key == lastKey) {
+                failed = true;                                              //Rendered twice
+            }
+            lastKey = key;
+            changes++;
+        }
+        wakeups++;
+        simulatedTime += display.getTimeToUpdate();
+    }
+    printResult(name, wakeups, display.getNumRenders() - renders);
+
+    if (failed || changes != expected) {
+        Serial.println("FAILED: not every change rendered exactly once");
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Prints one line of results.
+  @param    name            Name of the loop
+  @param    wakeups         Times the loop woke up
+  @param    renders         Times the screen was rendered
+*/
+/**************************************************************************/
+void printResult(const char* name, uint32_t wakeups, uint32_t renders) {
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.print(wakeups);
+    Serial.print("\t");
+    Serial.print(renders);
+    Serial.print("\t");
+    Serial.print(recorder.getWords());
+    Serial.print("\t");
+    Serial.print(recorder.getTransactions());
+    Serial.print("\t");
+    Serial.print(Metrics::getCounter(COUNTER_FRAMES));
+    Serial.print("\t");
+    Serial.print(Metrics::getCounter(COUNTER_SKIPPED_FRAMES));
+    Serial.print("\t");
+    Serial.println(Metrics::getAverageUs(TIMER_FLUSH));
+
+#if METRICS == 1
+    if (Metrics::getCounter(COUNTER_WORDS) != recorder.getWords() || Metrics::getCounter(COUNTER_TRANSACTIONS) != recorder.getTransactions()) {
+        Serial.println("FAILED: counters differ from the recorded bus");
+    }
+#endif
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns the time of day, the simulation starts at 11:59:30.
+  @param    ms              Simulated time in ms
+  @returns  Time object
+*/
+/**************************************************************************/
+Time timeAt(uint32_t ms) {
+    uint32_t seconds = 11*3600 + 59*60 + 30 + ms/1000;
+    Time time;
+
+    time.hour = (seconds / 3600) % 24;
+    time.minute = (seconds / 60) % 60;
+    time.second = seconds % 60;
+    return time;
+}
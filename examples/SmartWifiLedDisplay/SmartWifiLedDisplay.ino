@@ -3,24 +3,26 @@
  * Author:    Luke de Munk
  * 
  * Example file to test the SmartLedDisplay library with webcontrols.
- * For more info, checkout:
+ * The files in data are served gzip compressed: after editing one, make
+ * the .gz again with 'gzip -9 -n -k -f <file>'. For more info, checkout:
  * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
  */
-#include <NTPClient.h>
 #include <WiFiUdp.h>
 #include "WiFi.h"
 #include "ESPAsyncWebServer.h"
 #include "SPIFFS.h"
 #include "SmartLedDisplay.h"
+#include "ClockService.h"
+#include "AssetCache.h"
 #include "Debugger.h"                                                       //For serial debugging
 
 #define SSID            "YOUR SSID"
 #define PASSWORD        "YOUR PASSWORD"
 AsyncWebServer server(80);                                                  //Create AsyncWebServer object on port 80
 
-/* Define NTP Client to get time */
+/* Time from a NTP server, synchronised in the background */
 WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP);
+ClockService clockService;
 
 /* Pins */
 #define CLOCK_OUT_PIN   18                                                  //Use hardware SPI GPIO clock pin for your hardware
@@ -30,9 +32,27 @@ NTPClient timeClient(ntpUDP);
 #define WIDTH           4                                                   //4 segments horizontal
 #define HEIGHT          3                                                   //3 segments vertical
 
+#define METRICS_JSON_SIZE   1024                                            //Fits all counters and histograms
+#define STATE_JSON_SIZE     96
+
 SmartLedDisplay display(WIDTH, HEIGHT, CS_PIN);                             //Create a SmartLedDisplay object
 
-uint8_t screen = 0;
+TaskHandle_t loopTask;                                                      //Woken by the routes when the state changes
+
+/* State asked for by the routes. Only used in the web server task, the
+ * display gets it through commands, applied by the loop between frames */
+struct Settings {
+    bool power;
+    uint8_t intensity;
+    uint8_t screen;
+    bool inverted;
+    uint32_t version;                                                       //Changes with every change of the state
+};
+Settings settings;
+
+/* Files served from RAM, the page rendered once per state version */
+AssetCache assets;
+PageTemplate page;
 
 /**************************************************************************/
 /*!
@@ -41,13 +61,13 @@ uint8_t screen = 0;
 /**************************************************************************/
 String processor(const String& var){
     if (var == "POWER") {
-        return (String) display.getPower();
+        return (String) settings.power;
     } else if (var == "INTENSITY") {
-        return (String) display.getIntensity();
+        return (String) settings.intensity;
     } else if (var == "SCREEN") {
-        return (String) screen;
+        return (String) settings.screen;
     } else if (var == "INVERTED") {
-        return (String) display.getInverted();
+        return (String) settings.inverted;
     } else {
         return " placeholder_error ";
     }
@@ -61,6 +81,14 @@ String processor(const String& var){
 /**************************************************************************/
 void setup() {
     Serial.begin(115200);                                                   //Serial port for debugging purposes
+    loopTask = xTaskGetCurrentTaskHandle();                                 //setup() runs in the loop task
+
+    settings.power = display.getPower();
+    settings.intensity = display.getIntensity();
+    settings.screen = display.getScreen();
+    settings.inverted = display.getInverted();
+    settings.version = 0;
+    display.setTransition(TRANSITION_SLIDE);                                //Screens slide in from the right
     
     /* Initialize SPIFFS */
     if(!SPIFFS.begin(true)){
@@ -80,95 +108,133 @@ void setup() {
     debug("IP: ");
     debugln(WiFi.localIP());
 
-    timeClient.begin();                                                     //Initialize a NTPClient to get time
-    timeClient.setTimeOffset(3600);                                         //GMT +2 = 7200 (for summer time), GMT +1 = 3600 (for winter time)
+    clockService.begin(&ntpUDP);                                            //First request is sent by the loop
+    clockService.setTimeOffset(3600);                                       //GMT +2 = 7200 (for summer time), GMT +1 = 3600 (for winter time)
 
     /*
     *  Routes for loading all the necessary files
     */
-    /* Load index.html file */
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/index.html", String(), false, processor);
-    });
-    
-    /* Load style.css file */
-    server.on("/style.css", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/style.css", "text/css");
-    });
+    /* Page template, rendered when the state changed since the last load */
+    File indexFile = SPIFFS.open("/index.html", "r");
+    String index = indexFile.readString();
+    indexFile.close();
+    page.begin(index.c_str(), index.length(), processor);
 
-    /* Load style_mobile.css file */
-    server.on("/style_mobile.css", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/style_mobile.css", "text/css");
-    });
+    /* Hot files first, files past the RAM budget are read from flash */
+    assets.addFile(SPIFFS, "/base.js", "text/javascript");
+    assets.addFile(SPIFFS, "/switches.js", "text/javascript");
+    assets.addFile(SPIFFS, "/style.css", "text/css");
+    assets.addFile(SPIFFS, "/style_mobile.css", "text/css");
+    assets.addFile(SPIFFS, "/style_switches.css", "text/css");
+    assets.addFile(SPIFFS, "/jquery.min.js", "text/javascript");
+    assets.addFile(SPIFFS, "/favicon.ico", "image/x-icon");
 
-    /* Load style_switches.css file */
-    server.on("/style_switches.css", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/style_switches.css", "text/css");
-    });
+    /* Load index.html file */
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+        page.render(settings.version);
 
-    /* Load favicon.ico file */
-    server.on("/favicon.ico", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/favicon.ico", "image/x-icon");
-    });
+        if (isNotModified(request, page.getEtag())) {
+            sendNotModified(request, page.getEtag());
+            return;
+        }
 
-    /* Load jquery.min.js file */
-    server.on("/jquery.min.js", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/jquery.min.js", "text/script");
+        /* Copied, so a later render can not change a response that is still being sent */
+        AsyncWebServerResponse *response = request->beginResponse(200, "text/html", page.getPage());
+        response->addHeader("ETag", page.getEtag());
+        response->addHeader("Cache-Control", "no-cache");                   //Revalidate, the state may have changed
+        request->send(response);
     });
 
-    /* Load switches.js file */
-    server.on("/switches.js", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/switches.js", "text/script");
-    });
+    /* Load the other files */
+    for (uint16_t i = 0; i < assets.getNumAssets(); i++) {
+        const Asset* asset = assets.getAsset(i);
 
-    /* Load base.js file */
-    server.on("/base.js", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send(SPIFFS, "/base.js", "text/script");
-    });
+        server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest *request){
+            sendAsset(request, asset);
+        });
+    }
     /*
     * End of file loading
     */
 
-    /*
-    * Routes for receiving data
-    */
-    /* Route for power */
-    server.on("/set_power", HTTP_GET, [](AsyncWebServerRequest *request){
+    /* Route for reading and changing the state, changes may be batched:
+     * /state?power=1&intensity=7. A change the display can not queue is
+     * not stored, the rest of the batch is skipped */
+    server.on("/state", HTTP_GET, [](AsyncWebServerRequest *request){
+        bool changed = false;
+        bool queued = true;
+
         if (request->hasParam("power")) {
             bool power = (bool) atoi(request->getParam("power")->value().c_str());
-            display.setPower(power);
-        }
-        request->send(SPIFFS, "/index.html", String(), false, processor);
-    });
 
-    /* Route for updating intensity */
-    server.on("/set_intensity", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (request->hasParam("intensity")) {
-            uint8_t intensity = (uint8_t) atoi(request->getParam("intensity")->value().c_str());
-            display.setIntensity(intensity);
+            queued = display.post(COMMAND_POWER, power);
+            if (queued) {
+                settings.power = power;
+                changed = true;
+            }
         }
-        request->send(SPIFFS, "/index.html", String(), false, processor);
-    });
+        if (queued && request->hasParam("intensity")) {
+            uint8_t intensity = (uint8_t) atoi(request->getParam("intensity")->value().c_str());
 
-    /* Route for updating screen */
-    server.on("/set_screen", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (request->hasParam("screen")) {
-            screen = (uint8_t) atoi(request->getParam("screen")->value().c_str());
+            queued = display.post(COMMAND_INTENSITY, intensity);
+            if (queued) {
+                settings.intensity = intensity;
+                changed = true;
+            }
         }
-        request->send(SPIFFS, "/index.html", String(), false, processor);
-    });
+        if (queued && request->hasParam("screen")) {
+            uint8_t screen = (uint8_t) atoi(request->getParam("screen")->value().c_str());
 
-    /* Route for updating */
-    server.on("/set_invert", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (request->hasParam("inverted")) {
+            queued = display.post(COMMAND_SCREEN, screen);
+            if (queued) {
+                settings.screen = screen;
+                changed = true;
+            }
+        }
+        if (queued && request->hasParam("inverted")) {
             bool inverted = (bool) atoi(request->getParam("inverted")->value().c_str());
-            display.setInverted(inverted);
+
+            queued = display.post(COMMAND_INVERTED, inverted);
+            if (queued) {
+                settings.inverted = inverted;
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            settings.version++;
+            wakeLoop();
+        }
+
+        /* Command queue full, the client may try again */
+        if (!queued) {
+            AsyncWebServerResponse *response = request->beginResponse(503, "application/json", "{\"error\":\"display busy\"}");
+            response->addHeader("Retry-After", "1");
+            response->addHeader("Cache-Control", "no-store");
+            request->send(response);
+            return;
         }
-        request->send(SPIFFS, "/index.html", String(), false, processor);
+
+        char json[STATE_JSON_SIZE];
+        snprintf(json, sizeof(json), "{\"version\":%lu,\"power\":%d,\"intensity\":%d,\"screen\":%d,\"inverted\":%d}",
+                 (unsigned long) settings.version, settings.power, settings.intensity, settings.screen, settings.inverted);
+
+        AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
     });
-    /*
-    * End of data receiving
-    */
+
+#if METRICS == 1
+    /* Route for the performance counters */
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+        char json[METRICS_JSON_SIZE];
+        Metrics::toJson(json, sizeof(json));
+
+        AsyncWebServerResponse *response = request->beginResponse(200, "application/json", json);
+        response->addHeader("Cache-Control", "no-store");                   //Counters change every request
+        request->send(response);
+    });
+#endif
 
     server.begin();                                                         //Start server
 }
@@ -176,48 +242,104 @@ void setup() {
 
 /**************************************************************************/
 /*!
-  @brief    Mainloop.
+  @brief    Mainloop. Only renders when the shown state changed, then
+            sleeps until the display or the clock service has work, or
+            until a route wakes it. Send 'm' on the serial port to print
+            the performance counters.
 */
 /**************************************************************************/
 void loop() {
     updateTime();
-    
-    switch (screen) {
-    case 0:
-        display.showScreen1();
-        break;
-
-    case 1:
-        display.showScreen2();
-        break;
-
-    case 2:
-        display.showScreen3();
-        break;
-    
-    default:
-        break;
+    display.update();
+
+#if METRICS == 1
+    if (Serial.available() > 0 && Serial.read() == 'm') {
+        Metrics::print();
     }
-    delay(100);
+#endif
+
+    uint32_t timeToUpdate = min(display.getTimeToUpdate(), clockService.getTimeToUpdate(millis()));
+    ulTaskNotifyTake(pdTRUE, timeToUpdate == NO_DEADLINE ? portMAX_DELAY : pdMS_TO_TICKS(timeToUpdate));
 }
 
 /**************************************************************************/
 /*!
-  @brief    Visits the UDP server and updates the time of the display.
+  @brief    Wakes the main loop to show changed state.
 */
 /**************************************************************************/
-void updateTime() {
-    Time t;
-    
-    while (!timeClient.update()) {
-        timeClient.forceUpdate();
+void wakeLoop() {
+    xTaskNotifyGive(loopTask);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns if the browser already has this version of a file.
+  @param    request         Request
+  @param    etag            ETag of the file
+  @returns  True if a 304 can be sent
+*/
+/**************************************************************************/
+bool isNotModified(AsyncWebServerRequest *request, const char etag[]) {
+    if (!request->hasHeader("If-None-Match")) {
+        return false;
     }
-    
-    String formattedTime = timeClient.getFormattedTime();
+    return AssetCache::isNotModified(etag, request->header("If-None-Match").c_str());
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends a 304 Not Modified, without a body.
+  @param    request         Request
+  @param    etag            ETag of the file
+*/
+/**************************************************************************/
+void sendNotModified(AsyncWebServerRequest *request, const char etag[]) {
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    request->send(response);
+}
 
-    t.hour = atoi(formattedTime.substring(0, 2).c_str());
-    t.minute = atoi(formattedTime.substring(3, 5).c_str());
-    t.second = atoi(formattedTime.substring(6, 8).c_str());
+/**************************************************************************/
+/*!
+  @brief    Sends a file from the asset cache, from RAM if it is cached
+            and otherwise from flash, compressed if it is stored that way.
+  @param    request         Request
+  @param    asset           File to send
+*/
+/**************************************************************************/
+void sendAsset(AsyncWebServerRequest *request, const Asset* asset) {
+    if (isNotModified(request, asset->etag)) {
+        sendNotModified(request, asset->etag);
+        return;
+    }
+
+    AsyncWebServerResponse *response;
+    if (asset->data != nullptr) {
+        response = request->beginResponse_P(200, asset->contentType, asset->data, asset->length);
+    } else {
+        response = request->beginResponse(SPIFFS, asset->file, asset->contentType);
+    }
+
+    if (asset->gzip) {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", ASSET_MAX_AGE);
+    request->send(response);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Handles the time server without waiting for it, and passes the
+            drift corrected time to the display.
+*/
+/**************************************************************************/
+void updateTime() {
+    uint32_t now = millis();
 
-    display.setTime(t);
+    clockService.update(now);
+
+    if (clockService.isSynced()) {
+        display.setTime(clockService.getTime(now), clockService.getMillis(now));
+    }
 }
@@ -14,23 +14,55 @@ $(document).ready(function() {
     updateButtons();
 });
 
+var pendingState = {};                                                      //Changes not sent yet
+var stateTimer = null;
+
 /**************************************************************************/
 /*!
-  @brief    Sends the intensity to the display.
+  @brief    Sends changes of the state to the display. Changes made within
+            50 ms are sent together in one request. When the display is
+            busy (503), the changes are sent again a second later.
+  @param    changes     Object with the changed settings
 */
 /**************************************************************************/
-$("#intensity").change(
-    function() {
-        intensity = $(this).val();
+function sendState(changes) {
+    $.extend(pendingState, changes);
+
+    if (stateTimer != null) {
+        return;
+    }
+
+    stateTimer = setTimeout(function() {
+        var data = pendingState;
+        pendingState = {};
+        stateTimer = null;
+
         $.ajax({
-            url: "/set_intensity",
+            url: "/state",
             type: "get",
-            data: {
-                intensity: intensity
-                },
+            data: data,
+            dataType: "json",
             success: function(response) {},
-            error: function(xhr) {}
+            error: function(xhr) {
+                if (xhr.status == 503) {
+                    setTimeout(function() {
+                        sendState($.extend(data, pendingState));            //Newer changes win
+                    }, 1000);
+                }
+            }
         });
+    }, 50);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends the intensity to the display.
+*/
+/**************************************************************************/
+$("#intensity").change(
+    function() {
+        intensity = $(this).val();
+        sendState({intensity: intensity});
     }
 );
 
@@ -76,15 +108,7 @@ $("#screen3Btn").click(
 */
 /**************************************************************************/
 function setScreen() {
-    $.ajax({
-        url: "/set_screen",
-        type: "get",
-        data: {
-            screen: screen
-            },
-        success: function(response) {},
-        error: function(xhr) {}
-    });
+    sendState({screen: screen});
     updateButtons();
 }
 
@@ -22,16 +22,7 @@ $(document).ready(function() {
 /**************************************************************************/
 function setPower() {
     power = document.getElementById("cb_power").checked ? 1 : 0;
-
-    $.ajax({
-        url: "/set_power",
-        type: "get",
-        data: {
-            power: power
-            },
-        success: function(response) {},
-        error: function(xhr) {}
-    });
+    sendState({power: power});
 }
 
 /**************************************************************************/
@@ -41,14 +32,5 @@ function setPower() {
 /**************************************************************************/
 function setInversed() {
     inverted = document.getElementById("cb_inversed").checked ? 1 : 0;
-
-    $.ajax({
-        url: "/set_invert",
-        type: "get",
-        data: {
-            inverted: inverted
-            },
-        success: function(response) {},
-        error: function(xhr) {}
-    });
+    sendState({inverted: inverted});
 }
\ No newline at end of file
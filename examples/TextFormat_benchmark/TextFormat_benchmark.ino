@@ -0,0 +1,333 @@
+/*
+ * File:      TextFormat_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Heap and speed benchmark of the text formatting. Every format is run
+ * the old way (sprintf with the names in String objects) and with
+ * TextFormat, the outputs are compared, and the print functions of the
+ * SmartLedDisplay are run on a recording transport. Counts the heap
+ * allocations per call by replacing operator new, on Linux malloc() is
+ * counted too, and times the calls with Metrics::cycles().
+ * No display has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "SmartLedDisplay.h"
+
+#define CS_PIN          14
+#define WIDTH           8                                                   //8 segments horizontal
+#define HEIGHT          2                                                   //2 segments vertical
+#define CALLS           100000                                              //Calls per format
+#define CHECK_CALLS     10000                                               //Calls of which the outputs are compared
+
+SmartLedDisplay display(WIDTH, HEIGHT, CS_PIN);
+MAX7219RecordingTransport recorder;
+
+volatile uint32_t allocations = 0;
+volatile uint32_t allocatedBytes = 0;
+volatile uint32_t sink = 0;                                                 //Keeps the compiler from removing the calls
+
+/* The old way: names in String objects, as SmartLedDisplay had them */
+String legacyMonths[NUMBER_OF_MONTHS] = {JANUARY, FEBRUARY, MARCH, APRIL, MAY, JUNE, JULY, AUGUST, SEPTEMBER, OCTOBER, NOVEMBER, DECEMBER};
+String legacyDays[NUMBER_OF_DAYS] = {MONDAY, TUESDAY, WEDNESDAY, THURSDAY, FRIDAY, SATURDAY, SUNDAY};
+
+struct LegacyLongDate {
+    String dayName;
+    uint8_t day;
+    uint8_t month;
+};
+
+/* Counts every allocation, the heap itself is not changed */
+void* operator new(size_t size) {
+    allocations++;
+    allocatedBytes += size;
+    void* pointer = malloc(size);
+    if (pointer == nullptr) {
+        abort();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t /*size*/) noexcept {
+    free(pointer);
+}
+
+#if defined(__GLIBC__)
+/* On Linux malloc() is counted too, operator new above goes through it */
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+extern "C" void* malloc(size_t size) {
+    allocations++;
+    allocatedBytes += size;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    allocations++;
+    allocatedBytes += count*size;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+    allocations++;
+    allocatedBytes += size;
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+/**************************************************************************/
+/*!
+  @brief    Setup the display and run the benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    display.setTransport(&recorder);
+    display.setTime(Time{12, 34, 56});
+
+    if (!checkFormats()) {
+        return;
+    }
+
+    /* A String too long to be stored inside the object has to be counted */
+    allocations = 0;
+    String probe("Wednesday 17 September, long enough for the heap");
+    if (allocations == 0) {
+        Serial.println("NOTE: Allocations are not counted on this platform.");
+    }
+
+    Serial.println("Text format benchmark");
+    Serial.println("format\t\t\tallocs/call\tbytes/call\tns/call");
+    runCase("time sprintf\t\t", legacyTime, false);
+    runCase("time TextFormat\t\t", textTime, true);
+    runCase("short date sprintf\t", legacyShortDate, false);
+    runCase("short date TextFormat\t", textShortDate, true);
+    runCase("long date String\t", legacyLongDate, false);
+    runCase("long date TextFormat\t", textLongDate, true);
+    runCase("printDigitalTime\t", printTime, true);
+    runCase("printShortDate\t\t", printShortDate, true);
+    runCase("printLongDate\t\t", printLongDate, true);
+    runCase("printLongDate same date\t", printSameLongDate, true);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Formats the time of call i the old way.
+  @param    buffer          Buffer of at least 9 characters
+  @param    i               Call number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t legacyTime(char* buffer, uint32_t i) {
+    return sprintf(buffer, "%02d:%02d:%02d", (int) (i/60/60 % 24), (int) (i/60 % 60), (int) (i % 60));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Formats the time of call i with TextFormat.
+  @param    buffer          Buffer of at least 9 characters
+  @param    i               Call number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t textTime(char* buffer, uint32_t i) {
+    return TextFormat::time(buffer, i/60/60 % 24, i/60 % 60, i % 60);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Formats the short date of call i the old way.
+  @param    buffer          Buffer of at least 9 characters
+  @param    i               Call number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t legacyShortDate(char* buffer, uint32_t i) {
+    return sprintf(buffer, "%02d-%02d-%02d", (int) (1 + i % 31), (int) (1 + i % 12), (int) (i % 100));
+}
+
+/**************************************************************************/
+/*!
+  @brief    Formats the short date of call i with TextFormat.
+  @param    buffer          Buffer of at least 9 characters
+  @param    i               Call number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t textShortDate(char* buffer, uint32_t i) {
+    return TextFormat::shortDate(buffer, 1 + i % 31, 1 + i % 12, i % 100);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Formats the long date of call i the old way, the date is
+            passed by value like to printLongDate().
+  @param    buffer          Buffer of at least 32 characters
+  @param    i               Call number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t legacyLongDate(char* buffer, uint32_t i) {
+    LegacyLongDate date = {legacyDays[i % NUMBER_OF_DAYS], (uint8_t) (1 + i % 31), (uint8_t) (i % NUMBER_OF_MONTHS)};
+    return snprintf(buffer, 32, "%s %d %s", date.dayName.c_str(), date.day, legacyMonths[date.month].c_str());
+}
+
+/**************************************************************************/
+/*!
+  @brief    Formats the long date of call i with TextFormat.
+  @param    buffer          Buffer of at least 32 characters
+  @param    i               Call number
+  @returns  Length
+*/
+/**************************************************************************/
+uint8_t textLongDate(char* buffer, uint32_t i) {
+    return TextFormat::longDate(buffer, i % NUMBER_OF_DAYS, 1 + i % 31, i % NUMBER_OF_MONTHS);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the time with the display.
+  @param    buffer          Not used
+  @param    i               Call number
+  @returns  0
+*/
+/**************************************************************************/
+uint8_t printTime(char* /*buffer*/, uint32_t i) {
+    display.printDigitalTime(0, 1, i & 1);
+    return 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the short date of call i with the display.
+  @param    buffer          Not used
+  @param    i               Call number
+  @returns  0
+*/
+/**************************************************************************/
+uint8_t printShortDate(char* /*buffer*/, uint32_t i) {
+    Date date = {(uint8_t) (1 + i % 31), (uint8_t) (1 + i % 12), (uint8_t) (i % 100)};
+    display.printShortDate(0, 9, date, 1);
+    return 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the long date of call i with the display, the date
+            changes every call so the text is formatted every call.
+  @param    buffer          Not used
+  @param    i               Call number
+  @returns  0
+*/
+/**************************************************************************/
+uint8_t printLongDate(char* /*buffer*/, uint32_t i) {
+    LongDate date = {(uint8_t) (i % NUMBER_OF_DAYS), (uint8_t) (1 + i % 31), (uint8_t) (i % NUMBER_OF_MONTHS)};
+    display.printLongDate(0, 9, date, 1);
+    return 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Draws the same long date every call, like every frame of a
+            day, only the marquee is stepped.
+  @param    buffer          Not used
+  @param    i               Not used
+  @returns  0
+*/
+/**************************************************************************/
+uint8_t printSameLongDate(char* /*buffer*/, uint32_t /*i*/) {
+    LongDate date = {2, 17, 8};
+    display.printLongDate(0, 9, date, 1);
+    return 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Compares the outputs of the old way and TextFormat.
+  @returns  True if they are the same
+*/
+/**************************************************************************/
+bool checkFormats() {
+    uint8_t (*const pairs[][2])(char*, uint32_t) = {
+        {legacyTime, textTime}, {legacyShortDate, textShortDate}, {legacyLongDate, textLongDate}
+    };
+    char expected[32];
+    char actual[32];
+
+    for (uint8_t p = 0; p < sizeof(pairs)/sizeof(pairs[0]); p++) {
+        for (uint32_t i = 0; i < CHECK_CALLS; i++) {
+            uint8_t length = pairs[p][0](expected, i);
+
+            if (pairs[p][1](actual, i) != length || memcmp(expected, actual, length) != 0) {
+                Serial.print("FAILED: TextFormat differs from sprintf, expected ");
+                Serial.println(expected);
+                return false;
+            }
+        }
+    }
+    Serial.print("Outputs equal for ");
+    Serial.print(CHECK_CALLS);
+    Serial.println(" calls per format");
+    return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Runs a format CALLS times and prints the allocations and
+            the time per call.
+  @param    name            Name to print
+  @param    format          Format to run
+  @param    allocationFree  True if the format may not allocate
+*/
+/**************************************************************************/
+void runCase(const char name[], uint8_t (*format)(char*, uint32_t), bool allocationFree) {
+    char buffer[32] = {0};
+
+    format(buffer, 0);                                                      //Warm up, first use may allocate
+    allocations = 0;
+    allocatedBytes = 0;
+
+    uint32_t start = Metrics::cycles();
+    for (uint32_t i = 0; i < CALLS; i++) {
+        sink += format(buffer, i) + buffer[0];
+    }
+    uint32_t elapsed = Metrics::cycles() - start;
+
+    Serial.print(name);
+    Serial.print((float) allocations / CALLS);
+    Serial.print("\t\t");
+    Serial.print((float) allocatedBytes / CALLS);
+    Serial.print("\t\t");
+    Serial.println((float) elapsed * 1000 / Metrics::getCyclesPerUs() / CALLS);
+
+    if (allocationFree && allocations != 0) {
+        Serial.println("FAILED: allocates on the heap");
+    }
+}
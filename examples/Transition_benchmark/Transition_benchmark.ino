@@ -0,0 +1,412 @@
+/*
+ * File:      Transition_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Check and benchmark of the screen transitions. Runs on Linux: every
+ * slide, wipe and dissolve is stepped from one random frame to another
+ * with the framebuffer kernels, in every direction and rotation, and
+ * every step is compared pixel by pixel with what it should show. The
+ * scheduler of the SmartLedDisplay is run on a simulated clock. Then the
+ * transitions per second are timed for a 4x3 panel and the largest
+ * geometry, against redrawing every step with drawPixel(). No display
+ * has to be connected. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include "SmartLedDisplay.h"
+
+#define CS_PIN          14
+#define SMALL_WIDTH     4                                                   //4 segments horizontal
+#define SMALL_HEIGHT    3                                                   //3 segments vertical
+#define FRAMES          TRANSITION_FRAMES                                   //Steps per transition
+#define SECONDS         0.5                                                 //Time per timed case
+#define DISSOLVE_SEED   23                                                  //Moves the dither pattern
+
+MAX7219CWGMatrix small(SMALL_WIDTH, SMALL_HEIGHT, CS_PIN);
+MAX7219CWGMatrix large(MAX_HORIZONTAL_SEGMENTS, MAX_VERTICAL_SEGMENTS, CS_PIN);
+SmartLedDisplay display(SMALL_WIDTH, SMALL_HEIGHT, CS_PIN);
+MAX7219RecordingTransport recorder;
+
+const uint8_t Rotations[] = {STANDARD_ROTATION, UPSIDE_DOWN_ROTATION, CLOCKWISE_ROTATION, COUNTERCLOCKWISE_ROTATION | MIRRORED_ROTATION};
+const char* const TypeNames[] = {"none", "slide", "wipe", "dissolve"};
+const char* const DirectionNames[] = {"left", "right", "up", "down"};
+
+uint8_t* from;                                                              //Frame shown before the transition
+uint8_t* to;                                                                //Frame shown after
+unsigned long simulatedTime = 0;
+
+/**************************************************************************/
+/*!
+  @brief    Simulated clock, replaces millis().
+  @returns  simulatedTime   Time in ms
+*/
+/**************************************************************************/
+unsigned long simulatedClock() {
+    return simulatedTime;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Setup the matrices and run the check and benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    small.setTransport(&recorder);
+    large.setTransport(&recorder);
+
+    /* Frames of the largest geometry fit the small one too */
+    from = (uint8_t*) malloc(large.getFrameSize());
+    to = (uint8_t*) malloc(large.getFrameSize());
+
+    uint32_t failed = 0;
+    for (uint8_t r = 0; r < sizeof(Rotations); r++) {
+        failed += checkTransitions(small, Rotations[r]);
+        failed += checkTransitions(large, Rotations[r]);
+    }
+    failed += checkScheduler();
+
+    Serial.print("Checked every step of every transition and rotation, failed: ");
+    Serial.println(failed);
+    if (failed != 0) {
+        Serial.println("FAILED: a transition shows the wrong pixels");
+    }
+
+    Serial.println("Transitions per second, kernels and drawPixel redraw of every step");
+    Serial.println("panel\ttransition\tdirection\tkernels/s\tdrawPixel/s\tspeedup");
+    runGeometry("4x3", small);
+    runGeometry("32x8", large);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Fills a frame with random pixels.
+  @param    matrix          Matrix of the frame
+  @param    frame           Frame to fill
+  @param    seed            Seed of the pixels
+*/
+/**************************************************************************/
+void drawRandom(MAX7219CWGMatrix& matrix, uint8_t* frame, uint32_t seed) {
+    memset(frame, 0, matrix.getFrameSize());
+    matrix.setDrawBuffer(frame);
+
+    for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+        for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+            seed = seed*1103515245 + 12345;
+            matrix.drawPixel(x, y, (seed >> 16) & 1);
+        }
+    }
+    matrix.setDrawBuffer(nullptr);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns a pixel of a frame.
+  @param    matrix          Matrix of the frame
+  @param    frame           Frame
+  @param    x               X coordinate
+  @param    y               Y coordinate
+  @returns  Value of the pixel
+*/
+/**************************************************************************/
+uint8_t framePixel(MAX7219CWGMatrix& matrix, uint8_t* frame, int16_t x, int16_t y) {
+    matrix.setDrawBuffer(frame);
+    uint8_t value = matrix.getPixel(x, y);
+    matrix.setDrawBuffer(nullptr);
+    return value;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Runs a step of a transition, like the SmartLedDisplay does.
+  @param    matrix          Matrix to change
+  @param    type            TRANSITION_SLIDE, _WIPE or _DISSOLVE
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN
+  @param    step            Step, 1 to FRAMES
+*/
+/**************************************************************************/
+void stepTransition(MAX7219CWGMatrix& matrix, uint8_t type, uint8_t direction, uint8_t step) {
+    uint16_t size = direction == SHIFT_LEFT || direction == SHIFT_RIGHT ? matrix.getWidth() : matrix.getHeight();
+    uint16_t position = (uint32_t) size*step/FRAMES;
+
+    switch (type) {
+        case TRANSITION_SLIDE: {
+            uint16_t previous = (uint32_t) size*(step-1)/FRAMES;
+            matrix.shiftFrame(direction, position - previous, to, previous);
+            break;
+        }
+        case TRANSITION_WIPE:
+            matrix.wipeFrame(to, direction, position);
+            break;
+        case TRANSITION_DISSOLVE:
+            matrix.dissolveFrame(to, (uint16_t) DISSOLVE_LEVELS*step/FRAMES, DISSOLVE_SEED);
+            break;
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Returns what a pixel should show after a slide or wipe step.
+  @param    matrix          Matrix
+  @param    type            TRANSITION_SLIDE or _WIPE
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN
+  @param    position        Pixels the transition has moved
+  @param    x               X coordinate
+  @param    y               Y coordinate
+  @returns  Value of the pixel
+*/
+/**************************************************************************/
+uint8_t expectedPixel(MAX7219CWGMatrix& matrix, uint8_t type, uint8_t direction, uint16_t position, int16_t x, int16_t y) {
+    int16_t w = matrix.getWidth();
+    int16_t h = matrix.getHeight();
+
+    if (type == TRANSITION_WIPE) {
+        bool passed = (direction == SHIFT_LEFT && x >= w - position) || (direction == SHIFT_RIGHT && x < position)
+                   || (direction == SHIFT_UP && y >= h - position) || (direction == SHIFT_DOWN && y < position);
+        return framePixel(matrix, passed ? to : from, x, y);
+    }
+
+    /* A slide: the new frame lies next to the old one and both move */
+    switch (direction) {
+        case SHIFT_LEFT:
+            x += position;
+            return x < w ? framePixel(matrix, from, x, y) : framePixel(matrix, to, x - w, y);
+        case SHIFT_RIGHT:
+            x -= position;
+            return x >= 0 ? framePixel(matrix, from, x, y) : framePixel(matrix, to, x + w, y);
+        case SHIFT_UP:
+            y += position;
+            return y < h ? framePixel(matrix, from, x, y) : framePixel(matrix, to, x, y - h);
+        default:
+            y -= position;
+            return y >= 0 ? framePixel(matrix, from, x, y) : framePixel(matrix, to, x, y + h);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Steps every transition in every direction and compares every
+            pixel of every step. A dissolve may only turn pixels into the
+            new frame and has to end on it.
+  @param    matrix          Matrix to check
+  @param    rotation        Rotation to check
+  @returns  Number of failed transitions
+*/
+/**************************************************************************/
+uint32_t checkTransitions(MAX7219CWGMatrix& matrix, uint8_t rotation) {
+    uint32_t failed = 0;
+
+    matrix.setRotation(rotation);
+    drawRandom(matrix, from, 1);
+    drawRandom(matrix, to, 2);
+
+    for (uint8_t type = TRANSITION_SLIDE; type <= TRANSITION_DISSOLVE; type++) {
+        for (uint8_t direction = SHIFT_LEFT; direction <= SHIFT_DOWN; direction++) {
+            uint16_t size = direction == SHIFT_LEFT || direction == SHIFT_RIGHT ? matrix.getWidth() : matrix.getHeight();
+            uint32_t wrong = 0;
+            uint32_t turned = 0;                                            //Dissolve: pixels of the new frame
+            matrix.loadFrame(from);
+
+            for (uint8_t step = 1; step <= FRAMES; step++) {
+                stepTransition(matrix, type, direction, step);
+                uint32_t turnedNow = 0;
+
+                for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+                    for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+                        uint8_t value = matrix.getPixel(x, y);
+
+                        if (type != TRANSITION_DISSOLVE) {
+                            wrong += value != expectedPixel(matrix, type, direction, (uint32_t) size*step/FRAMES, x, y);
+                            continue;
+                        }
+
+                        uint8_t old = framePixel(matrix, from, x, y);
+                        uint8_t target = framePixel(matrix, to, x, y);
+                        wrong += value != old && value != target;
+                        wrong += step == FRAMES && value != target;
+                        turnedNow += old != target && value == target;
+                    }
+                }
+                wrong += turnedNow < turned;
+                turned = turnedNow;
+            }
+
+            if (wrong != 0) {
+                Serial.print("FAILED: ");
+                Serial.print(TypeNames[type]);
+                Serial.print(" ");
+                Serial.print(DirectionNames[direction]);
+                Serial.print(" on ");
+                Serial.print(matrix.getWidth());
+                Serial.print("x");
+                Serial.print(matrix.getHeight());
+                Serial.print(" rotation ");
+                Serial.print(rotation);
+                Serial.print(", wrong pixels: ");
+                Serial.println(wrong);
+                failed++;
+            }
+        }
+    }
+    matrix.setRotation(STANDARD_ROTATION);
+    return failed;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Switches screens on the SmartLedDisplay with every transition
+            and checks that the scheduler sends one frame per frame time
+            and then renders the screen as usual. A transition that is
+            stopped must be replaced by the screen.
+  @returns  Number of failed transitions
+*/
+/**************************************************************************/
+uint32_t checkScheduler() {
+    uint32_t failed = 0;
+
+    display.setTransport(&recorder);
+    display.setClockSource(simulatedClock);
+    display.update();
+
+    for (uint8_t type = TRANSITION_SLIDE; type <= TRANSITION_DISSOLVE; type++) {
+        display.setTransition(type, SHIFT_LEFT, FRAMES, TRANSITION_FRAME_TIME);
+        display.setScreen(type % 3);
+        display.update();                                                   //Applies the command, first frame
+
+        uint32_t start = simulatedTime;
+        uint32_t frames = 1;
+
+        while (display.isTransitioning()) {
+            simulatedTime += display.getTimeToUpdate();
+            frames += display.update();
+        }
+
+        if (frames != FRAMES || simulatedTime - start != (FRAMES - 1)*TRANSITION_FRAME_TIME) {
+            Serial.print("FAILED: scheduler of the ");
+            Serial.print(TypeNames[type]);
+            Serial.print(" sent ");
+            Serial.print(frames);
+            Serial.print(" frames in ");
+            Serial.print(simulatedTime - start);
+            Serial.println(" ms");
+            failed++;
+        }
+    }
+
+    /* Stopped halfway on a screen without dependencies, it is redrawn at once */
+    display.setTransition(TRANSITION_SLIDE, SHIFT_LEFT, FRAMES, TRANSITION_FRAME_TIME);
+    display.setScreen(1);
+    display.update();
+    display.setTransition(TRANSITION_NONE);
+
+    if (display.getTimeToUpdate() != 0 || !display.update()) {
+        Serial.println("FAILED: a stopped transition is left on the panel");
+        failed++;
+    }
+    return failed;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Redraws a step of a slide or wipe pixel by pixel, the way a
+            screen would be drawn without the kernels. A dissolve is
+            drawn as the pixels of the new frame below its level.
+  @param    matrix          Matrix to draw on
+  @param    type            TRANSITION_SLIDE, _WIPE or _DISSOLVE
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN
+  @param    step            Step, 1 to FRAMES
+*/
+/**************************************************************************/
+void redrawStep(MAX7219CWGMatrix& matrix, uint8_t type, uint8_t direction, uint8_t step) {
+    uint16_t size = direction == SHIFT_LEFT || direction == SHIFT_RIGHT ? matrix.getWidth() : matrix.getHeight();
+    uint16_t position = (uint32_t) size*step/FRAMES;
+    uint8_t level = (uint16_t) DISSOLVE_LEVELS*step/FRAMES;
+
+    for (uint16_t y = 0; y < matrix.getHeight(); y++) {
+        for (uint16_t x = 0; x < matrix.getWidth(); x++) {
+            uint8_t value;
+
+            if (type == TRANSITION_DISSOLVE) {
+                bool copied = ((x*5 + y*3) & (DISSOLVE_LEVELS-1)) < level;  //Any pattern, the cost is the same
+                value = framePixel(matrix, copied ? to : from, x, y);
+            } else {
+                value = expectedPixel(matrix, type, direction, position, x, y);
+            }
+            matrix.drawPixel(x, y, value);
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Times whole transitions, FRAMES steps each, for half a second.
+  @param    matrix          Matrix to time
+  @param    type            TRANSITION_SLIDE, _WIPE or _DISSOLVE
+  @param    direction       SHIFT_LEFT, _RIGHT, _UP or _DOWN
+  @param    kernels         True for the kernels, false for drawPixel()
+  @returns  Transitions per second
+*/
+/**************************************************************************/
+float timeTransitions(MAX7219CWGMatrix& matrix, uint8_t type, uint8_t direction, bool kernels) {
+    uint32_t transitions = 0;
+    uint32_t start = micros();
+    uint32_t elapsed;
+
+    do {
+        matrix.loadFrame(from);
+        for (uint8_t step = 1; step <= FRAMES; step++) {
+            if (kernels) {
+                stepTransition(matrix, type, direction, step);
+            } else {
+                redrawStep(matrix, type, direction, step);
+            }
+        }
+        transitions++;
+        elapsed = micros() - start;
+    } while (elapsed < SECONDS*1000000);
+
+    return (float) transitions * 1000000 / elapsed;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Times every transition on a geometry and prints the results.
+  @param    name            Name of the geometry
+  @param    matrix          Matrix to time
+*/
+/**************************************************************************/
+void runGeometry(const char name[], MAX7219CWGMatrix& matrix) {
+    drawRandom(matrix, from, 1);
+    drawRandom(matrix, to, 2);
+
+    for (uint8_t type = TRANSITION_SLIDE; type <= TRANSITION_DISSOLVE; type++) {
+        for (uint8_t direction = SHIFT_LEFT; direction <= SHIFT_DOWN; direction++) {
+            if (type == TRANSITION_DISSOLVE && direction != SHIFT_LEFT) {
+                break;                                                      //A dissolve has no direction
+            }
+            float kernels = timeTransitions(matrix, type, direction, true);
+            float redraw = timeTransitions(matrix, type, direction, false);
+
+            Serial.print(name);
+            Serial.print("\t");
+            Serial.print(TypeNames[type]);
+            Serial.print("\t\t");
+            Serial.print(type == TRANSITION_DISSOLVE ? "-" : DirectionNames[direction]);
+            Serial.print("\t\t");
+            Serial.print(kernels);
+            Serial.print("\t\t");
+            Serial.print(redraw);
+            Serial.print("\t\t");
+            Serial.println(kernels / redraw);
+        }
+    }
+}
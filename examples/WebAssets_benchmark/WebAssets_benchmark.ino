@@ -0,0 +1,433 @@
+/*
+ * File:      WebAssets_benchmark.ino
+ * Authors:   Luke de Munk
+ *
+ * Benchmark of serving the control page of the SmartWifiLedDisplay
+ * example. Runs on Linux: a small HTTP server on the loopback interface
+ * serves the files of ../SmartWifiLedDisplay/data in two ways. The old
+ * way reads every file from disk, uncompressed and without cache headers,
+ * renders the template for every page and answers every setting with the
+ * whole page. The new way uses the AssetCache and PageTemplate, and the
+ * /state route. A client times every interaction and counts the bytes it
+ * receives. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <atomic>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "AssetCache.h"
+
+#define REPEATS         50                                                  //Times every interaction is timed
+#define MAX_FILE_SIZE   131072
+#define STATE_JSON_SIZE 96
+
+/* Ways of serving */
+#define OLD_SERVER      0
+#define NEW_SERVER      1
+
+struct Settings {
+    bool power;
+    uint8_t intensity;
+    uint8_t screen;
+    bool inverted;
+    uint32_t version;
+};
+Settings settings = {true, 0, 0, false, 0};
+
+/* Same order as the example, hot files first */
+const char* const Files[] = {"/base.js", "/switches.js", "/style.css", "/style_mobile.css", "/style_switches.css", "/jquery.min.js", "/favicon.ico"};
+const char* const ContentTypes[] = {"text/javascript", "text/javascript", "text/css", "text/css", "text/css", "text/javascript", "image/x-icon"};
+#define NUMBER_OF_FILES (sizeof(Files)/sizeof(Files[0]))
+
+AssetCache assets;
+PageTemplate page;
+std::atomic<int> mode{OLD_SERVER};
+uint16_t port;
+uint32_t requests = 0;                                                      //Requests sent by the client
+
+/* Client side cache: ETag per path */
+std::string clientEtags[NUMBER_OF_FILES + 1];
+
+/**************************************************************************/
+/*!
+  @brief    Replaces placeholders with actual data in HTML page.
+*/
+/**************************************************************************/
+String processor(const String& var) {
+    if (var == "POWER") {
+        return String(settings.power);
+    } else if (var == "INTENSITY") {
+        return String(settings.intensity);
+    } else if (var == "SCREEN") {
+        return String(settings.screen);
+    } else if (var == "INVERTED") {
+        return String(settings.inverted);
+    }
+    return " placeholder_error ";
+}
+
+/**************************************************************************/
+/*!
+  @brief    Setup the server and run the benchmark once.
+*/
+/**************************************************************************/
+void setup() {
+    Serial.begin(115200);
+    delay(100);
+
+    std::string index = readFile("/index.html");
+    page.begin(index.c_str(), index.length(), processor);
+
+    for (uint8_t i = 0; i < NUMBER_OF_FILES; i++) {
+        std::string file = std::string(Files[i]) + ".gz";
+        std::string data = readFile(file.c_str());
+
+        assets.add(Files[i], ContentTypes[i], (const uint8_t*) data.data(), data.length(), true, file.c_str());
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    int on = 1;
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        Serial.println("Could not start the server");
+        return;
+    }
+    getsockname(listener, (sockaddr*) &address, &length);
+    port = ntohs(address.sin_port);
+
+    std::thread server(serve, listener);
+    server.detach();
+
+    Serial.print("Assets in RAM: ");
+    Serial.print(assets.getCachedSize());
+    Serial.println(" bytes");
+    Serial.println("Web benchmark (reload revalidates every file)");
+    Serial.println("interaction\tserver\trequests\tbytes\tus");
+
+    for (int m = OLD_SERVER; m <= NEW_SERVER; m++) {
+        mode = m;
+        benchmark("first load", m, [](int /*m*/) { return loadPage(false); });
+        benchmark("reload", m, [](int /*m*/) { return loadPage(true); });
+        benchmark("1 setting", m, [](int m) {
+            return m == OLD_SERVER ? request("/set_intensity?intensity=5", -1) : request("/state?intensity=5", -1);
+        });
+        benchmark("3 settings", m, [](int m) {
+            if (m == OLD_SERVER) {
+                return request("/set_power?power=1", -1) + request("/set_intensity?intensity=7", -1) + request("/set_screen?screen=1", -1);
+            }
+            return request("/state?power=1&intensity=7&screen=1", -1);
+        });
+    }
+
+    Serial.print("Page renders of the new server: ");
+    Serial.println(page.getNumRenders());
+}
+
+/**************************************************************************/
+/*!
+  @brief    Main loop, nothing to do.
+*/
+/**************************************************************************/
+void loop() {
+}
+
+/**************************************************************************/
+/*!
+  @brief    Times an interaction REPEATS times and prints one line.
+  @param    name            Name of the interaction
+  @param    m               OLD_SERVER or NEW_SERVER
+  @param    interaction     Runs the requests, returns the bytes received
+*/
+/**************************************************************************/
+void benchmark(const char name[], int m, uint32_t (*interaction)(int)) {
+    uint32_t bytes = 0;
+    uint32_t start;
+
+    requests = 0;
+    start = micros();
+    for (uint16_t i = 0; i < REPEATS; i++) {
+        bytes += interaction(m);
+    }
+    uint32_t time = micros() - start;
+
+    Serial.print(name);
+    Serial.print("\t");
+    Serial.print(m == OLD_SERVER ? "old" : "new");
+    Serial.print("\t");
+    Serial.print(requests / REPEATS);
+    Serial.print("\t");
+    Serial.print(bytes / REPEATS);
+    Serial.print("\t");
+    Serial.println(time / REPEATS);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Loads the page and every file on it, like a browser.
+  @param    revalidate      True to send the ETags from the last load
+  @returns  Bytes received
+*/
+/**************************************************************************/
+uint32_t loadPage(bool revalidate) {
+    if (!revalidate) {
+        for (uint8_t i = 0; i <= NUMBER_OF_FILES; i++) {
+            clientEtags[i].clear();
+        }
+    }
+
+    uint32_t bytes = request("/", NUMBER_OF_FILES);
+    for (uint8_t i = 0; i < NUMBER_OF_FILES; i++) {
+        bytes += request(Files[i], i);
+    }
+    return bytes;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Sends one request on a new connection and reads the response.
+  @param    path            Path and query
+  @param    cacheIndex      Slot of clientEtags to revalidate with and
+                            store the ETag in, -1 for none
+  @returns  Bytes received, headers included
+*/
+/**************************************************************************/
+uint32_t request(const char path[], int cacheIndex) {
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    connect(client, (sockaddr*) &address, sizeof(address));
+
+    std::string text = std::string("GET ") + path + " HTTP/1.1\r\nHost: display\r\nAccept-Encoding: gzip, deflate\r\n";
+    if (cacheIndex >= 0 && !clientEtags[cacheIndex].empty()) {
+        text += "If-None-Match: " + clientEtags[cacheIndex] + "\r\n";
+    }
+    text += "Connection: close\r\n\r\n";
+    send(client, text.data(), text.length(), 0);
+
+    std::string response;
+    char buffer[4096];
+    ssize_t received;
+
+    while ((received = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, received);
+    }
+    close(client);
+    requests++;
+
+    /* Remember the ETag, a 304 keeps the one the client has */
+    size_t etag = response.find("ETag: ");
+    if (cacheIndex >= 0 && etag != std::string::npos) {
+        clientEtags[cacheIndex] = response.substr(etag + 6, response.find("\r\n", etag) - etag - 6);
+    }
+    return response.length();
+}
+
+/**************************************************************************/
+/*!
+  @brief    Accepts connections and answers one request per connection.
+  @param    listener        Listening socket
+*/
+/**************************************************************************/
+void serve(int listener) {
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        std::string text;
+        char buffer[1024];
+        ssize_t received;
+
+        while (text.find("\r\n\r\n") == std::string::npos && (received = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+            text.append(buffer, received);
+        }
+
+        std::string target = text.substr(4, text.find(' ', 4) - 4);
+        std::string path = target.substr(0, target.find('?'));
+        std::string query = target.find('?') != std::string::npos ? target.substr(target.find('?') + 1) : "";
+        std::string ifNoneMatch;
+        size_t header = text.find("If-None-Match: ");
+
+        if (header != std::string::npos) {
+            ifNoneMatch = text.substr(header + 15, text.find("\r\n", header) - header - 15);
+        }
+
+        std::string response = mode == OLD_SERVER ? answerOld(path, query) : answerNew(path, query, ifNoneMatch);
+        send(client, response.data(), response.length(), 0);
+        close(client);
+    }
+}
+
+/**************************************************************************/
+/*!
+  @brief    Answers like the example did before: files from disk without
+            cache headers, the template rendered for every page and every
+            setting answered with the page.
+  @param    path            Path of the request
+  @param    query           Query of the request
+  @returns  Response
+*/
+/**************************************************************************/
+std::string answerOld(const std::string& path, const std::string& query) {
+    if (path == "/" || path.compare(0, 5, "/set_") == 0) {
+        applySettings(query);
+
+        PageTemplate oldPage;
+        std::string index = readFile("/index.html");
+
+        oldPage.begin(index.c_str(), index.length(), processor);
+        oldPage.render(0);
+        return response(200, "text/html", std::string(oldPage.getPage(), oldPage.getLength()), "");
+    }
+
+    for (uint8_t i = 0; i < NUMBER_OF_FILES; i++) {
+        if (path == Files[i]) {
+            return response(200, ContentTypes[i], readFile(Files[i]), "");
+        }
+    }
+    return response(404, "text/plain", "", "");
+}
+
+/**************************************************************************/
+/*!
+  @brief    Answers like the example does now.
+  @param    path            Path of the request
+  @param    query           Query of the request
+  @param    ifNoneMatch     If-None-Match header, empty if none
+  @returns  Response
+*/
+/**************************************************************************/
+std::string answerNew(const std::string& path, const std::string& query, const std::string& ifNoneMatch) {
+    if (path == "/") {
+        page.render(settings.version);
+
+        if (AssetCache::isNotModified(page.getEtag(), ifNoneMatch.c_str())) {
+            return response(304, nullptr, "", std::string("ETag: ") + page.getEtag() + "\r\n");
+        }
+        return response(200, "text/html", std::string(page.getPage(), page.getLength()),
+                        std::string("ETag: ") + page.getEtag() + "\r\nCache-Control: no-cache\r\n");
+    }
+
+    if (path == "/state") {
+        if (applySettings(query)) {
+            settings.version++;
+        }
+
+        char json[STATE_JSON_SIZE];
+        snprintf(json, sizeof(json), "{\"version\":%lu,\"power\":%d,\"intensity\":%d,\"screen\":%d,\"inverted\":%d}",
+                 (unsigned long) settings.version, settings.power, settings.intensity, settings.screen, settings.inverted);
+        return response(200, "application/json", json, "Cache-Control: no-store\r\n");
+    }
+
+    const Asset* asset = assets.find(path.c_str());
+    if (asset == nullptr) {
+        return response(404, "text/plain", "", "");
+    }
+
+    std::string headers = std::string("ETag: ") + asset->etag + "\r\n";
+    if (AssetCache::isNotModified(asset->etag, ifNoneMatch.c_str())) {
+        return response(304, nullptr, "", headers);
+    }
+
+    headers += "Content-Encoding: gzip\r\nCache-Control: " ASSET_MAX_AGE "\r\n";
+    if (asset->data != nullptr) {
+        return response(200, asset->contentType, std::string((const char*) asset->data, asset->length), headers);
+    }
+    return response(200, asset->contentType, readFile(asset->file), headers);
+}
+
+/**************************************************************************/
+/*!
+  @brief    Applies the settings in a query.
+  @param    query           Query, for example "power=1&intensity=7"
+  @returns  True if a setting was given
+*/
+/**************************************************************************/
+bool applySettings(const std::string& query) {
+    bool changed = false;
+    size_t start = 0;
+
+    while (start < query.length()) {
+        size_t end = query.find('&', start);
+        std::string parameter = query.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        size_t equals = parameter.find('=');
+        std::string name = parameter.substr(0, equals);
+        int value = equals != std::string::npos ? atoi(parameter.c_str() + equals + 1) : 0;
+
+        if (name == "power") {
+            settings.power = value;
+        } else if (name == "intensity") {
+            settings.intensity = value;
+        } else if (name == "screen") {
+            settings.screen = value;
+        } else if (name == "inverted") {
+            settings.inverted = value;
+        }
+        changed = true;
+
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return changed;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Builds a response.
+  @param    status          Status code
+  @param    contentType     MIME type, nullptr for none
+  @param    body            Body
+  @param    headers         Extra header lines
+  @returns  Response
+*/
+/**************************************************************************/
+std::string response(uint16_t status, const char contentType[], const std::string& body, const std::string& headers) {
+    std::string text = "HTTP/1.1 " + std::to_string(status) + (status == 200 ? " OK" : status == 304 ? " Not Modified" : " Not Found") + "\r\n";
+
+    if (contentType != nullptr) {
+        text += std::string("Content-Type: ") + contentType + "\r\n";
+    }
+    text += headers;
+    text += "Content-Length: " + std::to_string(body.length()) + "\r\nConnection: close\r\n\r\n";
+    return text + body;
+}
+
+/**************************************************************************/
+/*!
+  @brief    Reads a file of the data folder of the SmartWifiLedDisplay
+            example.
+  @param    name            Name of the file, starting with '/'
+  @returns  Contents, empty if not found
+*/
+/**************************************************************************/
+std::string readFile(const char name[]) {
+    std::string path = __FILE__;
+    path = path.substr(0, path.rfind('/')) + "/../SmartWifiLedDisplay/data" + name;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    std::string data;
+
+    if (file == nullptr) {
+        Serial.print("Could not open ");
+        Serial.println(path.c_str());
+        return data;
+    }
+
+    char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, length);
+    }
+    fclose(file);
+    return data;
+}
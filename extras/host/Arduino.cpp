@@ -0,0 +1,56 @@
+/*
+ * File:      Arduino.cpp
+ * Authors:   Luke de Munk
+ *
+ * Host Arduino core: Serial, SPI, timing and a main() that calls the
+ * setup() and loop() of the sketch. loop() is called HOST_LOOPS times,
+ * the sketches that run on Linux do their work in setup(). For more
+ * info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#include <stdarg.h>
+#include <chrono>
+#include "Arduino.h"
+#include "SPI.h"
+
+#ifndef HOST_LOOPS
+#define HOST_LOOPS              0
+#endif
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vprintf(format, arguments);
+    va_end(arguments);
+    return length;
+}
+
+int main() {
+    setup();
+    for (int i = 0; i < HOST_LOOPS; i++) {
+        loop();
+    }
+    fflush(stdout);
+    return 0;
+}
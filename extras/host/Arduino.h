@@ -0,0 +1,125 @@
+/*
+ * File:      Arduino.h
+ * Authors:   Luke de Munk
+ *
+ * Minimal Arduino core for building the library and the example sketches
+ * that run on Linux, see CMakeLists.txt. Only what the library and those
+ * sketches use: the types, PROGMEM access, timing and a Serial that
+ * prints to stdout. Not used when compiling for a board. For more info,
+ * checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+#include <thread>
+
+using std::min;
+using std::max;
+
+/* Flash is ordinary memory on the host */
+#define PROGMEM
+#define pgm_read_byte(address)          (*(const uint8_t*) (address))
+#define pgm_read_byte_near(address)     (*(const uint8_t*) (address))
+#define pgm_read_word(address)          (*(const uint16_t*) (address))
+#define pgm_read_dword(address)         (*(const uint32_t*) (address))
+#define memcpy_P                        memcpy
+#define strlen_P                        strlen
+
+#define INPUT                   0
+#define OUTPUT                  1
+#define LOW                     0
+#define HIGH                    1
+#define LSBFIRST                0
+#define MSBFIRST                1
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+/* Sketch entry points, called by main() */
+void setup();
+void loop();
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+/* Pins do nothing, the buses are transports */
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    (void) pin;
+    (void) mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    (void) pin;
+    (void) value;
+}
+
+class String {
+	public:
+        String() {}
+        String(const char* text) : _text(text != nullptr ? text : "") {}
+        String(const std::string& text) : _text(text) {}
+        String(int value) : _text(std::to_string(value)) {}
+        String(unsigned int value) : _text(std::to_string(value)) {}
+        String(long value) : _text(std::to_string(value)) {}
+        String(unsigned long value) : _text(std::to_string(value)) {}
+
+        const char* c_str() const { return _text.c_str(); }
+        unsigned int length() const { return _text.size(); }
+        char operator[](unsigned int i) const { return _text[i]; }
+        bool operator==(const String& other) const { return _text == other._text; }
+        String& operator+=(const String& other) { _text += other._text; return *this; }
+        friend String operator+(const String& a, const String& b) { return String(a._text + b._text); }
+
+	private:
+        std::string _text;
+};
+
+class HardwareSerial {
+	public:
+        void begin(unsigned long baudRate) { (void) baudRate; }
+        int available() { return 0; }
+        int read() { return -1; }
+        void flush() { fflush(stdout); }
+
+        template<class T> size_t print(const T& value) { return _print(value); }
+        template<class T> size_t println(const T& value) { return _print(value) + ::printf("\n"); }
+        size_t println() { return ::printf("\n"); }
+        size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+	private:
+        size_t _print(const char* value) { return ::printf("%s", value); }
+        size_t _print(char* value) { return ::printf("%s", value); }
+        size_t _print(const String& value) { return ::printf("%s", value.c_str()); }
+        size_t _print(char value) { return ::printf("%c", value); }
+        size_t _print(bool value) { return ::printf("%d", value); }
+        size_t _print(int8_t value) { return ::printf("%d", value); }
+        size_t _print(uint8_t value) { return ::printf("%u", value); }
+        size_t _print(int16_t value) { return ::printf("%d", value); }
+        size_t _print(uint16_t value) { return ::printf("%u", value); }
+        size_t _print(int value) { return ::printf("%d", value); }
+        size_t _print(unsigned int value) { return ::printf("%u", value); }
+        size_t _print(long value) { return ::printf("%ld", value); }
+        size_t _print(unsigned long value) { return ::printf("%lu", value); }
+        size_t _print(long long value) { return ::printf("%lld", value); }
+        size_t _print(unsigned long long value) { return ::printf("%llu", value); }
+        size_t _print(float value) { return ::printf("%.2f", value); }
+        size_t _print(double value) { return ::printf("%.2f", value); }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HOST_ARDUINO_H */
@@ -0,0 +1,38 @@
+/*
+ * File:      SPI.h
+ * Authors:   Luke de Munk
+ *
+ * SPI bus of the host Arduino core, it drops every byte. The example
+ * sketches that run on Linux set a recording transport or the simulator
+ * instead. For more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+#include "Arduino.h"
+
+#define SPI_MODE0               0
+
+struct SPISettings {
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+        (void) clock;
+        (void) bitOrder;
+        (void) dataMode;
+    }
+};
+
+class SPIClass {
+	public:
+        void begin() {}
+        void beginTransaction(SPISettings settings) { (void) settings; }
+        void endTransaction() {}
+        uint8_t transfer(uint8_t data) { return data; }
+        void transfer(void* data, uint32_t length) { (void) data; (void) length; }
+        uint16_t transfer16(uint16_t data) { return data; }
+        void writeBytes(const uint8_t* data, uint32_t length) { (void) data; (void) length; }
+};
+
+extern SPIClass SPI;
+
+#endif /* HOST_SPI_H */
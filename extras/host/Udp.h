@@ -0,0 +1,48 @@
+/*
+ * File:      Udp.h
+ * Authors:   Luke de Munk
+ *
+ * UDP interface of the host Arduino core, for the ClockService. The
+ * example sketches that run on Linux implement it with a loopback. For
+ * more info, checkout:
+ * https://github.com/LukedeMunk/ESP32-8x8ledmatrix-big-display
+ */
+#ifndef HOST_UDP_H
+#define HOST_UDP_H
+#include "Arduino.h"
+
+class IPAddress {
+	public:
+        IPAddress() {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+
+        uint8_t operator[](int i) const { return _bytes[i]; }
+        uint8_t& operator[](int i) { return _bytes[i]; }
+
+	private:
+        uint8_t _bytes[4] = {0};
+};
+
+class UDP {
+	public:
+        virtual ~UDP() {}
+
+        virtual uint8_t begin(uint16_t port) = 0;
+        virtual void stop() = 0;
+        virtual int beginPacket(IPAddress ip, uint16_t port) = 0;
+        virtual int beginPacket(const char* host, uint16_t port) = 0;
+        virtual int endPacket() = 0;
+        virtual size_t write(uint8_t data) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+        virtual int parsePacket() = 0;
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int read(unsigned char* buffer, size_t length) = 0;
+        virtual int read(char* buffer, size_t length) = 0;
+        virtual int peek() = 0;
+        virtual void flush() = 0;
+        virtual IPAddress remoteIP() = 0;
+        virtual uint16_t remotePort() = 0;
+};
+
+#endif /* HOST_UDP_H */